@@ -188,6 +188,14 @@ EventUPtr make_touch_event(
     std::vector<TouchContact> const& contacts);
 
 EventUPtr clone_event(MirEvent const& event);
+
+/**
+ * Share ownership of \a event
+ *
+ * Unlike converting the EventUPtr to std::shared_ptr, this doesn't allocate on the heap (in steady state):
+ * prefer it on the input path.
+ */
+auto share_event(EventUPtr&& event) -> std::shared_ptr<MirEvent>;
 void set_window_id(MirEvent& event, int window_id);
 
 [[deprecated("Not meaningful: legacy of mirclient API")]]
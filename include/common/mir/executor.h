@@ -17,6 +17,8 @@
 #ifndef MIR_EXECUTOR_H_
 #define MIR_EXECUTOR_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 
 namespace mir
@@ -75,14 +77,42 @@ public:
 
     /**
      * Wait for all current work to finish and terminate all worker threads
+     *
+     * This includes work spawned on the long_running_executor.
      */
     static void quiesce();
+
+    struct Statistics
+    {
+        int workers;        ///< The number of threads sharing the work (one per core)
+        size_t queued;      ///< Work waiting for a thread
+        uint64_t executed;  ///< Work completed
+        uint64_t stolen;    ///< Work a thread took from another thread's queue
+        uint64_t offloaded; ///< Work moved to a thread of its own because every worker was blocked
+    };
+
+    /// A snapshot of the thread_pool_executor's counters (since the process started)
+    static auto statistics() -> Statistics;
 protected:
     ThreadPoolExecutor() = default;
 };
 
+/**
+ * An Executor for short items of work, run on a pool of threads sized to the number of cores
+ *
+ * Work may block, but work that runs for a long time (such as a render loop) should use the
+ * long_running_executor rather than tie up one of this executor's threads.
+ */
 extern NonBlockingExecutor& thread_pool_executor;
 
+/**
+ * An Executor that runs each item of work on a thread of its own
+ *
+ * For work that runs for a long time or blocks (such as a compositor's render loop) so it
+ * doesn't hold up the short items of work on the thread_pool_executor.
+ */
+extern NonBlockingExecutor& long_running_executor;
+
 /**
  * An Executor that makes the following concurrency guarantees:
  *
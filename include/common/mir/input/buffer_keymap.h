@@ -39,6 +39,12 @@ public:
     auto model() const -> std::string override;
     auto make_unique_xkb_keymap(xkb_context* context) const -> XKBKeymapPtr override;
 
+    /// Identifies the compiled keymap: keymaps that match() have equal identities
+    auto identity() const -> std::string
+    {
+        return std::to_string(format) + "\n" + std::string{buffer.begin(), buffer.end()};
+    }
+
 private:
     std::string const name;
     std::vector<char> const buffer;
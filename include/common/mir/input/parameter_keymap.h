@@ -54,6 +54,12 @@ public:
     auto make_unique_xkb_keymap(xkb_context* context) const -> XKBKeymapPtr override;
     auto with_layout(std::string const& layout, std::string const& variant) const -> std::unique_ptr<Keymap>;
 
+    /// Identifies the compiled keymap: keymaps that match() have equal identities
+    auto identity() const -> std::string
+    {
+        return "evdev\n" + model_ + "\n" + layout + "\n" + variant + "\n" + options;
+    }
+
 private:
     std::string const model_{default_model};
     std::string const layout{default_layout};
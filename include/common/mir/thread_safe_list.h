@@ -17,29 +17,27 @@
 #ifndef MIR_THREAD_SAFE_LIST_H_
 #define MIR_THREAD_SAFE_LIST_H_
 
-#include <mir/recursive_read_write_mutex.h>
-
+#include <algorithm>
 #include <atomic>
-#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace mir
 {
 
 /*
  * Requirements for type 'Element'
- *  - for_each():
- *    - copy-assignable
  *  - add():
- *    - copy-assignable
- *    - conversion to bool: indicates whether this is a valid element
+ *    - copy-constructible
  *  - remove(), remove_all():
- *    - copy-assignable
- *    - Element{}: default construction should create an invalid element
  *    - bool operator==: equality of elements
- *    - bool operator!=: inequality of elements
- *  - clear():
- *    - copy-assignable
- *    - Element{}: value initialization should create an invalid element
+ *
+ * for_each() walks an immutable snapshot of the list, which is replaced whenever elements are
+ * added or removed, so it neither waits for nor blocks changes to the list. An element removed
+ * during a for_each() is skipped if it hasn't been reached yet. remove(), remove_all() and
+ * clear() wait for calls with the removed elements on other threads to finish, but not for
+ * those on the calling thread (so an element can be removed from within a call with it).
  */
 
 template<class Element>
@@ -50,133 +48,170 @@ public:
     void remove(Element const& element);
     unsigned int remove_all(Element const& element);
     void clear();
-    void for_each(std::function<void(Element const& element)> const& f);
+    template<typename Function>
+    void for_each(Function const& f);
 
 private:
-    struct ListItem
+    struct Item
     {
-        ListItem() {}
-        RecursiveReadWriteMutex mutex;
-        Element element{};
-        std::atomic<ListItem*> next{nullptr};
+        explicit Item(Element const& element) : element{element} {}
 
-        ~ListItem() { delete next.load(); }
-    } head;
-};
+        Element const element;
+        std::atomic<bool> removed{false};
+        /// Calls with element in progress (or about to see that it has been removed)
+        std::atomic<unsigned> calls{0};
+    };
 
-template<class Element>
-void ThreadSafeList<Element>::for_each(
-    std::function<void(Element const& element)> const& f)
-{
-    ListItem* current_item = &head;
+    using Items = std::vector<std::shared_ptr<Item>>;
 
-    while (current_item)
+    /// A call with an item in progress on this thread
+    class Call
     {
-        RecursiveReadLock lock{current_item->mutex};
+    public:
+        explicit Call(Item& item)
+            : item{item},
+              outer{innermost_call}
+        {
+            ++item.calls;
+            innermost_call = this;
+        }
 
-        // We need to take a copy in case we recursively remove during call
-        if (auto const copy_of_element = current_item->element) f(copy_of_element);
+        ~Call()
+        {
+            innermost_call = outer;
+            --item.calls;
+            if (item.removed)
+            {
+                item.calls.notify_all();
+            }
+        }
 
-        current_item = current_item->next;
-    }
-}
+        Call(Call const&) = delete;
+        Call& operator=(Call const&) = delete;
+
+        Item& item;
+        Call const* const outer;
+    };
+
+    /// Waits for calls on other threads with an item no longer in the list
+    static void retire(Item& item);
+
+    inline static thread_local Call const* innermost_call{nullptr};
+
+    /// Serialises changes to items
+    std::mutex mutex;
+    std::atomic<std::shared_ptr<Items const>> items{std::make_shared<Items const>()};
+};
 
 template<class Element>
-void ThreadSafeList<Element>::add(Element const& element)
+template<typename Function>
+void ThreadSafeList<Element>::for_each(Function const& f)
 {
-    ListItem* current_item = &head;
+    auto const snapshot = items.load();
 
-    do
+    for (auto const& item : *snapshot)
     {
-        // Note: we release the read lock to avoid two threads calling add at
-        // the same time mutually blocking the other's upgrade to write lock.
-        {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element) continue;
-        }
-
-        RecursiveWriteLock lock{current_item->mutex};
+        Call const call{*item};
 
-        if (!current_item->element)
-        {
-            current_item->element = element;
-            return;
-        }
+        if (!item->removed) f(item->element);
     }
-    while (current_item->next && (current_item = current_item->next));
+}
 
-    // No empty Items so append a new one
-    auto new_item = new ListItem;
-    new_item->element = element;
+template<class Element>
+void ThreadSafeList<Element>::add(Element const& element)
+{
+    std::lock_guard lock{mutex};
 
-    for (ListItem* expected{nullptr};
-        !current_item->next.compare_exchange_weak(expected, new_item);
-        expected = nullptr)
-    {
-        if (expected) current_item = expected;
-    }
+    auto updated = std::make_shared<Items>(*items.load());
+    updated->push_back(std::make_shared<Item>(element));
+    items.store(std::move(updated));
 }
 
 template<class Element>
 void ThreadSafeList<Element>::remove(Element const& element)
 {
-    ListItem* current_item = &head;
-
-    do
+    std::shared_ptr<Item> removed;
     {
-        {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element != element) continue;
-        }
+        std::lock_guard lock{mutex};
 
-        RecursiveWriteLock lock{current_item->mutex};
+        auto updated = std::make_shared<Items>(*items.load());
+        auto const i = std::find_if(
+            updated->begin(),
+            updated->end(),
+            [&element](auto const& item) { return item->element == element; });
 
-        if (current_item->element == element)
+        if (i == updated->end())
         {
-            current_item->element = Element{};
             return;
         }
+
+        removed = std::move(*i);
+        updated->erase(i);
+        items.store(std::move(updated));
     }
-    while ((current_item = current_item->next));
+
+    retire(*removed);
 }
 
 template<class Element>
 unsigned int ThreadSafeList<Element>::remove_all(Element const& element)
 {
-    ListItem* current_item = &head;
-    auto removed = 0u;
-
-    do
+    Items removed;
     {
+        std::lock_guard lock{mutex};
+
+        auto updated = std::make_shared<Items>();
+        for (auto const& item : *items.load())
         {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element != element) continue;
+            (item->element == element ? removed : *updated).push_back(item);
         }
 
-        RecursiveWriteLock lock{current_item->mutex};
-
-        if (current_item->element == element)
+        if (removed.empty())
         {
-            current_item->element = Element{};
-            ++removed;
+            return 0;
         }
+
+        items.store(std::move(updated));
+    }
+
+    for (auto const& item : removed)
+    {
+        retire(*item);
     }
-    while ((current_item = current_item->next));
 
-    return removed;
+    return removed.size();
 }
 
 template<class Element>
 void ThreadSafeList<Element>::clear()
 {
-    ListItem* current_item = &head;
+    std::shared_ptr<Items const> removed;
+    {
+        std::lock_guard lock{mutex};
+        removed = items.exchange(std::make_shared<Items const>());
+    }
+
+    for (auto const& item : *removed)
+    {
+        retire(*item);
+    }
+}
+
+template<class Element>
+void ThreadSafeList<Element>::retire(Item& item)
+{
+    item.removed = true;
+
+    auto on_this_thread = 0u;
+    for (auto call = innermost_call; call; call = call->outer)
+    {
+        if (&call->item == &item) ++on_this_thread;
+    }
 
-    do
+    for (auto calls = item.calls.load(); calls != on_this_thread; calls = item.calls.load())
     {
-        RecursiveWriteLock lock{current_item->mutex};
-        current_item->element = Element{};
+        item.calls.wait(calls);
     }
-    while ((current_item = current_item->next));
 }
 
 }
@@ -0,0 +1,79 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GEOMETRY_REGION_H_
+#define MIR_GEOMETRY_REGION_H_
+
+#include <mir/geometry/rectangle.h>
+
+#include <iosfwd>
+#include <vector>
+
+namespace mir
+{
+namespace geometry
+{
+class Rectangles;
+
+/**
+ * A set of points, supporting union, intersection and subtraction.
+ *
+ * The region is stored as disjoint rectangles in y-x banded order: rectangles are
+ * grouped into horizontal bands sharing a top and bottom, bands are sorted from
+ * top to bottom and the rectangles within a band from left to right. Vertically
+ * adjacent bands with identical horizontal extents are merged, so a region has a
+ * single canonical representation.
+ */
+class Region
+{
+public:
+    Region();
+    Region(Rectangle const& rect);
+    explicit Region(Rectangles const& rects);
+    /* We want to keep implicit copy and move methods */
+
+    /// Make the region rect, reusing the storage it already has
+    auto operator=(Rectangle const& rect) -> Region&;
+
+    auto empty() const -> bool;
+    auto bounding_rectangle() const -> Rectangle;
+    /// Whether every point of rect is in the region
+    auto contains(Rectangle const& rect) const -> bool;
+    /// Whether any point of rect is in the region
+    auto overlaps(Rectangle const& rect) const -> bool;
+
+    void unite(Region const& other);
+    void intersect(Region const& other);
+    void subtract(Region const& other);
+
+    /// The (disjoint, banded) rectangles making up the region
+    auto rectangles() const -> std::vector<Rectangle> const&;
+
+    auto operator==(Region const& other) const -> bool;
+
+private:
+    std::vector<Rectangle> bands;
+};
+
+auto union_of(Region const& a, Region const& b) -> Region;
+auto intersection_of(Region const& a, Region const& b) -> Region;
+auto difference_of(Region const& a, Region const& b) -> Region;
+
+std::ostream& operator<<(std::ostream& out, Region const& value);
+}
+}
+
+#endif /* MIR_GEOMETRY_REGION_H_ */
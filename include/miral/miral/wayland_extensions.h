@@ -188,6 +188,12 @@ public:
     /// \remark Since MirAL 5.6
     static char const* const ext_data_control_manager_v1;
 
+    /// Allows clients to ask for a surface to be shown as soon as possible, even if that tears,
+    /// while it is scanned out directly (typically when fullscreen). Tearing is visible to the
+    /// user, so only enable this for clients where that is wanted, such as games.
+    /// \remark Since MirAL 5.6
+    static char const* const wp_tearing_control_manager_v1;
+
     /// Add a bespoke Wayland extension both to "supported" and "enabled by default".
     void add_extension(Builder const& builder);
 
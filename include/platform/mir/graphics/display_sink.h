@@ -20,10 +20,13 @@
 #include <mir/graphics/platform.h>
 #include <mir/geometry/rectangle.h>
 #include <mir/graphics/renderable.h>
+#include <mir/graphics/frame.h>
+#include <mir/graphics/scanout_formats.h>
 #include <mir_toolkit/common.h>
 #include <glm/glm.hpp>
 
 #include <memory>
+#include <optional>
 
 namespace mir
 {
@@ -47,6 +50,8 @@ struct DisplayElement
      */
     geometry::RectangleF source_position;
     std::shared_ptr<Framebuffer> buffer;
+    /// The buffer may be flipped to asynchronously (with tearing), rather than at the next vblank
+    bool allow_tearing{false};
 };
 /**
  * Interface to an output sink.
@@ -74,6 +79,31 @@ public:
     **/
     virtual bool overlay(std::vector<DisplayElement> const& renderlist) = 0;
 
+    /**
+     * Show whichever elements of renderlist the hardware can on overlay planes,
+     * leaving the rest to be composited into the image for set_next_image().
+     *
+     * Where overlay() is all-or-nothing, this may take just some of the elements;
+     * they are shown above the image passed to set_next_image(), so an element is
+     * only taken if everything above it that it overlaps is taken too.
+     *
+     * If an element is taken, and nothing left for compositing has changed since
+     * the previous frame, the caller may skip set_next_image(); the image last set
+     * is shown again beneath the planes.
+     *
+     *  \param [in] renderlist
+     *      The elements that should appear on screen, bottom to top. Elements
+     *      with a null buffer cannot be placed on planes.
+     *  \returns
+     *      For each element of renderlist, whether it has been taken. The caller
+     *      composites the others (in order) for set_next_image(). An empty
+     *      result, as from platforms without overlay planes, means none were.
+    **/
+    virtual auto overlay_where_possible(std::vector<DisplayElement> const& /*renderlist*/) -> std::vector<bool>
+    {
+        return {};
+    }
+
     /**
      * Set the content for the next submission of this display
      *
@@ -96,6 +126,36 @@ public:
      */
     virtual glm::mat2 transformation() const = 0;
 
+    /**
+     * How the most recently posted frame was presented
+     *
+     * Called after the DisplaySyncGroup containing this sink has been posted.
+     * Platforms that learn when (and how) their frames reach the screen
+     * report that here; the default is that nothing is known, in which case
+     * the compositor assumes the frame was presented as post() returned.
+     */
+    virtual auto last_presentation() const -> std::optional<FramePresentation>
+    {
+        return std::nullopt;
+    }
+
+    /**
+     * The buffers this sink could show directly, on its primary or overlay planes
+     *
+     * Clients are told these formats for surfaces that are candidates for direct
+     * scanout, so they can allocate buffers that overlay() will accept. The default,
+     * for sinks that can't scan out client buffers, is none.
+     *
+     * \note   Only the atomic-kms platform reports formats. gbm-kms sinks keep the
+     *          default: they offer no DmaBufDisplayAllocator, so client buffers never
+     *          reach overlay() there, and advertising formats would only have clients
+     *          reallocate for nothing.
+     */
+    virtual auto scanout_formats() const -> std::optional<ScanoutFormats>
+    {
+        return std::nullopt;
+    }
+
     /**
      * Attempt to acquire a platform-specific provider from this DisplaySink
      *
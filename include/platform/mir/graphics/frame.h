@@ -18,6 +18,7 @@
 #define MIR_GRAPHICS_FRAME_H_
 
 #include <mir/time/posix_timestamp.h>
+#include <chrono>
 #include <cstdint>
 
 namespace mir { namespace graphics {
@@ -40,6 +41,19 @@ struct Frame
     Timestamp ust;     /**< Unadjusted System Time */
 };
 
+/**
+ * How a frame reached the screen, as reported by the display hardware.
+ */
+struct FramePresentation
+{
+    Frame frame;                              /**< The vblank the frame was scanned out in */
+    std::chrono::nanoseconds refresh{0};      /**< Nominal refresh interval of the output; zero if unknown */
+    bool vsync{false};                        /**< The update was synchronised to the output's vertical retrace */
+    bool hw_clock{false};                     /**< frame.ust was taken by the display hardware */
+    bool hw_completion{false};                /**< The hardware signalled completion, rather than it being assumed */
+    bool zero_copy{false};                    /**< Client buffers were scanned out directly, without compositing */
+};
+
 }} // namespace mir::graphics
 
 #endif // MIR_GRAPHICS_FRAME_H_
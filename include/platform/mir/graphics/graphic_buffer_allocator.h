@@ -18,10 +18,12 @@
 #define MIR_GRAPHICS_GRAPHIC_BUFFER_ALLOCATOR_H_
 
 #include <mir/graphics/buffer.h>
+#include <mir/geometry/rectangles.h>
 
 #include <vector>
 #include <memory>
 #include <functional>
+#include <optional>
 
 struct wl_display;
 struct wl_resource;
@@ -37,6 +39,7 @@ class RWMappable;
 
 namespace graphics
 {
+class SurfaceScanoutHints;
 
 /**
  * Interface to graphic buffer allocation.
@@ -68,8 +71,13 @@ public:
      *
      * \param display [in]          The Wayland display to initialise on
      * \param wayland_executor [in] An Executor that spawns tasks on the event loop of display.
+     * \param scanout_hints [in]    Which formats surfaces could be scanned out in, for
+     *                              allocators that tell clients (as linux-dmabuf feedback does)
      */
-    virtual void bind_display(wl_display* display, std::shared_ptr<Executor> wayland_executor) = 0;
+    virtual void bind_display(
+        wl_display* display,
+        std::shared_ptr<Executor> wayland_executor,
+        std::shared_ptr<SurfaceScanoutHints> scanout_hints) = 0;
 
     /**
      * Deinitialise the BufferAllocator for this Wayland display
@@ -91,6 +99,25 @@ public:
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> = 0;
 
+    /**
+     * Create a buffer for SHM content that replaces the content of \p previous
+     *
+     * Only \p damage is guaranteed to differ from \p previous, which allows implementations
+     * to reuse resources of the previous buffer and only upload the changed areas.
+     *
+     * \param previous [in]    The buffer this replaces; may be null
+     * \param damage [in]      The changed area, in buffer coordinates, or std::nullopt if unknown
+     */
+    virtual auto buffer_from_shm_update(
+        std::shared_ptr<renderer::software::RWMappable> shm_data,
+        std::shared_ptr<Buffer> const& /*previous*/,
+        std::optional<geometry::Rectangles> const& /*damage*/,
+        std::function<void()>&& on_consumed,
+        std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
+    {
+        return buffer_from_shm(std::move(shm_data), std::move(on_consumed), std::move(on_release));
+    }
+
 protected:
     GraphicBufferAllocator() = default;
     GraphicBufferAllocator(const GraphicBufferAllocator&) = delete;
@@ -51,6 +51,7 @@ class EGLContextExecutor;
 }
 
 class DmaBufFormatDescriptors;
+class SurfaceScanoutHints;
 class DMABufBuffer;
 class EGLBufferCopier;
 
@@ -103,9 +104,14 @@ private:
 class LinuxDmaBuf : public mir::wayland::LinuxDmabufV1::Global
 {
 public:
+    /**
+     * \param scanout_hints [in] If not null, surface feedback also prefers the formats each
+     *                          surface could be scanned out in
+     */
     LinuxDmaBuf(
         wl_display* display,
-        std::shared_ptr<DMABufEGLProvider> provider);
+        std::shared_ptr<DMABufEGLProvider> provider,
+        std::shared_ptr<SurfaceScanoutHints> scanout_hints);
 
     auto buffer_from_resource(
         wl_resource* buffer,
@@ -118,6 +124,7 @@ private:
     void bind(wl_resource* new_resource) override;
 
     std::shared_ptr<DMABufEGLProvider> const provider;
+    std::shared_ptr<SurfaceScanoutHints> const scanout_hints;
 };
 
 }
@@ -395,6 +395,17 @@ public:
         virtual ~MappableFB() override = default;
 
         using renderer::software::WriteMappable::size;
+
+        /**
+         * How many frames ago this framebuffer's content was drawn, with the semantics of EGL_EXT_buffer_age
+         *
+         * Allocators that recycle framebuffers can report this so that only what has changed since
+         * needs to be written. 0 means the content is undefined.
+         */
+        virtual auto buffer_age() const -> int
+        {
+            return 0;
+        }
     };
 
     virtual auto supported_formats() const
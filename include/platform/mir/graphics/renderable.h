@@ -23,6 +23,7 @@
 #include <vector>
 
 #include <mir/geometry/rectangles.h>
+#include <mir/graphics/buffer_id.h>
 #include <mir_toolkit/common.h>
 
 namespace mir
@@ -104,6 +105,27 @@ public:
      */
     virtual auto opaque_region() const -> std::optional<geometry::Rectangles> = 0;
 
+    /**
+     * Whether the content may be presented with tearing, to get it on screen sooner
+     *
+     * This is the client's hint; it is only honoured when the content is shown directly
+     * (without compositing).
+     */
+    virtual auto allows_tearing() const -> bool { return false; }
+
+    /**
+     * The area that differs from when this renderable showed the buffer with ID \a previous
+     *
+     * This is in the same coordinates as #screen_position, and #transformation is not applied.
+     *
+     * \returns std::nullopt if that isn't known, in which case the whole of #screen_position
+     *          must be assumed to differ
+     */
+    virtual auto damage_since(BufferID /*previous*/) const -> std::optional<geometry::Rectangles>
+    {
+        return std::nullopt;
+    }
+
 protected:
     Renderable() = default;
     Renderable(Renderable const&) = delete;
@@ -0,0 +1,74 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_SCANOUT_FORMATS_H_
+#define MIR_GRAPHICS_SCANOUT_FORMATS_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+
+struct wl_resource;
+
+namespace mir
+{
+namespace graphics
+{
+/// The buffers a display can show directly, without compositing them first
+struct ScanoutFormats
+{
+    dev_t device;                                       //< The display device
+    std::vector<std::pair<uint32_t, uint64_t>> formats; //< Supported {DRM format, modifier} pairs
+
+    auto operator==(ScanoutFormats const&) const -> bool = default;
+};
+
+/**
+ * Which buffers would let the content of a Wayland surface be scanned out directly
+ *
+ * A surface only has scanout formats while it is a candidate for direct scanout: while it
+ * covers an output, or could be shown on an overlay plane.
+ *
+ * Threadsafety: This should only be accessed from the Wayland thread
+ */
+class SurfaceScanoutHints
+{
+public:
+    using Listener = std::function<void(std::optional<ScanoutFormats> const& formats)>;
+
+    virtual ~SurfaceScanoutHints() = default;
+
+    /**
+     * Call \a listener with the scanout formats of the wl_surface \a surface, now and whenever they change
+     *
+     * The listener is called (on the Wayland thread) until it expires or the surface is destroyed.
+     */
+    virtual void register_listener(wl_resource* surface, std::weak_ptr<Listener> const& listener) = 0;
+
+protected:
+    SurfaceScanoutHints() = default;
+    SurfaceScanoutHints(SurfaceScanoutHints const&) = delete;
+    SurfaceScanoutHints& operator=(SurfaceScanoutHints const&) = delete;
+};
+}
+}
+
+#endif // MIR_GRAPHICS_SCANOUT_FORMATS_H_
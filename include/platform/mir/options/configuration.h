@@ -32,6 +32,7 @@ extern char const* const enable_input_opt;
 extern char const* const shared_library_prober_report_opt;
 extern char const* const shell_report_opt;
 extern char const* const compositor_report_opt;
+extern char const* const compositor_timings_file_opt;
 extern char const* const display_report_opt;
 extern char const* const scene_report_opt;
 extern char const* const input_report_opt;
@@ -41,6 +42,8 @@ extern char const* const cursor_opt;
 extern char const* const fatal_except_opt;
 extern char const* const debug_opt;
 extern char const* const composite_delay_opt;
+extern char const* const renderer_opt;
+extern char const* const deferred_output_readback_opt;
 extern char const* const x11_display_opt;
 extern char const* const x11_scale_opt;
 extern char const* const wayland_extensions_opt;
@@ -50,6 +53,8 @@ extern char const* const idle_timeout_opt;
 extern char const* const idle_timeout_when_locked_opt;
 
 extern char const* const enable_key_repeat_opt;
+extern char const* const coalesce_pointer_motion_opt;
+extern char const* const keymap_cache_dir_opt;
 
 extern char const* const off_opt_value;
 extern char const* const log_opt_value;
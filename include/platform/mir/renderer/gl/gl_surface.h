@@ -18,7 +18,9 @@
 #define MIR_RENDERER_GL_SURFACE_H_
 
 #include <mir/geometry/size.h>
+#include <mir/geometry/rectangle.h>
 #include <memory>
+#include <optional>
 
 namespace mir
 {
@@ -51,6 +53,51 @@ public:
         GL = BottomRowFirst     //< GL texture layout is in decreasing-y order.
     };
     virtual auto layout() const -> Layout = 0;
+
+    /**
+     * Age, in frames, of the contents of the buffer that will next be rendered into
+     *
+     * This has the semantics of EGL_EXT_buffer_age: 0 means the contents are undefined
+     * and everything must be redrawn, while N means the buffer still holds the frame
+     * that was committed N frames ago.
+     *
+     * \note Must be called with the surface current
+     */
+    virtual auto buffer_age() const -> int
+    {
+        return 0;
+    }
+
+    /**
+     * The area of the buffer changed by the frame about to be committed
+     *
+     * Like EGL_KHR_swap_buffers_with_damage this lets surfaces that copy their content
+     * elsewhere copy only what has changed. \a damage is in GL framebuffer coördinates;
+     * std::nullopt means anything may have changed.
+     *
+     * \note Must be called with the surface current, before commit()
+     */
+    virtual void set_damage(std::optional<geometry::Rectangle> const& /*damage*/)
+    {
+    }
+
+    /**
+     * Whether a frame rendered into this surface has yet to be returned by commit()
+     *
+     * A surface may return each frame from the commit() *after* the one that completed it,
+     * overlapping the work of getting one frame to the display with rendering the next.
+     * Such a surface needs another commit() to show the last frame rendered, even if
+     * nothing has changed since.
+     */
+    virtual auto has_pending_frame() const -> bool
+    {
+        return false;
+    }
+
+    /// Drop any pending frame; the next commit() returns the frame rendered for it
+    virtual void discard_pending_frame()
+    {
+    }
 };
 }
 }
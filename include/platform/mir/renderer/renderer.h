@@ -22,6 +22,8 @@
 #include <mir_toolkit/common.h>
 #include <glm/glm.hpp>
 
+#include <chrono>
+
 namespace mir
 {
 namespace graphics
@@ -44,6 +46,17 @@ public:
     virtual auto render(graphics::RenderableList const&) const -> std::unique_ptr<graphics::Framebuffer> = 0;
     virtual void suspend() = 0; // called when render() is skipped
 
+    /// Whether render() needs calling again to display the last frame rendered, even if nothing has changed
+    virtual auto has_pending_frame() const -> bool { return false; }
+
+    /// How long parts of the last render() took (as seen by the CPU), for reporting
+    struct Timings
+    {
+        std::chrono::nanoseconds texture_upload{0};     ///< Importing or uploading the renderables' buffers
+        std::chrono::nanoseconds commit{0};             ///< Finishing the frame (e.g. swapping or copying out)
+    };
+    virtual auto last_render_timings() const -> Timings { return {}; }
+
 protected:
     Renderer() = default;
     Renderer(const Renderer&) = delete;
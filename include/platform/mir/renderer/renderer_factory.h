@@ -17,6 +17,8 @@
 #ifndef MIR_RENDERER_RENDERER_FACTORY_H_
 #define MIR_RENDERER_RENDERER_FACTORY_H_
 
+#include <mir/renderer/renderer.h>
+
 #include <memory>
 
 namespace mir
@@ -24,6 +26,7 @@ namespace mir
 namespace graphics
 {
 class GLRenderingProvider;
+class DisplaySink;
 namespace gl
 {
 class OutputSurface;
@@ -36,8 +39,6 @@ namespace gl
 class RenderTarget;
 }
 
-class Renderer;
-
 class RendererFactory
 {
 public:
@@ -47,6 +48,18 @@ public:
         std::unique_ptr<graphics::gl::OutputSurface> output_surface,
         std::shared_ptr<graphics::GLRenderingProvider> gl_provider) const -> std::unique_ptr<Renderer> = 0;
 
+    /**
+     * Create a renderer that draws directly into CPU-addressable buffers of \a sink, without GL
+     *
+     * \returns    The renderer, or nullptr if this factory's renderers need a GL output surface or
+     *             \a sink does not provide CPU-addressable buffers. In that case create_renderer_for()
+     *             is used instead.
+     */
+    virtual auto create_software_renderer_for(graphics::DisplaySink& /*sink*/) const -> std::unique_ptr<Renderer>
+    {
+        return nullptr;
+    }
+
 protected:
     RendererFactory() = default;
     RendererFactory(RendererFactory const&) = delete;
@@ -52,6 +52,9 @@ public:
     // This is called _without_ a GL context:
     void suspend() override;
 
+    auto has_pending_frame() const -> bool override;
+    auto last_render_timings() const -> Timings override;
+
     struct Program
     {
         GLuint id = 0;
@@ -106,6 +109,10 @@ protected:
 private:
     void update_gl_viewport();
 
+    /// Tracks what changed between frames, so unchanged areas of the output need not be redrawn
+    class DamageTracker;
+    std::unique_ptr<DamageTracker> const damage_tracker;
+
     class ProgramFactory;
     std::unique_ptr<ProgramFactory> program_factory;
     geometry::Rectangle viewport;
@@ -113,6 +120,7 @@ private:
     glm::mat4 display_transform;
     std::vector<mir::gl::Primitive> mutable primitives;
     std::shared_ptr<graphics::GLRenderingProvider> const gl_interface;
+    Timings mutable timings;
 };
 
 }
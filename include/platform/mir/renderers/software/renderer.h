@@ -0,0 +1,100 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_SOFTWARE_RENDERER_H_
+#define MIR_RENDERER_SOFTWARE_RENDERER_H_
+
+#include <mir/renderer/renderer.h>
+#include <mir/geometry/rectangle.h>
+#include <mir/graphics/drm_formats.h>
+
+#include <glm/glm.hpp>
+#include <deque>
+#include <memory>
+
+namespace mir
+{
+namespace graphics { class CPUAddressableDisplayAllocator; }
+namespace renderer
+{
+class DamageTracker;
+
+namespace software
+{
+/**
+ * A renderer that composites on the CPU, without GL
+ *
+ * Client buffers are read through graphics::Buffer::map_readable() and blended, scaled and
+ * transformed with pixman (which uses SSE2/SSSE3/NEON where available) into a shadow of the
+ * output. Only the areas of the shadow that changed since the previous frame are repainted;
+ * each frame is then copied into a buffer from \a allocator for display. Where the allocator
+ * recycles its buffers (see MappableFB::buffer_age()) only what changed since the buffer last
+ * held a frame is copied.
+ *
+ * Buffers that cannot be mapped (such as those only accessible to a GPU) are not drawn.
+ */
+class Renderer : public renderer::Renderer
+{
+public:
+    explicit Renderer(graphics::CPUAddressableDisplayAllocator& allocator);
+    ~Renderer() override;
+
+    void set_viewport(geometry::Rectangle const& rect) override;
+    void set_output_transform(glm::mat2 const&) override;
+    void set_output_filter(MirOutputFilter filter) override;
+    auto render(graphics::RenderableList const&) const -> std::unique_ptr<graphics::Framebuffer> override;
+    void suspend() override;
+    auto last_render_timings() const -> Timings override;
+
+private:
+    void update_output_mapping();
+    void draw(graphics::Renderable const& renderable, geometry::Rectangle const& repaint) const;
+
+    /// The output area, in pixels, covered by the logical area \a area
+    auto output_area(geometry::Rectangle const& area) const -> geometry::Rectangle;
+
+    /// The output area, in pixels, that differs between the shadow and a framebuffer of age \a buffer_age
+    auto stale_area(int buffer_age) const -> geometry::Rectangle;
+
+    graphics::CPUAddressableDisplayAllocator& allocator;
+    graphics::DRMFormat const format;
+
+    /// The composited output, kept between frames so that only damaged areas need repainting
+    class Shadow;
+    std::unique_ptr<Shadow> const shadow;
+    std::unique_ptr<DamageTracker> const damage_tracker;
+
+    /// Framebuffer ages beyond this are treated as unknown
+    static size_t constexpr max_tracked_age = 4;
+    /// The areas of the shadow, in pixels, repainted by recent frames (most recent first)
+    std::deque<geometry::Rectangle> mutable repainted;
+
+    geometry::Rectangle viewport;
+    glm::mat2 output_transform{1};
+    MirOutputFilter filter{mir_output_filter_none};
+    /// Set when the filter changes, as every framebuffer then needs all of the next frame
+    bool mutable filter_changed{false};
+
+    /// Maps logical coordinates to output pixels, including output transform and letterboxing
+    glm::dmat3 logical_to_output{1};
+
+    Timings mutable timings;
+};
+}
+}
+}
+
+#endif // MIR_RENDERER_SOFTWARE_RENDERER_H_
@@ -15,6 +15,7 @@
  */
 
 #include <mir/events/event_builders.h>
+#include "event_pool.h"
 
 #include <mir/events/event_private.h>
 #include <mir/events/window_placement_event.h>
@@ -24,6 +25,7 @@
 
 #include <algorithm>
 #include <stdexcept>
+#include <typeinfo>
 
 namespace mi = mir::input;
 namespace mf = mir::frontend;
@@ -33,16 +35,38 @@ namespace geom = mir::geometry;
 namespace
 {
 
+// Events are made in storage from the event pool, to keep the heap out of the input path
 template<typename Type, typename... Args>
 auto new_event(Args&&... args) -> Type*
 {
-    return new Type(std::forward<Args>(args)...);
+    auto const storage = mev::event_pool::allocate(sizeof(Type));
+    try
+    {
+        return new (storage) Type(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        mev::event_pool::deallocate(storage, sizeof(Type));
+        throw;
+    }
 }
 
+/// Take ownership of an event from new_event<T>()
 template <class T>
 mir::EventUPtr make_uptr_event(T* e)
 {
-    return mir::EventUPtr(e, ([](MirEvent* e) { delete reinterpret_cast<T*>(e); }));
+    return mir::EventUPtr(e, ([](MirEvent* e)
+        {
+            auto const event = static_cast<T*>(e);
+            event->~T();
+            mev::event_pool::deallocate(event, sizeof(T));
+        }));
+}
+
+/// Take ownership of an event from the heap (e.g. from MirEvent::clone())
+mir::EventUPtr make_uptr_heap_event(MirEvent* e)
+{
+    return mir::EventUPtr(e, ([](MirEvent* e) { delete e; }));
 }
 }
 
@@ -247,7 +271,7 @@ mir::EventUPtr mev::make_pointer_event(
     events::ScrollAxisV1H h_scroll,
     events::ScrollAxisV1V v_scroll)
 {
-    return make_uptr_event(new MirPointerEvent(
+    return make_uptr_event(new_event<MirPointerEvent>(
         device_id,
         timestamp,
         mods,
@@ -372,7 +396,34 @@ mir::EventUPtr mev::make_input_configure_event(
 
 mir::EventUPtr mev::clone_event(MirEvent const& event)
 {
-    return make_uptr_event(event.clone());
+    // Input events are cloned for each surface they're delivered to, so are worth keeping off the heap
+    auto const& type = typeid(event);
+    if (type == typeid(MirPointerEvent))
+    {
+        return make_uptr_event(new_event<MirPointerEvent>(static_cast<MirPointerEvent const&>(event)));
+    }
+    if (type == typeid(MirKeyboardEvent))
+    {
+        return make_uptr_event(new_event<MirKeyboardEvent>(static_cast<MirKeyboardEvent const&>(event)));
+    }
+    if (type == typeid(MirTouchEvent))
+    {
+        return make_uptr_event(new_event<MirTouchEvent>(static_cast<MirTouchEvent const&>(event)));
+    }
+
+    return make_uptr_heap_event(event.clone());
+}
+
+auto mev::share_event(EventUPtr&& event) -> std::shared_ptr<MirEvent>
+{
+    if (!event)
+    {
+        return {};
+    }
+
+    // Construct the control block in pooled storage too, rather than let std::shared_ptr allocate it
+    auto const deleter = event.get_deleter();
+    return std::shared_ptr<MirEvent>{event.release(), deleter, event_pool::Allocator<MirEvent>{}};
 }
 
 void mev::transform_positions(MirEvent& event, mir::geometry::Displacement const& movement)
@@ -0,0 +1,106 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "event_pool.h"
+
+#include <array>
+#include <mutex>
+#include <new>
+
+namespace mev = mir::events;
+
+namespace
+{
+/// Storage is pooled in size classes of this granularity...
+std::size_t const granularity{64};
+/// ...up to this size; larger objects go to the heap
+std::size_t const max_pooled_size{512};
+/// Beyond this many free blocks in a size class, released storage goes back to the heap
+std::size_t const max_free_blocks{1024};
+
+struct FreeBlock
+{
+    FreeBlock* next;
+};
+
+struct FreeList
+{
+    std::mutex mutex;
+    FreeBlock* head{nullptr};
+    std::size_t length{0};
+};
+
+auto size_class_of(std::size_t size) -> std::size_t
+{
+    return (size + granularity - 1) / granularity - 1;
+}
+
+auto free_lists() -> std::array<FreeList, max_pooled_size/granularity>&
+{
+    // Deliberately never destroyed: events can be released during static destruction
+    static auto const lists = new std::array<FreeList, max_pooled_size/granularity>;
+    return *lists;
+}
+}
+
+auto mev::event_pool::allocate(std::size_t size) -> void*
+{
+    if (size == 0 || size > max_pooled_size)
+    {
+        return ::operator new(size);
+    }
+
+    auto const size_class = size_class_of(size);
+    auto& list = free_lists()[size_class];
+    {
+        std::lock_guard lock{list.mutex};
+        if (auto const block = list.head)
+        {
+            list.head = block->next;
+            --list.length;
+            return block;
+        }
+    }
+
+    return ::operator new((size_class + 1) * granularity);
+}
+
+void mev::event_pool::deallocate(void* storage, std::size_t size) noexcept
+{
+    if (!storage)
+    {
+        return;
+    }
+
+    if (size == 0 || size > max_pooled_size)
+    {
+        ::operator delete(storage);
+        return;
+    }
+
+    auto& list = free_lists()[size_class_of(size)];
+    {
+        std::lock_guard lock{list.mutex};
+        if (list.length < max_free_blocks)
+        {
+            list.head = new (storage) FreeBlock{list.head};
+            ++list.length;
+            return;
+        }
+    }
+
+    ::operator delete(storage);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_EVENTS_EVENT_POOL_H_
+#define MIR_EVENTS_EVENT_POOL_H_
+
+#include <cstddef>
+
+namespace mir
+{
+namespace events
+{
+/**
+ * Recycles the storage of events
+ *
+ * Input events are made and destroyed at the rate of the input devices (1000Hz, or more, for some mice), and each
+ * is cloned for delivery to its surface. Rather than go to the heap each time the storage is kept on free lists,
+ * so that the input path allocates nothing once it has warmed up.
+ *
+ * Threadsafety: storage may be allocated and deallocated on any thread (events are typically released on a
+ * different thread to the one that made them).
+ */
+namespace event_pool
+{
+/// Storage for an object of \a size bytes, aligned as ::operator new(size) would be
+auto allocate(std::size_t size) -> void*;
+
+/// Return storage obtained from allocate(\a size)
+void deallocate(void* storage, std::size_t size) noexcept;
+
+/// Allocates from the pool: intended for the control blocks of std::shared_ptr<MirEvent>
+template<typename T>
+struct Allocator
+{
+    using value_type = T;
+
+    Allocator() = default;
+    template<typename U>
+    Allocator(Allocator<U> const&) noexcept {}
+
+    auto allocate(std::size_t n) -> T* { return static_cast<T*>(event_pool::allocate(n * sizeof(T))); }
+    void deallocate(T* p, std::size_t n) noexcept { event_pool::deallocate(p, n * sizeof(T)); }
+
+    template<typename U>
+    auto operator==(Allocator<U> const&) const noexcept -> bool { return true; }
+};
+}
+}
+}
+
+#endif // MIR_EVENTS_EVENT_POOL_H_
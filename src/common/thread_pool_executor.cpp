@@ -19,16 +19,29 @@
 
 #include <mir/thread_name.h>
 
-#include <thread>
-#include <memory>
+#include <algorithm>
 #include <atomic>
-#include <list>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
 
 namespace
 {
+using namespace std::chrono_literals;
+
+/// The number of idle threads DedicatedThreads keeps ready for new work
 constexpr int const min_threadpool_threads = 4;
 
+/// How long the WorkStealingPool waits for a worker to become free before concluding they are all blocked
+constexpr auto const stall_timeout = 10ms;
+
 /* We use an atomic void(*)() rather than a std::function to avoid needing to take a mutex
  * in exception context, as taking a mutex can itself throw an exception!
  */
@@ -137,19 +150,19 @@ private:
 };
 
 /**
- * A self-managing ThreadPool
+ * A self-managing pool of threads for work that runs for a long time, or blocks
  *
  * Theory of operation:
- * The ThreadPool executes each item of work on an independent thread; each call to spawn() is
+ * The DedicatedThreads executes each item of work on an independent thread; each call to spawn() is
  * guaranteed to be on a different thread to the caller.
  *
- * To reduce the overhead of spawning threads, the ThreadPool attempts to maintain
+ * To reduce the overhead of spawning threads, the DedicatedThreads attempts to maintain
  * min_threadpool_threads of free worker threads.
  *
- * The ThreadPool maintains two linked-lists of Worker threads; a list of all Workers, and a list of
+ * The DedicatedThreads maintains two linked-lists of Worker threads; a list of all Workers, and a list of
  * (Worker, position-in-all-workers-list) containing idle Worker threads.
  *
- * When a work item is received through spawn() the ThreadPool first checks to see if there's a
+ * When a work item is received through spawn() the DedicatedThreads first checks to see if there's a
  * free Worker thread in the idle list; if so, it takes it off the free list and dispatches the work.
  * If there are no free Workers, it creates a new Worker, adds it to the all-workers list, and dispatches
  * the work to the new Worker.
@@ -158,14 +171,14 @@ private:
  * min_threadpool_threads in the free list, the Worker is added to the free list. Otherwise, the
  * Worker is removed from the all-workers list and is destroyed.
  */
-class ThreadPool : public mir::NonBlockingExecutor
+class DedicatedThreads : public mir::NonBlockingExecutor
 {
 public:
-    ThreadPool() noexcept
+    DedicatedThreads() noexcept
     {
     }
 
-    ~ThreadPool() noexcept
+    ~DedicatedThreads() noexcept
     {
         wait_for_idle();
     }
@@ -179,7 +192,7 @@ public:
         num_workers_free = 0;
     }
 
-    void spawn(std::function<void()>&& work)
+    void spawn(std::function<void()>&& work) override
     {
         WorkerHandle worker;
         {
@@ -262,11 +275,262 @@ private:
     std::list<std::shared_ptr<Worker>> workers;
 };
 
-ThreadPool thread_pool;
+/// The index of the WorkStealingPool worker running on this thread, if any
+thread_local std::optional<size_t> this_worker;
+
+/**
+ * A fixed number of threads (one per core) sharing short items of work
+ *
+ * Theory of operation:
+ * Each worker has a queue of its own. Work spawned from a worker goes on that worker's queue;
+ * work spawned from any other thread goes on a shared queue. An idle worker takes work from
+ * its own queue first, then from the shared queue, and finally steals from the other workers'
+ * queues. Each call to spawn() is still guaranteed to be on a different thread to the caller.
+ *
+ * Work on this executor is expected to be short, but some of it blocks (for example, waiting for
+ * other work to complete). So that can't deadlock the pool, a supervisor thread watches for all
+ * of the workers being busy: if no worker starts any work within stall_timeout, it assumes they
+ * are blocked and moves the oldest queued work onto a thread of its own (from `overflow`). The
+ * number of threads is therefore bounded unless the work itself blocks.
+ */
+class WorkStealingPool : public mir::NonBlockingExecutor
+{
+public:
+    explicit WorkStealingPool(DedicatedThreads& overflow) noexcept
+        : overflow{overflow},
+          queues(std::max(2u, std::thread::hardware_concurrency()))
+    {
+    }
+
+    ~WorkStealingPool() noexcept
+    {
+        quiesce();
+    }
+
+    void quiesce()
+    {
+        std::vector<std::thread> to_join;
+        {
+            std::unique_lock lock{mutex};
+            idle.wait(lock, [this] { return outstanding == 0; });
+
+            stopping = true;
+            to_join = std::move(threads);
+            threads.clear();
+        }
+        work_available.notify_all();
+        supervisor_wake.notify_all();
+
+        for (auto& thread : to_join)
+        {
+            thread.join();
+        }
+
+        std::lock_guard lock{mutex};
+        stopping = false;
+        started = false;
+    }
+
+    void spawn(std::function<void()>&& work) override
+    {
+        ensure_started();
+
+        ++outstanding;
+        auto& queue = this_worker ? queues[*this_worker] : shared_queue;
+        {
+            std::lock_guard lock{queue.mutex};
+            queue.work.push_back(std::move(work));
+        }
+        ++queued;
+
+        // Wake a worker, or if none is idle let the supervisor know they may all be blocked
+        if (sleeping > 0)
+        {
+            { std::lock_guard lock{mutex}; }
+            work_available.notify_one();
+        }
+        else if (busy == static_cast<int>(queues.size()))
+        {
+            { std::lock_guard lock{mutex}; }
+            supervisor_wake.notify_one();
+        }
+    }
+
+    auto statistics() const -> mir::ThreadPoolExecutor::Statistics
+    {
+        return {static_cast<int>(queues.size()), queued, executed, stolen, offloaded};
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> work;
+
+        auto take() -> std::optional<std::function<void()>>
+        {
+            std::lock_guard lock{mutex};
+            if (work.empty())
+            {
+                return std::nullopt;
+            }
+            auto next = std::move(work.front());
+            work.pop_front();
+            return next;
+        }
+    };
+
+    void ensure_started()
+    {
+        if (started)
+        {
+            return;
+        }
+
+        std::lock_guard lock{mutex};
+        if (!started)
+        {
+            for (auto i = 0u; i != queues.size(); ++i)
+            {
+                threads.emplace_back([this, i] { work_loop(i); });
+            }
+            threads.emplace_back([this] { supervise(); });
+            started = true;
+        }
+    }
+
+    /// Take the oldest work from \a worker's queue, the shared queue or (stealing) another worker's queue
+    auto take_for(std::optional<size_t> worker) -> std::optional<std::function<void()>>
+    {
+        auto next = worker ? queues[*worker].take() : std::nullopt;
+        if (!next)
+        {
+            next = shared_queue.take();
+        }
+        for (auto i = 0u; !next && i != queues.size(); ++i)
+        {
+            auto const victim = (worker.value_or(0) + i + 1) % queues.size();
+            if ((next = queues[victim].take()) && worker)
+            {
+                ++stolen;
+            }
+        }
+
+        if (next)
+        {
+            --queued;
+        }
+        return next;
+    }
+
+    void run(std::function<void()>&& work)
+    {
+        ++begun;
+        try
+        {
+            work();
+        }
+        catch (...)
+        {
+            (*exception_handler)();
+        }
+        // Destroy anything the work holds before reporting it done
+        work = nullptr;
+        ++executed;
+
+        if (--outstanding == 0)
+        {
+            { std::lock_guard lock{mutex}; }
+            idle.notify_all();
+        }
+    }
+
+    void work_loop(size_t index)
+    {
+        mir::set_thread_name("Mir/Workqueue");
+        this_worker = index;
+
+        std::unique_lock lock{mutex};
+        while (!stopping)
+        {
+            lock.unlock();
+            while (auto work = take_for(index))
+            {
+                if (++busy == static_cast<int>(queues.size()) && queued > 0)
+                {
+                    { std::lock_guard wake_lock{mutex}; }
+                    supervisor_wake.notify_one();
+                }
+                run(std::move(*work));
+                --busy;
+            }
+            lock.lock();
+
+            ++sleeping;
+            work_available.wait(lock, [this] { return queued > 0 || stopping; });
+            --sleeping;
+        }
+    }
+
+    void supervise()
+    {
+        mir::set_thread_name("Mir/Workqueue");
+
+        std::unique_lock lock{mutex};
+        while (!stopping)
+        {
+            if (busy < static_cast<int>(queues.size()) || queued == 0)
+            {
+                supervisor_wake.wait(lock);
+                continue;
+            }
+
+            auto const begun_before = begun.load();
+            supervisor_wake.wait_for(lock, stall_timeout, [this] { return stopping; });
+
+            if (!stopping && queued > 0 && begun == begun_before)
+            {
+                lock.unlock();
+                if (auto work = take_for(std::nullopt))
+                {
+                    ++offloaded;
+                    overflow.spawn([this, work = std::move(*work)]() mutable { run(std::move(work)); });
+                }
+                lock.lock();
+            }
+        }
+    }
+
+    DedicatedThreads& overflow;
+
+    std::vector<Queue> queues;
+    Queue shared_queue;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable supervisor_wake;
+    std::condition_variable idle;
+    std::vector<std::thread> threads;
+    std::atomic<bool> started{false};
+    bool stopping{false};
+
+    std::atomic<int> sleeping{0};
+    std::atomic<int> busy{0};
+    std::atomic<size_t> outstanding{0};
+    std::atomic<size_t> queued{0};
+    std::atomic<uint64_t> begun{0};
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> stolen{0};
+    std::atomic<uint64_t> offloaded{0};
+};
+
+DedicatedThreads dedicated_threads;
+WorkStealingPool thread_pool{dedicated_threads};
 
 }
 
 mir::NonBlockingExecutor& mir::thread_pool_executor = thread_pool;
+mir::NonBlockingExecutor& mir::long_running_executor = dedicated_threads;
 
 void mir::ThreadPoolExecutor::spawn(std::function<void()>&& work)
 {
@@ -281,4 +545,10 @@ void mir::ThreadPoolExecutor::set_unhandled_exception_handler(void (*handler)())
 void mir::ThreadPoolExecutor::quiesce()
 {
     thread_pool.quiesce();
+    dedicated_threads.quiesce();
+}
+
+auto mir::ThreadPoolExecutor::statistics() -> Statistics
+{
+    return thread_pool.statistics();
 }
@@ -0,0 +1,313 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <mir/geometry/region.h>
+#include <mir/geometry/rectangles.h>
+
+#include <algorithm>
+#include <ostream>
+#include <span>
+#include <utility>
+
+namespace geom = mir::geometry;
+
+namespace
+{
+/// A horizontal extent [first, second)
+using Span = std::pair<int, int>;
+
+/// The (merged) horizontal extents of the rectangles that cover the band [top, bottom)
+void spans_in_band(std::span<geom::Rectangle const> rects, int top, int bottom, std::vector<Span>& spans)
+{
+    spans.clear();
+    for (auto const& rect : rects)
+    {
+        if (rect.top().as_int() <= top && bottom <= rect.bottom().as_int() && rect.size.width > geom::Width{0})
+        {
+            spans.emplace_back(rect.left().as_int(), rect.right().as_int());
+        }
+    }
+
+    std::sort(spans.begin(), spans.end());
+
+    auto merged = spans.begin();
+    for (auto span = spans.begin(); span != spans.end(); ++span)
+    {
+        if (merged != span && span->first <= merged->second)
+        {
+            merged->second = std::max(merged->second, span->second);
+        }
+        else if (merged != span)
+        {
+            *++merged = *span;
+        }
+    }
+    if (!spans.empty())
+    {
+        spans.erase(std::next(merged), spans.end());
+    }
+}
+
+/// The extents of the points for which keep(in a, in b) is true
+template<typename Keep>
+void combine_spans(std::vector<Span> const& a, std::vector<Span> const& b, Keep keep, std::vector<Span>& result)
+{
+    static thread_local std::vector<int> edges;
+    edges.clear();
+    for (auto const& spans : {&a, &b})
+    {
+        for (auto const& [left, right] : *spans)
+        {
+            edges.push_back(left);
+            edges.push_back(right);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    result.clear();
+    auto next_a = a.begin();
+    auto next_b = b.begin();
+    for (size_t i = 1; i < edges.size(); ++i)
+    {
+        auto const left = edges[i - 1];
+        auto const right = edges[i];
+
+        while (next_a != a.end() && next_a->second <= left) ++next_a;
+        while (next_b != b.end() && next_b->second <= left) ++next_b;
+
+        bool const in_a = next_a != a.end() && next_a->first <= left;
+        bool const in_b = next_b != b.end() && next_b->first <= left;
+
+        if (keep(in_a, in_b))
+        {
+            if (!result.empty() && result.back().second == left)
+            {
+                result.back().second = right;
+            }
+            else
+            {
+                result.emplace_back(left, right);
+            }
+        }
+    }
+}
+
+/**
+ * Sweep the bands of a and b, producing (in result) the canonical banded rectangles of the points
+ * where keep(in a, in b)
+ *
+ * Regions are combined for every surface on every frame, so the working storage is kept between calls.
+ */
+template<typename Keep>
+void combine(
+    std::span<geom::Rectangle const> a,
+    std::span<geom::Rectangle const> b,
+    Keep keep,
+    std::vector<geom::Rectangle>& result)
+{
+    static thread_local std::vector<int> edges;
+    static thread_local std::vector<Span> spans_a, spans_b, spans, previous_spans;
+
+    edges.clear();
+    for (auto const& rects : {a, b})
+    {
+        for (auto const& rect : rects)
+        {
+            if (rect.size.width > geom::Width{0} && rect.size.height > geom::Height{0})
+            {
+                edges.push_back(rect.top().as_int());
+                edges.push_back(rect.bottom().as_int());
+            }
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    result.clear();
+    previous_spans.clear();
+    size_t previous_band_start{0};
+    bool previous_band_adjoins{false};
+
+    for (size_t i = 1; i < edges.size(); ++i)
+    {
+        auto const top = edges[i - 1];
+        auto const bottom = edges[i];
+
+        spans_in_band(a, top, bottom, spans_a);
+        spans_in_band(b, top, bottom, spans_b);
+        combine_spans(spans_a, spans_b, keep, spans);
+
+        if (spans.empty())
+        {
+            previous_band_adjoins = false;
+            continue;
+        }
+
+        if (previous_band_adjoins && spans == previous_spans)
+        {
+            // Extend the band above, rather than start a new one
+            for (auto k = previous_band_start; k != result.size(); ++k)
+            {
+                result[k].size.height = geom::Height{bottom - result[k].top().as_int()};
+            }
+        }
+        else
+        {
+            previous_band_start = result.size();
+            for (auto const& [left, right] : spans)
+            {
+                result.push_back(geom::Rectangle{{left, top}, {right - left, bottom - top}});
+            }
+            std::swap(previous_spans, spans);
+        }
+        previous_band_adjoins = true;
+    }
+}
+
+/// Replace the rectangles of a region with the combination of them and other (reusing their storage)
+template<typename Keep>
+void combine_into(std::vector<geom::Rectangle>& bands, std::vector<geom::Rectangle> const& other, Keep keep)
+{
+    static thread_local std::vector<geom::Rectangle> result;
+    combine(bands, other, keep, result);
+    bands.assign(result.begin(), result.end());
+}
+
+auto in_either(bool in_a, bool in_b) -> bool { return in_a || in_b; }
+auto in_both(bool in_a, bool in_b) -> bool { return in_a && in_b; }
+auto in_first_only(bool in_a, bool in_b) -> bool { return in_a && !in_b; }
+}
+
+geom::Region::Region()
+{
+}
+
+geom::Region::Region(Rectangle const& rect)
+{
+    if (rect.size.width > Width{0} && rect.size.height > Height{0})
+    {
+        bands.push_back(rect);
+    }
+}
+
+geom::Region::Region(Rectangles const& rects)
+{
+    combine(std::span<Rectangle const>{rects.begin(), rects.end()}, {}, in_either, bands);
+}
+
+auto geom::Region::operator=(Rectangle const& rect) -> Region&
+{
+    bands.clear();
+    if (rect.size.width > Width{0} && rect.size.height > Height{0})
+    {
+        bands.push_back(rect);
+    }
+    return *this;
+}
+
+auto geom::Region::empty() const -> bool
+{
+    return bands.empty();
+}
+
+auto geom::Region::bounding_rectangle() const -> Rectangle
+{
+    if (bands.empty())
+    {
+        return {};
+    }
+
+    auto left = bands.front().left();
+    auto right = bands.front().right();
+    for (auto const& rect : bands)
+    {
+        left = std::min(left, rect.left());
+        right = std::max(right, rect.right());
+    }
+
+    auto const top = bands.front().top();
+    auto const bottom = bands.back().bottom();
+    return {{left, top}, {right.as_int() - left.as_int(), bottom.as_int() - top.as_int()}};
+}
+
+auto geom::Region::contains(Rectangle const& rect) const -> bool
+{
+    static thread_local std::vector<Rectangle> uncovered;
+    combine(std::span{&rect, 1}, bands, in_first_only, uncovered);
+    return uncovered.empty();
+}
+
+auto geom::Region::overlaps(Rectangle const& rect) const -> bool
+{
+    return std::any_of(bands.begin(), bands.end(), [&](auto const& band) { return band.overlaps(rect); });
+}
+
+void geom::Region::unite(Region const& other)
+{
+    combine_into(bands, other.bands, in_either);
+}
+
+void geom::Region::intersect(Region const& other)
+{
+    combine_into(bands, other.bands, in_both);
+}
+
+void geom::Region::subtract(Region const& other)
+{
+    combine_into(bands, other.bands, in_first_only);
+}
+
+auto geom::Region::rectangles() const -> std::vector<Rectangle> const&
+{
+    return bands;
+}
+
+auto geom::Region::operator==(Region const& other) const -> bool
+{
+    // The banded representation is canonical
+    return bands == other.bands;
+}
+
+auto geom::union_of(Region const& a, Region const& b) -> Region
+{
+    auto result = a;
+    result.unite(b);
+    return result;
+}
+
+auto geom::intersection_of(Region const& a, Region const& b) -> Region
+{
+    auto result = a;
+    result.intersect(b);
+    return result;
+}
+
+auto geom::difference_of(Region const& a, Region const& b) -> Region
+{
+    auto result = a;
+    result.subtract(b);
+    return result;
+}
+
+std::ostream& geom::operator<<(std::ostream& out, Region const& value)
+{
+    out << '[';
+    for (auto const& rect : value.rectangles())
+        out << rect << ", ";
+    out << ']';
+    return out;
+}
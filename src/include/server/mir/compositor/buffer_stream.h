@@ -19,12 +19,14 @@
 
 #include <mir/geometry/size.h>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <mir/frontend/buffer_stream.h>
 #include <mir/graphics/drm_formats.h>
 #include <mir_toolkit/common.h>
 #include <mir/graphics/buffer_id.h>
 
 #include <memory>
+#include <optional>
 
 namespace mir
 {
@@ -45,6 +47,10 @@ public:
 
     virtual auto next_submission_for_compositor(void const* user_id) -> std::shared_ptr<Submission> = 0;
     virtual auto has_submitted_buffer() const -> bool = 0;
+    /// A frame the compositor rendered from this stream is now on screen
+    virtual void frame_presented(graphics::FramePresentation const& presentation) = 0;
+    /// The client accepts tearing to get submissions from this stream on screen sooner
+    virtual auto tearing_allowed() const -> bool = 0;
 
     class Submission
     {
@@ -69,6 +75,17 @@ public:
          * Pixel format
          */
         virtual auto pixel_format() const -> graphics::DRMFormat = 0;
+
+        /**
+         * The area, within {{0, 0}, size()}, that differs from the buffer with ID \a previous
+         *
+         * \returns std::nullopt if that isn't known (e.g. \a previous isn't the buffer this one
+         *          replaced), in which case all of it must be assumed to differ
+         */
+        virtual auto damage_since(graphics::BufferID /*previous*/) const -> std::optional<geometry::Rectangles>
+        {
+            return std::nullopt;
+        }
     };
 };
 
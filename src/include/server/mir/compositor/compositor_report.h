@@ -18,6 +18,9 @@
 #define MIR_COMPOSITOR_COMPOSITOR_REPORT_H_
 
 #include <mir/graphics/renderable.h>
+#include <mir/graphics/frame.h>
+
+#include <chrono>
 
 namespace mir
 {
@@ -28,11 +31,30 @@ class CompositorReport
 {
 public:
     typedef const void* SubCompositorId;  // e.g. thread/display buffer ID
+
+    /// The stages of compositing a frame that are timed separately
+    enum class FramePhase
+    {
+        scene_snapshot,     ///< Collecting the scene elements for the output
+        occlusion,          ///< Discarding occluded elements
+        overlay_decision,   ///< Choosing whether (and which) elements can bypass the renderer
+        texture_upload,     ///< Importing or uploading buffers for rendering
+        render,             ///< Drawing (excluding texture upload and commit)
+        commit,             ///< Finishing the rendered image (e.g. swapping or copying out)
+        flip,               ///< Posting the frame until the display reports completion
+        buffer_release,     ///< Releasing the buffers of the frame
+    };
+    static int const frame_phase_count{8};
+
     virtual void added_display(int width, int height, int x, int y, SubCompositorId id) = 0;
     virtual void began_frame(SubCompositorId id) = 0;
     virtual void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) = 0;
     virtual void rendered_frame(SubCompositorId id) = 0;
     virtual void finished_frame(SubCompositorId id) = 0;
+    /// The frame has been posted; \a presentation says how it reached the screen (e.g. vsynced or tearing)
+    virtual void presented_frame(SubCompositorId id, graphics::FramePresentation const& presentation) = 0;
+    /// \a phase of the current frame took \a duration
+    virtual void frame_phase(SubCompositorId id, FramePhase phase, std::chrono::nanoseconds duration) = 0;
     virtual void started() = 0;
     virtual void stopped() = 0;
     virtual void scheduled() = 0;
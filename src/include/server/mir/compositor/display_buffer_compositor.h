@@ -32,6 +32,9 @@ public:
     /// Returns true if any compositing happened, otherwise false.
     virtual bool composite(SceneElementSequence&& scene_sequence) = 0;
 
+    /// Whether composite() needs calling again to display what was last composited, even if the scene is unchanged
+    virtual auto needs_another_frame() const -> bool { return false; }
+
 protected:
     DisplayBufferCompositor() = default;
     DisplayBufferCompositor& operator=(DisplayBufferCompositor const&) = delete;
@@ -24,6 +24,10 @@
 
 namespace mir
 {
+namespace graphics
+{
+struct FramePresentation;
+}
 namespace scene
 {
 class Observer;
@@ -55,6 +59,14 @@ public:
     virtual void register_compositor(CompositorID id) = 0;
     virtual void unregister_compositor(CompositorID id) = 0;
 
+    /**
+     * Notify the Scene that the frame last composited by \a id has been presented
+     *
+     * Surfaces that were rendered into that frame are told they are now on screen,
+     * and how they got there.
+     */
+    virtual void frame_presented(CompositorID id, graphics::FramePresentation const& presentation) = 0;
+
     virtual void add_observer(std::shared_ptr<scene::Observer> const& observer) = 0;
     virtual void remove_observer(std::weak_ptr<scene::Observer> const& observer) = 0;
 
@@ -17,7 +17,10 @@
 #ifndef MIR_COMPOSITOR_SCENE_ELEMENT_H_
 #define MIR_COMPOSITOR_SCENE_ELEMENT_H_
 
+#include <mir/graphics/scanout_formats.h>
+
 #include <memory>
+#include <optional>
 
 namespace mir
 {
@@ -36,6 +39,11 @@ public:
     virtual std::shared_ptr<graphics::Renderable> renderable() const = 0;
     virtual void rendered() = 0;
     virtual void occluded() = 0;
+    /**
+     * Whether the element could be scanned out directly (without compositing) by
+     * the display it was just rendered to, and if so in which formats.
+     */
+    virtual void scanout_candidate(std::optional<graphics::ScanoutFormats> const& /*formats*/) {}
 
 protected:
     SceneElement() = default;
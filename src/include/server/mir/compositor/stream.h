@@ -42,16 +42,28 @@ public:
         std::shared_ptr<graphics::Buffer> const& buffer,
         geometry::Size dest_size,
         geometry::RectangleD src_bounds) override;
+    void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Size dest_size,
+        geometry::RectangleD src_bounds,
+        geometry::Rectangles const& damage) override;
     void set_frame_posted_callback(
-        std::function<void(geometry::Size const&)> const& callback) override;
+        std::function<void(geometry::Rectangle const& damage)> const& callback) override;
+    void set_frame_presented_callback(
+        std::function<void(graphics::FramePresentation const&)> const& callback) override;
+    void set_tearing_allowed(bool allowed) override;
     auto next_submission_for_compositor(void const* user_id) -> std::shared_ptr<Submission> override;
     bool has_submitted_buffer() const override;
+    void frame_presented(graphics::FramePresentation const& presentation) override;
+    auto tearing_allowed() const -> bool override;
 private:
     std::shared_ptr<MultiMonitorArbiter> const arbiter;
 
     std::atomic<bool> first_frame_posted;
+    std::atomic<bool> tearing_allowed_{false};
 
-    Synchronised<std::function<void(geometry::Size const&)>> frame_callback;
+    Synchronised<std::function<void(geometry::Rectangle const&)>> frame_callback;
+    Synchronised<std::function<void(graphics::FramePresentation const&)>> presented_callback;
 };
 }
 }
@@ -204,6 +204,8 @@ public:
         std::string const& interface_name,
         WaylandProtocolExtensionFilter const& policy) override;
 
+    void set_pointer_motion_coalescing_policy(PointerMotionCoalescingPolicy const& policy) override;
+
     /**
      * Function to call when a "fatal" error occurs. This implementation allows
      * the default strategy to be overridden by --on-fatal-error-except to avoid a
@@ -475,6 +477,7 @@ private:
     std::vector<WaylandExtensionHook> wayland_extension_hooks;
     std::map<std::string, WaylandProtocolExtensionFilter> wayland_extension_policy_map;
     WaylandProtocolExtensionFilter wayland_extension_filter;
+    PointerMotionCoalescingPolicy pointer_motion_coalescing_policy;
 
     // Helpers for platform library loading
     std::vector<std::shared_ptr<mir::SharedLibrary>> platform_libraries;
@@ -19,6 +19,8 @@
 
 #include <mir_toolkit/common.h>
 #include <mir/geometry/size.h>
+#include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <functional>
 #include <memory>
 
@@ -28,6 +30,7 @@ namespace graphics
 {
 class Buffer;
 struct BufferProperties;
+struct FramePresentation;
 }
 
 namespace frontend
@@ -38,13 +41,48 @@ class BufferStream
 public:
     virtual ~BufferStream() = default;
 
+    /**
+     * Submit a buffer, treating its whole area as damaged
+     */
     virtual void submit_buffer(
         std::shared_ptr<graphics::Buffer> const& buffer,
         geometry::Size dest_size,
         geometry::RectangleD src_bounds) = 0;
 
+    /**
+     * Submit a buffer that differs from the previous submission only within \a damage
+     *
+     * \param [in] damage  The changed area, in logical coordinates relative to the stream origin.
+     *                      An empty set of rectangles means nothing visible has changed.
+     */
+    virtual void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Size dest_size,
+        geometry::RectangleD src_bounds,
+        geometry::Rectangles const& damage) = 0;
+
+    /**
+     * Set the callback invoked after each submission
+     *
+     * The callback receives the damaged area of the submission, in logical
+     * coordinates relative to the stream origin.
+     */
     virtual void set_frame_posted_callback(
-        std::function<void(geometry::Size const&)> const& callback) = 0;
+        std::function<void(geometry::Rectangle const& damage)> const& callback) = 0;
+
+    /**
+     * Set the callback invoked when a frame containing content from this stream has been presented
+     */
+    virtual void set_frame_presented_callback(
+        std::function<void(graphics::FramePresentation const& presentation)> const& callback) = 0;
+
+    /**
+     * Set whether subsequent submissions may be presented with tearing
+     *
+     * This is only a hint: the content is presented without tearing whenever the display can't
+     * present it immediately.
+     */
+    virtual void set_tearing_allowed(bool allowed) = 0;
 protected:
     BufferStream() = default;
     BufferStream(BufferStream const&) = delete;
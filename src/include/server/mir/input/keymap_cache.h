@@ -0,0 +1,99 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_INPUT_KEYMAP_CACHE_H_
+#define MIR_INPUT_KEYMAP_CACHE_H_
+
+#include <mir/fd.h>
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+struct xkb_context;
+
+namespace mir
+{
+namespace input
+{
+class Keymap;
+
+/**
+ * Compiles each distinct keymap once and shares the serialised result with every keyboard
+ *
+ * The serialised keymap is kept in a sealed, read-only memfd, so the same file can be sent to
+ * every client. Keymaps are told apart with Keymap::matches(), so a new Keymap instance
+ * describing a keymap already seen doesn't cause a recompilation.
+ *
+ * If a persistence directory is set, serialised ParameterKeymap and BufferKeymap keymaps are
+ * also written there and read back instead of compiling them (e.g. by the next server run).
+ * Persisted keymaps are only read back by a server using the same libxkbcommon and XKB data
+ * files, so upgrading either doesn't leave stale keymaps in use.
+ *
+ * Compiled xkb_keymaps are not shared through this cache: libxkbcommon's reference counting
+ * is not threadsafe, so each compiled keymap stays with the component that compiled it.
+ *
+ * Threadsafety: All member functions are threadsafe
+ */
+class KeymapCache
+{
+public:
+    /// A keymap serialised as XKB_KEYMAP_FORMAT_TEXT_V1, including the terminating nul
+    struct Serialised
+    {
+        Fd fd;          ///< Sealed against writing and resizing
+        size_t size;
+    };
+
+    /// \param capacity the number of distinct keymaps to keep; the least recently used are dropped
+    explicit KeymapCache(size_t capacity = 16);
+    ~KeymapCache();
+
+    /// The serialised form of \a keymap, compiling it if it isn't already cached
+    auto serialised(std::shared_ptr<Keymap const> const& keymap) -> std::shared_ptr<Serialised const>;
+
+    /// Persist serialised keymaps in \a directory, or not at all if unset
+    void persist_to(std::optional<std::string> const& directory);
+
+private:
+    KeymapCache(KeymapCache const&) = delete;
+    KeymapCache& operator=(KeymapCache const&) = delete;
+
+    struct Entry
+    {
+        std::shared_ptr<Keymap const> keymap;
+        std::shared_ptr<Serialised const> serialised;
+    };
+
+    auto serialise(Keymap const& keymap) -> std::string;
+
+    size_t const capacity;
+
+    std::mutex mutex;
+    std::unique_ptr<xkb_context, void(*)(xkb_context*)> const context;
+    std::optional<std::string> directory;
+    std::list<Entry> entries;   ///< Most recently used first
+};
+
+/// The cache shared by everything in the server process
+auto keymap_cache() -> KeymapCache&;
+}
+}
+
+#endif // MIR_INPUT_KEYMAP_CACHE_H_
@@ -72,6 +72,8 @@ private:
     void set_keymap(MirInputDeviceId id, std::shared_ptr<Keymap> new_keymap);
     void set_keymap(std::shared_ptr<Keymap> new_keymap);
     void update_modifier();
+    /// Reuses a compiled keymap already in use by a device if one matches
+    auto compile(Keymap const& keymap) const -> std::shared_ptr<xkb_keymap>;
 
     std::mutex mutable guard;
 
@@ -105,6 +107,8 @@ private:
         auto xkb_modifiers() const -> MirXkbModifiers;
         void notify_leds_changed();
         XkbMappingStateLedRegistrar& get_registrar();
+        /// The compiled keymap, if it is what \a other compiles to
+        auto compiled_keymap_matching(Keymap const& other) const -> std::shared_ptr<xkb_keymap>;
     private:
         /// Returns a pair containing the keysym for the given scancode and if any XKB modifiers have been changed
         auto update_state(
@@ -18,11 +18,12 @@
 #define MIR_OBSERVER_MULTIPLEXER_H_
 
 #include <mir/observer_registrar.h>
-#include <mir/posix_rw_mutex.h>
 #include <mir/executor.h>
 #include <mir/raii.h>
 #include <mir/synchronised.h>
 
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <algorithm>
 #include <mutex>
@@ -45,6 +46,9 @@ namespace mir
  * When an observer is removed a WeakObserver is marked as reset and removed from the observers list.
  * ObserverMultiplexer::unregister_interest() does not return until the related WeakObserver has been reset. This
  * happens once all in-flight observations have either completed, or are on threads that have removed the observer.
+ *
+ * The observers list is an immutable snapshot that is replaced (under a mutex) whenever an observer is added or
+ * removed, so sending an observation never waits for, or blocks, a change to the list.
  */
 template<class Observer>
 class ObserverMultiplexer : public ObserverRegistrar<Observer>, public Observer
@@ -126,6 +130,12 @@ private:
             }
         }
 
+        /// True if observations are made on the calling thread, so need not be wrapped up for spawn()
+        auto is_immediate() const -> bool
+        {
+            return executor == &immediate_executor;
+        }
+
         template<typename MemberFn, typename... Args>
         void invoke(MemberFn f, Args&&... args)
         {
@@ -247,10 +257,13 @@ private:
         std::condition_variable reset_cv;
     };
 
-    PosixRWMutex observer_mutex;
+    using Observers = std::vector<std::shared_ptr<WeakObserver>>;
+
+    /// Serialises changes to observers
+    std::mutex observer_mutex;
     /// This is a two-partitioning of early observers and other observers.
     /// Early observers are always partitioned before other observers.
-    std::vector<std::shared_ptr<WeakObserver>> observers;
+    std::atomic<std::shared_ptr<Observers const>> observers{std::make_shared<Observers const>()};
 };
 
 template<class Observer>
@@ -266,7 +279,9 @@ void ObserverMultiplexer<Observer>::register_interest(
 {
     std::lock_guard lock{observer_mutex};
 
-    observers.emplace_back(std::make_shared<WeakObserver>(observer, executor));
+    auto updated = std::make_shared<Observers>(*observers.load());
+    updated->emplace_back(std::make_shared<WeakObserver>(observer, executor));
+    observers.store(std::move(updated));
 }
 
 template<class Observer>
@@ -276,28 +291,32 @@ void ObserverMultiplexer<Observer>::register_early_observer(
 {
     std::lock_guard lock{observer_mutex};
 
-    observers.insert(observers.begin(), std::make_shared<WeakObserver>(observer, executor));
+    auto updated = std::make_shared<Observers>(*observers.load());
+    updated->insert(updated->begin(), std::make_shared<WeakObserver>(observer, executor));
+    observers.store(std::move(updated));
 }
 
 template<class Observer>
 void ObserverMultiplexer<Observer>::unregister_interest(Observer const& observer)
 {
     std::lock_guard lock{observer_mutex};
+
+    auto updated = std::make_shared<Observers>(*observers.load());
     std::erase_if(
-        observers,
+        *updated,
         [&observer](auto& candidate)
         {
             // This will wait for any (other) thread to finish with the candidate observer, then reset it
             // (preventing future notifications from being sent) if it is the same as the unregistered observer.
             return candidate->maybe_reset(&observer);
         });
+    observers.store(std::move(updated));
 }
 
 template<class Observer>
 auto ObserverMultiplexer<Observer>::empty() -> bool
 {
-    std::lock_guard lock{observer_mutex};
-    return observers.empty();
+    return observers.load()->empty();
 }
 
 template<class Observer>
@@ -307,15 +326,17 @@ void ObserverMultiplexer<Observer>::for_each_observer(MemberFn f, Args&&... args
     static_assert(
         std::is_member_function_pointer<MemberFn>::value,
         "f must be of type (Observer::*)(Args...), a pointer to an Observer member function.");
-    decltype(observers) local_observers;
-    {
-        std::lock_guard lock{observer_mutex};
-        local_observers = observers;
-    }
-    for (auto& weak_observer: local_observers)
+    auto const local_observers = observers.load();
+    for (auto const& weak_observer: *local_observers)
     {
+        if (weak_observer->is_immediate())
+        {
+            // The snapshot keeps weak_observer alive, and the observation is made before we move on
+            weak_observer->invoke(f, args...);
+            continue;
+        }
         weak_observer->spawn(
-            [f, weak_observer = std::move(weak_observer), args...]() mutable
+            [f, weak_observer, args...]() mutable
             {
                 weak_observer->invoke(f, std::forward<Args>(args)...);
             });
@@ -329,15 +350,11 @@ void ObserverMultiplexer<Observer>::for_single_observer(Observer const& target_o
     static_assert(
         std::is_member_function_pointer<MemberFn>::value,
         "f must be of type (Observer::*)(Args...), a pointer to an Observer member function.");
-    decltype(observers) local_observers;
-    {
-        std::lock_guard lock{observer_mutex};
-        local_observers = observers;
-    }
-    for (auto& weak_observer: local_observers)
+    auto const local_observers = observers.load();
+    for (auto const& weak_observer: *local_observers)
     {
         weak_observer->spawn_if_eq(target_observer,
-            [f, weak_observer = std::move(weak_observer), args...]() mutable
+            [f, weak_observer, args...]() mutable
             {
                 weak_observer->invoke(f, std::forward<Args>(args)...);
             });
@@ -0,0 +1,153 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RECYCLING_ALLOCATOR_H_
+#define MIR_RECYCLING_ALLOCATOR_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace mir
+{
+/**
+ * A thread-safe free list of equally sized memory blocks
+ *
+ * The block size is fixed by the first allocation; requests of any other
+ * size go straight to the global allocator. Blocks that are handed back are
+ * kept (up to \a max_free of them) for the next allocation rather than
+ * being freed, so a steady stream of short-lived objects of the same type
+ * stops touching the heap once the pool has warmed up.
+ */
+class RecyclingPool
+{
+public:
+    explicit RecyclingPool(std::size_t max_free = 64)
+        : max_free{max_free}
+    {
+        free_blocks.reserve(max_free);
+    }
+
+    ~RecyclingPool()
+    {
+        for (auto const block : free_blocks)
+        {
+            ::operator delete(block);
+        }
+    }
+
+    RecyclingPool(RecyclingPool const&) = delete;
+    RecyclingPool& operator=(RecyclingPool const&) = delete;
+
+    auto allocate(std::size_t size) -> void*
+    {
+        {
+            std::lock_guard lock{mutex};
+            if (block_size == 0)
+            {
+                block_size = size;
+            }
+            if (size == block_size && !free_blocks.empty())
+            {
+                auto const block = free_blocks.back();
+                free_blocks.pop_back();
+                return block;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    void deallocate(void* block, std::size_t size) noexcept
+    {
+        {
+            std::lock_guard lock{mutex};
+            if (size == block_size && free_blocks.size() < max_free)
+            {
+                free_blocks.push_back(block);
+                return;
+            }
+        }
+        ::operator delete(block);
+    }
+
+private:
+    std::size_t const max_free;
+    std::mutex mutex;
+    std::size_t block_size{0};
+    std::vector<void*> free_blocks;
+};
+
+/**
+ * A standard allocator drawing single objects from a shared RecyclingPool
+ *
+ * Intended for std::allocate_shared(): the object and its control block
+ * live in one recycled block, and the allocator copy held by the control
+ * block keeps the pool alive for as long as any object drawn from it.
+ */
+template<typename T>
+class RecyclingAllocator
+{
+public:
+    using value_type = T;
+
+    explicit RecyclingAllocator(std::shared_ptr<RecyclingPool> pool)
+        : pool{std::move(pool)}
+    {
+    }
+
+    template<typename U>
+    RecyclingAllocator(RecyclingAllocator<U> const& other)
+        : pool{other.pool}
+    {
+    }
+
+    auto allocate(std::size_t n) -> T*
+    {
+        static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+        if (n != 1)
+        {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T*>(pool->allocate(sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (n != 1)
+        {
+            ::operator delete(p);
+            return;
+        }
+        pool->deallocate(p, sizeof(T));
+    }
+
+    template<typename U>
+    auto operator==(RecyclingAllocator<U> const& other) const -> bool
+    {
+        return pool == other.pool;
+    }
+
+private:
+    template<typename U>
+    friend class RecyclingAllocator;
+
+    std::shared_ptr<RecyclingPool> pool;
+};
+}
+
+#endif // MIR_RECYCLING_ALLOCATOR_H_
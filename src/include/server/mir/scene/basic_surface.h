@@ -32,6 +32,7 @@
 
 namespace mir
 {
+class RecyclingPool;
 namespace compositor
 {
 class BufferStream;
@@ -115,6 +116,9 @@ public:
     bool visible() const override;
 
     graphics::RenderableList generate_renderables(compositor::CompositorID id) const override;
+    void append_renderables(compositor::CompositorID id, graphics::RenderableList& renderables) const override;
+    void frame_presented(graphics::FramePresentation const& presentation) override;
+    void set_scanout_formats(std::optional<graphics::ScanoutFormats> const& formats) override;
 
     MirWindowType type() const override;
     MirWindowState state() const override;
@@ -210,7 +214,13 @@ private:
         bool hidden;
         input::InputReceptionMode input_mode;
         std::vector<geometry::Rectangle> custom_input_rectangles{};
-        geometry::Rectangles opaque_region{};
+        std::shared_ptr<geometry::Rectangles const> opaque_region;
+        /// opaque_region translated to where it was last composited, shared by the snapshots taken there
+        struct
+        {
+            geometry::Point top_left;
+            std::shared_ptr<geometry::Rectangles const> region;
+        } placed_opaque_region{};
         std::shared_ptr<graphics::CursorImage> cursor_image;
 
         std::list<StreamInfo> layers;
@@ -248,6 +258,8 @@ private:
 
     std::shared_ptr<Multiplexer> const observers;
     std::shared_ptr<SceneReport> const report;
+    /// Storage recycled between the snapshots handed to compositors each frame
+    std::shared_ptr<RecyclingPool> const snapshot_pool;
     std::weak_ptr<Surface> const parent_;
     std::shared_ptr<ObserverRegistrar<graphics::DisplayConfigurationObserver>> display_config_registrar;
     std::shared_ptr<DisplayConfigurationEarlyListener> const display_config_monitor;
@@ -18,6 +18,7 @@
 #define MIR_SCENE_SURFACE_H_
 
 #include <mir/graphics/renderable.h>
+#include <mir/graphics/scanout_formats.h>
 #include <mir/input/surface.h>
 #include <mir/frontend/surface.h>
 #include <mir/compositor/compositor_id.h>
@@ -31,7 +32,7 @@
 
 namespace mir
 {
-namespace graphics { class CursorImage; }
+namespace graphics { class CursorImage; struct FramePresentation; }
 namespace compositor { class BufferStream; }
 namespace scene
 {
@@ -67,6 +68,16 @@ public:
     virtual geometry::Size window_size() const = 0;
 
     virtual graphics::RenderableList generate_renderables(compositor::CompositorID id) const = 0;
+    /// As generate_renderables(), but appending to \a renderables so the caller can reuse its storage
+    virtual void append_renderables(compositor::CompositorID id, graphics::RenderableList& renderables) const
+    {
+        auto const generated = generate_renderables(id);
+        renderables.insert(renderables.end(), generated.begin(), generated.end());
+    }
+    /// The content last rendered from this surface is now on screen
+    virtual void frame_presented(graphics::FramePresentation const& presentation) = 0;
+    /// The compositor could scan out content in \a formats (or none, if std::nullopt) directly
+    virtual void set_scanout_formats(std::optional<graphics::ScanoutFormats> const& formats) = 0;
 
     virtual MirWindowType type() const = 0;
     virtual MirWindowState state() const = 0;
@@ -23,12 +23,14 @@
 #include <mir/input/input_reception_mode.h>
 #include <mir/geometry/rectangle.h>
 #include <mir/graphics/display_configuration.h>
+#include <mir/graphics/scanout_formats.h>
 #include <mir/flags.h>
 
 #include <glm/glm.hpp>
 #include <string>
 #include <vector>
 #include <memory>
+#include <optional>
 
 namespace mir
 {
@@ -68,6 +70,14 @@ public:
     virtual void left_output(Surface const* surf, graphics::DisplayConfigurationOutputId const& id) = 0;
     virtual void rescale_output(Surface const* surf, graphics::DisplayConfigurationOutputId const& id) = 0;
     virtual void tiled_edges(Surface const* surf, Flags<MirTiledEdge> edges) = 0;
+    /// The buffer formats the surface could be scanned out in, or std::nullopt if it is not a candidate
+    virtual void scanout_formats_set_to(
+        Surface const* /*surf*/,
+        std::optional<graphics::ScanoutFormats> const& /*formats*/) {}
+    /// The custom input region (in surface-local coordinates) has been set, or cleared if empty
+    virtual void input_region_set_to(
+        Surface const* /*surf*/,
+        std::vector<geometry::Rectangle> const& /*region*/) {}
 
 protected:
     SurfaceObserver() = default;
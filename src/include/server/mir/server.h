@@ -509,6 +509,17 @@ public:
     void set_wayland_extension_policy(
         std::string const& interface_name,
         std::function<bool(std::shared_ptr<scene::Session> const&, char const*)> const& policy);
+
+    /// Set which clients have their pointer motion coalesced to (at most) one motion event per frame.
+    ///
+    /// For clients whose \p policy returns `true`, the first motion after the pointer has been still is sent
+    /// straight away; after that they are sent the latest position once per frame they draw, with the relative
+    /// motion summed. Button, scroll and enter/leave events are still sent straight away.
+    /// Without a policy, the --coalesce-pointer-motion option applies to all clients.
+    ///
+    /// \param policy the policy predicate, given the session of the client
+    void set_pointer_motion_coalescing_policy(
+        std::function<bool(std::shared_ptr<scene::Session> const&)> const& policy);
 /** @} */
 
     auto the_decoration_strategy() const -> std::shared_ptr<DecorationStrategy>;
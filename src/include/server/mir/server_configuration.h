@@ -126,6 +126,15 @@ public:
         std::string const& interface_name,
         std::function<bool(std::shared_ptr<scene::Session> const&, const char*)> const& policy) = 0;
 
+    using PointerMotionCoalescingPolicy = std::function<bool(std::shared_ptr<scene::Session> const&)>;
+
+    /// Set which clients have their pointer motion coalesced to (at most) one motion event per frame.
+    ///
+    /// Without a policy this is decided by the --coalesce-pointer-motion option.
+    ///
+    /// \param policy the policy predicate, given the session of the client binding a pointer
+    virtual void set_pointer_motion_coalescing_policy(PointerMotionCoalescingPolicy const& policy) = 0;
+
     virtual auto the_decoration_strategy() -> std::shared_ptr<DecorationStrategy> = 0;
     virtual void set_the_decoration_strategy(std::shared_ptr<DecorationStrategy> strategy) = 0;
 protected:
@@ -196,10 +196,10 @@ public:
     {
     }
 
-    mg::RenderableList generate_renderables(mc::CompositorID id) const override
+    void append_renderables(mc::CompositorID id, mg::RenderableList& renderables) const override
     {
         if (id == screen_shooter->id())
-            return {};
+            return;
 
         std::lock_guard lock{mutex};
         auto buffer = pool.claim();
@@ -212,7 +212,7 @@ public:
             [](auto const&) {});
         get_streams().begin()->stream->submit_buffer(
             buffer, capture_rect.size, geom::RectangleD({0, 0}, capture_rect.size));
-        return BasicSurface::generate_renderables(id);
+        BasicSurface::append_renderables(id, renderables);
     }
 
     bool input_area_contains(mir::geometry::Point const&) const override
@@ -48,6 +48,7 @@ char const* const miral::WaylandExtensions::ext_session_lock_manager_v1{"ext_ses
 char const* const miral::WaylandExtensions::ext_data_control_manager_v1{"ext_data_control_manager_v1"};
 char const* const miral::WaylandExtensions::ext_image_copy_capture_manager_v1{"ext_image_copy_capture_manager_v1"};
 char const* const miral::WaylandExtensions::ext_output_image_capture_source_manager_v1{"ext_output_image_capture_source_manager_v1"};
+char const* const miral::WaylandExtensions::wp_tearing_control_manager_v1{"wp_tearing_control_manager_v1"};
 
 namespace
 {
@@ -17,6 +17,8 @@
 #include <mir/graphics/egl_context_executor.h>
 #include <mir/renderer/gl/context.h>
 
+#include <utility>
+
 namespace mgc = mir::graphics::common;
 
 mgc::EGLContextExecutor::EGLContextExecutor(
@@ -53,13 +55,21 @@ void mgc::EGLContextExecutor::process_loop(mgc::EGLContextExecutor* const me)
     std::unique_lock lock{me->mutex};
     while (!me->shutdown_requested)
     {
-        for (auto& work : me->work_queue)
+        if (me->work_queue.empty())
         {
-            work();
+            me->new_work.wait(lock);
+            continue;
         }
-        me->work_queue.clear();
 
-        me->new_work.wait(lock);
+        // Run the work without holding the lock, so that (potentially lengthy) work doesn't block spawn()
+        auto work_queue = std::exchange(me->work_queue, {});
+        lock.unlock();
+        for (auto& work : work_queue)
+        {
+            work();
+        }
+        work_queue.clear();
+        lock.lock();
     }
 
     // Drain the work-queue
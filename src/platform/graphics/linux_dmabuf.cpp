@@ -32,6 +32,7 @@
 #include <mir/graphics/buffer.h>
 #include <mir/graphics/buffer_basic.h>
 #include <mir/graphics/dmabuf_buffer.h>
+#include <mir/graphics/scanout_formats.h>
 #include <mir/graphics/egl_context_executor.h>
 #include <mir/renderer/sw/pixel_source.h>
 
@@ -52,6 +53,7 @@
 #include <optional>
 #include <utility>
 #include <algorithm>
+#include <numeric>
 #include <drm_fourcc.h>
 #include <wayland-server.h>
 
@@ -881,43 +883,73 @@ public:
     LinuxDmaBufFeedback(
         wl_resource* new_resource,
         struct wl_resource* surface,
-        std::shared_ptr<mg::DMABufEGLProvider> provider)
+        std::shared_ptr<mg::DMABufEGLProvider> provider,
+        std::shared_ptr<mg::SurfaceScanoutHints> const& scanout_hints)
         : mir::wayland::LinuxDmabufFeedbackV1(new_resource, Version<5>{}),
-          provider{std::move(provider)}
+          provider{std::move(provider)},
+          table_entries{format_table_entries(this->provider->supported_formats())},
+          format_table{table_entries.size() * sizeof(Format)}
     {
-        // We have the same feedback regardless of surface.
-        (void)surface;
-
         // Build table in shared memory.
-        struct Format
+        Format *data = static_cast<Format*>(format_table.base_ptr());
+        for (auto const& [format, modifier] : table_entries)
         {
-            uint32_t format;
-            uint32_t padding; /* unused */
-            uint64_t modifier;
-        };
-        auto const& formats = this->provider->supported_formats();
-        size_t format_table_length = 0;
-        for (auto i = 0u; i < formats.num_formats(); ++i)
+            *data++ = Format{format, 0, modifier};
+        }
+
+        if (surface && scanout_hints)
+        {
+            // Surface feedback also prefers the formats the surface could be scanned out in, while there are any
+            scanout_listener = std::make_shared<mg::SurfaceScanoutHints::Listener>(
+                [this](std::optional<mg::ScanoutFormats> const& formats)
+                {
+                    send_feedback(formats);
+                });
+            scanout_hints->register_listener(surface, scanout_listener);
+        }
+
+        if (!sent_scanout_formats)
         {
-            format_table_length += formats[i].modifiers.size();
+            send_feedback(std::nullopt);
         }
-        mir::AnonymousShmFile shm_buffer{format_table_length * sizeof(Format)};
-        Format *data = static_cast<Format*>(shm_buffer.base_ptr());
-        size_t k = 0;
+    }
+
+private:
+    struct Format
+    {
+        uint32_t format;
+        uint32_t padding; /* unused */
+        uint64_t modifier;
+    };
+
+    static auto format_table_entries(mg::DmaBufFormatDescriptors const& formats)
+        -> std::vector<std::pair<uint32_t, uint64_t>>
+    {
+        std::vector<std::pair<uint32_t, uint64_t>> entries;
         for (auto i = 0u; i < formats.num_formats(); ++i)
         {
             auto format = formats[i];
             for (auto j = 0u; j < format.modifiers.size(); ++j)
             {
-                data[k].format = format.format;
-                data[k].padding = 0;
-                data[k].modifier = format.modifiers[j];
-                k++;
+                entries.emplace_back(format.format, format.modifiers[j]);
             }
         }
+        return entries;
+    }
+
+    /// Send all the parameters; they are re-sent in full whenever \a scanout changes
+    void send_feedback(std::optional<mg::ScanoutFormats> const& scanout)
+    {
+        if (sent_scanout_formats && *sent_scanout_formats == scanout)
+        {
+            return;
+        }
+        sent_scanout_formats = scanout;
 
+        send_format_table_event(
+            mir::Fd{mir::IntOwnedFd{format_table.fd()}},
+            table_entries.size() * sizeof(Format));
         {
-            send_format_table_event(mir::Fd{mir::IntOwnedFd{shm_buffer.fd()}}, format_table_length * sizeof(Format));
             wl_array main_device = {};
             wl_array_init(&main_device);
             wl_array_add<dev_t>(&main_device, this->provider->devnum());
@@ -925,20 +957,50 @@ public:
             wl_array_release(&main_device);
         }
 
+        if (scanout)
+        {
+            // Scanout only helps if we can still import the buffer when it has to be composited
+            std::vector<uint32_t> indices;
+            for (auto i = 0u; i < table_entries.size(); ++i)
+            {
+                if (std::find(scanout->formats.begin(), scanout->formats.end(), table_entries[i]) !=
+                    scanout->formats.end())
+                {
+                    indices.push_back(i);
+                }
+            }
+
+            if (!indices.empty())
+            {
+                send_tranche(scanout->device, TrancheFlags::scanout, indices);
+            }
+        }
+
+        {
+            // We only currently support one rendering device, which accessess all formats.
+            std::vector<uint32_t> indices(table_entries.size());
+            std::iota(indices.begin(), indices.end(), 0u);
+            send_tranche(this->provider->devnum(), 0, indices);
+        }
+
+        send_done_event();
+    }
+
+    void send_tranche(dev_t target_device, uint32_t flags, std::vector<uint32_t> const& indices)
+    {
         {
-            // We only currently support one device, which accessess all formats.
             wl_array device = {};
             wl_array_init(&device);
-            wl_array_add<dev_t>(&device, this->provider->devnum());
+            wl_array_add<dev_t>(&device, target_device);
             send_tranche_target_device_event(&device);
             wl_array_release(&device);
         }
-        send_tranche_flags_event(0);
+        send_tranche_flags_event(flags);
 
         {
             wl_array indicies = {};
             wl_array_init(&indicies);
-            for (auto i = 0u; i < format_table_length; ++i)
+            for (auto const i : indices)
             {
                 uint32_t *index = static_cast<uint32_t*>(wl_array_add(&indicies, sizeof(uint32_t)));
                 *index = i;
@@ -947,12 +1009,14 @@ public:
             wl_array_release(&indicies);
         }
         send_tranche_done_event();
-
-        send_done_event();
     }
 
-private:
     std::shared_ptr<mg::DMABufEGLProvider> const provider;
+    std::vector<std::pair<uint32_t, uint64_t>> const table_entries;
+    mir::AnonymousShmFile const format_table;
+    /// What the last feedback sent said about scanout (std::nullopt until something has been sent)
+    std::optional<std::optional<mg::ScanoutFormats>> sent_scanout_formats;
+    std::shared_ptr<mg::SurfaceScanoutHints::Listener> scanout_listener;
 };
 
 GLuint get_tex_id()
@@ -1359,9 +1423,11 @@ class mg::LinuxDmaBuf::Instance : public mir::wayland::LinuxDmabufV1
 public:
     Instance(
         wl_resource* new_resource,
-        std::shared_ptr<mg::DMABufEGLProvider> provider)
+        std::shared_ptr<mg::DMABufEGLProvider> provider,
+        std::shared_ptr<mg::SurfaceScanoutHints> scanout_hints)
         : mir::wayland::LinuxDmabufV1(new_resource, Version<5>{}),
-          provider{std::move(provider)}
+          provider{std::move(provider)},
+          scanout_hints{std::move(scanout_hints)}
     {
         if (wl_resource_get_version(new_resource) < 4)
         {
@@ -1395,22 +1461,25 @@ private:
 
     void get_default_feedback(struct wl_resource* params_id) override
     {
-        new LinuxDmaBufFeedback{params_id, nullptr, provider};
+        new LinuxDmaBufFeedback{params_id, nullptr, provider, scanout_hints};
     }
 
     void get_surface_feedback(struct wl_resource* params_id, struct wl_resource* surface) override
     {
-        new LinuxDmaBufFeedback{params_id, surface, provider};
+        new LinuxDmaBufFeedback{params_id, surface, provider, scanout_hints};
     }
 
     std::shared_ptr<mg::DMABufEGLProvider> const provider;
+    std::shared_ptr<mg::SurfaceScanoutHints> const scanout_hints;
 };
 
 mg::LinuxDmaBuf::LinuxDmaBuf(
     wl_display* display,
-    std::shared_ptr<mg::DMABufEGLProvider> provider)
+    std::shared_ptr<mg::DMABufEGLProvider> provider,
+    std::shared_ptr<SurfaceScanoutHints> scanout_hints)
     : mir::wayland::LinuxDmabufV1::Global(display, Version<5>{}),
-      provider{std::move(provider)}
+      provider{std::move(provider)},
+      scanout_hints{std::move(scanout_hints)}
 {
 }
 
@@ -1433,7 +1502,7 @@ auto mg::LinuxDmaBuf::buffer_from_resource(
 
 void mg::LinuxDmaBuf::bind(wl_resource* new_resource)
 {
-    new LinuxDmaBuf::Instance{new_resource, provider};
+    new LinuxDmaBuf::Instance{new_resource, provider, scanout_hints};
 }
 
 namespace
@@ -31,6 +31,7 @@ namespace mo = mir::options;
 char const* const mo::arw_server_socket_opt       = "arw-file";
 char const* const mo::enable_input_opt            = "enable-input,i";
 char const* const mo::compositor_report_opt       = "compositor-report";
+char const* const mo::compositor_timings_file_opt = "compositor-timings-file";
 char const* const mo::display_report_opt          = "display-report";
 char const* const mo::scene_report_opt            = "scene-report";
 char const* const mo::input_report_opt            = "input-report";
@@ -42,7 +43,11 @@ char const* const mo::cursor_opt                  = "cursor";
 char const* const mo::fatal_except_opt            = "on-fatal-error-except";
 char const* const mo::debug_opt                   = "debug";
 char const* const mo::composite_delay_opt         = "composite-delay";
+char const* const mo::renderer_opt                = "renderer";
+char const* const mo::deferred_output_readback_opt = "deferred-output-readback";
 char const* const mo::enable_key_repeat_opt       = "enable-key-repeat";
+char const* const mo::coalesce_pointer_motion_opt = "coalesce-pointer-motion";
+char const* const mo::keymap_cache_dir_opt        = "keymap-cache-dir";
 char const* const mo::x11_display_opt             = "enable-x11";
 char const* const mo::x11_scale_opt               = "x11-scale";
 char const* const mo::wayland_extensions_opt      = "wayland-extensions";
@@ -163,6 +168,9 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "Enable input.")
         (compositor_report_opt, po::value<std::string>()->default_value(off_opt_value),
             "Configure compositor reporting. [{off,log,lttng}]")
+        (compositor_timings_file_opt, po::value<std::string>(),
+            "With `--compositor-report=log`, write the frame phase timings to this file (as JSON) on SIGUSR2. "
+            "If not provided they are logged instead.")
         (display_report_opt, po::value<std::string>()->default_value(off_opt_value),
             "Configure display reporting. [{off,log,lttng}]")
         (input_report_opt, po::value<std::string>()->default_value(off_opt_value),
@@ -178,6 +186,15 @@ mo::DefaultConfiguration::DefaultConfiguration(
         (composite_delay_opt, po::value<int>()->default_value(0),
             "Number of milliseconds to wait for new frames from clients before compositing. "
             "Higher values result in lower latency but risk causing frame skipping.")
+        (renderer_opt, po::value<std::string>()->default_value("gl"),
+            "Renderer used to composite outputs:\n"
+            " - `gl`: render with OpenGL ES.\n"
+            " - `software`: composite on the CPU, for systems without a GPU. "
+            "Outputs that cannot be drawn to from the CPU still use `gl`.")
+        (deferred_output_readback_opt, po::value<bool>()->default_value(false),
+            "On outputs drawn with OpenGL ES but displayed from CPU memory, read each frame back "
+            "while the next is rendered rather than waiting for it. "
+            "Reduces rendering stalls at the cost of a frame of latency.")
         (touchspots_opt,
             "Enable visual feedback of touch events. "
             "Useful for screencasting.")
@@ -189,6 +206,12 @@ mo::DefaultConfiguration::DefaultConfiguration(
             " - `software`: always use software cursor.")
         (enable_key_repeat_opt, po::value<bool>()->default_value(true),
             "Enable server generated key repeat.")
+        (coalesce_pointer_motion_opt, po::value<bool>()->default_value(false),
+            "Send Wayland clients at most one pointer motion event per frame, "
+            "with the relative motion of the events merged. Reduces client wakeups with high rate mice.")
+        (keymap_cache_dir_opt, po::value<std::string>(),
+            "Directory to keep compiled keymaps in, so they aren't compiled again by later runs. "
+            "Clear it after updating the XKB data files.")
         (idle_timeout_opt, po::value<int>()->default_value(0),
             "Number of seconds Mir will remain idle before turning off the display "
             "when the session is not locked, or 0 to keep display on forever.")
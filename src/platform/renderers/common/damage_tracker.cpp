@@ -0,0 +1,170 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "damage_tracker.h"
+
+#include <mir/graphics/buffer.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace mg = mir::graphics;
+namespace mr = mir::renderer;
+namespace geom = mir::geometry;
+
+void mr::DamageTracker::invalidate()
+{
+    have_previous = false;
+    history.clear();
+}
+
+auto mr::DamageTracker::area_to_repaint(
+    mg::RenderableList const& renderables,
+    geom::Rectangle const& viewport,
+    int buffer_age) -> std::optional<geom::Rectangle>
+{
+    auto const damage = frame_damage(renderables);
+
+    // A buffer of age N is missing the changes of this frame and the N-1 frames before it
+    std::optional<geom::Rectangles> repaint = damage;
+    if (buffer_age <= 0 || static_cast<size_t>(buffer_age - 1) > history.size())
+    {
+        repaint = std::nullopt;
+    }
+    for (auto i = 0; repaint && i < buffer_age - 1; ++i)
+    {
+        if (auto const& older = history[i])
+        {
+            for (auto const& rect : *older)
+                repaint->add(rect);
+        }
+        else
+        {
+            repaint = std::nullopt;
+        }
+    }
+
+    history.push_front(damage);
+    if (history.size() > max_tracked_age)
+    {
+        history.pop_back();
+    }
+
+    return repaint.transform([&](auto const& area) { return intersection_of(area.bounding_rectangle(), viewport); });
+}
+
+auto mr::DamageTracker::bounds_of(mg::Renderable const& renderable) -> geom::Rectangle
+{
+    auto const position = renderable.screen_position();
+    if (auto const clip = renderable.clip_area())
+        return intersection_of(position, *clip);
+    return position;
+}
+
+auto mr::DamageTracker::RenderedState::placed_as(RenderedState const& other) const -> bool
+{
+    auto with_our_buffer = other;
+    with_our_buffer.buffer = buffer;
+    return with_our_buffer == *this;
+}
+
+auto mr::DamageTracker::frame_damage(mg::RenderableList const& renderables) -> std::optional<geom::Rectangles>
+{
+    std::swap(previous, current);
+    bool const had_previous = std::exchange(have_previous, true);
+
+    current.clear();
+    bool transformed{false};
+    for (auto const& renderable : renderables)
+    {
+        current.push_back(RenderedState{
+            renderable->id(),
+            renderable->buffer()->id(),
+            bounds_of(*renderable),
+            renderable->alpha(),
+            renderable->transformation(),
+            renderable->orientation(),
+            renderable->mirror_mode(),
+            renderable->shaped()});
+        // We don't try to work out where arbitrarily transformed renderables end up
+        transformed = transformed || current.back().transformation != glm::mat4{1};
+    }
+
+    if (!had_previous || transformed)
+        return std::nullopt;
+
+    previous_by_id.clear();
+    for (size_t i = 0; i != previous.size(); ++i)
+    {
+        if (previous[i].transformation != glm::mat4{1})
+            return std::nullopt;
+        previous_by_id.emplace_back(previous[i].id, i);
+    }
+    std::ranges::sort(previous_by_id);
+
+    geom::Rectangles damage;
+    matched.assign(previous.size(), false);
+    std::optional<size_t> highest_matched;
+    for (size_t i = 0; i != current.size(); ++i)
+    {
+        auto const& now = current[i];
+        auto const match = std::ranges::lower_bound(
+            previous_by_id, now.id, {}, [](auto const& entry) { return entry.first; });
+
+        if (match == previous_by_id.end() || match->first != now.id || matched[match->second])
+        {
+            damage.add(now.bounds);
+            continue;
+        }
+
+        auto const& then = previous[match->second];
+        matched[match->second] = true;
+
+        // Anything that changed, or was restacked beneath something it was previously above, is damaged
+        bool const restacked = highest_matched && match->second < *highest_matched;
+        if (restacked || !now.placed_as(then))
+        {
+            damage.add(then.bounds);
+            damage.add(now.bounds);
+        }
+        else if (now.buffer != then.buffer)
+        {
+            // Only the content changed, so the client may have told us which part
+            if (auto const changed = renderables[i]->damage_since(then.buffer))
+            {
+                for (auto const& rect : *changed)
+                {
+                    auto const visible = intersection_of(rect, now.bounds);
+                    if (visible.size != geom::Size{})
+                        damage.add(visible);
+                }
+            }
+            else
+            {
+                damage.add(now.bounds);
+            }
+        }
+        highest_matched = std::max(highest_matched.value_or(0), match->second);
+    }
+
+    for (size_t i = 0; i != previous.size(); ++i)
+    {
+        if (!matched[i])
+            damage.add(previous[i].bounds);
+    }
+
+    return damage;
+}
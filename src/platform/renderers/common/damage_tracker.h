@@ -0,0 +1,96 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_DAMAGE_TRACKER_H_
+#define MIR_RENDERER_DAMAGE_TRACKER_H_
+
+#include <mir/graphics/buffer_id.h>
+#include <mir/graphics/renderable.h>
+#include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
+
+#include <glm/glm.hpp>
+
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace renderer
+{
+/**
+ * Tracks what changed between the frames a renderer draws, so unchanged areas of the output need not be redrawn
+ *
+ * The damage is worked out by comparing the renderables of each frame with those of the frame before.
+ * Where only a renderable's buffer has changed, the damage the client submitted with the new buffer
+ * is used (see Renderable::damage_since()), so a small change to a large surface is a small repaint.
+ */
+class DamageTracker
+{
+public:
+    /// Forget everything; the next frame will be fully repainted
+    void invalidate();
+
+    /**
+     * Record the scene about to be rendered and work out what needs repainting
+     *
+     * \param buffer_age    The age of the buffer being rendered into, with the semantics of
+     *                      EGL_EXT_buffer_age (0 means the content is undefined)
+     * \returns    The area, in logical coordinates, that needs repainting, or
+     *             std::nullopt if the whole output must be repainted.
+     */
+    auto area_to_repaint(graphics::RenderableList const& renderables, geometry::Rectangle const& viewport, int buffer_age)
+        -> std::optional<geometry::Rectangle>;
+
+    /// The logical area \a renderable is drawn in, ignoring its transformation
+    static auto bounds_of(graphics::Renderable const& renderable) -> geometry::Rectangle;
+
+private:
+    /// Buffer ages beyond this are treated as unknown
+    static size_t constexpr max_tracked_age = 4;
+
+    struct RenderedState
+    {
+        graphics::Renderable::ID id;
+        graphics::BufferID buffer;
+        geometry::Rectangle bounds;
+        float alpha;
+        glm::mat4 transformation;
+        MirOrientation orientation;
+        MirMirrorMode mirror_mode;
+        bool shaped;
+
+        auto operator==(RenderedState const&) const -> bool = default;
+
+        /// Whether this is shown the same way as \a other, whatever the content of their buffers
+        auto placed_as(RenderedState const& other) const -> bool;
+    };
+
+    /// \returns  The damage between the previous frame and this, or std::nullopt if everything is damaged
+    auto frame_damage(graphics::RenderableList const& renderables) -> std::optional<geometry::Rectangles>;
+
+    bool have_previous{false};
+    std::vector<RenderedState> previous;
+    std::vector<RenderedState> current;
+    std::vector<std::pair<graphics::Renderable::ID, size_t>> previous_by_id;
+    std::vector<bool> matched;
+    std::deque<std::optional<geometry::Rectangles>> history;
+};
+}
+}
+
+#endif // MIR_RENDERER_DAMAGE_TRACKER_H_
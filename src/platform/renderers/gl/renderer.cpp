@@ -28,6 +28,7 @@
 #include <mir/graphics/program_factory.h>
 #include <mir/graphics/program.h>
 #include <mir/renderer/gl/gl_surface.h>
+#include "../common/damage_tracker.h"
 
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/matrix_transform.hpp>
@@ -36,6 +37,8 @@
 
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <sstream>
 #include <mutex>
@@ -333,14 +336,16 @@ public:
     {
     }
 
-    void set_filter(MirOutputFilter filter)
+    /// \returns whether the filter changed
+    auto set_filter(MirOutputFilter filter) -> bool
     {
         if (this->filter == filter)
-            return;
+            return false;
         this->filter = filter;
 
         // Clear existing filter
         program = nullptr;
+        return true;
     }
 
     void bind() override
@@ -422,6 +427,33 @@ public:
         return output->layout();
     }
 
+    auto buffer_age() const -> int override
+    {
+        // When filtering we render into our own texture, which always holds the previous frame
+        if (filter == mir_output_filter_none)
+            return output->buffer_age();
+        return 1;
+    }
+
+    void set_damage(std::optional<mir::geometry::Rectangle> const& damage) override
+    {
+        // Filtering redraws the whole output
+        if (filter == mir_output_filter_none)
+            output->set_damage(damage);
+        else
+            output->set_damage(std::nullopt);
+    }
+
+    auto has_pending_frame() const -> bool override
+    {
+        return output->has_pending_frame();
+    }
+
+    void discard_pending_frame() override
+    {
+        output->discard_pending_frame();
+    }
+
 private:
     static GLuint compile_shader(GLenum type, GLchar const* src)
     {
@@ -535,6 +567,49 @@ private:
     GLint tex_uniform;
 };
 
+class mrg::Renderer::DamageTracker : public mir::renderer::DamageTracker
+{
+public:
+    /// An area of the framebuffer, in pixels, as used by glScissor()
+    struct Box
+    {
+        GLint x, y;
+        GLsizei width, height;
+    };
+
+    void set_gl_viewport(Box const& box)
+    {
+        gl_viewport = box;
+    }
+
+    /// Convert a logical area to the framebuffer pixels it covers, given the logical to NDC transform
+    auto framebuffer_box(geom::Rectangle const& area, glm::mat4 const& to_ndc) const -> Box
+    {
+        auto const to_pixels = [&](geom::Point p)
+            {
+                auto const ndc = to_ndc * glm::vec4{p.x.as_int(), p.y.as_int(), 0, 1};
+                return glm::vec2{
+                    gl_viewport.x + (ndc.x + 1.0f) / 2.0f * gl_viewport.width,
+                    gl_viewport.y + (ndc.y + 1.0f) / 2.0f * gl_viewport.height};
+            };
+        auto const a = to_pixels(area.top_left);
+        auto const b = to_pixels(area.bottom_right());
+
+        // Round outwards, with a pixel of slack for filtering at the edges
+        auto const left = static_cast<GLint>(std::floor(std::min(a.x, b.x))) - 1;
+        auto const bottom = static_cast<GLint>(std::floor(std::min(a.y, b.y))) - 1;
+        auto const right = static_cast<GLint>(std::ceil(std::max(a.x, b.x))) + 1;
+        auto const top = static_cast<GLint>(std::ceil(std::max(a.y, b.y))) + 1;
+        return Box{left, bottom, right - left, top - bottom};
+    }
+
+    /// The scissor applied to the whole of the frame currently being rendered, if any
+    std::optional<Box> frame_scissor;
+
+private:
+    Box gl_viewport{0, 0, 0, 0};
+};
+
 mrg::Renderer::Program::Program(GLuint program_id)
 {
     id = program_id;
@@ -571,6 +646,7 @@ mrg::Renderer::Renderer(
     std::unique_ptr<graphics::gl::OutputSurface> output)
     : output_surface{std::make_unique<OutputFilter>(make_output_current(std::move(output)))},
       clear_color{0.0f, 0.0f, 0.0f, 1.0f},
+      damage_tracker{std::make_unique<DamageTracker>()},
       program_factory{std::make_unique<ProgramFactory>()},
       screen_to_gl_coords(0),
       display_transform(1),
@@ -663,18 +739,46 @@ auto mrg::Renderer::render(mg::RenderableList const& renderables) const -> std::
 {
     output_surface->make_current();
     output_surface->bind();
+    timings = {};
 
-    glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
-    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glClear(GL_COLOR_BUFFER_BIT);
+    // If the output surface preserves its contents we only need to repaint what has changed
+    auto const repaint = damage_tracker->area_to_repaint(renderables, viewport, output_surface->buffer_age());
 
     ++frameno;
-    for (auto const& r : renderables)
+    output_surface->set_damage(repaint ? std::optional{geom::Rectangle{}} : std::nullopt);
+    if (!repaint || repaint->size != geom::Size{})
     {
-        draw(*r);
+        if (repaint)
+        {
+            auto const box = damage_tracker->framebuffer_box(*repaint, display_transform * screen_to_gl_coords);
+            damage_tracker->frame_scissor = box;
+            output_surface->set_damage(geom::Rectangle{{box.x, box.y}, {box.width, box.height}});
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(box.x, box.y, box.width, box.height);
+        }
+
+        glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        for (auto const& r : renderables)
+        {
+            if (!repaint || DamageTracker::bounds_of(*r).overlaps(*repaint))
+            {
+                draw(*r);
+            }
+        }
+
+        if (repaint)
+        {
+            damage_tracker->frame_scissor = std::nullopt;
+            glDisable(GL_SCISSOR_TEST);
+        }
     }
 
+    auto const commit_start = std::chrono::steady_clock::now();
     auto output = output_surface->commit();
+    timings.commit = std::chrono::steady_clock::now() - commit_start;
 
     // Report any GL errors after commit, to catch any *during* commit
     while (auto const gl_error = glGetError())
@@ -697,7 +801,9 @@ auto calc_scale(T logical, T physical) -> double
 
 void mrg::Renderer::draw(mg::Renderable const& renderable) const
 {
+    auto const upload_start = std::chrono::steady_clock::now();
     auto const texture = gl_interface->as_texture(renderable.buffer());
+    timings.texture_upload += std::chrono::steady_clock::now() - upload_start;
     auto const clip_area = renderable.clip_area();
     if (clip_area)
     {
@@ -718,12 +824,23 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
         double const scale_x = calc_scale(viewport.size.width, output_size.width);
         double const scale_y = calc_scale(viewport.size.height, output_size.height);
 
-        glScissor(
+        DamageTracker::Box scissor{
             static_cast<int>((clip_pos.x - static_cast<float>(viewport.top_left.x.as_int())) * scale_x),
             static_cast<int>(clip_pos.y * scale_y),
             static_cast<int>(clip_area.value().size.width.as_int() * scale_x),
-            static_cast<int>(clip_area.value().size.height.as_int() * scale_y)
-        );
+            static_cast<int>(clip_area.value().size.height.as_int() * scale_y)};
+
+        if (auto const& frame = damage_tracker->frame_scissor)
+        {
+            // Stay within the area being repainted
+            auto const left = std::max(scissor.x, frame->x);
+            auto const bottom = std::max(scissor.y, frame->y);
+            auto const right = std::min(scissor.x + scissor.width, frame->x + frame->width);
+            auto const top = std::min(scissor.y + scissor.height, frame->y + frame->height);
+            scissor = {left, bottom, std::max(right - left, 0), std::max(top - bottom, 0)};
+        }
+
+        glScissor(scissor.x, scissor.y, scissor.width, scissor.height);
     }
 
     // All the programs are held by program_factory through its lifetime. Using pointers avoids
@@ -890,7 +1007,14 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
     glDisableVertexAttribArray(prog->position_attr);
     if (renderable.clip_area())
     {
-        glDisable(GL_SCISSOR_TEST);
+        if (auto const& frame = damage_tracker->frame_scissor)
+        {
+            glScissor(frame->x, frame->y, frame->width, frame->height);
+        }
+        else
+        {
+            glDisable(GL_SCISSOR_TEST);
+        }
     }
 }
 
@@ -970,7 +1094,11 @@ void mrg::Renderer::update_gl_viewport()
         GLint offset_y = (output_height - reduced_height) / 2;
 
         glViewport(offset_x, offset_y, reduced_width, reduced_height);
+        damage_tracker->set_gl_viewport({offset_x, offset_y, reduced_width, reduced_height});
     }
+
+    // Everything drawn so far is in the wrong place
+    damage_tracker->invalidate();
 }
 
 void mrg::Renderer::set_output_transform(glm::mat2 const& t)
@@ -1002,10 +1130,25 @@ void mrg::Renderer::set_output_transform(glm::mat2 const& t)
 
 void mrg::Renderer::set_output_filter(MirOutputFilter filter)
 {
-    output_surface->set_filter(filter);
+    if (output_surface->set_filter(filter))
+    {
+        damage_tracker->invalidate();
+    }
 }
 
 void mrg::Renderer::suspend()
 {
+    // Whatever was last rendered is not going to be displayed
+    output_surface->discard_pending_frame();
     output_surface->release_current();
 }
+
+auto mrg::Renderer::has_pending_frame() const -> bool
+{
+    return output_surface->has_pending_frame();
+}
+
+auto mrg::Renderer::last_render_timings() const -> Timings
+{
+    return timings;
+}
@@ -0,0 +1,620 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "SoftwareRenderer"
+
+#include <mir/renderers/software/renderer.h>
+#include <mir/graphics/buffer.h>
+#include <mir/graphics/platform.h>
+#include <mir/graphics/renderable.h>
+#include <mir/graphics/transformation.h>
+#include <mir/renderer/sw/pixel_source.h>
+#include <mir/log.h>
+#include "../common/damage_tracker.h"
+
+#include "pixman-1/pixman.h"
+#include <drm_fourcc.h>
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace mg = mir::graphics;
+namespace mr = mir::renderer;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+
+namespace
+{
+using UniquePixmanImage = std::unique_ptr<pixman_image_t, decltype(&pixman_image_unref)>;
+
+auto select_format_from(mg::CPUAddressableDisplayAllocator const& allocator) -> mg::DRMFormat
+{
+    std::optional<mg::DRMFormat> best_format;
+    for (auto const format : allocator.supported_formats())
+    {
+        switch(static_cast<uint32_t>(format))
+        {
+        case DRM_FORMAT_ARGB8888:
+        case DRM_FORMAT_XRGB8888:
+            // ?RGB8888 is what pixman is fastest at
+            return format;
+        case DRM_FORMAT_ABGR8888:
+        case DRM_FORMAT_XBGR8888:
+            best_format = format;
+            break;
+        default:
+            break;
+        }
+    }
+    if (best_format)
+    {
+        return *best_format;
+    }
+    BOOST_THROW_EXCEPTION((std::runtime_error{"Output supports no 32-bit RGB format suitable for software rendering"}));
+}
+
+/// The pixman format of the shadow for an output of \a format
+///
+/// The shadow always has an alpha channel, so that compositing keeps it opaque.
+auto shadow_format_for(mg::DRMFormat format) -> pixman_format_code_t
+{
+    switch (static_cast<uint32_t>(format))
+    {
+    case DRM_FORMAT_ABGR8888:
+    case DRM_FORMAT_XBGR8888:
+        return PIXMAN_a8b8g8r8;
+    default:
+        return PIXMAN_a8r8g8b8;
+    }
+}
+
+/// The pixman format with the same memory layout as \a format, if there is one
+auto pixman_format_for(MirPixelFormat format) -> std::optional<pixman_format_code_t>
+{
+    switch (format)
+    {
+    case mir_pixel_format_argb_8888:
+        return PIXMAN_a8r8g8b8;
+    case mir_pixel_format_xrgb_8888:
+        return PIXMAN_x8r8g8b8;
+    case mir_pixel_format_abgr_8888:
+        return PIXMAN_a8b8g8r8;
+    case mir_pixel_format_xbgr_8888:
+        return PIXMAN_x8b8g8r8;
+    case mir_pixel_format_rgb_888:
+        return PIXMAN_r8g8b8;
+    case mir_pixel_format_bgr_888:
+        return PIXMAN_b8g8r8;
+    case mir_pixel_format_rgb_565:
+        return PIXMAN_r5g6b5;
+    default:
+        // pixman has no equivalent of RGBA5551 or RGBA4444
+        return std::nullopt;
+    }
+}
+
+/// Embed a 2D linear transformation in an affine transformation
+auto affine(glm::dmat2 const& linear) -> glm::dmat3
+{
+    return glm::dmat3{
+        linear[0][0], linear[0][1], 0.0,
+        linear[1][0], linear[1][1], 0.0,
+        0.0, 0.0, 1.0};
+}
+
+auto translation(double x, double y) -> glm::dmat3
+{
+    return glm::dmat3{
+        1.0, 0.0, 0.0,
+        0.0, 1.0, 0.0,
+        x, y, 1.0};
+}
+
+auto scale(double x, double y) -> glm::dmat3
+{
+    return glm::dmat3{
+        x, 0.0, 0.0,
+        0.0, y, 0.0,
+        0.0, 0.0, 1.0};
+}
+
+/// The 2D part of a renderable's transformation (we do not attempt perspective)
+auto affine(glm::mat4 const& m) -> glm::dmat3
+{
+    return glm::dmat3{
+        m[0][0], m[0][1], 0.0,
+        m[1][0], m[1][1], 0.0,
+        m[3][0], m[3][1], 1.0};
+}
+
+/// The smallest pixel-aligned rectangle containing the image of \a area under \a transform
+auto bounding_pixels(glm::dmat3 const& transform, geom::RectangleD const& area) -> geom::Rectangle
+{
+    auto const left = area.top_left.x.as_value();
+    auto const top = area.top_left.y.as_value();
+    auto const right = left + area.size.width.as_value();
+    auto const bottom = top + area.size.height.as_value();
+
+    std::array<glm::dvec3, 4> const corners{
+        transform * glm::dvec3{left, top, 1.0},
+        transform * glm::dvec3{right, top, 1.0},
+        transform * glm::dvec3{left, bottom, 1.0},
+        transform * glm::dvec3{right, bottom, 1.0}};
+
+    // Allow for rounding errors, so exact pixel boundaries don't spill into the next pixel
+    auto constexpr epsilon = 1e-6;
+    auto x1 = std::numeric_limits<double>::max(), y1 = x1;
+    auto x2 = std::numeric_limits<double>::lowest(), y2 = x2;
+    for (auto const& corner : corners)
+    {
+        x1 = std::min<double>(x1, corner.x);
+        y1 = std::min<double>(y1, corner.y);
+        x2 = std::max<double>(x2, corner.x);
+        y2 = std::max<double>(y2, corner.y);
+    }
+
+    auto const left_px = static_cast<int>(std::floor(x1 + epsilon));
+    auto const top_px = static_cast<int>(std::floor(y1 + epsilon));
+    auto const right_px = static_cast<int>(std::ceil(x2 - epsilon));
+    auto const bottom_px = static_cast<int>(std::ceil(y2 - epsilon));
+    return {{left_px, top_px}, {std::max(right_px - left_px, 0), std::max(bottom_px - top_px, 0)}};
+}
+
+auto as_rectangle_d(geom::Rectangle const& rect) -> geom::RectangleD
+{
+    return {
+        {rect.top_left.x.as_int(), rect.top_left.y.as_int()},
+        {rect.size.width.as_int(), rect.size.height.as_int()}};
+}
+
+/// Whether \a transform maps whole pixels to whole pixels by translation alone
+auto is_integer_translation(glm::dmat3 const& transform) -> bool
+{
+    auto constexpr epsilon = 1e-9;
+    return std::abs(transform[0][0] - 1.0) < epsilon && std::abs(transform[0][1]) < epsilon &&
+           std::abs(transform[1][0]) < epsilon && std::abs(transform[1][1] - 1.0) < epsilon &&
+           std::abs(transform[2][0] - std::round(transform[2][0])) < epsilon &&
+           std::abs(transform[2][1] - std::round(transform[2][1])) < epsilon;
+}
+
+/// Whether \a transform keeps the edges of a rectangle parallel to the axes (scaling, flipping and quarter turns)
+auto is_axis_aligned(glm::dmat3 const& transform) -> bool
+{
+    auto constexpr epsilon = 1e-9;
+    auto const is_zero = [](double v) { return std::abs(v) < epsilon; };
+    return (is_zero(transform[0][1]) && is_zero(transform[1][0])) ||
+           (is_zero(transform[0][0]) && is_zero(transform[1][1]));
+}
+
+/// Whether \a transform maps pixels onto pixels exactly (so needs no filtering), possibly rotating or flipping them
+auto is_pixel_exact(glm::dmat3 const& transform) -> bool
+{
+    auto constexpr epsilon = 1e-9;
+    auto const is_unit = [](double v) { return std::abs(std::abs(v) - 1.0) < epsilon; };
+    auto const is_zero = [](double v) { return std::abs(v) < epsilon; };
+    bool const unit_scale =
+        (is_unit(transform[0][0]) && is_zero(transform[0][1]) && is_zero(transform[1][0]) && is_unit(transform[1][1])) ||
+        (is_zero(transform[0][0]) && is_unit(transform[0][1]) && is_unit(transform[1][0]) && is_zero(transform[1][1]));
+    return unit_scale &&
+           std::abs(transform[2][0] - std::round(transform[2][0])) < epsilon &&
+           std::abs(transform[2][1] - std::round(transform[2][1])) < epsilon;
+}
+
+/// The smallest rectangle containing both \a a and \a b, ignoring either if it is empty
+auto bounding(geom::Rectangle const& a, geom::Rectangle const& b) -> geom::Rectangle
+{
+    if (a.size == geom::Size{})
+        return b;
+    if (b.size == geom::Size{})
+        return a;
+
+    geom::Point const top_left{std::min(a.left(), b.left()), std::min(a.top(), b.top())};
+    geom::Point const bottom_right{std::max(a.right(), b.right()), std::max(a.bottom(), b.bottom())};
+    return {top_left, as_size(bottom_right - top_left)};
+}
+
+void apply_filter(MirOutputFilter filter, uint32_t* pixels, size_t count)
+{
+    switch (filter)
+    {
+    case mir_output_filter_none:
+        break;
+
+    case mir_output_filter_grayscale:
+        // Both shadow formats have alpha in the top byte, so the colour channels can be treated alike
+        for (auto p = pixels; p != pixels + count; ++p)
+        {
+            uint32_t const s = (((*p >> 16) & 0xff) + ((*p >> 8) & 0xff) + (*p & 0xff)) / 3;
+            *p = (*p & 0xff000000) | (s << 16) | (s << 8) | s;
+        }
+        break;
+
+    case mir_output_filter_invert:
+        for (auto p = pixels; p != pixels + count; ++p)
+        {
+            *p ^= 0x00ffffff;
+        }
+        break;
+    }
+}
+}
+
+class mrs::Renderer::Shadow
+{
+public:
+    Shadow(geom::Size size, pixman_format_code_t format)
+        : size{size},
+          pixels(size.width.as_int() * size.height.as_int()),
+          image{
+              pixman_image_create_bits_no_clear(
+                  format,
+                  size.width.as_int(),
+                  size.height.as_int(),
+                  pixels.data(),
+                  size.width.as_int() * sizeof(uint32_t)),
+              &pixman_image_unref}
+    {
+        if (!image)
+        {
+            BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to create software renderer shadow buffer"}));
+        }
+    }
+
+    void clear(geom::Rectangle const& area)
+    {
+        pixman_color_t const black{0, 0, 0, 0xffff};
+        pixman_box32_t const box{
+            area.left().as_int(),
+            area.top().as_int(),
+            area.right().as_int(),
+            area.bottom().as_int()};
+        pixman_image_fill_boxes(PIXMAN_OP_SRC, image.get(), &black, 1, &box);
+    }
+
+    geom::Size const size;
+    std::vector<uint32_t> pixels;
+    UniquePixmanImage const image;
+};
+
+mrs::Renderer::Renderer(mg::CPUAddressableDisplayAllocator& allocator)
+    : allocator{allocator},
+      format{select_format_from(allocator)},
+      shadow{std::make_unique<Shadow>(allocator.output_size(), shadow_format_for(format))},
+      damage_tracker{std::make_unique<DamageTracker>()}
+{
+}
+
+mrs::Renderer::~Renderer() = default;
+
+void mrs::Renderer::set_viewport(geom::Rectangle const& rect)
+{
+    if (rect == viewport)
+        return;
+
+    viewport = rect;
+    update_output_mapping();
+}
+
+void mrs::Renderer::set_output_transform(glm::mat2 const& t)
+{
+    if (t == output_transform)
+        return;
+
+    output_transform = t;
+    update_output_mapping();
+}
+
+void mrs::Renderer::set_output_filter(MirOutputFilter filter)
+{
+    // The filter is applied as each frame is copied out of the shadow, so nothing needs repainting...
+    if (filter == this->filter)
+        return;
+
+    this->filter = filter;
+    // ...but framebuffers holding earlier frames were filtered the old way
+    filter_changed = true;
+}
+
+void mrs::Renderer::update_output_mapping()
+{
+    /*
+     * This matches the GL renderer: the viewport is mapped to normalised coordinates,
+     * the output transform is applied, and the result is letterboxed into the output
+     * so that pixels stay square.
+     */
+    auto const view_width = viewport.size.width.as_int();
+    auto const view_height = viewport.size.height.as_int();
+    auto const output_width = shadow->size.width.as_int();
+    auto const output_height = shadow->size.height.as_int();
+
+    auto const transformed_view = output_transform * glm::vec2(view_width, view_height);
+    auto const transformed_width = std::abs(transformed_view.x);
+    auto const transformed_height = std::abs(transformed_view.y);
+
+    if (transformed_width > 0.0f && transformed_height > 0.0f && output_width > 0 && output_height > 0)
+    {
+        auto reduced_width = output_width, reduced_height = output_height;
+        if (transformed_width * output_height >= output_width * transformed_height)
+            reduced_height = static_cast<int>(output_width * transformed_height / transformed_width);
+        else
+            reduced_width = static_cast<int>(output_height * transformed_width / transformed_height);
+
+        auto const offset_x = (output_width - reduced_width) / 2;
+        auto const offset_y = (output_height - reduced_height) / 2;
+
+        auto const to_normalised =
+            scale(2.0 / view_width, -2.0 / view_height) *
+            translation(-viewport.top_left.x.as_int() - view_width / 2.0, -viewport.top_left.y.as_int() - view_height / 2.0);
+        auto const to_pixels =
+            translation(offset_x + reduced_width / 2.0, offset_y + reduced_height / 2.0) *
+            scale(reduced_width / 2.0, -reduced_height / 2.0);
+
+        logical_to_output = to_pixels * affine(glm::dmat2{output_transform}) * to_normalised;
+    }
+
+    // Everything drawn so far is in the wrong place
+    damage_tracker->invalidate();
+}
+
+auto mrs::Renderer::output_area(geom::Rectangle const& area) const -> geom::Rectangle
+{
+    return bounding_pixels(logical_to_output, as_rectangle_d(area));
+}
+
+auto mrs::Renderer::render(mg::RenderableList const& renderables) const -> std::unique_ptr<mg::Framebuffer>
+{
+    geom::Rectangle const whole_output{{0, 0}, shadow->size};
+    timings = {};
+
+    // The shadow always holds the previous frame, so only what has changed needs repainting
+    auto const repaint = damage_tracker->area_to_repaint(renderables, viewport, 1);
+
+    auto const repaint_area = [&]
+        {
+            if (!repaint)
+                return whole_output;
+
+            // Allow a pixel of slack for filtering at the edges
+            auto const area = output_area(*repaint);
+            return intersection_of(
+                whole_output,
+                geom::Rectangle{
+                    area.top_left - geom::Displacement{1, 1},
+                    geom::Size{area.size.width + geom::DeltaX{2}, area.size.height + geom::DeltaY{2}}});
+        }();
+
+    if (repaint_area.size != geom::Size{})
+    {
+        shadow->clear(repaint_area);
+
+        for (auto const& r : renderables)
+        {
+            // Test against the cleared area, slack included; a renderable that only abuts
+            // the damage still has to repaint its edge pixels
+            if (!repaint || output_area(mr::DamageTracker::bounds_of(*r)).overlaps(repaint_area))
+            {
+                draw(*r, repaint_area);
+            }
+        }
+    }
+
+    repainted.push_front(std::exchange(filter_changed, false) ? whole_output : repaint_area);
+    if (repainted.size() > max_tracked_age)
+    {
+        repainted.pop_back();
+    }
+
+    auto const commit_start = std::chrono::steady_clock::now();
+    auto fb = allocator.alloc_fb(format);
+    {
+        auto const copy = intersection_of(stale_area(fb->buffer_age()), geom::Rectangle{{0, 0}, fb->size()});
+        auto const mapping = fb->map_writeable();
+        auto const left = copy.left().as_int();
+        auto const width = copy.size.width.as_int();
+        auto const stride = mapping->stride().as_int();
+        auto const shadow_stride = shadow->size.width.as_int();
+
+        for (auto y = copy.top().as_int(); y != copy.bottom().as_int(); ++y)
+        {
+            auto const row = reinterpret_cast<uint32_t*>(mapping->data() + y * stride) + left;
+            std::memcpy(row, shadow->pixels.data() + y * shadow_stride + left, width * sizeof(uint32_t));
+            apply_filter(filter, row, width);
+        }
+    }
+    timings.commit = std::chrono::steady_clock::now() - commit_start;
+    return fb;
+}
+
+auto mrs::Renderer::stale_area(int buffer_age) const -> geom::Rectangle
+{
+    // A framebuffer of age N is missing what was repainted this frame and in the N-1 frames before it
+    if (buffer_age <= 0 || static_cast<size_t>(buffer_age) > repainted.size())
+        return {{0, 0}, shadow->size};
+
+    auto area = repainted[0];
+    for (auto i = 1; i < buffer_age; ++i)
+    {
+        area = bounding(area, repainted[i]);
+    }
+    return area;
+}
+
+void mrs::Renderer::draw(mg::Renderable const& renderable, geom::Rectangle const& repaint) const
+{
+    auto const buffer = renderable.buffer();
+    auto const pixman_format = pixman_format_for(buffer->pixel_format());
+    if (!pixman_format)
+    {
+        mir::log_debug("Not drawing buffer of unsupported format %d", buffer->pixel_format());
+        return;
+    }
+
+    // Mapping is where the buffer's content is made available to the CPU: our "texture upload"
+    auto const upload_start = std::chrono::steady_clock::now();
+    std::unique_ptr<mrs::Mapping<std::byte const>> mapping;
+    try
+    {
+        mapping = buffer->map_readable();
+    }
+    catch (mg::UnmappableBuffer const&)
+    {
+        mir::log_debug("Not drawing buffer that cannot be mapped for CPU access");
+        return;
+    }
+    timings.texture_upload += std::chrono::steady_clock::now() - upload_start;
+
+    auto const buffer_size = mapping->size();
+    UniquePixmanImage const source{
+        pixman_image_create_bits_no_clear(
+            *pixman_format,
+            buffer_size.width.as_int(),
+            buffer_size.height.as_int(),
+            // pixman takes a non-const pointer, but only reads from source images
+            reinterpret_cast<uint32_t*>(const_cast<std::byte*>(mapping->data())),
+            mapping->stride().as_int()),
+        &pixman_image_unref};
+    if (!source)
+        return;
+
+    /*
+     * Work out where each buffer pixel ends up, following the GL renderer's vertex shader:
+     * the part of the buffer in src_bounds() is stretched over screen_position(), which is
+     * unrotated by the buffer orientation and transformed (including any mirroring) around
+     * its centre, then mapped onto the output.
+     */
+    auto const rect = renderable.screen_position();
+    auto const src = renderable.src_bounds();
+    if (rect.size == geom::Size{} || src.size.width.as_value() <= 0 || src.size.height.as_value() <= 0)
+        return;
+
+    auto const left = rect.top_left.x.as_int();
+    auto const top = rect.top_left.y.as_int();
+    auto const width = rect.size.width.as_int();
+    auto const height = rect.size.height.as_int();
+
+    auto const buffer_to_vertex =
+        translation(left, top) *
+        scale(width / src.size.width.as_value(), height / src.size.height.as_value()) *
+        translation(-src.top_left.x.as_value(), -src.top_left.y.as_value());
+
+    auto const orientation = renderable.orientation();
+    bool const quarter_turn = orientation == mir_orientation_left || orientation == mir_orientation_right;
+    glm::dvec2 const centre{left + width / 2.0, top + height / 2.0};
+    glm::dvec2 const oriented_centre = quarter_turn ?
+        glm::dvec2{left + height / 2.0, top + width / 2.0} : centre;
+
+    auto const orient =
+        translation(oriented_centre.x, oriented_centre.y) *
+        affine(glm::dmat2{mg::inverse_transformation(orientation)}) *
+        translation(-centre.x, -centre.y);
+
+    auto const transform =
+        translation(oriented_centre.x, oriented_centre.y) *
+        affine(renderable.transformation()) *
+        affine(glm::dmat2{mg::transformation(renderable.mirror_mode())}) *
+        translation(-oriented_centre.x, -oriented_centre.y);
+
+    auto const buffer_to_output = logical_to_output * transform * orient * buffer_to_vertex;
+
+    auto area = intersection_of(bounding_pixels(buffer_to_output, src), repaint);
+    if (auto const clip = renderable.clip_area())
+    {
+        area = intersection_of(area, output_area(*clip));
+    }
+    if (area.size == geom::Size{})
+        return;
+
+    UniquePixmanImage mask{nullptr, &pixman_image_unref};
+    if (renderable.alpha() < 1.0f)
+    {
+        pixman_color_t const alpha{0, 0, 0, static_cast<uint16_t>(std::clamp(renderable.alpha(), 0.0f, 1.0f) * 0xffff)};
+        mask.reset(pixman_image_create_solid_fill(&alpha));
+    }
+
+    auto const x = area.top_left.x.as_int();
+    auto const y = area.top_left.y.as_int();
+    auto const w = area.size.width.as_int();
+    auto const h = area.size.height.as_int();
+
+    if (is_integer_translation(buffer_to_output))
+    {
+        // The common case: pixman has fast paths for a straight copy or blend
+        auto const dx = static_cast<int>(std::round(buffer_to_output[2][0]));
+        auto const dy = static_cast<int>(std::round(buffer_to_output[2][1]));
+        bool const opaque = !renderable.shaped() && !mask;
+        pixman_image_composite32(
+            opaque ? PIXMAN_OP_SRC : PIXMAN_OP_OVER,
+            source.get(), mask.get(), shadow->image.get(),
+            x - dx, y - dy,
+            0, 0,
+            x, y, w, h);
+        return;
+    }
+
+    // pixman transforms map destination pixels back to the source
+    auto const output_to_buffer = glm::inverse(buffer_to_output);
+    pixman_f_transform ftransform;
+    for (auto row = 0; row != 3; ++row)
+    {
+        for (auto col = 0; col != 3; ++col)
+        {
+            ftransform.m[row][col] = output_to_buffer[col][row];
+        }
+    }
+    pixman_transform_t pixman_transform;
+    if (!pixman_transform_from_pixman_f_transform(&pixman_transform, &ftransform))
+        return;
+
+    pixman_image_set_transform(source.get(), &pixman_transform);
+    pixman_image_set_filter(
+        source.get(),
+        is_pixel_exact(buffer_to_output) ? PIXMAN_FILTER_NEAREST : PIXMAN_FILTER_BILINEAR,
+        nullptr, 0);
+
+    // When the buffer stays a rectangle on the output, clamp samples at its edges (as GL_CLAMP_TO_EDGE
+    // does) so filtering doesn't fade them. Otherwise samples from beyond the edges are transparent.
+    bool const axis_aligned = is_axis_aligned(buffer_to_output);
+    if (axis_aligned)
+    {
+        pixman_image_set_repeat(source.get(), PIXMAN_REPEAT_PAD);
+    }
+    bool const opaque = axis_aligned && !renderable.shaped() && !mask;
+    pixman_image_composite32(
+        opaque ? PIXMAN_OP_SRC : PIXMAN_OP_OVER,
+        source.get(), mask.get(), shadow->image.get(),
+        x, y,
+        0, 0,
+        x, y, w, h);
+}
+
+void mrs::Renderer::suspend()
+{
+}
+
+auto mrs::Renderer::last_render_timings() const -> Timings
+{
+    return timings;
+}
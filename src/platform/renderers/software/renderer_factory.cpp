@@ -0,0 +1,62 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "SoftwareRenderer"
+
+#include <mir/renderers/software/renderer_factory.h>
+#include <mir/renderers/software/renderer.h>
+#include <mir/renderers/gl/renderer.h>
+#include <mir/graphics/display_sink.h>
+#include <mir/graphics/platform.h>
+#include <mir/renderer/gl/gl_surface.h>
+#include <mir/log.h>
+
+#include <stdexcept>
+
+namespace mg = mir::graphics;
+namespace mrs = mir::renderer::software;
+
+auto mrs::RendererFactory::create_renderer_for(
+    std::unique_ptr<graphics::gl::OutputSurface> output_surface,
+    std::shared_ptr<graphics::GLRenderingProvider> gl_provider) const -> std::unique_ptr<mir::renderer::Renderer>
+{
+    return std::make_unique<gl::Renderer>(std::move(gl_provider), std::move(output_surface));
+}
+
+auto mrs::RendererFactory::create_software_renderer_for(
+    mg::DisplaySink& sink) const -> std::unique_ptr<mir::renderer::Renderer>
+{
+    if (auto const allocator = sink.acquire_compatible_allocator<mg::CPUAddressableDisplayAllocator>())
+    {
+        try
+        {
+            return std::make_unique<Renderer>(*allocator);
+        }
+        catch (std::runtime_error const&)
+        {
+            mir::log(
+                mir::logging::Severity::warning,
+                MIR_LOG_COMPONENT,
+                std::current_exception(),
+                "Falling back to GL rendering for output");
+        }
+    }
+    else
+    {
+        mir::log_info("Output does not provide CPU-addressable buffers; falling back to GL rendering");
+    }
+    return nullptr;
+}
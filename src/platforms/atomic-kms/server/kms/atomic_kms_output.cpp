@@ -22,10 +22,14 @@
 #include <mir/graphics/gamma_curves.h>
 #include <mir_toolkit/common.h>
 #include "kms-utils/kms_connector.h"
+#include "kms-utils/drm_event_handler.h"
 #include <mir/fatal.h>
 #include <mir/log.h>
 #include <drm_fourcc.h>
 #include <drm_mode.h>
+#include <algorithm>
+#include <iterator>
+#include <map>
 #include <span>
 #include <string.h> // strcmp
 
@@ -39,8 +43,19 @@ namespace mga = mg::atomic;
 namespace mgk = mg::kms;
 namespace geom = mir::geometry;
 
+// Older libdrm headers predate asynchronous atomic flips
+#ifndef DRM_CAP_ATOMIC_ASYNC_PAGE_FLIP
+#define DRM_CAP_ATOMIC_ASYNC_PAGE_FLIP 0x15
+#endif
+
 namespace
 {
+bool atomic_async_flips_supported(mir::Fd const& drm_fd)
+{
+    uint64_t supported = 0;
+    return drmGetCap(drm_fd, DRM_CAP_ATOMIC_ASYNC_PAGE_FLIP, &supported) == 0 && supported;
+}
+
 bool kms_modes_are_equal(drmModeModeInfo const* info1, drmModeModeInfo const* info2)
 {
     return (info1 && info2) &&
@@ -145,6 +160,164 @@ public:
 private:
     drmModeAtomicReqPtr const req;
 };
+
+/// DRM plane source coordinates are 16.16 fixed point
+auto to_fixed_16_16(float value) -> uint64_t
+{
+    return static_cast<uint64_t>(value * 65536.0f + 0.5f);
+}
+
+void set_plane(
+    AtomicUpdate& update,
+    mgk::ObjectProperties const& plane_props,
+    uint32_t crtc_id,
+    uint32_t fb_id,
+    geom::RectangleF const& source,
+    geom::Rectangle const& destination)
+{
+    update.add_property(plane_props, "SRC_X", to_fixed_16_16(source.top_left.x.as_value()));
+    update.add_property(plane_props, "SRC_Y", to_fixed_16_16(source.top_left.y.as_value()));
+    update.add_property(plane_props, "SRC_W", to_fixed_16_16(source.size.width.as_value()));
+    update.add_property(plane_props, "SRC_H", to_fixed_16_16(source.size.height.as_value()));
+    update.add_property(plane_props, "CRTC_X", destination.top_left.x.as_int());
+    update.add_property(plane_props, "CRTC_Y", destination.top_left.y.as_int());
+    update.add_property(plane_props, "CRTC_W", destination.size.width.as_uint32_t());
+    update.add_property(plane_props, "CRTC_H", destination.size.height.as_uint32_t());
+    update.add_property(plane_props, "CRTC_ID", crtc_id);
+    update.add_property(plane_props, "FB_ID", fb_id);
+}
+
+void switch_off_plane(AtomicUpdate& update, mgk::ObjectProperties const& plane_props)
+{
+    update.add_property(plane_props, "FB_ID", 0);
+    update.add_property(plane_props, "CRTC_ID", 0);
+}
+
+/// Switch off every overlay plane in \a active, as part of switching off the CRTC
+void switch_off_overlays(
+    AtomicUpdate& update,
+    std::map<uint32_t, std::unique_ptr<mgk::ObjectProperties>> const& plane_props,
+    std::vector<uint32_t>& active)
+{
+    for (auto const plane_id : active)
+    {
+        if (auto const props = plane_props.find(plane_id); props != plane_props.end())
+        {
+            switch_off_plane(update, *props->second);
+        }
+    }
+    active.clear();
+}
+
+auto plane_formats(mir::Fd const& drm_fd, mgk::DRMModePlaneUPtr const& plane, mgk::ObjectProperties const& plane_props)
+    -> std::vector<std::pair<uint32_t, uint64_t>>
+{
+    std::vector<std::pair<uint32_t, uint64_t>> formats;
+    if (!plane_props.has_property("IN_FORMATS"))
+    {
+        // We don't know which modifiers are supported; leave that for the test commit to find out
+        for (auto i = 0u; i != plane->count_formats; ++i)
+        {
+            formats.emplace_back(plane->formats[i], DRM_FORMAT_MOD_INVALID);
+        }
+        return formats;
+    }
+
+    PropertyBlobData format_blob{drm_fd, static_cast<uint32_t>(plane_props["IN_FORMATS"])};
+    drmModeFormatModifierIterator iter{};
+    while (drmModeFormatModifierBlobIterNext(format_blob.raw(), &iter))
+    {
+        formats.emplace_back(iter.fmt, iter.mod);
+    }
+    return formats;
+}
+
+/**
+ * Find the overlay and cursor planes that only \a crtc_id can use, topmost first
+ *
+ * Planes shared between CRTCs are left alone, so one output can never take a plane
+ * another is showing something on. Overlays whose zpos puts them beneath the primary
+ * plane (with \a primary_props) are left alone too, as the composited frame would hide them.
+ */
+auto find_overlay_planes(mir::Fd const& drm_fd, uint32_t crtc_id, mgk::ObjectProperties const& primary_props)
+    -> std::pair<std::vector<mga::OverlayPlane>, std::map<uint32_t, std::unique_ptr<mgk::ObjectProperties>>>
+{
+    std::vector<mga::OverlayPlane> planes;
+    std::map<uint32_t, std::unique_ptr<mgk::ObjectProperties>> plane_props;
+
+    mgk::DRMModeResources resources{drm_fd};
+    int crtc_index{-1};
+    int index{0};
+    for (auto& crtc : resources.crtcs())
+    {
+        if (crtc->crtc_id == crtc_id)
+        {
+            crtc_index = index;
+            break;
+        }
+        ++index;
+    }
+    if (crtc_index < 0)
+    {
+        return {};
+    }
+
+    std::vector<std::pair<uint64_t, mga::OverlayPlane>> overlays;
+    bool all_have_zpos{true};
+    mgk::PlaneResources plane_res{drm_fd};
+    for (auto& plane : plane_res.planes())
+    {
+        if (plane->possible_crtcs != (1u << crtc_index))
+        {
+            continue;
+        }
+
+        auto props = std::make_unique<mgk::ObjectProperties>(drm_fd, plane);
+        auto const type = (*props)["type"];
+        if (type != DRM_PLANE_TYPE_OVERLAY && type != DRM_PLANE_TYPE_CURSOR)
+        {
+            continue;
+        }
+
+        mga::OverlayPlane overlay{plane->plane_id, type == DRM_PLANE_TYPE_CURSOR, plane_formats(drm_fd, plane, *props)};
+        if (overlay.cursor)
+        {
+            // Cursor planes are above everything else
+            planes.push_back(std::move(overlay));
+        }
+        else if (props->has_property("zpos"))
+        {
+            if (primary_props.has_property("zpos") && (*props)["zpos"] <= primary_props["zpos"])
+            {
+                // An underlay; we'd have to punch a hole in the composited frame to show it
+                continue;
+            }
+            overlays.emplace_back((*props)["zpos"], std::move(overlay));
+        }
+        else
+        {
+            all_have_zpos = false;
+            overlays.emplace_back(0, std::move(overlay));
+        }
+        plane_props[plane->plane_id] = std::move(props);
+    }
+
+    std::stable_sort(
+        overlays.begin(),
+        overlays.end(),
+        [](auto const& a, auto const& b) { return a.first > b.first; });
+    if (!all_have_zpos && overlays.size() > 1)
+    {
+        // Without zpos we can't know how overlays stack, only that they're all above the primary
+        overlays.resize(1);
+    }
+    for (auto& [_, overlay] : overlays)
+    {
+        planes.push_back(std::move(overlay));
+    }
+
+    return {std::move(planes), std::move(plane_props)};
+}
 }
 
 class mga::AtomicKMSOutput::PropertyBlob
@@ -186,8 +359,11 @@ private:
  */
 mga::AtomicKMSOutput::AtomicKMSOutput(
     mir::Fd drm_master,
-    kms::DRMModeConnectorUPtr connector)
+    kms::DRMModeConnectorUPtr connector,
+    std::shared_ptr<kms::DRMEventHandler> event_handler)
     : drm_fd_{drm_master},
+      event_handler{std::move(event_handler)},
+      async_flips_supported{atomic_async_flips_supported(drm_fd_)},
       configuration{
           Configuration {
           .connector = std::move(connector),
@@ -198,7 +374,11 @@ mga::AtomicKMSOutput::AtomicKMSOutput(
           .mode = nullptr,
           .crtc_props = nullptr,
           .plane_props = nullptr,
-          .connector_props = nullptr
+          .connector_props = nullptr,
+          .primary_formats = {},
+          .overlays = {},
+          .overlay_props = {},
+          .active_overlays = {}
       }},
       saved_crtc(),
       using_saved_crtc{true}
@@ -219,6 +399,20 @@ mga::AtomicKMSOutput::AtomicKMSOutput(
 
 mga::AtomicKMSOutput::~AtomicKMSOutput()
 {
+    if (pending_page_flip.valid())
+    {
+        using namespace std::chrono_literals;
+        /* The event handler calls back into us when the flip completes, so we must not
+         * leave before it has. If it doesn't come (say, we've lost DRM master) give up on it;
+         * we only cancel after a timeout as a stale cancellation would eat the next flip
+         * expected on this CRTC.
+         */
+        if (pending_page_flip.wait_for(1s) != std::future_status::ready)
+        {
+            event_handler->cancel_flip_events(pending_flip_crtc);
+            pending_page_flip.wait();
+        }
+    }
     restore_saved_crtc();
 }
 
@@ -246,6 +440,7 @@ void mga::AtomicKMSOutput::reset()
             update.add_property(*conf->crtc_props, "MODE_ID", 0);
             update.add_property(*conf->plane_props, "FB_ID", 0);
             update.add_property(*conf->plane_props, "CRTC_ID", 0);
+            switch_off_overlays(update, conf->overlay_props, conf->active_overlays);
 
             if (auto err = drmModeAtomicCommit(drm_fd(), update, DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr))
             {
@@ -386,6 +581,7 @@ void mga::AtomicKMSOutput::clear_crtc()
     update.add_property(*conf->crtc_props, "MODE_ID", 0);
     update.add_property(*conf->plane_props, "FB_ID", 0);
     update.add_property(*conf->plane_props, "CRTC_ID", 0);
+    switch_off_overlays(update, conf->overlay_props, conf->active_overlays);
 
     auto result = drmModeAtomicCommit(drm_fd_, update, DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr);
     if (result)
@@ -414,8 +610,137 @@ void mga::AtomicKMSOutput::clear_crtc()
     conf->current_crtc = nullptr;
 }
 
-bool mga::AtomicKMSOutput::page_flip(FBHandle const& fb)
+auto mga::AtomicKMSOutput::primary_plane_formats() const -> std::vector<std::pair<uint32_t, uint64_t>>
+{
+    auto const conf = configuration.lock();
+    if (!conf->current_crtc)
+    {
+        return {};
+    }
+    return conf->primary_formats;
+}
+
+auto mga::AtomicKMSOutput::overlay_planes() const -> std::vector<OverlayPlane>
+{
+    auto const conf = configuration.lock();
+    if (!cursor_image_set)
+    {
+        return conf->overlays;
+    }
+
+    // The cursor plane is showing the (legacy) hardware cursor
+    std::vector<OverlayPlane> planes;
+    std::copy_if(
+        conf->overlays.begin(),
+        conf->overlays.end(),
+        std::back_inserter(planes),
+        [](auto const& plane) { return !plane.cursor; });
+    return planes;
+}
+
+bool mga::AtomicKMSOutput::test_layers(FBHandle const& primary, std::vector<OverlayLayer> const& layers)
 {
+    auto conf = configuration.lock();
+    if (!conf->current_crtc ||
+        conf->current_crtc->width != primary.size().width.as_uint32_t() ||
+        conf->current_crtc->height != primary.size().height.as_uint32_t())
+    {
+        return false;
+    }
+
+    return commit_planes(*conf, primary, layers, DRM_MODE_ATOMIC_TEST_ONLY, nullptr) == 0;
+}
+
+auto mga::AtomicKMSOutput::commit_planes(
+    Configuration& conf,
+    FBHandle const& fb,
+    std::vector<OverlayLayer> const& layers,
+    uint32_t flags,
+    void* user_data) -> int
+{
+    auto const crtc_id = conf.current_crtc->crtc_id;
+
+    AtomicUpdate update;
+    update.add_property(*conf.crtc_props, "MODE_ID", conf.mode->handle());
+    update.add_property(*conf.connector_props, "CRTC_ID", crtc_id);
+
+    set_plane(
+        update,
+        *conf.plane_props,
+        crtc_id,
+        fb,
+        geom::RectangleF{
+            {conf.fb_offset.dx.as_value(), conf.fb_offset.dy.as_value()},
+            {fb.size().width.as_value(), fb.size().height.as_value()}},
+        geom::Rectangle{{0, 0}, {conf.current_crtc->width, conf.current_crtc->height}});
+
+    std::vector<uint32_t> active_overlays;
+    for (auto const& layer : layers)
+    {
+        auto const props = conf.overlay_props.find(layer.plane_id);
+        if (props == conf.overlay_props.end())
+        {
+            return -EINVAL;
+        }
+        set_plane(update, *props->second, crtc_id, *layer.fb, layer.source, layer.destination);
+        active_overlays.push_back(layer.plane_id);
+    }
+
+    for (auto const plane_id : conf.active_overlays)
+    {
+        if (std::find(active_overlays.begin(), active_overlays.end(), plane_id) != active_overlays.end())
+        {
+            continue;
+        }
+
+        auto const plane = std::find_if(
+            conf.overlays.begin(),
+            conf.overlays.end(),
+            [plane_id](auto const& plane) { return plane.id == plane_id; });
+        if (plane != conf.overlays.end() && plane->cursor && cursor_image_set)
+        {
+            continue;   // The hardware cursor has taken it back
+        }
+        if (auto const props = conf.overlay_props.find(plane_id); props != conf.overlay_props.end())
+        {
+            switch_off_plane(update, *props->second);
+        }
+    }
+
+    auto const ret = drmModeAtomicCommit(drm_fd_, update, flags, user_data);
+    if (ret == 0 && !(flags & DRM_MODE_ATOMIC_TEST_ONLY))
+    {
+        conf.active_overlays = std::move(active_overlays);
+    }
+    return ret;
+}
+
+bool mga::AtomicKMSOutput::schedule_page_flip(FBHandle const& fb, std::vector<OverlayLayer> const& layers)
+{
+    return schedule_flip(fb, layers, false);
+}
+
+bool mga::AtomicKMSOutput::schedule_async_page_flip(FBHandle const& fb)
+{
+    if (!async_flips_supported)
+    {
+        return false;
+    }
+
+    // Asynchronous flips can only change the framebuffer on the primary plane
+    if (!configuration.lock()->active_overlays.empty())
+    {
+        return false;
+    }
+
+    return schedule_flip(fb, {}, true);
+}
+
+bool mga::AtomicKMSOutput::schedule_flip(FBHandle const& fb, std::vector<OverlayLayer> const& layers, bool async)
+{
+    // KMS rejects a commit while one is still pending on the CRTC
+    wait_for_page_flip();
+
     auto conf = configuration.lock();
     if (!ensure_crtc(*conf))
     {
@@ -441,42 +766,94 @@ bool mga::AtomicKMSOutput::page_flip(FBHandle const& fb)
         return false;
     }
 
-    AtomicUpdate update;
-    update.add_property(*conf->crtc_props, "MODE_ID", conf->mode->handle());
-    update.add_property(*conf->connector_props, "CRTC_ID", conf->current_crtc->crtc_id);
-
-    /* Source viewport. Coordinates are 16.16 fixed point format */
-    update.add_property(*conf->plane_props, "SRC_X", conf->fb_offset.dx.as_uint32_t() << 16);
-    update.add_property(*conf->plane_props, "SRC_Y", conf->fb_offset.dy.as_uint32_t() << 16);
-    update.add_property(*conf->plane_props, "SRC_W", fb_width << 16);
-    update.add_property(*conf->plane_props, "SRC_H", fb_height << 16);
-
-    /* Destination viewport. Coordinates are *not* 16.16 */
-    update.add_property(*conf->plane_props, "CRTC_X", 0);
-    update.add_property(*conf->plane_props, "CRTC_Y", 0);
-    update.add_property(*conf->plane_props, "CRTC_W", crtc_width);
-    update.add_property(*conf->plane_props, "CRTC_H", crtc_height);
-
-    /* Set a surface for the plane */
-    update.add_property(*conf->plane_props, "CRTC_ID", conf->current_crtc->crtc_id);
-    update.add_property(*conf->plane_props, "FB_ID", fb);
-
-    auto ret = drmModeAtomicCommit(
-        drm_fd_,
-        update,
-        0,
-        nullptr);
+    pending_flip_crtc = conf->current_crtc->crtc_id;
+    pending_flip_refresh = conf->mode_index < static_cast<size_t>(conf->connector->count_modes) ?
+        mgk::refresh_interval(conf->connector->modes[conf->mode_index]) : std::chrono::nanoseconds::zero();
+    flip_sequence = std::nullopt;
+    pending_page_flip = event_handler->expect_flip_event(
+        pending_flip_crtc,
+        [this](unsigned int frame_number, std::chrono::milliseconds)
+        {
+            flip_sequence = frame_number;
+        });
+
+    auto ret = commit_planes(
+        *conf,
+        fb,
+        layers,
+        DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT | (async ? DRM_MODE_PAGE_FLIP_ASYNC : 0),
+        const_cast<void*>(event_handler->drm_event_data()));
     if (ret)
     {
+        // No event is coming; don't leave the expectation to match a later flip
+        event_handler->cancel_flip_events(pending_flip_crtc);
+        pending_page_flip.wait();
+        pending_page_flip = {};
+
+        if (async)
+        {
+            // Drivers reject asynchronous flips that change more than the framebuffer; the caller can flip vsynced
+            mir::log_debug("Asynchronous page flip rejected: %s (%i)", strerror(-ret), -ret);
+            return false;
+        }
+
         mir::log_error("Failed to schedule page flip: %s (%i)", strerror(-ret), -ret);
         conf->current_crtc = nullptr;
         return false;
     }
 
+    pending_flip_async = async;
     using_saved_crtc = false;
     return true;
 }
 
+auto mga::AtomicKMSOutput::wait_for_page_flip() -> std::optional<FramePresentation>
+{
+    if (!pending_page_flip.valid())
+    {
+        return std::nullopt;
+    }
+
+    pending_page_flip.get();
+    if (!flip_sequence)
+    {
+        // The flip was cancelled
+        return std::nullopt;
+    }
+
+    FramePresentation presentation;
+    presentation.refresh = pending_flip_refresh;
+    presentation.vsync = !pending_flip_async;
+    presentation.hw_completion = true;
+
+    /* The flip event carries only the low 32 bits of the vblank counter, and only a
+     * millisecond-precision timestamp; the kernel's record of the latest vblank has both
+     * in full. That will be the flip's vblank unless we were slow to get here, in which
+     * case count back to it.
+     *
+     * An asynchronous flip completes mid-scanout, so the vblank says nothing about when it did.
+     */
+    uint64_t sequence;
+    uint64_t vblank_ns;
+    if (!pending_flip_async && drmCrtcGetSequence(drm_fd_, pending_flip_crtc, &sequence, &vblank_ns) == 0)
+    {
+        auto const vblanks_since_flip = static_cast<uint32_t>(sequence) - *flip_sequence;
+        presentation.frame.msc = static_cast<int64_t>(sequence - vblanks_since_flip);
+        // DRM vblank timestamps are always CLOCK_MONOTONIC
+        presentation.frame.ust = {
+            CLOCK_MONOTONIC,
+            std::chrono::nanoseconds{vblank_ns} - vblanks_since_flip * presentation.refresh};
+        presentation.hw_clock = true;
+    }
+    else
+    {
+        presentation.frame.msc = *flip_sequence;
+        presentation.frame.ust = Frame::Timestamp::now(CLOCK_MONOTONIC);
+    }
+
+    return presentation;
+}
+
 void mga::AtomicKMSOutput::set_cursor_image(gbm_bo* buffer)
 {
     if (auto conf = configuration.lock(); conf->current_crtc)
@@ -550,6 +927,21 @@ bool mga::AtomicKMSOutput::ensure_crtc(Configuration& to_update)
     to_update.crtc_props = std::make_unique<mgk::ObjectProperties>(drm_fd_, to_update.current_crtc);
     to_update.plane_props = std::make_unique<mgk::ObjectProperties>(drm_fd_, to_update.current_plane);
 
+    to_update.primary_formats = plane_formats(drm_fd_, to_update.current_plane, *to_update.plane_props);
+
+    try
+    {
+        std::tie(to_update.overlays, to_update.overlay_props) =
+            find_overlay_planes(drm_fd_, to_update.current_crtc->crtc_id, *to_update.plane_props);
+    }
+    catch (std::exception const& e)
+    {
+        // We can still composite everything
+        mir::log_warning("Failed to probe overlay planes: %s", e.what());
+        to_update.overlays.clear();
+        to_update.overlay_props.clear();
+    }
+
     return true;
 }
 
@@ -635,6 +1027,7 @@ void mga::AtomicKMSOutput::refresh_hardware_state()
         update.add_property(*conf->crtc_props, "MODE_ID", 0);
         update.add_property(*conf->plane_props, "FB_ID", 0);
         update.add_property(*conf->plane_props, "CRTC_ID", 0);
+        switch_off_overlays(update, conf->overlay_props, conf->active_overlays);
 
         drmModeAtomicCommit(drm_fd(), update, DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr);
 
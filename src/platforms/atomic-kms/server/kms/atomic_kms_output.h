@@ -22,13 +22,22 @@
 #include <mir/fd.h>
 #include <mir/synchronised.h>
 
+#include <chrono>
+#include <map>
 #include <memory>
 #include <future>
+#include <optional>
+#include <vector>
 
 namespace mir
 {
 namespace graphics
 {
+namespace kms
+{
+class DRMEventHandler;
+}
+
 namespace atomic
 {
 
@@ -39,7 +48,8 @@ class AtomicKMSOutput : public KMSOutput
 public:
     AtomicKMSOutput(
         mir::Fd drm_master,
-        kms::DRMModeConnectorUPtr connector);
+        kms::DRMModeConnectorUPtr connector,
+        std::shared_ptr<kms::DRMEventHandler> event_handler);
     ~AtomicKMSOutput();
 
     uint32_t id() const override;
@@ -52,7 +62,12 @@ public:
     bool set_crtc(FBHandle const& fb) override;
     bool has_crtc_mismatch() override;
     void clear_crtc() override;
-    bool page_flip(FBHandle const& fb) override;
+    auto primary_plane_formats() const -> std::vector<std::pair<uint32_t, uint64_t>> override;
+    auto overlay_planes() const -> std::vector<OverlayPlane> override;
+    bool test_layers(FBHandle const& primary, std::vector<OverlayLayer> const& layers) override;
+    bool schedule_page_flip(FBHandle const& fb, std::vector<OverlayLayer> const& layers) override;
+    bool schedule_async_page_flip(FBHandle const& fb) override;
+    auto wait_for_page_flip() -> std::optional<FramePresentation> override;
 
     void set_cursor_image(gbm_bo* buffer) override;
     void move_cursor(geometry::Point destination) override;
@@ -81,14 +96,37 @@ private:
         std::unique_ptr<kms::ObjectProperties> crtc_props;
         std::unique_ptr<kms::ObjectProperties> plane_props;
         std::unique_ptr<kms::ObjectProperties> connector_props;
+        std::vector<std::pair<uint32_t, uint64_t>> primary_formats;
+        std::vector<OverlayPlane> overlays;     //< Topmost first
+        std::map<uint32_t, std::unique_ptr<kms::ObjectProperties>> overlay_props;
+        std::vector<uint32_t> active_overlays;  //< The overlay planes the last flip switched on
     };
 
     bool ensure_crtc(Configuration& to_update);
+    /**
+     * Commit \a fb on the primary plane and \a layers on overlays, switching off any other overlay
+     *
+     * \returns    0 on success, or a negative errno
+     */
+    auto commit_planes(
+        Configuration& conf,
+        FBHandle const& fb,
+        std::vector<OverlayLayer> const& layers,
+        uint32_t flags,
+        void* user_data) -> int;
+    bool schedule_flip(FBHandle const& fb, std::vector<OverlayLayer> const& layers, bool async);
     void restore_saved_crtc();
 
     mir::Fd const drm_fd_;
+    std::shared_ptr<kms::DRMEventHandler> const event_handler;
+    bool const async_flips_supported;   //< The driver accepts DRM_MODE_PAGE_FLIP_ASYNC in atomic commits
 
+    // The flip scheduled by schedule_page_flip(), and what its event told us
     std::future<void> pending_page_flip;
+    uint32_t pending_flip_crtc{0};
+    std::chrono::nanoseconds pending_flip_refresh{0};
+    bool pending_flip_async{false};
+    std::optional<unsigned int> flip_sequence;   //< Written by the event handler before pending_page_flip is ready
 
     mir::Synchronised<Configuration> configuration;
     drmModeCrtc saved_crtc;
@@ -17,6 +17,7 @@
 #include "display_sink.h"
 #include "kms_cpu_addressable_display_provider.h"
 #include "kms_output.h"
+#include "overlay_planes.h"
 #include "cpu_addressable_fb.h"
 #include "gbm_display_allocator.h"
 #include <mir/fd.h>
@@ -42,12 +43,26 @@
 #include <chrono>
 #include <xf86drm.h>
 #include <xf86drmMode.h>
+#include <sys/stat.h>
 
 namespace mg = mir::graphics;
 namespace mga = mir::graphics::atomic;
 namespace geom = mir::geometry;
 namespace mgk = mir::graphics::kms;
 
+namespace
+{
+/* Allowance, beyond the predicted render and commit time, for what we can't measure:
+ * GPU work still in flight when the commit returns, and scheduling jitter in waking up.
+ */
+auto const vblank_slack = std::chrono::milliseconds{2};
+
+auto monotonic_now() -> std::chrono::nanoseconds
+{
+    return mg::Frame::Timestamp::now(CLOCK_MONOTONIC).nanoseconds;
+}
+}
+
 mga::DisplaySink::DisplaySink(
     mir::Fd drm_fd,
     std::shared_ptr<struct gbm_device> gbm,
@@ -129,11 +144,86 @@ bool mga::DisplaySink::overlay(std::vector<DisplayElement> const& renderable_lis
     if (auto fb = std::dynamic_pointer_cast<graphics::FBHandle>(renderable_list[0].buffer))
     {
         next_swap = std::move(fb);
+        next_swap_is_client_buffer = true;
+        next_swap_allows_tearing = renderable_list[0].allow_tearing;
+        next_layers.clear();
         return true;
     }
     return false;
 }
 
+auto mga::DisplaySink::overlay_where_possible(std::vector<DisplayElement> const& renderlist) -> std::vector<bool>
+{
+    next_layers.clear();
+
+    if (std::exchange(layers_rejected, false))
+    {
+        // Composite everything for a frame, rather than leave elements missing
+        return {};
+    }
+
+    /* We'd need to rotate the layers; let the renderer deal with it. We test layers against
+     * what is on screen now, so there must be something.
+     */
+    if (transform != glm::mat2{1} || !visible_fb || needs_set_crtc)
+    {
+        return {};
+    }
+
+    auto const planes = output->overlay_planes();
+    auto const mode_size = output->size();
+    if (planes.empty() || area.size.width.as_int() <= 0 || area.size.height.as_int() <= 0)
+    {
+        return {};
+    }
+
+    std::vector<OverlayCandidate> candidates;
+    candidates.reserve(renderlist.size());
+    for (auto const& element : renderlist)
+    {
+        // The part of the element that is to be shown, in the output's logical coordinates
+        geom::Rectangle const shown{
+            element.screen_positon.top_left - as_displacement(area.top_left) + geom::Displacement{
+                element.source_position.top_left.x.as_value(),
+                element.source_position.top_left.y.as_value()},
+            geom::Size{
+                element.source_position.size.width.as_value(),
+                element.source_position.size.height.as_value()}};
+
+        // ...and where that is on the CRTC, which differs if the output is scaled
+        auto const destination = logical_to_crtc(shown, area.size, mode_size);
+
+        auto fb = std::dynamic_pointer_cast<DmaBufFBHandle const>(element.buffer);
+        if (!fb ||
+            !geom::Rectangle{{0, 0}, mode_size}.contains(destination) ||
+            element.screen_positon.size.width.as_int() <= 0 ||
+            element.screen_positon.size.height.as_int() <= 0)
+        {
+            candidates.push_back({nullptr, 0, 0, destination, {}});
+            continue;
+        }
+
+        // The plane wants the source in buffer pixels
+        auto const source = to_buffer_source(element.source_position, element.screen_positon.size, fb->size());
+
+        auto const format = fb->format();
+        auto const modifier = fb->modifier();
+        candidates.push_back({std::move(fb), format, modifier, destination, source});
+    }
+
+    auto const primary = visible_fb;
+    auto assignment = assign_overlay_planes(
+        candidates,
+        planes,
+        [this, &primary](std::vector<OverlayLayer> const& layers)
+        {
+            return output->test_layers(*primary, layers);
+        });
+
+    next_layers = std::move(assignment.layers);
+    return std::move(assignment.on_plane);
+}
+
 void mga::DisplaySink::for_each_display_sink(std::function<void(graphics::DisplaySink&)> const& f)
 {
     f(*this);
@@ -156,24 +246,66 @@ void mga::DisplaySink::set_crtc(FBHandle const& forced_frame)
 
 void mga::DisplaySink::post()
 {
-    if (!next_swap)
+    presentation = std::nullopt;
+    auto layers = std::move(next_layers);
+    next_layers.clear();
+
+    if (!next_swap && layers.empty())
     {
         // Hey! No one has given us a next frame yet, so we don't have to change what's onscreen.
         // Sweet! We can just bail.
+        compositor_wake = std::nullopt;
         return;
     }
+    if (!next_swap)
+    {
+        // Only what's on the overlays has changed; the composited frame beneath them is still good
+        next_swap = visible_fb;
+    }
     /*
      * Otherwise, pull the next frame into the pending slot
      */
     scheduled_fb = std::move(next_swap);
     next_swap = nullptr;
+    // A client that accepts tearing gets its (directly scanned out) buffer flipped to immediately
+    bool const async = std::exchange(next_swap_allows_tearing, false) && layers.empty();
 
     /*
      * Try to schedule a page flip as first preference to avoid tearing.
-     * We wait synchronously for this to complete.
+     * The commit doesn't block; we wait for the flip event below.
      */
-    if (!needs_set_crtc && !output->page_flip(*scheduled_fb))
-        needs_set_crtc = true;
+    if (!needs_set_crtc &&
+        !(async && output->schedule_async_page_flip(*scheduled_fb)) &&
+        !output->schedule_page_flip(*scheduled_fb, layers))
+    {
+        /* The layers passed a test commit, so this is unlikely to be their fault, but if
+         * it is we can still show the rest of the frame.
+         */
+        if (layers.empty() || !output->schedule_page_flip(*scheduled_fb, {}))
+            needs_set_crtc = true;
+        if (!layers.empty())
+        {
+            layers.clear();
+            layers_rejected = true;
+        }
+    }
+    else if (needs_set_crtc && !layers.empty())
+    {
+        layers.clear();
+        layers_rejected = true;
+    }
+
+    auto const committed = monotonic_now();
+
+    if (!needs_set_crtc)
+    {
+        presentation = output->wait_for_page_flip();
+        if (presentation)
+        {
+            presentation->zero_copy = next_swap_is_client_buffer;
+            listener->report_vsync(output->id(), presentation->frame);
+        }
+    }
 
     /*
      * Fallback blitting: Not pretty, since it may tear. VirtualBox seems
@@ -189,20 +321,64 @@ void mga::DisplaySink::post()
 
     visible_fb = std::move(scheduled_fb);
     scheduled_fb = nullptr;
+    visible_layers = std::move(layers);
+
+    schedule_next_frame(committed);
+}
+
+void mga::DisplaySink::schedule_next_frame(std::chrono::nanoseconds committed)
+{
+    using namespace std::chrono_literals;
+
+    recommend_sleep = 0ms;
 
-    using namespace std::chrono_literals;  // For operator""ms()
+    if (!presentation || !presentation->vsync || presentation->refresh <= 0ns)
+    {
+        // Without knowing when the next vblank is we can't aim for it (and a torn frame needn't wait for one)
+        compositor_wake = std::nullopt;
+        return;
+    }
 
-    // Predicted worst case render time for the next frame...
-    auto predicted_render_time = 50ms;
+    auto const refresh = presentation->refresh;
+    if (compositor_wake && target_msc)
+    {
+        /* If we woke the compositor when we asked to, it spent this long rendering and
+         * committing. If the compositor was idle instead, the time tells us nothing.
+         */
+        auto const frame_time = committed - *compositor_wake;
+        auto const missed = presentation->frame.msc > *target_msc;
+        if (frame_time >= 0ns && frame_time < refresh)
+        {
+            render_time.add_sample(frame_time);
+            if (missed)
+                render_time.missed_deadline();
+        }
+        else if (missed && frame_time >= refresh && frame_time < 2 * refresh)
+        {
+            // Either too slow for the refresh rate or late from idle; assume the worse
+            render_time.add_sample(refresh);
+            render_time.missed_deadline();
+        }
+    }
 
     /*
-     * TODO: Make a sensible predicited_render_time
+     * Start the next frame just in time for it to be committed before the next vblank:
+     * sampling the scene any earlier adds to the latency of everything we show.
      */
+    auto const now = monotonic_now();
+    if (auto const predicted = render_time.prediction())
+    {
+        auto const next_vblank = presentation->frame.ust.nanoseconds + refresh;
+        auto const start_by = next_vblank - *predicted - vblank_slack;
+        if (start_by > now)
+        {
+            // Rounding down wakes us early rather than late
+            recommend_sleep = std::chrono::duration_cast<std::chrono::milliseconds>(start_by - now);
+        }
+    }
 
-    recommend_sleep = 0ms;
-    auto const min_frame_interval = 1000ms / output->max_refresh_rate();
-    if (predicted_render_time < min_frame_interval)
-        recommend_sleep = min_frame_interval - predicted_render_time;
+    compositor_wake = now + recommend_sleep;
+    target_msc = presentation->frame.msc + 1;
 }
 
 std::chrono::milliseconds mga::DisplaySink::recommended_sleep() const
@@ -210,6 +386,38 @@ std::chrono::milliseconds mga::DisplaySink::recommended_sleep() const
     return recommend_sleep;
 }
 
+auto mga::DisplaySink::last_presentation() const -> std::optional<FramePresentation>
+{
+    return presentation;
+}
+
+auto mga::DisplaySink::scanout_formats() const -> std::optional<ScanoutFormats>
+{
+    struct stat info{};
+    if (fstat(output->drm_fd(), &info) != 0)
+    {
+        return std::nullopt;
+    }
+
+    auto formats = output->primary_plane_formats();
+    for (auto const& plane : output->overlay_planes())
+    {
+        // Cursor planes only take small buffers; not worth a client reallocating for
+        if (!plane.cursor)
+        {
+            formats.insert(formats.end(), plane.formats.begin(), plane.formats.end());
+        }
+    }
+    if (formats.empty())
+    {
+        return std::nullopt;
+    }
+
+    std::sort(formats.begin(), formats.end());
+    formats.erase(std::unique(formats.begin(), formats.end()), formats.end());
+    return ScanoutFormats{info.st_rdev, std::move(formats)};
+}
+
 void mga::DisplaySink::schedule_set_crtc()
 {
     needs_set_crtc = true;
@@ -227,20 +435,19 @@ auto mga::DisplaySink::gbm_device() const -> std::shared_ptr<struct gbm_device>
 
 void mga::DisplaySink::set_next_image(std::unique_ptr<Framebuffer> content)
 {
-    std::vector<DisplayElement> const single_buffer = {
-        DisplayElement {
-            view_area(),
-            geom::RectangleF{
-                {0, 0},
-                {view_area().size.width.as_value(), view_area().size.height.as_value()}},
-            std::move(content)
-        }
-    };
-    if (!overlay(single_buffer))
+    // Not via overlay(): this is the frame beneath any layers from overlay_where_possible()
+    std::shared_ptr<Framebuffer> frame{std::move(content)};
+    auto fb = std::dynamic_pointer_cast<graphics::FBHandle>(frame);
+    if (!fb)
     {
-        // Oh, oh! We should be *guaranteed* to “overlay” a single Framebuffer; this is likely a programming error
+        // Oh, oh! We should be *guaranteed* to be able to display a Framebuffer we allocated;
+        // this is likely a programming error
         BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to post buffer to display"}));
     }
+    next_swap = std::move(fb);
+    // ...and this is a frame we composited, not a client buffer
+    next_swap_is_client_buffer = false;
+    next_swap_allows_tearing = false;
 }
 
 namespace {
@@ -362,32 +569,45 @@ auto mga::DmaBufDisplayAllocator::framebuffer_for(std::shared_ptr<DMABufBuffer>
         return {};
     }
 
-    struct AtomicKmsFbHandle : public mg::FBHandle
-    {
-        AtomicKmsFbHandle(std::shared_ptr<uint32_t> fb_handle, geometry::Size size) :
-            kms_fb_id{fb_handle},
-            size_{size}
-        {
-        }
+    buffer->on_consumed();
 
-        virtual auto size() const -> geometry::Size override
-        {
-            return size_;
-        }
+    return std::make_unique<DmaBufFBHandle>(
+        fb_id,
+        buffer->size(),
+        buffer->format(),
+        buffer->modifier().value_or(DRM_FORMAT_MOD_INVALID));
+}
 
-        virtual operator uint32_t() const override
-        {
-            return *kms_fb_id;
-        }
+mga::DmaBufFBHandle::DmaBufFBHandle(
+    std::shared_ptr<uint32_t> fb_id,
+    geometry::Size size,
+    uint32_t format,
+    uint64_t modifier)
+    : fb_id{std::move(fb_id)},
+      size_{size},
+      format_{format},
+      modifier_{modifier}
+{
+}
 
-    private:
-        std::shared_ptr<uint32_t> kms_fb_id;
-        geometry::Size size_;
-    };
+auto mga::DmaBufFBHandle::size() const -> geometry::Size
+{
+    return size_;
+}
 
-    buffer->on_consumed();
+mga::DmaBufFBHandle::operator uint32_t() const
+{
+    return *fb_id;
+}
+
+auto mga::DmaBufFBHandle::format() const -> uint32_t
+{
+    return format_;
+}
 
-    return std::make_unique<AtomicKmsFbHandle>(fb_id, buffer->size());
+auto mga::DmaBufFBHandle::modifier() const -> uint64_t
+{
+    return modifier_;
 }
 
 auto mga::DisplaySink::maybe_create_allocator(DisplayAllocator::Tag const& type_tag)
@@ -24,6 +24,8 @@
 #include <mir/graphics/platform.h>
 #include "platform_common.h"
 #include "kms_framebuffer.h"
+#include "kms_output.h"
+#include "render_time_predictor.h"
 
 #include <boost/iostreams/detail/buffer.hpp>
 #include <future>
@@ -51,6 +53,27 @@ class Platform;
 class KMSOutput;
 class GbmQuirks;
 
+/// A client's dma-buf, imported for scanout
+class DmaBufFBHandle : public FBHandle
+{
+public:
+    DmaBufFBHandle(std::shared_ptr<uint32_t> fb_id, geometry::Size size, uint32_t format, uint64_t modifier);
+
+    auto size() const -> geometry::Size override;
+    operator uint32_t() const override;
+
+    /// The DRM fourcc format of the buffer
+    auto format() const -> uint32_t;
+    /// The DRM format modifier of the buffer; DRM_FORMAT_MOD_INVALID if implicit
+    auto modifier() const -> uint64_t;
+
+private:
+    std::shared_ptr<uint32_t> const fb_id;
+    geometry::Size const size_;
+    uint32_t const format_;
+    uint64_t const modifier_;
+};
+
 class DmaBufDisplayAllocator : public graphics::DmaBufDisplayAllocator
 {
     public:
@@ -94,6 +117,7 @@ public:
     void set_next_image(std::unique_ptr<Framebuffer> content) override;
 
     bool overlay(std::vector<DisplayElement> const& renderlist) override;
+    auto overlay_where_possible(std::vector<DisplayElement> const& renderlist) -> std::vector<bool> override;
 
     void for_each_display_sink(
         std::function<void(graphics::DisplaySink&)> const& f) override;
@@ -101,6 +125,8 @@ public:
     std::chrono::milliseconds recommended_sleep() const override;
 
     glm::mat2 transformation() const override;
+    auto last_presentation() const -> std::optional<FramePresentation> override;
+    auto scanout_formats() const -> std::optional<ScanoutFormats> override;
 
     void set_transformation(glm::mat2 const& t, geometry::Rectangle const& a);
     void schedule_set_crtc();
@@ -114,6 +140,8 @@ protected:
 
 private:
     void set_crtc(FBHandle const&);
+    /// Work out recommend_sleep from how the frame just posted was presented
+    void schedule_next_frame(std::chrono::nanoseconds committed);
 
     std::shared_ptr<struct gbm_device> const gbm;
     std::shared_ptr<DisplayReport> const listener;
@@ -130,12 +158,22 @@ private:
     std::shared_ptr<FBHandle const> next_swap{nullptr};    //< Next frame to submit to the hardware
     std::shared_ptr<FBHandle const> scheduled_fb{nullptr}; //< Frame currently submitted to the hardware, not yet on-screen
     std::shared_ptr<FBHandle const> visible_fb{nullptr};   //< Frame currently onscreen
+    bool next_swap_is_client_buffer{false};                //< next_swap came from overlay(), not set_next_image()
+    bool next_swap_allows_tearing{false};                  //< next_swap may be flipped to asynchronously
+    // The same, for what's shown on overlay planes above the frame
+    std::vector<OverlayLayer> next_layers;
+    std::vector<OverlayLayer> visible_layers;
+    bool layers_rejected{false};                            //< The last frame's layers failed to commit
 
     geometry::Rectangle area;
     glm::mat2 transform;
     std::atomic<bool> needs_set_crtc;
     std::chrono::milliseconds recommend_sleep{0};
+    RenderTimePredictor render_time;
+    std::optional<std::chrono::nanoseconds> compositor_wake;   //< When (CLOCK_MONOTONIC) we expect the next frame to start
+    std::optional<int64_t> target_msc;                         //< The vblank the next frame is aiming for
     std::shared_ptr<GbmQuirks> const gbm_quirks;
+    std::optional<FramePresentation> presentation; //< How the last frame posted reached the screen
 };
 
 }
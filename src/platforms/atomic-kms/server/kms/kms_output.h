@@ -20,6 +20,7 @@
 #include <mir/geometry/size.h>
 #include <mir/geometry/point.h>
 #include <mir/geometry/displacement.h>
+#include <mir/geometry/rectangle.h>
 #include <mir/graphics/display_configuration.h>
 #include <mir/graphics/frame.h>
 #include <mir/graphics/dmabuf_buffer.h>
@@ -28,6 +29,11 @@
 
 #include <gbm.h>
 
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
 namespace mir
 {
 namespace graphics
@@ -38,6 +44,25 @@ class FBHandle;
 namespace atomic
 {
 
+/// A plane (other than the primary) that can show a buffer above the composited image
+struct OverlayPlane
+{
+    uint32_t id;
+    bool cursor;                                        //< Cursor planes typically can't scale
+    std::vector<std::pair<uint32_t, uint64_t>> formats; //< Supported {format, modifier} pairs
+
+    auto supports(uint32_t format, uint64_t modifier) const -> bool;
+};
+
+/// A buffer to show on an overlay plane
+struct OverlayLayer
+{
+    uint32_t plane_id;
+    std::shared_ptr<FBHandle const> fb;
+    geometry::Rectangle destination;    //< Relative to the output's top left
+    geometry::RectangleF source;        //< In buffer pixels
+};
+
 class KMSOutput
 {
 public:
@@ -70,7 +95,43 @@ public:
     virtual bool has_crtc_mismatch() = 0;
     virtual void clear_crtc() = 0;
 
-    virtual bool page_flip(FBHandle const& fb) = 0;
+    /// The {format, modifier} pairs the primary plane of this output can show
+    virtual auto primary_plane_formats() const -> std::vector<std::pair<uint32_t, uint64_t>> = 0;
+
+    /**
+     * The overlay planes this output can use, topmost first
+     *
+     * These are only the planes that can't be claimed by another output.
+     */
+    virtual auto overlay_planes() const -> std::vector<OverlayPlane> = 0;
+
+    /**
+     * Check, without changing anything, whether the hardware can show \a layers above \a primary
+     */
+    virtual bool test_layers(FBHandle const& primary, std::vector<OverlayLayer> const& layers) = 0;
+
+    /**
+     * Commit \a fb, with \a layers above it, to be shown from the next vblank, without waiting for it
+     *
+     * Any overlay plane not in \a layers is switched off.
+     *
+     * \returns    false if the flip could not be scheduled; set_crtc() is needed instead
+     */
+    virtual bool schedule_page_flip(FBHandle const& fb, std::vector<OverlayLayer> const& layers) = 0;
+    /**
+     * Commit \a fb, with no overlays, to be shown as soon as possible (tearing) rather than from the next vblank
+     *
+     * \returns    false if the hardware can't flip asynchronously; nothing has been scheduled,
+     *              and the caller should fall back to schedule_page_flip()
+     */
+    virtual bool schedule_async_page_flip(FBHandle const& fb) = 0;
+    /**
+     * Wait for the flip scheduled by schedule_page_flip() to complete
+     *
+     * \returns    How the flip reached the screen, or std::nullopt if there
+     *              was nothing to wait for or the hardware could not tell us
+     */
+    virtual auto wait_for_page_flip() -> std::optional<FramePresentation> = 0;
 
     virtual void set_cursor_image(gbm_bo* buffer) = 0;
     virtual void move_cursor(geometry::Point destination) = 0;
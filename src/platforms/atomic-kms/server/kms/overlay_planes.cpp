@@ -0,0 +1,123 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "overlay_planes.h"
+
+#include <drm_fourcc.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace mga = mir::graphics::atomic;
+namespace geom = mir::geometry;
+
+auto mga::OverlayPlane::supports(uint32_t format, uint64_t modifier) const -> bool
+{
+    return std::any_of(
+        formats.begin(),
+        formats.end(),
+        [&](auto const& supported)
+        {
+            // An invalid modifier on either side means "whatever the driver picked"; let the test commit decide
+            return supported.first == format &&
+                (supported.second == modifier ||
+                 supported.second == DRM_FORMAT_MOD_INVALID ||
+                 modifier == DRM_FORMAT_MOD_INVALID);
+        });
+}
+
+auto mga::logical_to_crtc(geom::Rectangle const& logical, geom::Size view_size, geom::Size mode_size)
+    -> geom::Rectangle
+{
+    auto const x_scale = mode_size.width.as_int() / double(view_size.width.as_int());
+    auto const y_scale = mode_size.height.as_int() / double(view_size.height.as_int());
+
+    auto const left = static_cast<int>(std::lround(logical.left().as_int() * x_scale));
+    auto const top = static_cast<int>(std::lround(logical.top().as_int() * y_scale));
+    auto const right = static_cast<int>(std::lround(logical.right().as_int() * x_scale));
+    auto const bottom = static_cast<int>(std::lround(logical.bottom().as_int() * y_scale));
+
+    return {{left, top}, {right - left, bottom - top}};
+}
+
+auto mga::to_buffer_source(geom::RectangleF const& source, geom::Size screen_size, geom::Size buffer_size)
+    -> geom::RectangleF
+{
+    auto const x_scale = buffer_size.width.as_value() / float(screen_size.width.as_int());
+    auto const y_scale = buffer_size.height.as_value() / float(screen_size.height.as_int());
+
+    return {
+        {source.top_left.x.as_value() * x_scale, source.top_left.y.as_value() * y_scale},
+        {source.size.width.as_value() * x_scale, source.size.height.as_value() * y_scale}};
+}
+
+namespace
+{
+auto is_scaled(mga::OverlayCandidate const& candidate) -> bool
+{
+    return candidate.source.size.width.as_value() != candidate.destination.size.width.as_int() ||
+           candidate.source.size.height.as_value() != candidate.destination.size.height.as_int();
+}
+}
+
+auto mga::assign_overlay_planes(
+    std::vector<OverlayCandidate> const& candidates,
+    std::vector<OverlayPlane> const& planes,
+    std::function<bool(std::vector<OverlayLayer> const&)> const& test) -> OverlayAssignment
+{
+    OverlayAssignment result{std::vector<bool>(candidates.size(), false), {}};
+    std::vector<geom::Rectangle> composited_above;
+
+    auto next_plane = planes.begin();
+    for (auto i = candidates.size(); i-- != 0;)
+    {
+        auto const& candidate = candidates[i];
+
+        auto const hidden_by_composited = std::any_of(
+            composited_above.begin(),
+            composited_above.end(),
+            [&](auto const& above) { return above.overlaps(candidate.destination); });
+
+        if (candidate.fb && !hidden_by_composited)
+        {
+            auto const plane = std::find_if(
+                next_plane,
+                planes.end(),
+                [&](OverlayPlane const& plane)
+                {
+                    return plane.supports(candidate.format, candidate.modifier) &&
+                        !(plane.cursor && is_scaled(candidate));
+                });
+
+            if (plane != planes.end())
+            {
+                result.layers.push_back({plane->id, candidate.fb, candidate.destination, candidate.source});
+                if (test(result.layers))
+                {
+                    result.on_plane[i] = true;
+                    next_plane = std::next(plane);
+                    continue;
+                }
+                result.layers.pop_back();
+            }
+        }
+
+        composited_above.push_back(candidate.destination);
+    }
+
+    // We walked the scene top-down, so the layers are topmost first
+    return result;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_ATOMIC_KMS_OVERLAY_PLANES_H_
+#define MIR_GRAPHICS_ATOMIC_KMS_OVERLAY_PLANES_H_
+
+#include "kms_output.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace atomic
+{
+/// An element of the scene that might be shown on an overlay plane
+struct OverlayCandidate
+{
+    std::shared_ptr<FBHandle const> fb;     //< null if the element has to be composited
+    uint32_t format;
+    uint64_t modifier;
+    geometry::Rectangle destination;        //< In CRTC pixels, relative to the output's top left
+    geometry::RectangleF source;            //< In buffer pixels
+};
+
+struct OverlayAssignment
+{
+    std::vector<bool> on_plane;             //< For each candidate, whether it is in layers
+    std::vector<OverlayLayer> layers;
+};
+
+/**
+ * Where \a logical, in the output's logical coordinates relative to its top left, is shown on the CRTC
+ *
+ * The output shows \a view_size of the scene scaled to fill \a mode_size, so on a scaled output the
+ * rectangle in CRTC pixels differs from the logical one. Each edge is rounded to the nearest pixel
+ * separately, so elements that abut in the scene still abut on screen. Transformed (rotated or
+ * reflected) outputs are not handled.
+ */
+auto logical_to_crtc(
+    geometry::Rectangle const& logical,
+    geometry::Size view_size,
+    geometry::Size mode_size) -> geometry::Rectangle;
+
+/**
+ * The part of a buffer of \a buffer_size that \a source, in screen pixels relative to the element, shows
+ *
+ * An element is \a screen_size on screen whatever the size of its buffer, so the source is scaled
+ * from screen pixels to buffer pixels.
+ */
+auto to_buffer_source(
+    geometry::RectangleF const& source,
+    geometry::Size screen_size,
+    geometry::Size buffer_size) -> geometry::RectangleF;
+
+/**
+ * Choose which of \a candidates to show on \a planes, rather than compositing them
+ *
+ * Candidates are taken from the top of the scene down, each onto a plane below those already
+ * used. A candidate that overlaps anything above it that is being composited can't be taken,
+ * as the composited image is beneath every overlay. Each tentative assignment is checked with
+ * \a test, which should ask the hardware whether it can show the layers as given.
+ *
+ * \param candidates    The scene, bottom to top
+ * \param planes        The available planes, topmost first
+ * \param test          Whether the hardware accepts a set of layers
+ */
+auto assign_overlay_planes(
+    std::vector<OverlayCandidate> const& candidates,
+    std::vector<OverlayPlane> const& planes,
+    std::function<bool(std::vector<OverlayLayer> const&)> const& test) -> OverlayAssignment;
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_ATOMIC_KMS_OVERLAY_PLANES_H_ */
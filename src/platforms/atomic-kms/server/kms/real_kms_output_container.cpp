@@ -18,12 +18,14 @@
 #include "real_kms_output_container.h"
 #include "atomic_kms_output.h"
 #include "kms-utils/drm_mode_resources.h"
+#include "kms-utils/threaded_drm_event_handler.h"
 
 namespace mga = mir::graphics::atomic;
 
 mga::RealKMSOutputContainer::RealKMSOutputContainer(
     mir::Fd drm_fd)
-    : drm_fd{std::move(drm_fd)}
+    : drm_fd{std::move(drm_fd)},
+      event_handler{std::make_shared<kms::ThreadedDRMEventHandler>(this->drm_fd)}
 {
 }
 
@@ -66,7 +68,8 @@ void mga::RealKMSOutputContainer::update_from_hardware_state()
         {
             new_outputs.push_back(std::make_shared<AtomicKMSOutput>(
                 drm_fd,
-                std::move(connector)));
+                std::move(connector),
+                event_handler));
         }
     }
 
@@ -25,6 +25,10 @@ namespace mir
 {
 namespace graphics
 {
+namespace kms
+{
+class DRMEventHandler;
+}
 
 namespace atomic
 {
@@ -39,6 +43,8 @@ public:
     void update_from_hardware_state() override;
 private:
     mir::Fd const drm_fd;
+    // All outputs on a device share the one DRM fd, so they must share the one reader of its events
+    std::shared_ptr<kms::DRMEventHandler> const event_handler;
     std::vector<std::shared_ptr<KMSOutput>> outputs;
 };
 
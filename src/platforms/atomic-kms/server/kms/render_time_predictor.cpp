@@ -0,0 +1,59 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "render_time_predictor.h"
+
+namespace mga = mir::graphics::atomic;
+
+namespace
+{
+// Weights as for TCP's smoothed round-trip time (RFC 6298): α = 1/8, β = 1/4, K = 4
+int const average_weight_shift{3};
+int const deviation_weight_shift{2};
+int const deviation_multiple{4};
+}
+
+void mga::RenderTimePredictor::add_sample(std::chrono::nanoseconds frame_time)
+{
+    if (!average)
+    {
+        average = frame_time;
+        deviation = frame_time / 2;
+        return;
+    }
+
+    auto const error = frame_time - *average;
+    deviation += (abs(error) - deviation) / (1 << deviation_weight_shift);
+    *average += error / (1 << average_weight_shift);
+}
+
+void mga::RenderTimePredictor::missed_deadline()
+{
+    if (average)
+    {
+        // Double the prediction by widening the margin; on-time frames will shrink it back again
+        deviation = 2 * deviation + *average / deviation_multiple;
+    }
+}
+
+auto mga::RenderTimePredictor::prediction() const -> std::optional<std::chrono::nanoseconds>
+{
+    if (!average)
+    {
+        return std::nullopt;
+    }
+    return *average + deviation_multiple * deviation;
+}
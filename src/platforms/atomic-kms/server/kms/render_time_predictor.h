@@ -0,0 +1,61 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_ATOMIC_KMS_RENDER_TIME_PREDICTOR_H_
+#define MIR_GRAPHICS_ATOMIC_KMS_RENDER_TIME_PREDICTOR_H_
+
+#include <chrono>
+#include <optional>
+
+namespace mir
+{
+namespace graphics
+{
+namespace atomic
+{
+/**
+ * Predicts how long the next frame will take from waking the compositor to committing it
+ *
+ * Keeps exponentially weighted moving averages of recent frame times and of their deviation
+ * from that average (the same estimator TCP uses for round-trip times), and predicts the
+ * average plus a multiple of the deviation, so that occasional slow frames widen the margin
+ * rather than being missed.
+ */
+class RenderTimePredictor
+{
+public:
+    /// Record how long a frame took to render and commit
+    void add_sample(std::chrono::nanoseconds frame_time);
+
+    /**
+     * Record that a frame missed the vblank it was aiming for
+     *
+     * Whatever the samples say, the prediction was too optimistic; back off.
+     */
+    void missed_deadline();
+
+    /// The predicted time for the next frame, or std::nullopt if there is no history yet
+    auto prediction() const -> std::optional<std::chrono::nanoseconds>;
+
+private:
+    std::optional<std::chrono::nanoseconds> average;
+    std::chrono::nanoseconds deviation{0};
+};
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_ATOMIC_KMS_RENDER_TIME_PREDICTOR_H_ */
@@ -46,15 +46,6 @@ class mg::CPUAddressableFB::Buffer : public mir::renderer::software::RWMappable
         {
         }
 
-        ~Mapping()
-        {
-            if (::munmap(const_cast<typename std::remove_const<T>::type *>(data_), len_) == -1)
-            {
-                // It's unclear how this could happen, but tell *someone* about it if it does!
-                log_error("Failed to unmap CPU buffer: %s (%i)", strerror(errno), errno);
-            }
-        }
-
         [[nodiscard]]
         auto format() const -> MirPixelFormat
         {
@@ -96,6 +87,12 @@ class mg::CPUAddressableFB::Buffer : public mir::renderer::software::RWMappable
 public:
     ~Buffer()
     {
+        if (mapped && ::munmap(mapped, size_) == -1)
+        {
+            // It's unclear how this could happen, but tell *someone* about it if it does!
+            log_error("Failed to unmap CPU buffer: %s (%i)", strerror(errno), errno);
+        }
+
         struct drm_mode_destroy_dumb params = { gem_handle };
 
         if (auto const err = drmIoctl(drm_fd, DRM_IOCTL_MODE_DESTROY_DUMB, &params))
@@ -128,23 +125,22 @@ public:
 
     auto map_writeable() -> std::unique_ptr<mir::renderer::software::Mapping<std::byte>> override
     {
-        auto const data = mmap_buffer(PROT_WRITE);
-        return std::make_unique<Mapping<std::byte>>(
-            width(), height(),
-            pitch(),
-            format(),
-            static_cast<std::byte*>(data),
-            size_);
+        return map_rw();
     }
 
     auto map_rw() -> std::unique_ptr<mir::renderer::software::Mapping<std::byte>> override
     {
-        auto const data = mmap_buffer(PROT_READ | PROT_WRITE);
+        // Buffers are mapped once and stay mapped: a buffer is written every frame it is
+        // used, and mapping it afresh each time costs a syscall and a page fault per page.
+        if (!mapped)
+        {
+            mapped = mmap_buffer(PROT_READ | PROT_WRITE);
+        }
         return std::make_unique<Mapping<std::byte>>(
             width(), height(),
             pitch(),
             format(),
-            static_cast<std::byte*>(data),
+            static_cast<std::byte*>(mapped),
             size_);
     }
 
@@ -236,6 +232,7 @@ private:
     DRMFormat const format_;
     uint32_t const gem_handle;
     size_t const size_;
+    void* mapped{nullptr};
 };
 
 mg::CPUAddressableFB::CPUAddressableFB(
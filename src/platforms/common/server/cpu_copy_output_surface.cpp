@@ -16,6 +16,7 @@
 
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <GLES3/gl3.h>
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
@@ -30,6 +31,10 @@
 #include "cpu_copy_output_surface.h"
 #include "egl_helpers.h"
 
+#include <array>
+#include <cstring>
+#include <deque>
+
 namespace mg = mir::graphics;
 namespace mgc = mg::common;
 namespace geom = mir::geometry;
@@ -78,15 +83,11 @@ private:
 
 using RenderbufferHandle = GLHandle<&glGenRenderbuffers, &glDeleteRenderbuffers>;
 using FramebufferHandle = GLHandle<&glGenFramebuffers, &glDeleteFramebuffers>;
+using BufferHandle = GLHandle<&glGenBuffers, &glDeleteBuffers>;
 
 auto create_current_context(EGLDisplay dpy, EGLContext share_ctx)
     -> EGLContext
 {
-    static const EGLint context_attr[] = {
-        EGL_CONTEXT_CLIENT_VERSION, 2,
-        EGL_NONE
-    };
-
     auto egl_extensions = eglQueryString(dpy, EGL_EXTENSIONS);
     if (strstr(egl_extensions, "EGL_KHR_no_config_context") == nullptr)
     {
@@ -95,7 +96,23 @@ auto create_current_context(EGLDisplay dpy, EGLContext share_ctx)
     }
 
     eglBindAPI(EGL_OPENGL_ES_API);
-    auto ctx = eglCreateContext(dpy, EGL_NO_CONFIG_KHR, share_ctx, context_attr);
+
+    // GLES 3 gives us pixel buffer objects and fences for asynchronous readback, but we can manage without
+    EGLContext ctx{EGL_NO_CONTEXT};
+    for (EGLint const version : {3, 2})
+    {
+        EGLint const context_attr[] = {
+            EGL_CONTEXT_CLIENT_VERSION, version,
+            EGL_NONE
+        };
+        ctx = eglCreateContext(dpy, EGL_NO_CONFIG_KHR, share_ctx, context_attr);
+        if (ctx != EGL_NO_CONTEXT)
+            break;
+    }
+    if (ctx == EGL_NO_CONTEXT)
+    {
+        BOOST_THROW_EXCEPTION(mg::egl_error("Failed to create EGL context"));
+    }
 
     if (eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx) != EGL_TRUE)
     {
@@ -104,6 +121,34 @@ auto create_current_context(EGLDisplay dpy, EGLContext share_ctx)
     return ctx;
 }
 
+auto client_version_of(EGLDisplay dpy, EGLContext ctx) -> EGLint
+{
+    EGLint version{0};
+    eglQueryContext(dpy, ctx, EGL_CONTEXT_CLIENT_VERSION, &version);
+    return version;
+}
+
+/// How many frames of damage we remember; anything older is treated as entirely changed
+size_t constexpr max_tracked_age = 4;
+
+/// The rows [begin, end) of the output that changed
+struct Rows
+{
+    int begin;
+    int end;
+
+    auto empty() const -> bool { return begin >= end; }
+};
+
+auto union_of(Rows const& a, Rows const& b) -> Rows
+{
+    if (a.empty())
+        return b;
+    if (b.empty())
+        return a;
+    return {std::min(a.begin, b.begin), std::max(a.end, b.end)};
+}
+
 auto select_format_from(mg::CPUAddressableDisplayAllocator const& provider) -> mg::DRMFormat
 {
     std::optional<mg::DRMFormat> best_format;
@@ -141,7 +186,8 @@ public:
         EGLDisplay dpy,
         EGLContext share_ctx,
         mg::CPUAddressableDisplayAllocator& allocator,
-        GLConfig const& config);
+        GLConfig const& config,
+        OutputReadback readback);
 
     ~Impl();
 
@@ -155,22 +201,59 @@ public:
     auto size() const -> geom::Size;
     auto layout() const -> Layout;
 
+    auto buffer_age() const -> int;
+    void set_damage(std::optional<geom::Rectangle> const& damage);
+    auto has_pending_frame() const -> bool;
+    void discard_pending_frame();
+
 private:
+    /// A pixel buffer object the frame is read back into, and the fence marking the end of the readback
+    struct PixelBuffer
+    {
+        BufferHandle pbo;
+        GLsync fence{nullptr};
+        uint64_t frame{0};      //< The frame the buffer holds; 0 for none
+    };
+
+    auto pixel_layout() const -> GLenum;
+    auto rows_changed_between(uint64_t since, uint64_t until) const -> std::optional<Rows>;
+    auto stale_rows(mg::CPUAddressableDisplayAllocator::MappableFB const& fb, uint64_t content) const -> Rows;
+    void read_into(PixelBuffer& buffer);
+    void copy_out(PixelBuffer& buffer, mg::CPUAddressableDisplayAllocator::MappableFB& fb);
+    void read_pixels_into(mg::CPUAddressableDisplayAllocator::MappableFB& fb);
+    void record_displayed(uint64_t content);
+
     mg::CPUAddressableDisplayAllocator& allocator;
     EGLDisplay const dpy;
     EGLContext ctx;
+    EGLint const gles_version;
     DRMFormat const format;
     RenderbufferHandle colour_buffer;
     std::shared_ptr<RenderbufferHandle> depth_stencil_buffer;
     FramebufferHandle fbo;
+
+    /// Empty unless readback is deferred (which needs GLES 3)
+    std::vector<PixelBuffer> pixel_buffers;
+    /// The pixel buffer holding a frame yet to be returned from commit()
+    PixelBuffer* pending{nullptr};
+    /// The pixel buffer holding the frame last returned from commit()
+    PixelBuffer* last_displayed{nullptr};
+
+    uint64_t frame{0};
+    std::optional<Rows> frame_damage;
+    /// The rows changed by each recent frame, most recent last; std::nullopt for all of them
+    std::deque<std::optional<Rows>> damage_history;
+    /// The frame written into each framebuffer we returned from commit(), most recent last
+    std::deque<uint64_t> displayed_frames;
 };
 
 mgc::CPUCopyOutputSurface::CPUCopyOutputSurface(
         EGLDisplay dpy,
         EGLContext share_ctx,
         mg::CPUAddressableDisplayAllocator& allocator,
-        GLConfig const& config)
-        : impl{std::make_unique<Impl>(dpy, share_ctx, allocator, config)}
+        GLConfig const& config,
+        OutputReadback readback)
+        : impl{std::make_unique<Impl>(dpy, share_ctx, allocator, config, readback)}
 {
 }
 
@@ -206,14 +289,36 @@ auto mgc::CPUCopyOutputSurface::layout() const -> Layout
     return impl->layout();
 }
 
+auto mgc::CPUCopyOutputSurface::buffer_age() const -> int
+{
+    return impl->buffer_age();
+}
+
+void mgc::CPUCopyOutputSurface::set_damage(std::optional<geom::Rectangle> const& damage)
+{
+    impl->set_damage(damage);
+}
+
+auto mgc::CPUCopyOutputSurface::has_pending_frame() const -> bool
+{
+    return impl->has_pending_frame();
+}
+
+void mgc::CPUCopyOutputSurface::discard_pending_frame()
+{
+    impl->discard_pending_frame();
+}
+
 mgc::CPUCopyOutputSurface::Impl::Impl(
     EGLDisplay dpy,
     EGLContext share_ctx,
     mg::CPUAddressableDisplayAllocator& allocator,
-    GLConfig const& config)
+    GLConfig const& config,
+    OutputReadback readback)
     : allocator{allocator},
       dpy{dpy},
       ctx{create_current_context(dpy, share_ctx)},
+      gles_version{client_version_of(dpy, ctx)},
       format{select_format_from(allocator)}
 {
     glBindRenderbuffer(GL_RENDERBUFFER, colour_buffer);
@@ -266,6 +371,24 @@ mgc::CPUCopyOutputSurface::Impl::Impl(
                         std::string{"Unknown GL framebuffer error code: "} + std::to_string(status)}));
         }
     }
+
+    // Reading synchronously through a pixel buffer object would only add a copy, so only deferred readback uses them
+    if (readback == OutputReadback::deferred && gles_version >= 3)
+    {
+        // One to read the frame just rendered into, and one for the frame before it
+        pixel_buffers.resize(2);
+        GLsizeiptr const frame_bytes = size().width.as_int() * size().height.as_int() * 4;
+        for (auto& buffer : pixel_buffers)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, frame_bytes, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    else if (readback == OutputReadback::deferred)
+    {
+        mir::log_info("GLES 3 unavailable; reading back output frames synchronously");
+    }
 }
 
 mgc::CPUCopyOutputSurface::Impl::~Impl()
@@ -288,6 +411,12 @@ mgc::CPUCopyOutputSurface::Impl::~Impl()
         }();
 
     // We're the current EGL context; destroy our GL resources...
+    for (auto& buffer : pixel_buffers)
+    {
+        if (buffer.fence)
+            glDeleteSync(buffer.fence);
+        buffer.pbo.reset();
+    }
     fbo.reset();
     colour_buffer.reset();
 
@@ -321,32 +450,215 @@ auto mgc::CPUCopyOutputSurface::Impl::commit() -> std::unique_ptr<mg::Framebuffe
 {
     auto fb = allocator.alloc_fb(format);
     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    ++frame;
+    damage_history.push_back(std::exchange(frame_damage, std::nullopt));
+    while (damage_history.size() > max_tracked_age)
+    {
+        damage_history.pop_front();
+    }
+
+    if (pixel_buffers.empty())
+    {
+        read_pixels_into(*fb);
+        return fb;
+    }
+
+    auto const changed = damage_history.back();
+    if (changed && changed->empty() && (pending || last_displayed))
+    {
+        // Nothing changed since the pending (or displayed) frame, so it is up to date
+        copy_out(*(pending ? pending : last_displayed), *fb);
+        pending = nullptr;
+        return fb;
+    }
+
+    // Display the previous frame while this one is read back
+    auto const previous = pending ? pending : last_displayed;
+
+    // Read into a buffer not holding that, preferring the more up to date
+    PixelBuffer* target{nullptr};
+    for (auto& buffer : pixel_buffers)
+    {
+        if (&buffer != previous && (!target || buffer.frame > target->frame))
+        {
+            target = &buffer;
+        }
+    }
+    read_into(*target);
+
+    if (previous)
+    {
+        copy_out(*previous, *fb);
+        pending = target;
+    }
+    else
+    {
+        copy_out(*target, *fb);
+        pending = nullptr;
+    }
+    return fb;
+}
+
+auto mgc::CPUCopyOutputSurface::Impl::pixel_layout() const -> GLenum
+{
+    /* TODO: We can usefully put this *into* DRMFormat */
+    if (format == DRM_FORMAT_ARGB8888 || format == DRM_FORMAT_XRGB8888)
+    {
+        return GL_BGRA_EXT;
+    }
+    else if (format == DRM_FORMAT_RGBA8888 || format == DRM_FORMAT_RGBX8888)
+    {
+        return GL_RGBA;
+    }
+    return GL_INVALID_ENUM;
+}
+
+auto mgc::CPUCopyOutputSurface::Impl::rows_changed_between(uint64_t since, uint64_t until) const -> std::optional<Rows>
+{
+    if (since == 0 || since > until || frame - since > damage_history.size())
+    {
+        return std::nullopt;
+    }
+
+    Rows changed{0, 0};
+    auto const newest = damage_history.end() - (frame - until);
+    for (auto i = damage_history.end() - (frame - since); i != newest; ++i)
     {
-        /* TODO: We can usefully put this *into* DRMFormat */
-        GLenum pixel_layout = GL_INVALID_ENUM;
-        if (format == DRM_FORMAT_ARGB8888 || format == DRM_FORMAT_XRGB8888)
+        if (!*i)
         {
-            pixel_layout = GL_BGRA_EXT;
+            return std::nullopt;
         }
-        else if (format == DRM_FORMAT_RGBA8888 || format == DRM_FORMAT_RGBX8888)
+        changed = union_of(changed, **i);
+    }
+    return changed;
+}
+
+auto mgc::CPUCopyOutputSurface::Impl::stale_rows(
+    mg::CPUAddressableDisplayAllocator::MappableFB const& fb,
+    uint64_t content) const -> Rows
+{
+    // A framebuffer of age N holds what we wrote into the one we returned N commits ago
+    auto const age = fb.buffer_age();
+    if (age > 0 && static_cast<size_t>(age) <= displayed_frames.size())
+    {
+        if (auto const changed = rows_changed_between(displayed_frames[displayed_frames.size() - age], content))
         {
-            pixel_layout = GL_RGBA;
+            return *changed;
         }
-        auto mapping = fb->map_writeable();
-        /*
-         * TODO: This introduces a pipeline stall; GL must wait for all previous rendering commands
-         * to complete before glReadPixels returns. We could instead do something fancy with
-         * pixel buffer objects to defer this cost.
-         */
-        /*
-         * TODO: We are assuming that the framebuffer pixel format is RGBX
-         */
-        glReadPixels(
-            0, 0,
-            fb->size().width.as<GLsizei>(), fb->size().height.as<GLsizei>(),
-            pixel_layout, GL_UNSIGNED_BYTE, mapping->data());
     }
-    return fb;
+    return Rows{0, fb.size().height.as_int()};
+}
+
+void mgc::CPUCopyOutputSurface::Impl::read_into(PixelBuffer& buffer)
+{
+    auto const width = size().width.as_int();
+    auto const rows = rows_changed_between(buffer.frame, frame).value_or(Rows{0, size().height.as_int()});
+
+    if (buffer.fence)
+    {
+        glDeleteSync(buffer.fence);
+        buffer.fence = nullptr;
+    }
+    buffer.frame = frame;
+
+    if (rows.empty())
+    {
+        return;
+    }
+
+    /* Reading into a pixel buffer object only queues the copy, so this returns without waiting
+     * for rendering to finish; the fence tells us when the pixels have arrived.
+     * TODO: We are assuming that the framebuffer pixel format is RGBX
+     */
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.pbo);
+    glReadPixels(
+        0, rows.begin,
+        width, rows.end - rows.begin,
+        pixel_layout(), GL_UNSIGNED_BYTE,
+        reinterpret_cast<void*>(static_cast<intptr_t>(rows.begin) * width * 4));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+}
+
+void mgc::CPUCopyOutputSurface::Impl::copy_out(PixelBuffer& buffer, mg::CPUAddressableDisplayAllocator::MappableFB& fb)
+{
+    if (buffer.fence)
+    {
+        auto constexpr one_second_ns = 1'000'000'000;
+        if (glClientWaitSync(buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, one_second_ns) == GL_TIMEOUT_EXPIRED)
+        {
+            mir::log_warning("Timed out waiting for output readback; frame may be incomplete");
+        }
+        glDeleteSync(buffer.fence);
+        buffer.fence = nullptr;
+    }
+
+    // Framebuffers are recycled, so only the rows changed since the frame this one holds need copying
+    auto const rows = stale_rows(fb, buffer.frame);
+    size_t const row_bytes = fb.size().width.as_int() * 4;
+
+    if (!rows.empty())
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.pbo);
+        auto const pixels = static_cast<std::byte const*>(
+            glMapBufferRange(
+                GL_PIXEL_PACK_BUFFER,
+                rows.begin * row_bytes, (rows.end - rows.begin) * row_bytes,
+                GL_MAP_READ_BIT));
+        if (pixels)
+        {
+            auto const mapping = fb.map_writeable();
+            auto const stride = mapping->stride().as_uint32_t();
+            for (auto row = rows.begin; row != rows.end; ++row)
+            {
+                std::memcpy(mapping->data() + row * stride, pixels + (row - rows.begin) * row_bytes, row_bytes);
+            }
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        else
+        {
+            mir::log_warning("Failed to map output readback buffer");
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    last_displayed = &buffer;
+    record_displayed(buffer.frame);
+}
+
+void mgc::CPUCopyOutputSurface::Impl::read_pixels_into(mg::CPUAddressableDisplayAllocator::MappableFB& fb)
+{
+    // Framebuffers are recycled, so only the rows changed since the frame this one holds need reading
+    auto const rows = stale_rows(fb, frame);
+    record_displayed(frame);
+    if (rows.empty())
+    {
+        return;
+    }
+
+    auto mapping = fb.map_writeable();
+    /*
+     * Without pixel buffer objects this is a pipeline stall; GL must wait for all previous
+     * rendering commands to complete before glReadPixels returns.
+     */
+    /*
+     * TODO: We are assuming that the framebuffer pixel format is RGBX
+     */
+    glReadPixels(
+        0, rows.begin,
+        fb.size().width.as<GLsizei>(), rows.end - rows.begin,
+        pixel_layout(), GL_UNSIGNED_BYTE, mapping->data() + rows.begin * mapping->stride().as_int());
+}
+
+void mgc::CPUCopyOutputSurface::Impl::record_displayed(uint64_t content)
+{
+    displayed_frames.push_back(content);
+    while (displayed_frames.size() > max_tracked_age)
+    {
+        displayed_frames.pop_front();
+    }
 }
 
 auto mgc::CPUCopyOutputSurface::Impl::size() const -> geom::Size
@@ -358,3 +670,41 @@ auto mgc::CPUCopyOutputSurface::Impl::layout() const -> Layout
 {
     return Layout::TopRowFirst;
 }
+
+auto mgc::CPUCopyOutputSurface::Impl::buffer_age() const -> int
+{
+    // We render into the same renderbuffer every frame
+    return frame > 0 ? 1 : 0;
+}
+
+void mgc::CPUCopyOutputSurface::Impl::set_damage(std::optional<geom::Rectangle> const& damage)
+{
+    if (damage)
+    {
+        // The renderbuffer's rows are in output order, so GL y coördinates are output rows
+        auto const height = size().height.as_int();
+        frame_damage = Rows{
+            std::clamp(damage->top().as_int(), 0, height),
+            std::clamp(damage->bottom().as_int(), 0, height)};
+        if (damage->size.width == geom::Width{0})
+        {
+            frame_damage = Rows{0, 0};
+        }
+    }
+    else
+    {
+        frame_damage = std::nullopt;
+    }
+}
+
+auto mgc::CPUCopyOutputSurface::Impl::has_pending_frame() const -> bool
+{
+    return pending != nullptr;
+}
+
+void mgc::CPUCopyOutputSurface::Impl::discard_pending_frame()
+{
+    // Whatever is displayed next, it won't be what we last returned
+    pending = nullptr;
+    last_displayed = nullptr;
+}
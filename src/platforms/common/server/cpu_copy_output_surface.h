@@ -28,6 +28,22 @@ namespace mir::graphics
 {
 namespace common
 {
+/// How CPUCopyOutputSurface gets rendered frames into CPU memory
+enum class OutputReadback
+{
+    synchronous,    ///< Wait for each frame to render, then read it back in commit()
+    deferred        ///< Overlap reading back each frame with rendering the next
+};
+
+/**
+ * Renders with GL, then copies each frame into a CPU-addressable framebuffer for display
+ *
+ * By default commit() waits for rendering to finish and reads the whole frame back. With
+ * OutputReadback::deferred (and GLES 3) frames are read back through pixel buffer objects,
+ * reading only the rows that changed, and the readback of each frame overlaps rendering of the
+ * next: commit() returns the *previous* frame, at the cost of a frame of latency (and
+ * has_pending_frame() asks for a final commit() to show the last one).
+ */
 class CPUCopyOutputSurface : public gl::OutputSurface
 {
 public:
@@ -35,7 +51,8 @@ public:
         EGLDisplay dpy,
         EGLContext share_ctx,
         CPUAddressableDisplayAllocator& allocator,
-        GLConfig const& config);
+        GLConfig const& config,
+        OutputReadback readback);
 
     ~CPUCopyOutputSurface() override;
 
@@ -51,6 +68,14 @@ public:
 
     auto layout() const -> Layout override;
 
+    auto buffer_age() const -> int override;
+
+    void set_damage(std::optional<geometry::Rectangle> const& damage) override;
+
+    auto has_pending_frame() const -> bool override;
+
+    void discard_pending_frame() override;
+
 private:
     class Impl;
     std::unique_ptr<Impl> const impl;
@@ -99,6 +99,16 @@ std::string mgk::connector_name(mgk::DRMModeConnectorUPtr const& connector)
     return name;
 }
 
+auto mgk::refresh_interval(drmModeModeInfo const& mode) -> std::chrono::nanoseconds
+{
+    if (mode.clock == 0)
+        return std::chrono::nanoseconds::zero();
+
+    // One frame is htotal × vtotal pixels; mode.clock is the pixel clock in kHz
+    auto const pixels_per_frame = static_cast<int64_t>(mode.htotal) * mode.vtotal;
+    return std::chrono::nanoseconds{pixels_per_frame * 1'000'000 / mode.clock};
+}
+
 namespace
 {
 std::tuple<mgk::DRMModeCrtcUPtr, int> find_crtc_and_index_for_connector(
@@ -19,6 +19,7 @@
 
 #include "drm_mode_resources.h"
 
+#include <chrono>
 #include <string>
 #include <vector>
 #include <xf86drmMode.h>
@@ -31,6 +32,13 @@ namespace kms
 {
 std::string connector_name(DRMModeConnectorUPtr const& connector);
 
+/**
+ * The time between successive vblanks when scanning out \a mode
+ *
+ * \returns     The refresh interval, or zero if the mode timings don't define one.
+ */
+auto refresh_interval(drmModeModeInfo const& mode) -> std::chrono::nanoseconds;
+
 /**
  * Finds the first available CRTC that can drive Connector
  *
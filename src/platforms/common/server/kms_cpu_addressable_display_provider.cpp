@@ -19,6 +19,11 @@
 #include <drm_fourcc.h>
 #include <xf86drm.h>
 
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <vector>
+
 namespace
 {
 auto drm_get_cap_checked(mir::Fd const& drm_fd, uint64_t cap) -> uint64_t
@@ -39,10 +44,123 @@ auto drm_get_cap_checked(mir::Fd const& drm_fd, uint64_t cap) -> uint64_t
 namespace mg = mir::graphics;
 namespace geom = mir::geometry;
 
+/// Released framebuffers, kept to be handed out again rather than reallocated
+class mg::kms::CPUAddressableDisplayAllocator::FreeList
+{
+public:
+    /// Enough for one framebuffer on screen, one waiting to be flipped to, and one being drawn
+    static size_t constexpr max_free = 3;
+
+    struct Taken
+    {
+        std::unique_ptr<CPUAddressableFB> fb;   ///< Null if there is no free framebuffer of the format
+        int age;                                ///< How many frames ago fb was drawn into
+        uint64_t frame;                         ///< The frame fb is taken for
+    };
+
+    /// Each framebuffer taken is for a new frame
+    auto take(DRMFormat format) -> Taken
+    {
+        auto const mir_format = format.as_mir_format().value_or(mir_pixel_format_invalid);
+
+        std::lock_guard lock{mutex};
+        ++frame;
+        for (auto i = fbs.begin(); i != fbs.end(); ++i)
+        {
+            if (i->fb->format() == mir_format)
+            {
+                auto fb = std::move(i->fb);
+                auto const age = frame - i->drawn_in;
+                fbs.erase(i);
+                return {std::move(fb), static_cast<int>(std::min<uint64_t>(age, std::numeric_limits<int>::max())), frame};
+            }
+        }
+        return {nullptr, 0, frame};
+    }
+
+    void give(std::unique_ptr<CPUAddressableFB> fb, uint64_t drawn_in)
+    {
+        std::lock_guard lock{mutex};
+        if (fbs.size() < max_free)
+        {
+            fbs.push_back({std::move(fb), drawn_in});
+        }
+    }
+
+private:
+    struct Free
+    {
+        std::unique_ptr<CPUAddressableFB> fb;
+        uint64_t drawn_in;
+    };
+
+    std::mutex mutex;
+    uint64_t frame{0};
+    std::vector<Free> fbs;
+};
+
+/// A framebuffer that goes back to its allocator's free list when it is released
+class mg::kms::CPUAddressableDisplayAllocator::RecycledFB : public FBHandle, public MappableFB
+{
+public:
+    RecycledFB(std::unique_ptr<mg::CPUAddressableFB> fb, int age, uint64_t drawn_in, std::weak_ptr<FreeList> free_list)
+        : fb{std::move(fb)},
+          age{age},
+          drawn_in{drawn_in},
+          free_list{std::move(free_list)}
+    {
+    }
+
+    ~RecycledFB() override
+    {
+        if (auto const list = free_list.lock())
+        {
+            list->give(std::move(fb), drawn_in);
+        }
+    }
+
+    auto buffer_age() const -> int override
+    {
+        return age;
+    }
+
+    auto map_writeable() -> std::unique_ptr<mir::renderer::software::Mapping<std::byte>> override
+    {
+        return fb->map_writeable();
+    }
+
+    auto format() const -> MirPixelFormat override
+    {
+        return fb->format();
+    }
+
+    auto stride() const -> geom::Stride override
+    {
+        return fb->stride();
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return fb->size();
+    }
+
+    operator uint32_t() const override
+    {
+        return *fb;
+    }
+
+private:
+    std::unique_ptr<mg::CPUAddressableFB> fb;
+    int const age;
+    uint64_t const drawn_in;
+    std::weak_ptr<FreeList> const free_list;
+};
+
 mg::kms::CPUAddressableDisplayAllocator::CPUAddressableDisplayAllocator(mir::Fd drm_fd, geom::Size size)
     : drm_fd{std::move(drm_fd)},
       supports_modifiers{drm_get_cap_checked(this->drm_fd, DRM_CAP_ADDFB2_MODIFIERS) == 1},
-      size{size}
+      size{size},
+      free_fbs{std::make_shared<FreeList>()}
 {
 }
 
@@ -55,7 +173,12 @@ auto mg::kms::CPUAddressableDisplayAllocator::supported_formats() const
 
 auto mg::kms::CPUAddressableDisplayAllocator::alloc_fb(DRMFormat format) -> std::unique_ptr<MappableFB>
 {
-    return std::make_unique<mg::CPUAddressableFB>(drm_fd, supports_modifiers, format, size);
+    auto taken = free_fbs->take(format);
+    if (!taken.fb)
+    {
+        taken.fb = std::make_unique<mg::CPUAddressableFB>(drm_fd, supports_modifiers, format, size);
+    }
+    return std::make_unique<RecycledFB>(std::move(taken.fb), taken.age, taken.frame, free_fbs);
 }
 
 auto mg::kms::CPUAddressableDisplayAllocator::output_size() const -> geom::Size
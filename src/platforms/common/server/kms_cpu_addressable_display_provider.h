@@ -37,6 +37,8 @@ public:
     auto supported_formats() const
         -> std::vector<DRMFormat> override;
 
+    /// Framebuffers are recycled: once one is released its storage is reused for a later alloc_fb(),
+    /// which reports the age of what it holds through MappableFB::buffer_age()
     auto alloc_fb(DRMFormat format)
         -> std::unique_ptr<MappableFB> override;
 
@@ -44,9 +46,13 @@ public:
 private:
     explicit CPUAddressableDisplayAllocator(mir::Fd drm_fd, geometry::Size size);
 
+    class FreeList;
+    class RecycledFB;
+
     mir::Fd const drm_fd;
     bool const supports_modifiers;
     geometry::Size const size;
+    std::shared_ptr<FreeList> const free_fbs;
 };
 }
 }
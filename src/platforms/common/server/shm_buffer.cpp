@@ -20,15 +20,22 @@
 #include "shm_buffer.h"
 #include <mir/graphics/program_factory.h>
 #include <mir/graphics/egl_context_executor.h>
+#include <mir/graphics/egl_extensions.h>
 
 #define MIR_LOG_COMPONENT "gfx-common"
 #include <mir/log.h>
 
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 
 #include <boost/throw_exception.hpp>
 
+#include <deque>
+#include <map>
+#include <utility>
+
 namespace mg=mir::graphics;
 namespace mgc = mir::graphics::common;
 namespace geom = mir::geometry;
@@ -49,6 +56,119 @@ GLuint new_texture()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     return tex;
 }
+
+struct FenceSyncKHR
+{
+    FenceSyncKHR()
+        : create_sync{reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(eglGetProcAddress("eglCreateSyncKHR"))},
+          destroy_sync{reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(eglGetProcAddress("eglDestroySyncKHR"))},
+          client_wait_sync{reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(eglGetProcAddress("eglClientWaitSyncKHR"))},
+          wait_sync{reinterpret_cast<PFNEGLWAITSYNCKHRPROC>(eglGetProcAddress("eglWaitSyncKHR"))}
+    {
+    }
+
+    /// The entrypoints, if EGL_KHR_fence_sync is supported on \p dpy
+    static auto for_display(EGLDisplay dpy) -> FenceSyncKHR const*
+    {
+        static FenceSyncKHR const functions;
+
+        if (dpy == EGL_NO_DISPLAY || !mg::has_egl_extension(dpy, "EGL_KHR_fence_sync") ||
+            !functions.create_sync || !functions.destroy_sync || !functions.client_wait_sync)
+        {
+            return nullptr;
+        }
+        return &functions;
+    }
+
+    PFNEGLCREATESYNCKHRPROC const create_sync;
+    PFNEGLDESTROYSYNCKHRPROC const destroy_sync;
+    PFNEGLCLIENTWAITSYNCKHRPROC const client_wait_sync;
+    PFNEGLWAITSYNCKHRPROC const wait_sync;
+};
+
+/**
+ * Orders the GL commands issued so far in one context before later commands in another
+ * (shared) context
+ *
+ * Rather than draining the whole pipeline with glFinish() we insert a fence the other
+ * context can wait on. This is needed in both directions around a texture: uses must
+ * wait for the upload, and an upload into a reclaimed texture must wait for the draws
+ * that are still sampling its previous content.
+ */
+class ContextFence
+{
+public:
+    ContextFence() = default;
+
+    ~ContextFence()
+    {
+        reset();
+    }
+
+    /**
+     * Must be called in the signalling context, after the commands to be waited for
+     *
+     * \return false if fences are not supported, in which case nothing has been inserted
+     */
+    auto insert() -> bool
+    {
+        reset();
+
+        auto const dpy = eglGetCurrentDisplay();
+        if (auto const fence_sync = FenceSyncKHR::for_display(dpy))
+        {
+            if (auto const new_sync = fence_sync->create_sync(dpy, EGL_SYNC_FENCE_KHR, nullptr);
+                new_sync != EGL_NO_SYNC_KHR)
+            {
+                // Ensure the fence (and the commands) are submitted, so a waiter in another context can't deadlock
+                glFlush();
+                functions = fence_sync;
+                display = dpy;
+                sync = new_sync;
+                signalling_context = eglGetCurrentContext();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Must be called in the waiting context, before the commands that must come later
+    void wait() const
+    {
+        if (sync == EGL_NO_SYNC_KHR || eglGetCurrentContext() == signalling_context)
+        {
+            // Commands in a single context are executed in order
+            return;
+        }
+
+        if (functions->wait_sync && mg::has_egl_extension(display, "EGL_KHR_wait_sync"))
+        {
+            functions->wait_sync(display, sync, 0);
+        }
+        else
+        {
+            functions->client_wait_sync(display, sync, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, EGL_FOREVER_KHR);
+        }
+    }
+
+    ContextFence(ContextFence const&) = delete;
+    ContextFence& operator=(ContextFence const&) = delete;
+
+private:
+    void reset()
+    {
+        if (sync != EGL_NO_SYNC_KHR)
+        {
+            functions->destroy_sync(display, sync);
+            sync = EGL_NO_SYNC_KHR;
+        }
+    }
+
+    FenceSyncKHR const* functions{nullptr};
+    EGLDisplay display{EGL_NO_DISPLAY};
+    EGLSyncKHR sync{EGL_NO_SYNC_KHR};
+    EGLContext signalling_context{EGL_NO_CONTEXT};
+};
 }
 
 bool mg::get_gl_pixel_format(MirPixelFormat mir_format,
@@ -119,6 +239,10 @@ public:
 
     void bind() override
     {
+        {
+            std::lock_guard lock{uploaded_mutex};
+            upload_fence.wait();
+        }
         glBindTexture(GL_TEXTURE_2D, tex_id());
     }
 
@@ -147,6 +271,15 @@ public:
 
     void add_syncpoint() override
     {
+        // Called in the renderer's context after each draw; a later upload into this texture
+        // (once it's been retired and reclaimed) must not overwrite what those draws sample.
+        std::lock_guard lock{uploaded_mutex};
+        auto& fence = sample_fences[eglGetCurrentContext()];
+        if (!fence.insert())
+        {
+            // We can't order an upload after the draw, so the texture mustn't be overwritten
+            reusable = false;
+        }
     }
 
     void try_upload_to_texture(
@@ -157,13 +290,20 @@ public:
         if (uploaded)
             return;
 
-        bind();
+        // Draws from other contexts may still be reading the previous content
+        for (auto const& [context, fence] : sample_fences)
+        {
+            fence.wait();
+        }
+        sample_fences.clear();
+
+        glBindTexture(GL_TEXTURE_2D, tex_id());
         GLenum format, type;
 
         if (mg::get_gl_pixel_format(pixel_format, format, type))
         {
-            auto const stride_in_px =
-                stride.as_int() / MIR_BYTES_PER_PIXEL(pixel_format);
+            auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(pixel_format);
+            auto const stride_in_px = stride.as_int() / bytes_per_pixel;
             /*
              * We assume (as does Weston, AFAICT) that stride is
              * a multiple of whole pixels, but it need not be.
@@ -176,20 +316,55 @@ public:
             glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride_in_px);
             glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-            glTexImage2D(
-                GL_TEXTURE_2D,
-                0,
-                format,
-                size.width.as_int(), size.height.as_int(),
-                0,
-                format,
-                type,
-                pixels);
+            if (pending_damage && storage_size == size && storage_format == pixel_format)
+            {
+                // The texture already holds an earlier frame; only the changed areas need to be copied
+                geom::Rectangle const buffer_rect{{}, size};
+                for (auto const& rect : *pending_damage)
+                {
+                    auto const area = intersection_of(rect, buffer_rect);
+                    if (area.size == geom::Size{})
+                        continue;
+
+                    auto const origin = static_cast<std::byte const*>(pixels) +
+                        area.top().as_int() * stride.as_int() +
+                        area.left().as_int() * bytes_per_pixel;
+
+                    glTexSubImage2D(
+                        GL_TEXTURE_2D,
+                        0,
+                        area.left().as_int(), area.top().as_int(),
+                        area.size.width.as_int(), area.size.height.as_int(),
+                        format,
+                        type,
+                        origin);
+                }
+            }
+            else
+            {
+                glTexImage2D(
+                    GL_TEXTURE_2D,
+                    0,
+                    format,
+                    size.width.as_int(), size.height.as_int(),
+                    0,
+                    format,
+                    type,
+                    pixels);
+
+                storage_size = size;
+                storage_format = pixel_format;
+            }
 
             // Be nice to other users of the GL context by reverting our changes to shared state
             glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);     // 0 is default, meaning “use width”
             glPixelStorei(GL_UNPACK_ALIGNMENT, 4);          // 4 is default; word alignment.
-            glFinish();
+            if (!upload_fence.insert())
+            {
+                // No fences; fall back to waiting for the upload to complete
+                glFinish();
+            }
+            content_generation = target_generation;
         }
         else
         {
@@ -199,22 +374,187 @@ public:
                 pixel_format);
         }
 
+        pending_damage = std::nullopt;
         uploaded = true;
     }
 
     void mark_dirty()
     {
         std::lock_guard lock{uploaded_mutex};
+        pending_damage = std::nullopt;
         uploaded = false;
     }
 
+    /**
+     * Prepare the texture to hold the frame \p generation
+     *
+     * \param damage   The area that differs from the current content of the texture,
+     *                  or std::nullopt to upload everything
+     */
+    void update_to(uint64_t generation, std::optional<geom::Rectangles> damage)
+    {
+        std::lock_guard lock{uploaded_mutex};
+        target_generation = generation;
+        pending_damage = std::move(damage);
+        uploaded = false;
+    }
+
+    /// The executor for the (shared) context the texture belongs to
+    auto executor() const -> EGLContextExecutor*
+    {
+        return egl_delegate.get();
+    }
+
+    /// The frame whose content the texture holds, if any
+    auto generation() -> std::optional<uint64_t>
+    {
+        std::lock_guard lock{uploaded_mutex};
+        return content_generation;
+    }
+
+    auto holds_storage_for(geom::Size const& size, MirPixelFormat pixel_format) -> bool
+    {
+        std::lock_guard lock{uploaded_mutex};
+        return reusable && content_generation && storage_size == size && storage_format == pixel_format;
+    }
+
 private:
     std::shared_ptr<EGLContextExecutor> egl_delegate;
     GLuint tex_id_;
     std::mutex uploaded_mutex;
     bool uploaded = false;
+    std::optional<geom::Rectangles> pending_damage;
+    uint64_t target_generation{0};
+    std::optional<uint64_t> content_generation;
+    geom::Size storage_size;
+    MirPixelFormat storage_format{mir_pixel_format_invalid};
+    ContextFence upload_fence;
+    /// The latest draws sampling the texture, for each context that has used it
+    std::map<EGLContext, ContextFence> sample_fences;
+    bool reusable{true};
+};
+
+/**
+ * Tracks the damage between successive ShmBuffers committed to a single surface, along
+ * with the textures of retired buffers that can be reused by their successors.
+ */
+class mgc::ShmBuffer::TextureHistory
+{
+public:
+    /// Record a new frame that differs from the previous one by \p damage
+    auto add_generation(std::optional<geom::Rectangles> const& damage) -> uint64_t
+    {
+        auto const locked = state.lock();
+        locked->damage.push_back(damage);
+        if (locked->damage.size() > max_tracked_generations)
+        {
+            locked->damage.pop_front();
+        }
+        return ++locked->latest;
+    }
+
+    /// Make the texture of a retired buffer available to its successors
+    void retire(std::shared_ptr<ShmBufferTexture> texture)
+    {
+        auto const generation = texture->generation();
+        if (!generation)
+            return;
+
+        // We only keep the newest texture for each context; drop the other outside the lock
+        std::shared_ptr<ShmBufferTexture> discard;
+        auto const locked = state.lock();
+        auto& spare = locked->spares[texture->executor()];
+        if (spare && spare->generation() >= generation)
+        {
+            discard = std::move(texture);
+        }
+        else
+        {
+            discard = std::exchange(spare, std::move(texture));
+        }
+    }
+
+    /// Take a retired texture that can be brought up to date with \p generation by a partial upload
+    auto reclaim(
+        EGLContextExecutor* executor,
+        uint64_t generation,
+        geom::Size const& size,
+        MirPixelFormat pixel_format) -> std::shared_ptr<ShmBufferTexture>
+    {
+        auto const locked = state.lock();
+        auto const spare = locked->spares.find(executor);
+        if (spare == locked->spares.end() ||
+            spare->second.use_count() > 1 ||            // Still in use by the renderer
+            // (Draws the renderer has queued but the GPU hasn't finished are fenced by the texture)
+            !spare->second->holds_storage_for(size, pixel_format))
+        {
+            return nullptr;
+        }
+
+        auto const spare_generation = spare->second->generation().value();
+        if (spare_generation >= generation)
+        {
+            return nullptr;
+        }
+
+        auto texture = std::move(spare->second);
+        locked->spares.erase(spare);
+        texture->update_to(generation, damage_between(*locked, spare_generation, generation));
+        return texture;
+    }
+
+private:
+    static size_t constexpr max_tracked_generations{4};
+    static size_t constexpr max_damage_rects{16};
+
+    struct State
+    {
+        uint64_t latest{0};
+        /// Damage of the most recent generations; back() is the damage of generation latest
+        std::deque<std::optional<geom::Rectangles>> damage;
+        std::map<EGLContextExecutor*, std::shared_ptr<ShmBufferTexture>> spares;
+    };
+
+    static auto damage_between(State const& state, uint64_t from, uint64_t to) -> std::optional<geom::Rectangles>
+    {
+        if (state.latest - from > state.damage.size())
+        {
+            // We've forgotten some of the intermediate damage
+            return std::nullopt;
+        }
+
+        geom::Rectangles result;
+        for (auto generation = from + 1; generation <= to; ++generation)
+        {
+            auto const& damage = state.damage[state.damage.size() - 1 - (state.latest - generation)];
+            if (!damage)
+            {
+                return std::nullopt;
+            }
+            for (auto const& rect : *damage)
+            {
+                result.add(rect);
+            }
+        }
+
+        if (result.size() > max_damage_rects)
+        {
+            // Each rectangle costs a separate upload, so trade some excess copying for fewer calls
+            return geom::Rectangles{{result.bounding_rectangle()}};
+        }
+        return result;
+    }
+
+    Synchronised<State> state;
 };
 
+struct mgc::ShmBuffer::PendingUpload
+{
+    EGLContextExecutor* const executor;
+    std::mutex mutex;
+    bool cancelled{false};
+    std::shared_ptr<ShmBufferTexture> texture;
+};
 
 bool mgc::ShmBuffer::supports(MirPixelFormat mir_format)
 {
@@ -225,13 +565,42 @@ bool mgc::ShmBuffer::supports(MirPixelFormat mir_format)
 mgc::ShmBuffer::ShmBuffer(
     geom::Size const& size,
     MirPixelFormat const& format)
+    : ShmBuffer(size, format, nullptr, std::nullopt)
+{
+}
+
+mgc::ShmBuffer::ShmBuffer(
+    geom::Size const& size,
+    MirPixelFormat const& format,
+    std::shared_ptr<Buffer> const& predecessor,
+    std::optional<geom::Rectangles> const& damage)
     : size_{size},
-      pixel_format_{format}
+      pixel_format_{format},
+      history{[&]()
+          {
+              if (auto const shm_predecessor = std::dynamic_pointer_cast<ShmBuffer>(predecessor))
+              {
+                  return shm_predecessor->history;
+              }
+              return std::make_shared<TextureHistory>();
+          }()},
+      generation{history->add_generation(damage)}
 {
 }
 
 mgc::ShmBuffer::~ShmBuffer() noexcept
 {
+    cancel_upload();
+    if (pending_upload && pending_upload->texture)
+    {
+        history->retire(std::move(pending_upload->texture));
+    }
+
+    auto const locked_provider_to_texture_map = provider_to_texture_map.lock();
+    for (auto& [provider, texture] : *locked_provider_to_texture_map)
+    {
+        history->retire(std::move(texture));
+    }
 }
 
 geom::Size mgc::ShmBuffer::size() const
@@ -257,13 +626,83 @@ auto mgc::ShmBuffer::texture_for_provider(
     // This method is called from the renderer where the egl context is current.
     // Hence, we do not need to spawn texture creation the egl_delegate.
     if (!locked_provider_to_texture_map->contains(provider))
-        locked_provider_to_texture_map->emplace(provider, std::make_shared<ShmBufferTexture>(egl_delegate));
+    {
+        auto texture = take_upload(egl_delegate.get());
+        if (!texture)
+        {
+            texture = history->reclaim(egl_delegate.get(), generation, size_, pixel_format_);
+        }
+        if (!texture)
+        {
+            texture = std::make_shared<ShmBufferTexture>(egl_delegate);
+            texture->update_to(generation, std::nullopt);
+        }
+        locked_provider_to_texture_map->emplace(provider, std::move(texture));
+    }
 
     auto texture = locked_provider_to_texture_map->at(provider);
     on_texture_accessed(texture);
     return texture;
 }
 
+void mgc::ShmBuffer::start_upload(
+    std::shared_ptr<EGLContextExecutor> const& egl_delegate,
+    std::shared_ptr<mrs::RWMappable> const& data)
+{
+    pending_upload = std::make_shared<PendingUpload>(egl_delegate.get());
+
+    egl_delegate->spawn(
+        [pending = pending_upload,
+         data,
+         history = history,
+         egl_delegate,
+         generation = generation,
+         id = id(),
+         size = size_,
+         pixel_format = pixel_format_]()
+        {
+            // Holding the lock until we're done lets the buffer (and the client) know we're still reading
+            std::lock_guard lock{pending->mutex};
+            if (pending->cancelled)
+            {
+                return;
+            }
+
+            auto texture = history->reclaim(egl_delegate.get(), generation, size, pixel_format);
+            if (!texture)
+            {
+                texture = std::make_shared<ShmBufferTexture>(egl_delegate);
+                texture->update_to(generation, std::nullopt);
+            }
+
+            auto const mapping = data->map_rw();
+            texture->try_upload_to_texture(id, mapping->data(), size, mapping->stride(), pixel_format);
+            pending->texture = std::move(texture);
+        });
+}
+
+auto mgc::ShmBuffer::take_upload(EGLContextExecutor* executor) -> std::shared_ptr<ShmBufferTexture>
+{
+    if (!pending_upload || pending_upload->executor != executor)
+    {
+        return nullptr;
+    }
+
+    // If the upload is in progress we wait for it, rather than duplicate the work
+    std::lock_guard lock{pending_upload->mutex};
+    pending_upload->cancelled = true;
+    return pending_upload->texture;
+}
+
+void mgc::ShmBuffer::cancel_upload()
+{
+    if (pending_upload)
+    {
+        std::lock_guard lock{pending_upload->mutex};
+        pending_upload->cancelled = true;
+    }
+}
+
 void mgc::ShmBuffer::on_texture_accessed(std::shared_ptr<ShmBufferTexture> const&)
 {
 }
@@ -366,6 +805,15 @@ mgc::MappableBackedShmBuffer::MappableBackedShmBuffer(
 {
 }
 
+mgc::MappableBackedShmBuffer::MappableBackedShmBuffer(
+    std::shared_ptr<mrs::RWMappable> data,
+    std::shared_ptr<Buffer> const& predecessor,
+    std::optional<geom::Rectangles> const& damage)
+    : ShmBuffer(data->size(), data->format(), predecessor, damage),
+      data{std::move(data)}
+{
+}
+
 auto mgc::MappableBackedShmBuffer::map_writeable() -> std::unique_ptr<mrs::Mapping<std::byte>>
 {
     return data->map_writeable();
@@ -427,6 +875,11 @@ void mgc::MappableBackedShmBuffer::on_texture_accessed(std::shared_ptr<ShmBuffer
         pixel_format());
 }
 
+void mgc::MappableBackedShmBuffer::upload_ahead(std::shared_ptr<EGLContextExecutor> const& egl_delegate)
+{
+    start_upload(egl_delegate, data);
+}
+
 auto mgc::MappableBackedShmBuffer::format() const -> MirPixelFormat
 {
     return data->format();
@@ -452,8 +905,22 @@ mgc::NotifyingMappableBackedShmBuffer::NotifyingMappableBackedShmBuffer(
 {
 }
 
+mgc::NotifyingMappableBackedShmBuffer::NotifyingMappableBackedShmBuffer(
+    std::shared_ptr<mrs::RWMappable> data,
+    std::shared_ptr<Buffer> const& predecessor,
+    std::optional<geom::Rectangles> const& damage,
+    std::function<void()>&& on_consumed,
+    std::function<void()>&& on_release)
+    :  MappableBackedShmBuffer(std::move(data), predecessor, damage),
+       on_consumed{std::move(on_consumed)},
+       on_release{std::move(on_release)}
+{
+}
+
 mgc::NotifyingMappableBackedShmBuffer::~NotifyingMappableBackedShmBuffer()
 {
+    // The client is free to reuse the buffer once released, so we must be done reading it
+    cancel_upload();
     on_release();
 }
 
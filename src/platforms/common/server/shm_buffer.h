@@ -21,14 +21,17 @@
 #include <mir/graphics/buffer_basic.h>
 #include <mir/geometry/dimensions.h>
 #include <mir/geometry/size.h>
+#include <mir/geometry/rectangles.h>
 #include <mir_toolkit/common.h>
 #include <mir/renderer/sw/pixel_source.h>
 #include <mir/graphics/texture.h>
 
 #include <GLES2/gl2.h>
 
+#include <cstdint>
 #include <mutex>
 #include <map>
+#include <optional>
 
 namespace mir
 {
@@ -63,14 +66,52 @@ protected:
     ShmBuffer(
         geometry::Size const& size,
         MirPixelFormat const& format);
+    /**
+     * Construct a ShmBuffer holding the next frame of content after \p predecessor
+     *
+     * \param damage   The area (in buffer coordinates) that differs from \p predecessor,
+     *                  or std::nullopt if this is unknown.
+     *
+     * Textures of retired predecessors are reused, so that only the damaged areas need
+     * to be uploaded.
+     */
+    ShmBuffer(
+        geometry::Size const& size,
+        MirPixelFormat const& format,
+        std::shared_ptr<Buffer> const& predecessor,
+        std::optional<geometry::Rectangles> const& damage);
     class ShmBufferTexture;
+    class TextureHistory;
 
     virtual void on_texture_accessed(std::shared_ptr<ShmBufferTexture> const&) = 0;
 
+    /**
+     * Start uploading \p data to a texture on \p egl_delegate's thread
+     *
+     * This takes the copy out of the client's buffer off the compositor thread. Providers
+     * using \p egl_delegate pick up the texture in texture_for_provider(), and only wait
+     * if the upload has not yet completed.
+     *
+     * Must be called before the buffer is shared with other threads.
+     */
+    void start_upload(
+        std::shared_ptr<EGLContextExecutor> const& egl_delegate,
+        std::shared_ptr<renderer::software::RWMappable> const& data);
+
+    /// Abandon an upload that has not yet started, and wait for one that is in progress
+    void cancel_upload();
+
     Synchronised<std::map<RenderingProvider*, std::shared_ptr<ShmBufferTexture>>> provider_to_texture_map;
 private:
+    struct PendingUpload;
+
+    auto take_upload(EGLContextExecutor* executor) -> std::shared_ptr<ShmBufferTexture>;
+
     geometry::Size const size_;
     MirPixelFormat const pixel_format_;
+    std::shared_ptr<TextureHistory> const history;
+    uint64_t const generation;
+    std::shared_ptr<PendingUpload> pending_upload;
 };
 
 class MemoryBackedShmBuffer :
@@ -116,6 +157,10 @@ class MappableBackedShmBuffer :
 public:
     MappableBackedShmBuffer(
         std::shared_ptr<RWMappable> data);
+    MappableBackedShmBuffer(
+        std::shared_ptr<RWMappable> data,
+        std::shared_ptr<Buffer> const& predecessor,
+        std::optional<geometry::Rectangles> const& damage);
 
     auto map_readable() const -> std::unique_ptr<renderer::software::Mapping<std::byte const>> override;
 
@@ -126,6 +171,9 @@ public:
     auto stride() const -> geometry::Stride override;
     auto size() const -> geometry::Size override;
 
+    /// Begin uploading the content for renderers sharing \p egl_delegate's context
+    void upload_ahead(std::shared_ptr<EGLContextExecutor> const& egl_delegate);
+
     MappableBackedShmBuffer(MappableBackedShmBuffer const&) = delete;
     MappableBackedShmBuffer& operator=(MappableBackedShmBuffer const&) = delete;
 
@@ -143,6 +191,12 @@ public:
         std::shared_ptr<renderer::software::RWMappable> data,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release);
+    NotifyingMappableBackedShmBuffer(
+        std::shared_ptr<renderer::software::RWMappable> data,
+        std::shared_ptr<Buffer> const& predecessor,
+        std::optional<geometry::Rectangles> const& damage,
+        std::function<void()>&& on_consumed,
+        std::function<void()>&& on_release);
 
     ~NotifyingMappableBackedShmBuffer() override;
 
@@ -350,7 +350,8 @@ void mge::BufferAllocator::bind_eglstream_controller(
 
 void mir::graphics::eglstream::BufferAllocator::bind_display(
     wl_display* display,
-    std::shared_ptr<Executor>)
+    std::shared_ptr<Executor>,
+    std::shared_ptr<SurfaceScanoutHints>)
 {
     if (!wl_global_create(
         display,
@@ -628,6 +629,21 @@ auto mge::BufferAllocator::buffer_from_shm(
         std::move(on_release));
 }
 
+auto mge::BufferAllocator::buffer_from_shm_update(
+    std::shared_ptr<renderer::software::RWMappable> data,
+    std::shared_ptr<Buffer> const& previous,
+    std::optional<geometry::Rectangles> const& damage,
+    std::function<void()>&& on_consumed,
+    std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
+{
+    return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
+        std::move(data),
+        previous,
+        damage,
+        std::move(on_consumed),
+        std::move(on_release));
+}
+
 namespace
 {
 // libepoxy replaces the GL symbols with resolved-on-first-use function pointers
@@ -819,10 +835,12 @@ auto pick_stream_surface_config(EGLDisplay dpy, mg::GLConfig const& gl_config) -
 
 mge::GLRenderingProvider::GLRenderingProvider(
     EGLDisplay dpy,
-    std::unique_ptr<mir::renderer::gl::Context> ctx)
+    std::unique_ptr<mir::renderer::gl::Context> ctx,
+    mgc::OutputReadback readback)
     : dpy{dpy},
       egl_delegate{std::make_shared<mgc::EGLContextExecutor>(ctx->make_share_context())},
-      ctx{std::move(ctx)}
+      ctx{std::move(ctx)},
+      readback{readback}
 {
 }
 
@@ -869,7 +887,8 @@ auto mge::GLRenderingProvider::surface_for_sink(
             dpy,
             static_cast<EGLContext>(*ctx),
             *cpu_provider,
-            gl_config);
+            gl_config,
+            readback);
     }
     BOOST_THROW_EXCEPTION((std::runtime_error{"DisplayInterfaceProvider does not support any viable output interface"}));
 }
@@ -46,6 +46,11 @@ namespace gl
 class Program;
 }
 
+namespace common
+{
+enum class OutputReadback;
+}
+
 namespace eglstream
 {
 
@@ -59,7 +64,10 @@ public:
     std::shared_ptr<Buffer> alloc_software_buffer(geometry::Size size, MirPixelFormat format) override;
     std::vector<MirPixelFormat> supported_pixel_formats() override;
 
-    void bind_display(wl_display* display, std::shared_ptr<Executor> wayland_executor) override;
+    void bind_display(
+        wl_display* display,
+        std::shared_ptr<Executor> wayland_executor,
+        std::shared_ptr<SurfaceScanoutHints> scanout_hints) override;
     void unbind_display(wl_display* display) override;
 
     std::shared_ptr<Buffer> buffer_from_resource(
@@ -71,6 +79,12 @@ public:
         std::shared_ptr<renderer::software::RWMappable> shm_data,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> override;
+    auto buffer_from_shm_update(
+        std::shared_ptr<renderer::software::RWMappable> shm_data,
+        std::shared_ptr<Buffer> const& previous,
+        std::optional<geometry::Rectangles> const& damage,
+        std::function<void()>&& on_consumed,
+        std::function<void()>&& on_release) -> std::shared_ptr<Buffer> override;
 
 private:
     static void create_buffer_eglstream_resource(
@@ -95,7 +109,10 @@ private:
 class GLRenderingProvider : public graphics::GLRenderingProvider
 {
 public:
-    GLRenderingProvider(EGLDisplay dpy, std::unique_ptr<renderer::gl::Context> ctx);
+    GLRenderingProvider(
+        EGLDisplay dpy,
+        std::unique_ptr<renderer::gl::Context> ctx,
+        common::OutputReadback readback);
     ~GLRenderingProvider();
 
     auto as_texture(std::shared_ptr<Buffer> buffer) -> std::shared_ptr<gl::Texture> override;
@@ -113,6 +130,7 @@ private:
     EGLDisplay dpy;
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
     std::unique_ptr<renderer::gl::Context> const ctx;
+    common::OutputReadback const readback;
 };
 
 }
@@ -183,9 +183,10 @@ private:
 };
 }
 
-mge::RenderingPlatform::RenderingPlatform(EGLDisplay dpy)
+mge::RenderingPlatform::RenderingPlatform(EGLDisplay dpy, mgc::OutputReadback readback)
     : dpy{dpy},
-      ctx{std::make_unique<BasicEGLContext>(dpy)}
+      ctx{std::make_unique<BasicEGLContext>(dpy)},
+      readback{readback}
 {
     // XWayland eglstream has always been kinda flaky, now it's somehow worse.
     // Disable it until we've had a chance to look at what's wrong.
@@ -208,7 +209,7 @@ auto mge::RenderingPlatform::maybe_create_provider(
 {
     if (dynamic_cast<graphics::GLRenderingProvider::Tag const*>(&type_tag))
     {
-        return std::make_shared<mge::GLRenderingProvider>(dpy, ctx->make_share_context());
+        return std::make_shared<mge::GLRenderingProvider>(dpy, ctx->make_share_context(), readback);
     }
     return nullptr;
 }
@@ -37,12 +37,17 @@ class Device;
 
 namespace graphics
 {
+namespace common
+{
+enum class OutputReadback;
+}
+
 namespace eglstream
 {
 class RenderingPlatform : public graphics::RenderingPlatform
 {
 public:
-    RenderingPlatform(EGLDisplay dpy);
+    RenderingPlatform(EGLDisplay dpy, common::OutputReadback readback);
     ~RenderingPlatform() override;
 
     UniqueModulePtr<GraphicBufferAllocator>
@@ -54,6 +59,7 @@ protected:
 private:
     EGLDisplay const dpy;
     std::unique_ptr<renderer::gl::Context> const ctx;
+    common::OutputReadback const readback;
 };
 
 class DisplayPlatform : public graphics::DisplayPlatform
@@ -18,6 +18,7 @@
 
 #include "platform.h"
 #include "utils.h"
+#include "cpu_copy_output_surface.h"
 #include <mir/graphics/platform.h>
 #include <mir/options/option.h>
 #include <mir/options/configuration.h>
@@ -50,7 +51,7 @@ namespace mge = mir::graphics::eglstream;
 auto create_rendering_platform(
     mg::SupportedDevice const& device,
     std::vector<std::shared_ptr<mg::DisplayPlatform>> const& /*displays*/,
-    mo::Option const&,
+    mo::Option const& options,
     mir::EmergencyCleanupRegistry&) -> mir::UniqueModulePtr<mg::RenderingPlatform>
 {
     mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
@@ -82,7 +83,11 @@ auto create_rendering_platform(
         }
     }
 
-    return mir::make_module_ptr<mge::RenderingPlatform>(display);
+    auto const readback = options.get<bool>(mo::deferred_output_readback_opt) ?
+        mgc::OutputReadback::deferred :
+        mgc::OutputReadback::synchronous;
+
+    return mir::make_module_ptr<mge::RenderingPlatform>(display, readback);
 }
 
 void add_graphics_platform_options(boost::program_options::options_description& /*config*/)
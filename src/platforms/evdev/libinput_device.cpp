@@ -149,21 +149,21 @@ void mie::LibInputDevice::process_event(libinput_event* event)
         switch(libinput_event_get_type(event))
         {
         case LIBINPUT_EVENT_KEYBOARD_KEY:
-            sink->handle_input(convert_event(libinput_event_get_keyboard_event(event)));
+            sink->handle_input(mev::share_event(convert_event(libinput_event_get_keyboard_event(event))));
             break;
         case LIBINPUT_EVENT_POINTER_MOTION:
-            sink->handle_input(convert_motion_event(libinput_event_get_pointer_event(event)));
+            sink->handle_input(mev::share_event(convert_motion_event(libinput_event_get_pointer_event(event))));
             break;
         case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
-            sink->handle_input(convert_absolute_motion_event(libinput_event_get_pointer_event(event)));
+            sink->handle_input(mev::share_event(convert_absolute_motion_event(libinput_event_get_pointer_event(event))));
             break;
         case LIBINPUT_EVENT_POINTER_BUTTON:
-            sink->handle_input(convert_button_event(libinput_event_get_pointer_event(event)));
+            sink->handle_input(mev::share_event(convert_button_event(libinput_event_get_pointer_event(event))));
             break;
         case LIBINPUT_EVENT_POINTER_SCROLL_WHEEL:
         case LIBINPUT_EVENT_POINTER_SCROLL_FINGER:
         case LIBINPUT_EVENT_POINTER_SCROLL_CONTINUOUS:
-            sink->handle_input(convert_axis_event(libinput_event_get_pointer_event(event)));
+            sink->handle_input(mev::share_event(convert_axis_event(libinput_event_get_pointer_event(event))));
             break;
         // touch events are processed as a batch of changes over all touch pointts
         case LIBINPUT_EVENT_TOUCH_DOWN:
@@ -183,7 +183,7 @@ void mie::LibInputDevice::process_event(libinput_event* event)
             {
                 if (auto input = convert_touch_frame(libinput_event_get_touch_event(event)))
                 {
-                    sink->handle_input(std::move(input));
+                    sink->handle_input(mev::share_event(std::move(input)));
                 }
             }
             break;
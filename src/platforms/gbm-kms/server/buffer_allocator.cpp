@@ -116,7 +116,10 @@ std::vector<MirPixelFormat> mgg::BufferAllocator::supported_pixel_formats()
     return pixel_formats;
 }
 
-void mgg::BufferAllocator::bind_display(wl_display* display, std::shared_ptr<Executor> wayland_executor)
+void mgg::BufferAllocator::bind_display(
+    wl_display* display,
+    std::shared_ptr<Executor> wayland_executor,
+    std::shared_ptr<SurfaceScanoutHints> scanout_hints)
 {
     auto context_guard = mir::raii::paired_calls(
         [this]() { ctx->make_current(); },
@@ -142,7 +145,7 @@ void mgg::BufferAllocator::bind_display(wl_display* display, std::shared_ptr<Exe
         if (dmabuf_provider)
         {
             mg::EGLExtensions::EXTImageDmaBufImportModifiers modifier_ext{dpy};
-            dmabuf_extension = std::make_unique<LinuxDmaBuf>(display, dmabuf_provider);
+            dmabuf_extension = std::make_unique<LinuxDmaBuf>(display, dmabuf_provider, std::move(scanout_hints));
             mir::log_info("Enabled linux-dmabuf import support");
         }
     }
@@ -204,10 +207,29 @@ auto mgg::BufferAllocator::buffer_from_shm(
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
 {
-    return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
+    auto buffer = std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
         std::move(on_consumed),
         std::move(on_release));
+    buffer->upload_ahead(egl_delegate);
+    return buffer;
+}
+
+auto mgg::BufferAllocator::buffer_from_shm_update(
+    std::shared_ptr<renderer::software::RWMappable> data,
+    std::shared_ptr<Buffer> const& previous,
+    std::optional<geometry::Rectangles> const& damage,
+    std::function<void()>&& on_consumed,
+    std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
+{
+    auto buffer = std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
+        std::move(data),
+        previous,
+        damage,
+        std::move(on_consumed),
+        std::move(on_release));
+    buffer->upload_ahead(egl_delegate);
+    return buffer;
 }
 
 auto mgg::BufferAllocator::shared_egl_context() -> EGLContext
@@ -316,6 +338,22 @@ public:
         return Layout::GL;
     }
 
+    auto buffer_age() const -> int override
+    {
+        if (!has_buffer_age)
+        {
+            return 0;
+        }
+
+        EGLint age{0};
+        if (eglQuerySurface(dpy, egl_surf, EGL_BUFFER_AGE_EXT, &age) != EGL_TRUE)
+        {
+            // Not fatal; we just have to redraw everything
+            return 0;
+        }
+        return age;
+    }
+
 private:
     static auto get_matching_configs(EGLDisplay dpy, EGLint const attr[]) -> std::vector<EGLConfig>
     {
@@ -471,7 +509,10 @@ private:
           egl_surf{std::get<2>(renderables)},
           dpy{dpy},
           ctx{std::get<1>(renderables)},
-          quirks{quirks}
+          quirks{quirks},
+          // EGL_KHR_partial_update also exposes the age, but without eglSetDamageRegionKHR() the
+          // driver may discard the old content we'd be relying on
+          has_buffer_age{mg::has_egl_extension(dpy, "EGL_EXT_buffer_age")}
     {
     }
 
@@ -480,6 +521,7 @@ private:
     EGLDisplay const dpy;
     EGLContext const ctx;
     std::shared_ptr<mgg::GbmQuirks> const quirks;
+    bool const has_buffer_age;
 };
 }
 
@@ -545,7 +587,8 @@ auto mgg::GLRenderingProvider::surface_for_sink(
         dpy,
         ctx,
         *cpu_allocator,
-        config);
+        config,
+        readback);
 }
 
 auto mgg::GLRenderingProvider::import_syncobj(Fd const& syncobj_fd)
@@ -613,13 +656,15 @@ mgg::GLRenderingProvider::GLRenderingProvider(
     std::shared_ptr<mg::DMABufEGLProvider> dmabuf_provider,
     EGLDisplay dpy,
     EGLContext ctx,
-    std::shared_ptr<GbmQuirks> const& quirks)
+    std::shared_ptr<GbmQuirks> const& quirks,
+    mgc::OutputReadback readback)
     : drm_fd{std::move(drm_fd)},
       bound_display{std::move(associated_display)},
       dpy{dpy},
       ctx{ctx},
       dmabuf_provider{std::move(dmabuf_provider)},
       egl_delegate{std::move(egl_delegate)},
-      quirks{quirks}
+      quirks{quirks},
+      readback{readback}
 {
 }
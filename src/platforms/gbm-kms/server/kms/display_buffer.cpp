@@ -139,6 +139,8 @@ bool mgg::DisplaySink::overlay(std::vector<DisplayElement> const& renderable_lis
     if (auto fb = std::dynamic_pointer_cast<graphics::FBHandle>(renderable_list[0].buffer))
     {
         next_swap = std::move(fb);
+        holding_client_buffers = true;
+        next_swap_allows_tearing = renderable_list[0].allow_tearing;
         return true;
     }
     return false;
@@ -185,6 +187,9 @@ void mgg::DisplaySink::post()
      */
     wait_for_page_flip();
 
+    // That flip was the previous frame's (whose presentation has been reported); this frame's is yet to come
+    presentation = std::nullopt;
+
     if (!next_swap)
     {
         // Hey! No one has given us a next frame yet, so we don't have to change what's onscreen.
@@ -196,12 +201,15 @@ void mgg::DisplaySink::post()
      */
     scheduled_fb = std::move(next_swap);
     next_swap = nullptr;
+    scheduled_client_buffers = holding_client_buffers;
 
     /*
-     * Try to schedule a page flip as first preference to avoid tearing.
+     * Try to schedule a page flip as first preference to avoid tearing
+     * (unless the client has asked for its buffer to be flipped to
+     * immediately, tearing or not).
      * [will complete in a background thread]
      */
-    if (!needs_set_crtc && !schedule_page_flip(*scheduled_fb))
+    if (!needs_set_crtc && !schedule_page_flip(*scheduled_fb, next_swap_allows_tearing))
         needs_set_crtc = true;
 
     /*
@@ -246,9 +254,15 @@ void mgg::DisplaySink::post()
          * Not in clone mode? We can afford to wait for the page flip then,
          * making us double-buffered (noticeably less laggy than the triple
          * buffering that clone mode requires).
+         *
+         * In clone mode we still wait for the output whose flip we report,
+         * so this frame's presentation is known when post() returns; the
+         * other outputs are waited for before the next frame is scheduled.
          */
         if (outputs.size() == 1)
             wait_for_page_flip();
+        else
+            wait_for_presentation_flip();
 
         /*
          * TODO: If you're optimistic about your GPU performance and/or
@@ -274,18 +288,25 @@ std::chrono::milliseconds mgg::DisplaySink::recommended_sleep() const
     return recommend_sleep;
 }
 
-bool mgg::DisplaySink::schedule_page_flip(FBHandle const& bufobj)
+auto mgg::DisplaySink::last_presentation() const -> std::optional<FramePresentation>
+{
+    return presentation;
+}
+
+bool mgg::DisplaySink::schedule_page_flip(FBHandle const& bufobj, bool async)
 {
     /*
      * Schedule the current front buffer object for display. Note that
-     * the page flip is asynchronous and synchronized with vertical refresh.
+     * the page flip is asynchronous and (unless async, and the output
+     * supports it) synchronized with vertical refresh.
      */
     for (auto& output : outputs)
     {
-        if (output->schedule_page_flip(bufobj))
-            page_flips_pending = true;
+        if ((async && output->schedule_async_page_flip(bufobj)) || output->schedule_page_flip(bufobj))
+            outputs_flipping.push_back(output);
     }
 
+    page_flips_pending = !outputs_flipping.empty();
     return page_flips_pending;
 }
 
@@ -293,8 +314,10 @@ void mgg::DisplaySink::wait_for_page_flip()
 {
     if (page_flips_pending)
     {
-        for (auto& output : outputs)
-            output->wait_for_page_flip();
+        for (auto const& output : std::exchange(outputs_flipping, {}))
+        {
+            flipped(*output, output->wait_for_page_flip());
+        }
 
         // The previously-scheduled FB has been page-flipped, and is now visible
         visible_fb = std::move(scheduled_fb);
@@ -304,6 +327,38 @@ void mgg::DisplaySink::wait_for_page_flip()
     }
 }
 
+void mgg::DisplaySink::wait_for_presentation_flip()
+{
+    auto const output = std::find(outputs_flipping.begin(), outputs_flipping.end(), presentation_output());
+    if (output != outputs_flipping.end())
+    {
+        auto const flipping = *output;
+        outputs_flipping.erase(output);
+        flipped(*flipping, flipping->wait_for_page_flip());
+    }
+}
+
+auto mgg::DisplaySink::presentation_output() const -> std::shared_ptr<KMSOutput> const&
+{
+    /*
+     * In clone mode every output flips on its own vblank, and none can flip to
+     * the next frame until all have flipped to this one. The slowest output
+     * therefore sets the pace, so its flips are the ones clients should hear of.
+     */
+    return *std::min_element(
+        outputs.begin(), outputs.end(),
+        [](auto const& a, auto const& b) { return a->max_refresh_rate() < b->max_refresh_rate(); });
+}
+
+void mgg::DisplaySink::flipped(KMSOutput const& output, std::optional<FramePresentation> const& flip)
+{
+    if (flip && &output == presentation_output().get())
+    {
+        presentation = flip;
+        presentation->zero_copy = scheduled_client_buffers;
+    }
+}
+
 void mgg::DisplaySink::schedule_set_crtc()
 {
     needs_set_crtc = true;
@@ -335,6 +390,9 @@ void mir::graphics::gbm::DisplaySink::set_next_image(std::unique_ptr<Framebuffer
         // Oh, oh! We should be *guaranteed* to “overlay” a single Framebuffer; this is likely a programming error
         BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to post buffer to display"}));
     }
+    // ...but this is a frame we composited, not a client buffer
+    holding_client_buffers = false;
+    next_swap_allows_tearing = false;
 }
 
 auto mgg::DisplaySink::maybe_create_allocator(DisplayAllocator::Tag const& type_tag)
@@ -69,6 +69,8 @@ public:
     std::chrono::milliseconds recommended_sleep() const override;
 
     glm::mat2 transformation() const override;
+    auto last_presentation() const -> std::optional<FramePresentation> override;
+    // No scanout_formats(): we can't make framebuffers of client buffers, so there are none to offer
 
     void set_transformation(glm::mat2 const& t, geometry::Rectangle const& a);
     void schedule_set_crtc();
@@ -82,11 +84,19 @@ protected:
     auto maybe_create_allocator(DisplayAllocator::Tag const& type_tag) -> DisplayAllocator* override;
 
 private:
-    bool schedule_page_flip(FBHandle const& bufobj);
+    bool schedule_page_flip(FBHandle const& bufobj, bool async);
+    /// Wait only for the flip of presentation_output() (if it is flipping)
+    void wait_for_presentation_flip();
+    /// The output whose flips are reported by last_presentation()
+    auto presentation_output() const -> std::shared_ptr<KMSOutput> const&;
+    /// Record how the scheduled frame reached \p output
+    void flipped(KMSOutput const& output, std::optional<FramePresentation> const& flip);
     void set_crtc(FBHandle const&);
 
     std::shared_ptr<struct gbm_device> const gbm;
-    bool holding_client_buffers{false};
+    bool holding_client_buffers{false};     //< next_swap is a client buffer, not a composited frame
+    bool scheduled_client_buffers{false};   //< scheduled_fb is a client buffer, not a composited frame
+    bool next_swap_allows_tearing{false};   //< next_swap may be flipped to asynchronously
     std::shared_ptr<FBHandle const> bypass_bufobj{nullptr};
     std::shared_ptr<DisplayReport> const listener;
 
@@ -107,6 +117,8 @@ private:
     std::atomic<bool> needs_set_crtc;
     std::chrono::milliseconds recommend_sleep{0};
     bool page_flips_pending;
+    std::vector<std::shared_ptr<KMSOutput>> outputs_flipping; //< Outputs whose flip to scheduled_fb is yet to be waited for
+    std::optional<FramePresentation> presentation; //< How the last frame posted reached the screen
 };
 
 }
@@ -28,6 +28,8 @@
 
 #include <gbm.h>
 
+#include <optional>
+
 namespace mir
 {
 namespace graphics
@@ -70,7 +72,20 @@ public:
     virtual bool has_crtc_mismatch() = 0;
     virtual void clear_crtc() = 0;
     virtual bool schedule_page_flip(FBHandle const& fb) = 0;
-    virtual void wait_for_page_flip() = 0;
+    /**
+     * Schedule a flip to \a fb that happens as soon as possible, tearing, rather than at the next vblank
+     *
+     * \returns    false if the output can't flip asynchronously; nothing has been scheduled
+     *              and the caller should fall back to schedule_page_flip()
+     */
+    virtual bool schedule_async_page_flip(FBHandle const& fb) = 0;
+    /**
+     * Wait for the flip scheduled by schedule_page_flip() to complete
+     *
+     * \returns    How the flip reached the screen, or std::nullopt if there
+     *              was nothing to wait for (e.g. the output is powered off)
+     */
+    virtual auto wait_for_page_flip() -> std::optional<FramePresentation> = 0;
 
     virtual bool set_cursor_image(gbm_bo* buffer) = 0;
     virtual void move_cursor(geometry::Point destination) = 0;
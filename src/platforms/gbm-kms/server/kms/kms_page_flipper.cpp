@@ -57,11 +57,32 @@ mgg::KMSPageFlipper::KMSPageFlipper(
         clock_id = CLOCK_REALTIME;
     else
         clock_id = CLOCK_MONOTONIC;
+
+    uint64_t async = 0;
+    async_flips_supported = !drmGetCap(drm_fd, DRM_CAP_ASYNC_PAGE_FLIP, &async) && async;
 }
 
 bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
                                         uint32_t fb_id,
                                         uint32_t connector_id)
+{
+    return schedule(crtc_id, fb_id, connector_id, DRM_MODE_PAGE_FLIP_EVENT);
+}
+
+bool mgg::KMSPageFlipper::schedule_async_flip(uint32_t crtc_id,
+                                              uint32_t fb_id,
+                                              uint32_t connector_id)
+{
+    if (!async_flips_supported)
+        return false;
+
+    return schedule(crtc_id, fb_id, connector_id, DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_PAGE_FLIP_ASYNC);
+}
+
+bool mgg::KMSPageFlipper::schedule(uint32_t crtc_id,
+                                   uint32_t fb_id,
+                                   uint32_t connector_id,
+                                   uint32_t flags)
 {
     std::unique_lock lock{pf_mutex};
 
@@ -77,7 +98,7 @@ bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
      * apparently valid.
      */
     auto ret = drmModePageFlip(drm_fd, crtc_id, fb_id,
-                               DRM_MODE_PAGE_FLIP_EVENT,
+                               flags,
                                &pending_page_flips[crtc_id]);
 
     if (ret)
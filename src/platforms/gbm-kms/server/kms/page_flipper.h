@@ -33,6 +33,13 @@ public:
     virtual ~PageFlipper() {}
 
     virtual bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
+    /**
+     * Schedule a flip that completes as soon as possible, rather than at the next vblank
+     *
+     * \returns    false if the flip could not be scheduled (e.g. the driver doesn't support
+     *              asynchronous flips), in which case nothing has been scheduled
+     */
+    virtual bool schedule_async_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
     virtual Frame wait_for_flip(uint32_t crtc_id) = 0;
 
 protected:
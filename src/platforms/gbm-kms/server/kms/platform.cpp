@@ -34,6 +34,7 @@
 #include <mir/graphics/drm_syncobj.h>
 #include "kms_cpu_addressable_display_provider.h"
 #include "surfaceless_egl_context.h"
+#include "cpu_copy_output_surface.h"
 #include <boost/throw_exception.hpp>
 #include <drm.h>
 #include <drm_fourcc.h>
@@ -49,6 +50,7 @@
 
 namespace mg = mir::graphics;
 namespace mgg = mg::gbm;
+namespace mgc = mg::common;
 
 namespace
 {
@@ -401,21 +403,24 @@ auto maybe_make_dmabuf_provider(
 mgg::RenderingPlatform::RenderingPlatform(
     mir::udev::Device const& device,
     std::vector<std::shared_ptr<mg::DisplayPlatform>> const& platforms,
-    std::shared_ptr<GbmQuirks> quirks)
-    : RenderingPlatform(gbm_device_for_udev_device(device, platforms), std::move(quirks))
+    std::shared_ptr<GbmQuirks> quirks,
+    mgc::OutputReadback readback)
+    : RenderingPlatform(gbm_device_for_udev_device(device, platforms), std::move(quirks), readback)
 {
 }
 
 mgg::RenderingPlatform::RenderingPlatform(
     std::variant<std::shared_ptr<mg::GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw,
-    std::shared_ptr<GbmQuirks> quirks)
+    std::shared_ptr<GbmQuirks> quirks,
+    mgc::OutputReadback readback)
     : device{std::visit(gbm_device_from_hw{}, hw)},
       dpy{initialise_egl(dpy_for_gbm_device(device.get()), 1, 4)},
       bound_display{std::visit(display_provider_or_nothing{}, hw)},
       share_ctx{std::make_unique<SurfacelessEGLContext>(dpy)},
       egl_delegate{std::make_shared<mg::common::EGLContextExecutor>(share_ctx->make_share_context())},
       dmabuf_provider{maybe_make_dmabuf_provider(device, share_ctx->egl_display(), std::make_shared<mg::EGLExtensions>(), egl_delegate)},
-      quirks{std::move(quirks)}
+      quirks{std::move(quirks)},
+      readback{readback}
 {
 }
 
@@ -442,7 +447,8 @@ auto mgg::RenderingPlatform::maybe_create_provider(
             dmabuf_provider,
             share_ctx->egl_display(),
             static_cast<EGLContext>(*share_ctx),
-            quirks);
+            quirks,
+            readback);
     }
     if (dynamic_cast<mg::DRMRenderingProvider::Tag const*>(&type_tag))
     {
@@ -468,7 +474,8 @@ auto mgg::RenderingPlatform::maybe_create_provider(
             dmabuf_provider,
             share_ctx->egl_display(),
             static_cast<EGLContext>(*share_ctx),
-            quirks);
+            quirks,
+            readback);
     }
     return nullptr;
 }
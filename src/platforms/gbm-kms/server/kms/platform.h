@@ -36,6 +36,7 @@ class DMABufEGLProvider;
 namespace common
 {
 class EGLContextExecutor;
+enum class OutputReadback;
 }
 
 namespace gbm
@@ -93,7 +94,8 @@ public:
     RenderingPlatform(
         udev::Device const& device,
         std::vector<std::shared_ptr<graphics::DisplayPlatform>> const& platforms,
-        std::shared_ptr<GbmQuirks> quirks);
+        std::shared_ptr<GbmQuirks> quirks,
+        common::OutputReadback readback);
 
     ~RenderingPlatform() override;
 
@@ -107,7 +109,8 @@ protected:
 private:
     RenderingPlatform(
         std::variant<std::shared_ptr<GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw,
-        std::shared_ptr<GbmQuirks> quirks);
+        std::shared_ptr<GbmQuirks> quirks,
+        common::OutputReadback readback);
 
     class EGLDisplayHandle
     {
@@ -137,6 +140,7 @@ private:
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
     std::shared_ptr<DMABufEGLProvider> const dmabuf_provider;
     std::shared_ptr<GbmQuirks> const quirks;
+    common::OutputReadback const readback;
 };
 }
 }
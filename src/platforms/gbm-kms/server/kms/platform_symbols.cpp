@@ -35,6 +35,7 @@
 #include <mir/graphics/gl_config.h>
 #include <mir/graphics/egl_logger.h>
 #include "quirk_common.h"
+#include "cpu_copy_output_surface.h"
 
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
@@ -84,8 +85,12 @@ auto create_rendering_platform(
 {
     mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
 
+    auto const readback = options.get<bool>(mo::deferred_output_readback_opt) ?
+        mg::common::OutputReadback::deferred :
+        mg::common::OutputReadback::synchronous;
+
     return mir::make_module_ptr<mgg::RenderingPlatform>(
-        *device.device, platforms, mgg::Quirks{options}.gbm_quirks_for(*device.device));
+        *device.device, platforms, mgg::Quirks{options}.gbm_quirks_for(*device.device), readback);
 }
 
 void add_graphics_platform_options(boost::program_options::options_description& config)
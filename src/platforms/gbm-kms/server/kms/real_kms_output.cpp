@@ -237,23 +237,49 @@ bool mgg::RealKMSOutput::schedule_page_flip(FBHandle const& fb)
                        mgk::connector_name(connector).c_str());
         return false;
     }
+    async_flip = false;
     return page_flipper->schedule_flip(
         current_crtc->crtc_id,
         fb,
         connector->connector_id);
 }
 
-void mgg::RealKMSOutput::wait_for_page_flip()
+bool mgg::RealKMSOutput::schedule_async_page_flip(FBHandle const& fb)
+{
+    std::unique_lock lg(power_mutex);
+    if (power_mode != mir_power_mode_on || !current_crtc)
+        return false;
+
+    async_flip = page_flipper->schedule_async_flip(
+        current_crtc->crtc_id,
+        fb,
+        connector->connector_id);
+    return async_flip;
+}
+
+auto mgg::RealKMSOutput::wait_for_page_flip() -> std::optional<FramePresentation>
 {
     std::unique_lock lg(power_mutex);
     if (power_mode != mir_power_mode_on)
-        return;
+        return std::nullopt;
     if (!current_crtc)
     {
         fatal_error("Output %s has no associated CRTC to wait on",
                    mgk::connector_name(connector).c_str());
     }
-    page_flipper->wait_for_flip(current_crtc->crtc_id);
+
+    FramePresentation presentation;
+    presentation.frame = page_flipper->wait_for_flip(current_crtc->crtc_id);
+    if (mode_index < static_cast<size_t>(connector->count_modes))
+    {
+        presentation.refresh = mgk::refresh_interval(connector->modes[mode_index]);
+    }
+    // A vsynced flip event is timestamped by the kernel at the vblank the flip completed in;
+    // an asynchronous flip completes mid-scanout, so its timestamp isn't a scanout measurement
+    presentation.vsync = !async_flip;
+    presentation.hw_clock = !async_flip;
+    presentation.hw_completion = true;
+    return presentation;
 }
 
 bool mgg::RealKMSOutput::set_cursor_image(gbm_bo* buffer)
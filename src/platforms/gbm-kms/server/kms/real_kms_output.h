@@ -52,7 +52,8 @@ public:
     bool has_crtc_mismatch() override;
     void clear_crtc() override;
     bool schedule_page_flip(FBHandle const& fb) override;
-    void wait_for_page_flip() override;
+    bool schedule_async_page_flip(FBHandle const& fb) override;
+    auto wait_for_page_flip() -> std::optional<FramePresentation> override;
 
     bool set_cursor_image(gbm_bo* buffer) override;
     void move_cursor(geometry::Point destination) override;
@@ -85,6 +86,7 @@ private:
 
     MirPowerMode power_mode;
     int dpms_enum_id;
+    bool async_flip{false};     //< The scheduled flip was asynchronous
 
     std::mutex power_mutex;
 };
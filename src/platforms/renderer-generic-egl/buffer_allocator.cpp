@@ -209,7 +209,10 @@ std::vector<MirPixelFormat> mge::BufferAllocator::supported_pixel_formats()
     return pixel_formats;
 }
 
-void mge::BufferAllocator::bind_display(wl_display* display, std::shared_ptr<Executor> wayland_executor)
+void mge::BufferAllocator::bind_display(
+    wl_display* display,
+    std::shared_ptr<Executor> wayland_executor,
+    std::shared_ptr<SurfaceScanoutHints> scanout_hints)
 {
     auto context_guard = mir::raii::paired_calls(
         [this]() { ctx->make_current(); },
@@ -234,7 +237,7 @@ void mge::BufferAllocator::bind_display(wl_display* display, std::shared_ptr<Exe
     {
         if (dmabuf_provider)
         {
-            dmabuf_extension = std::make_unique<LinuxDmaBuf>(display, dmabuf_provider);
+            dmabuf_extension = std::make_unique<LinuxDmaBuf>(display, dmabuf_provider, std::move(scanout_hints));
             mir::log_info("Enabled linux-dmabuf import support");
         }
     }
@@ -302,6 +305,21 @@ auto mge::BufferAllocator::buffer_from_shm(
         std::move(on_release));
 }
 
+auto mge::BufferAllocator::buffer_from_shm_update(
+    std::shared_ptr<renderer::software::RWMappable> data,
+    std::shared_ptr<Buffer> const& previous,
+    std::optional<geometry::Rectangles> const& damage,
+    std::function<void()>&& on_consumed,
+    std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
+{
+    return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
+        std::move(data),
+        previous,
+        damage,
+        std::move(on_consumed),
+        std::move(on_release));
+}
+
 auto mge::BufferAllocator::shared_egl_context() -> EGLContext
 {
     return static_cast<EGLContext>(*ctx);
@@ -423,7 +441,8 @@ auto mge::GLRenderingProvider::surface_for_sink(
         dpy,
         ctx,
         *cpu_provider,
-        config);
+        config,
+        readback);
 }
 
 auto mge::GLRenderingProvider::make_framebuffer_provider(DisplaySink& /*sink*/)
@@ -447,10 +466,12 @@ mge::GLRenderingProvider::GLRenderingProvider(
     EGLDisplay dpy,
     EGLContext ctx,
     std::shared_ptr<mg::DMABufEGLProvider> dmabuf_provider,
-    std::shared_ptr<mgc::EGLContextExecutor> egl_delegate)
+    std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
+    mgc::OutputReadback readback)
     : dpy{dpy},
       ctx{ctx},
       dmabuf_provider{std::move(dmabuf_provider)},
-      egl_delegate(egl_delegate)
+      egl_delegate(egl_delegate),
+      readback{readback}
 {
 }
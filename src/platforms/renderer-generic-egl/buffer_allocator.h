@@ -43,6 +43,7 @@ struct EGLExtensions;
 namespace common
 {
 class EGLContextExecutor;
+enum class OutputReadback;
 }
 
 namespace egl::generic
@@ -60,7 +61,10 @@ public:
     std::shared_ptr<Buffer> alloc_software_buffer(geometry::Size size, MirPixelFormat) override;
     std::vector<MirPixelFormat> supported_pixel_formats() override;
 
-    void bind_display(wl_display* display, std::shared_ptr<Executor> wayland_executor) override;
+    void bind_display(
+        wl_display* display,
+        std::shared_ptr<Executor> wayland_executor,
+        std::shared_ptr<SurfaceScanoutHints> scanout_hints) override;
     void unbind_display(wl_display* display) override;
     auto buffer_from_resource(
         wl_resource* buffer,
@@ -70,6 +74,12 @@ public:
         std::shared_ptr<renderer::software::RWMappable> data,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> override;
+    auto buffer_from_shm_update(
+        std::shared_ptr<renderer::software::RWMappable> data,
+        std::shared_ptr<Buffer> const& previous,
+        std::optional<geometry::Rectangles> const& damage,
+        std::function<void()>&& on_consumed,
+        std::function<void()>&& on_release) -> std::shared_ptr<Buffer> override;
 
     auto shared_egl_context() -> EGLContext;
 private:
@@ -89,7 +99,8 @@ public:
          EGLDisplay dpy,
          EGLContext ctx,
          std::shared_ptr<DMABufEGLProvider> dmabuf_provider,
-         std::shared_ptr<common::EGLContextExecutor> egl_delegate);
+         std::shared_ptr<common::EGLContextExecutor> egl_delegate,
+         common::OutputReadback readback);
 
     auto make_framebuffer_provider(DisplaySink& sink)
         -> std::unique_ptr<FramebufferProvider> override;
@@ -109,6 +120,7 @@ private:
     EGLContext const ctx;
     std::shared_ptr<DMABufEGLProvider> const dmabuf_provider;
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
+    common::OutputReadback const readback;
 };
 }
 }
@@ -19,6 +19,7 @@
 #include <mir/log.h>
 
 #include "rendering_platform.h"
+#include "cpu_copy_output_surface.h"
 #include <mir/module_deleter.h>
 #include <mir/assert_module_entry_point.h>
 #include <mir/libname.h>
@@ -27,6 +28,8 @@
 #include <mir/graphics/egl_error.h>
 #include <mir/graphics/gl_config.h>
 #include <mir/graphics/egl_logger.h>
+#include <mir/options/option.h>
+#include <mir/options/configuration.h>
 
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
@@ -38,12 +41,16 @@ namespace mge = mg::egl::generic;
 auto create_rendering_platform(
     mg::SupportedDevice const&,
     std::vector<std::shared_ptr<mg::DisplayPlatform>> const& displays,
-    mo::Option const&,
+    mo::Option const& options,
     mir::EmergencyCleanupRegistry&) -> mir::UniqueModulePtr<mg::RenderingPlatform>
 {
    mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
 
-    return mir::make_module_ptr<mge::RenderingPlatform>(displays);
+    auto const readback = options.get<bool>(mo::deferred_output_readback_opt) ?
+        mg::common::OutputReadback::deferred :
+        mg::common::OutputReadback::synchronous;
+
+    return mir::make_module_ptr<mge::RenderingPlatform>(displays, readback);
 }
 
 void add_graphics_platform_options(boost::program_options::options_description&)
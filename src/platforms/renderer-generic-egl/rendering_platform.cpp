@@ -196,12 +196,14 @@ auto maybe_make_dmabuf_provider(
 }
 }
 
-mge::RenderingPlatform::RenderingPlatform(std::vector<std::shared_ptr<DisplayPlatform>> const& displays)
-    : RenderingPlatform(egl_display_from_platforms(displays))
+mge::RenderingPlatform::RenderingPlatform(
+    std::vector<std::shared_ptr<DisplayPlatform>> const& displays,
+    mgc::OutputReadback readback)
+    : RenderingPlatform(egl_display_from_platforms(displays), readback)
 {
 }
 
-mge::RenderingPlatform::RenderingPlatform(std::tuple<EGLDisplay, bool> display)
+mge::RenderingPlatform::RenderingPlatform(std::tuple<EGLDisplay, bool> display, mgc::OutputReadback readback)
     : dpy{std::get<0>(display), std::get<1>(display)},
       ctx{std::make_unique<SurfacelessEGLContext>(dpy)},
       dmabuf_provider{
@@ -209,7 +211,8 @@ mge::RenderingPlatform::RenderingPlatform(std::tuple<EGLDisplay, bool> display)
               dpy,
               std::make_shared<mg::EGLExtensions>(),
               std::make_shared<mgc::EGLContextExecutor>(ctx->make_share_context()))},
-      egl_delegate{std::make_shared<mg::common::EGLContextExecutor>(ctx->make_share_context())}
+      egl_delegate{std::make_shared<mg::common::EGLContextExecutor>(ctx->make_share_context())},
+      readback{readback}
 {
 }
 
@@ -230,7 +233,8 @@ auto mge::RenderingPlatform::maybe_create_provider(RenderingProvider::Tag const&
             dpy,
             static_cast<EGLContext>(*ctx),
             dmabuf_provider,
-            egl_delegate);
+            egl_delegate,
+            readback);
     }
     return nullptr;
 }
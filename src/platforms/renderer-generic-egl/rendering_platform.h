@@ -29,13 +29,20 @@ namespace renderer::gl
 class Context;
 }
 
+namespace graphics::common
+{
+enum class OutputReadback;
+}
+
 namespace graphics::egl::generic
 {
 
 class RenderingPlatform : public graphics::RenderingPlatform
 {
 public:
-    explicit RenderingPlatform(std::vector<std::shared_ptr<DisplayPlatform>> const& displays);
+    RenderingPlatform(
+        std::vector<std::shared_ptr<DisplayPlatform>> const& displays,
+        common::OutputReadback readback);
 
     ~RenderingPlatform();
 
@@ -47,7 +54,7 @@ protected:
         RenderingProvider::Tag const& type_tag) -> std::shared_ptr<RenderingProvider> override;
 
 private:
-    explicit RenderingPlatform(std::tuple<EGLDisplay, bool> dpy);
+    RenderingPlatform(std::tuple<EGLDisplay, bool> dpy, common::OutputReadback readback);
 
     /*
      * We (sometimes) need to clean up the EGLDisplay with eglTerminate,
@@ -73,6 +80,7 @@ private:
     std::unique_ptr<renderer::gl::Context> const ctx;
     std::shared_ptr<DMABufEGLProvider> const dmabuf_provider;
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
+    common::OutputReadback const readback;
 };
 
 }
@@ -22,6 +22,7 @@
 #include <mir/executor.h>
 #include "multi_threaded_compositor.h"
 #include <mir/renderers/gl/renderer_factory.h>
+#include <mir/renderers/software/renderer_factory.h>
 #include "basic_screen_shooter.h"
 #include "basic_screen_shooter_factory.h"
 #include "null_screen_shooter.h"
@@ -91,8 +92,20 @@ mir::DefaultServerConfiguration::the_compositor()
 std::shared_ptr<mir::renderer::RendererFactory> mir::DefaultServerConfiguration::the_renderer_factory()
 {
     return renderer_factory(
-        []()
+        [this]() -> std::shared_ptr<mir::renderer::RendererFactory>
         {
+            auto const renderer = the_options()->get<std::string>(options::renderer_opt);
+
+            if (renderer == "software")
+            {
+                mir::log_info("Using software renderer");
+                return std::make_shared<mir::renderer::software::RendererFactory>();
+            }
+            else if (renderer != "gl")
+            {
+                BOOST_THROW_EXCEPTION((std::runtime_error{"Unknown renderer \"" + renderer + "\""}));
+            }
+
             return std::make_shared<mir::renderer::gl::RendererFactory>();
         });
 }
@@ -27,7 +27,10 @@
 #include <mir/graphics/platform.h>
 #include <mir/compositor/buffer_stream.h>
 #include <mir/renderer/renderer.h>
+#include <mir/recycling_allocator.h>
 #include "occlusion.h"
+#include <algorithm>
+#include <chrono>
 #include <memory>
 
 #define MIR_LOG_COMPONENT "compositor"
@@ -35,7 +38,255 @@
 
 namespace mc = mir::compositor;
 namespace mg = mir::graphics;
+namespace geom = mir::geometry;
 
+namespace
+{
+using FramePhase = mc::CompositorReport::FramePhase;
+
+/// Reports the time from construction until the end of the scope (or done()) as a frame phase
+class PhaseTimer
+{
+public:
+    PhaseTimer(mc::CompositorReport& report, mc::CompositorReport::SubCompositorId id, FramePhase phase)
+        : report{report},
+          id{id},
+          phase{phase}
+    {
+    }
+
+    ~PhaseTimer()
+    {
+        done();
+    }
+
+    void done()
+    {
+        if (!reported)
+        {
+            reported = true;
+            report.frame_phase(id, phase, std::chrono::steady_clock::now() - start);
+        }
+    }
+
+private:
+    mc::CompositorReport& report;
+    mc::CompositorReport::SubCompositorId const id;
+    FramePhase const phase;
+    std::chrono::steady_clock::time_point const start{std::chrono::steady_clock::now()};
+    bool reported{false};
+};
+
+/// Restricts drawing of a renderable to the part not hidden by opaque renderables above it
+class ExposedRenderable : public mg::Renderable
+{
+public:
+    ExposedRenderable(std::shared_ptr<mg::Renderable> const& renderable, geom::Rectangle const& exposed)
+        : renderable{renderable},
+          exposed{exposed}
+    {
+    }
+
+    auto id() const -> ID override { return renderable->id(); }
+    auto buffer() const -> std::shared_ptr<mg::Buffer> override { return renderable->buffer(); }
+    auto screen_position() const -> geom::Rectangle override { return renderable->screen_position(); }
+    auto src_bounds() const -> geom::RectangleD override { return renderable->src_bounds(); }
+    auto clip_area() const -> std::optional<geom::Rectangle> override
+    {
+        if (auto const clip = renderable->clip_area())
+            return intersection_of(*clip, exposed);
+        return exposed;
+    }
+    auto alpha() const -> float override { return renderable->alpha(); }
+    auto transformation() const -> glm::mat4 override { return renderable->transformation(); }
+    auto orientation() const -> MirOrientation override { return renderable->orientation(); }
+    auto mirror_mode() const -> MirMirrorMode override { return renderable->mirror_mode(); }
+    auto shaped() const -> bool override { return renderable->shaped(); }
+    auto surface_if_any() const -> std::optional<mir::scene::Surface const*> override
+    {
+        return renderable->surface_if_any();
+    }
+    auto opaque_region() const -> std::optional<geom::Rectangles> override { return renderable->opaque_region(); }
+    auto allows_tearing() const -> bool override { return renderable->allows_tearing(); }
+    auto damage_since(mg::BufferID previous) const -> std::optional<geom::Rectangles> override
+    {
+        return renderable->damage_since(previous);
+    }
+
+private:
+    std::shared_ptr<mg::Renderable> const renderable;
+    geom::Rectangle const exposed;
+};
+
+/**
+ * Clip the renderables to (the bounds of) their exposed regions, so the renderer doesn't
+ * draw pixels that will be overdrawn by opaque renderables above.
+ *
+ * Renderable::clip_area() is a single rectangle, so this only clips to the bounding rectangle
+ * of each exposed region. Where that region isn't rectangular (a window partly covered by one
+ * that doesn't span it, say) the covered pixels inside the bounds are still drawn; it is the
+ * renderables that are fully covered, and those covered along a whole edge, that gain.
+ *
+ * This happens every frame, so the list and the clipped renderables reuse storage.
+ */
+void clip_to_exposed(
+    mg::RenderableList const& renderables,
+    std::vector<std::optional<geom::Region> const*> const& exposed_regions,
+    std::shared_ptr<mir::RecyclingPool> const& pool,
+    mg::RenderableList& result)
+{
+    result.clear();
+
+    for (size_t i = 0; i != renderables.size(); ++i)
+    {
+        auto const& renderable = renderables[i];
+        auto const& exposed = *exposed_regions[i];
+        if (!exposed)
+        {
+            result.push_back(renderable);
+            continue;
+        }
+
+        auto const exposed_bounds = exposed->bounding_rectangle();
+        auto drawn = renderable->screen_position();
+        if (auto const clip = renderable->clip_area())
+            drawn = intersection_of(drawn, *clip);
+
+        if (intersection_of(drawn, exposed_bounds) == drawn)
+        {
+            result.push_back(renderable);   // Nothing to gain
+        }
+        else
+        {
+            result.push_back(std::allocate_shared<ExposedRenderable>(
+                mir::RecyclingAllocator<ExposedRenderable>{pool}, renderable, exposed_bounds));
+        }
+    }
+}
+
+/**
+ * Whether the client could have \a renderable scanned out, were its buffer in a scanout format
+ *
+ * That is if it is on a plane already, or could replace the composited image entirely.
+ */
+/// Whether \a renderable samples all of its buffer, rather than a part cropped out by (say) wp_viewporter
+auto shows_whole_buffer(mg::Renderable const& renderable) -> bool
+{
+    return renderable.src_bounds() == geom::RectangleD{{0, 0}, renderable.buffer()->size()};
+}
+
+auto is_scanout_candidate(mg::Renderable const& renderable, geom::Rectangle const& view_area, bool on_plane) -> bool
+{
+    if (on_plane)
+    {
+        return true;
+    }
+
+    return renderable.alpha() == 1.0f &&
+           renderable.transformation() == glm::mat4{1} &&
+           shows_whole_buffer(renderable) &&
+           renderable.screen_position().contains(view_area);
+}
+}
+
+
+auto mc::DefaultDisplayBufferCompositor::framebuffer_for(
+    mg::Renderable const& renderable,
+    FramebufferCache& used) -> std::shared_ptr<mg::Framebuffer>
+{
+    /* Planes can't apply a renderable's opacity or transformation; those have to be composited.
+     * Nor do we pass a crop on: a DisplayElement's source is the part of the element that is
+     * shown, and the display maps that onto the whole buffer.
+     */
+    if (renderable.alpha() != 1.0f || renderable.transformation() != glm::mat4{1} || !shows_whole_buffer(renderable))
+    {
+        return nullptr;
+    }
+
+    auto const buffer = renderable.buffer();
+    auto const id = buffer->id();
+    auto const is_for_buffer = [id](auto const& entry) { return entry.first == id; };
+    if (auto const seen = std::find_if(used.begin(), used.end(), is_for_buffer); seen != used.end())
+    {
+        return seen->second;
+    }
+    if (auto const cached = std::find_if(framebuffer_cache.begin(), framebuffer_cache.end(), is_for_buffer);
+        cached != framebuffer_cache.end())
+    {
+        return used.emplace_back(*cached).second;
+    }
+    // Importing a buffer for scanout is costly, and mostly fails; remember failures too
+    return used.emplace_back(id, fb_adaptor->buffer_to_framebuffer(buffer)).second;
+}
+
+void mc::DefaultDisplayBufferCompositor::report_scanout_candidates(
+    SceneElementSequence const& elements,
+    std::vector<bool> const& on_planes,
+    geom::Rectangle const& view_area)
+{
+    if (!scanout_formats)
+    {
+        return;
+    }
+
+    auto const candidate = [&](size_t i)
+        {
+            return is_scanout_candidate(*elements[i]->renderable(), view_area, i < on_planes.size() && on_planes[i]);
+        };
+
+    // The client allocates for the whole surface, so it is a candidate if any of its buffers is
+    std::vector<mir::scene::Surface const*> candidate_surfaces;
+    for (size_t i = 0; i != elements.size(); ++i)
+    {
+        if (candidate(i))
+        {
+            if (auto const surface = elements[i]->renderable()->surface_if_any())
+            {
+                candidate_surfaces.push_back(*surface);
+            }
+        }
+    }
+
+    for (size_t i = 0; i != elements.size(); ++i)
+    {
+        auto const surface = elements[i]->renderable()->surface_if_any();
+        auto const is_candidate = surface ?
+            std::find(candidate_surfaces.begin(), candidate_surfaces.end(), *surface) != candidate_surfaces.end() :
+            candidate(i);
+        if (is_candidate)
+        {
+            elements[i]->scanout_candidate(scanout_formats);
+        }
+        else
+        {
+            elements[i]->scanout_candidate(std::nullopt);
+        }
+    }
+}
+
+void mc::DefaultDisplayBufferCompositor::composited_image(
+    mg::RenderableList const& renderables,
+    geom::Rectangle const& view_area,
+    glm::mat2 const& output_transform,
+    MirOutputFilter filter,
+    CompositedImage& image)
+{
+    image.view_area = view_area;
+    image.output_transform = output_transform;
+    image.filter = filter;
+    image.renderables.clear();
+
+    for (auto const& renderable : renderables)
+    {
+        image.renderables.push_back({
+            renderable->id(),
+            renderable->buffer()->id(),
+            renderable->screen_position(),
+            renderable->clip_area(),
+            renderable->alpha(),
+            renderable->transformation()});
+    }
+}
 
 mc::DefaultDisplayBufferCompositor::DefaultDisplayBufferCompositor(
     mg::DisplaySink& display_sink,
@@ -47,7 +298,9 @@ mc::DefaultDisplayBufferCompositor::DefaultDisplayBufferCompositor(
     renderer(renderer),
     output_filter(output_filter),
     fb_adaptor{gl_provider.make_framebuffer_provider(display_sink)},
-    report(report)
+    report(report),
+    scanout_formats{display_sink.scanout_formats()},
+    exposed_renderable_pool{std::make_shared<RecyclingPool>()}
 {
 }
 
@@ -60,13 +313,17 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
     report->began_frame(this);
 
     auto const& view_area = display_sink.view_area();
-    auto [occluded_elements, visible_elements] = mc::split_occluded_and_visible(std::move(scene_elements), view_area);
+    PhaseTimer occlusion_timer{*report, this, FramePhase::occlusion};
+    mc::split_occluded_and_exposed(std::move(scene_elements), view_area, exposure);
+    auto& occluded_elements = exposure.occluded;
+    auto& visible_elements = exposure.visible;
 
     for (auto const& element : occluded_elements)
         element->occluded();
+    occluded_elements.clear();
+    occlusion_timer.done();
 
-    mg::RenderableList renderable_list;
-    renderable_list.reserve(visible_elements.size());
+    renderable_list.clear();
     for (auto const& element : visible_elements)
     {
         element->rendered();
@@ -77,22 +334,19 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
      * Note: Buffer lifetimes are ensured by the two objects holding
      *       references to them; visible_elements and renderable_list.
      *       So no buffer is going to be released back to the client till
-     *       both of those containers get destroyed (end of the function).
+     *       both of those containers get cleared (end of the function).
      *       Actually, there's a third reference held by the texture cache
      *       in GLRenderer, but that gets released earlier in render().
      */
-    visible_elements.clear();  // Those in use are still in renderable_list
 
-    std::vector<mg::DisplayElement> framebuffers;
-    framebuffers.reserve(renderable_list.size());
+    PhaseTimer overlay_timer{*report, this, FramePhase::overlay_decision};
+    framebuffers.clear();
+    bool all_have_framebuffers = true;
+    bool any_have_framebuffers = false;
+    used_framebuffers.clear();
 
     for (auto const& renderable : renderable_list)
     {
-        auto fb = fb_adaptor->buffer_to_framebuffer(renderable->buffer());
-        if (!fb)
-        {
-            break;
-        }
         geometry::Rectangle clipped_dest;
         if (renderable->clip_area())
         {
@@ -113,25 +367,100 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
         framebuffers.emplace_back(mg::DisplayElement{
             renderable->screen_position(),
             geometry::RectangleF{source_origin, source_size},
-            std::move(fb)
+            framebuffer_for(*renderable, used_framebuffers),
+            renderable->allows_tearing()
         });
+
+        if (framebuffers.back().buffer)
+            any_have_framebuffers = true;
+        else
+            all_have_framebuffers = false;
     }
 
-    if (framebuffers.size() == renderable_list.size() && display_sink.overlay(framebuffers))
+    // Only keep framebuffers for buffers still on screen; the rest can go back to their clients
+    std::swap(framebuffer_cache, used_framebuffers);
+    used_framebuffers.clear();
+
+    bool const all_on_planes = all_have_framebuffers && display_sink.overlay(framebuffers);
+    auto const on_planes =
+        all_on_planes ? std::vector<bool>(framebuffers.size(), true) :
+        any_have_framebuffers ? display_sink.overlay_where_possible(framebuffers) :
+        std::vector<bool>{};
+    framebuffers.clear();
+    overlay_timer.done();
+
+    report_scanout_candidates(visible_elements, on_planes, view_area);
+    visible_elements.clear();  // Those in use are still in renderable_list
+
+    if (all_on_planes)
     {
         report->renderables_in_frame(this, renderable_list);
         renderer->suspend();
+        last_composited.reset();
+        renderable_list.clear();
     }
     else
     {
-        renderer->set_output_transform(display_sink.transformation());
-        renderer->set_viewport(view_area);
-        renderer->set_output_filter(output_filter->filter());
+        to_composite.clear();
+        exposed_to_composite.clear();
+        for (size_t i = 0; i != renderable_list.size(); ++i)
+        {
+            if (i < on_planes.size() && on_planes[i])
+                continue;
+
+            to_composite.push_back(renderable_list[i]);
+            exposed_to_composite.push_back(&exposure.exposed[i]);
+        }
 
-        display_sink.set_next_image(renderer->render(renderable_list));
+        auto const output_transform = display_sink.transformation();
+        auto const filter = output_filter->filter();
+        composited_image(to_composite, view_area, output_transform, filter, composited);
 
         report->renderables_in_frame(this, renderable_list);
-        report->rendered_frame(this);
+
+        /* When only what is on the planes has changed (a video playing in an
+         * otherwise still desktop, say) the image beneath them is still good.
+         * (Unless the renderer has yet to display it.)
+         */
+        if (to_composite.size() == renderable_list.size() || !last_composited || composited != *last_composited ||
+            renderer->has_pending_frame())
+        {
+            renderer->set_output_transform(output_transform);
+            renderer->set_viewport(view_area);
+            renderer->set_output_filter(filter);
+
+            /* The renderer's clipping doesn't account for rotated outputs, so only restrict
+             * drawing to the exposed areas when the output is untransformed.
+             */
+            auto const render_start = std::chrono::steady_clock::now();
+            if (output_transform == glm::mat2{1})
+            {
+                clip_to_exposed(to_composite, exposed_to_composite, exposed_renderable_pool, clipped);
+                display_sink.set_next_image(renderer->render(clipped));
+                clipped.clear();
+            }
+            else
+            {
+                display_sink.set_next_image(renderer->render(to_composite));
+            }
+            std::chrono::nanoseconds const render_time = std::chrono::steady_clock::now() - render_start;
+
+            // Report the renderer's texture upload and commit separately from the rest of its work
+            auto const timings = renderer->last_render_timings();
+            report->frame_phase(this, FramePhase::texture_upload, timings.texture_upload);
+            report->frame_phase(this, FramePhase::commit, timings.commit);
+            report->frame_phase(
+                this,
+                FramePhase::render,
+                std::max(render_time - timings.texture_upload - timings.commit, std::chrono::nanoseconds::zero()));
+
+            report->rendered_frame(this);
+        }
+
+        // Keep the storage of the image we replace for the next frame
+        if (!last_composited)
+            last_composited.emplace();
+        std::swap(*last_composited, composited);
 
         /*
          * This is used for the 'early release' optimization to release buffers
@@ -144,9 +473,15 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
          *        problematic IPC (LP: #1395421) will instead occur in buffer
          *        acquisition calls when we composite the next frame.
          */
+        PhaseTimer release_timer{*report, this, FramePhase::buffer_release};
+        to_composite.clear();
         renderable_list.clear();
     }
-
     report->finished_frame(this);
     return true;
 }
+
+auto mc::DefaultDisplayBufferCompositor::needs_another_frame() const -> bool
+{
+    return renderer->has_pending_frame();
+}
@@ -17,12 +17,24 @@
 #ifndef MIR_COMPOSITOR_DEFAULT_DISPLAY_BUFFER_COMPOSITOR_H_
 #define MIR_COMPOSITOR_DEFAULT_DISPLAY_BUFFER_COMPOSITOR_H_
 
+#include "occlusion.h"
+
 #include <mir/compositor/display_buffer_compositor.h>
 #include <mir/graphics/platform.h>
+#include <mir/graphics/buffer_id.h>
+#include <mir/graphics/renderable.h>
+#include <mir/graphics/scanout_formats.h>
+#include <mir/graphics/display_sink.h>
+#include <mir_toolkit/common.h>
+
 #include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace mir
 {
+class RecyclingPool;
 namespace compositor
 {
 class CompositorReport;
@@ -52,14 +64,73 @@ public:
         std::shared_ptr<compositor::CompositorReport> const& report);
 
     bool composite(SceneElementSequence&& scene_sequence) override;
+    auto needs_another_frame() const -> bool override;
 
 private:
+    /// There are only ever a few buffers on screen, so this is a short list rather than a map
+    using FramebufferCache = std::vector<std::pair<graphics::BufferID, std::shared_ptr<graphics::Framebuffer>>>;
+
+    /// What went into a composited image; if it is unchanged the image needn't be redrawn
+    struct CompositedRenderable
+    {
+        graphics::Renderable::ID id;
+        graphics::BufferID buffer;
+        geometry::Rectangle screen_position;
+        std::optional<geometry::Rectangle> clip_area;
+        float alpha;
+        glm::mat4 transformation;
+
+        auto operator==(CompositedRenderable const&) const -> bool = default;
+    };
+
+    struct CompositedImage
+    {
+        geometry::Rectangle view_area;
+        glm::mat2 output_transform;
+        MirOutputFilter filter;
+        std::vector<CompositedRenderable> renderables;
+
+        auto operator==(CompositedImage const&) const -> bool = default;
+    };
+
+    /// The (cached) scanout framebuffer for \a renderable, or null if it must be composited
+    auto framebuffer_for(graphics::Renderable const& renderable, FramebufferCache& used)
+        -> std::shared_ptr<graphics::Framebuffer>;
+
+    /// Tell each element whether a client could get it scanned out by allocating in scanout_formats
+    void report_scanout_candidates(
+        SceneElementSequence const& elements,
+        std::vector<bool> const& on_planes,
+        geometry::Rectangle const& view_area);
+
+    static void composited_image(
+        graphics::RenderableList const& renderables,
+        geometry::Rectangle const& view_area,
+        glm::mat2 const& output_transform,
+        MirOutputFilter filter,
+        CompositedImage& image);
+
     graphics::DisplaySink& display_sink;
     std::shared_ptr<renderer::Renderer> const renderer;
     std::shared_ptr<graphics::OutputFilter> const output_filter;
     std::unique_ptr<graphics::RenderingProvider::FramebufferProvider> const fb_adaptor;
     std::shared_ptr<compositor::CompositorReport> const report;
+    std::optional<graphics::ScanoutFormats> const scanout_formats;
     bool completed_first_render = false;
+    FramebufferCache framebuffer_cache;
+    /// The image last passed to the sink, if it is still in use beneath overlays
+    std::optional<CompositedImage> last_composited;
+
+    // Working storage for composite(), kept so that a steady frame needn't allocate
+    Exposure exposure;
+    graphics::RenderableList renderable_list;
+    std::vector<graphics::DisplayElement> framebuffers;
+    FramebufferCache used_framebuffers;
+    graphics::RenderableList to_composite;
+    std::vector<std::optional<geometry::Region> const*> exposed_to_composite;
+    graphics::RenderableList clipped;
+    CompositedImage composited;
+    std::shared_ptr<RecyclingPool> const exposed_renderable_pool;
 };
 
 }
@@ -82,9 +82,14 @@ mc::DefaultDisplayBufferCompositorFactory::create_compositor_for(
 
     auto const chosen_allocator = best_provider.second;
 
-    auto output_surface = chosen_allocator->surface_for_sink(
-        display_sink, *gl_config);
-    auto renderer = renderer_factory->create_renderer_for(std::move(output_surface), chosen_allocator);
+    // A software renderer needs no GL surface; otherwise the renderer draws into one
+    auto renderer = renderer_factory->create_software_renderer_for(display_sink);
+    if (!renderer)
+    {
+        auto output_surface = chosen_allocator->surface_for_sink(
+            display_sink, *gl_config);
+        renderer = renderer_factory->create_renderer_for(std::move(output_surface), chosen_allocator);
+    }
     renderer->set_viewport(display_sink.view_area());
     return std::make_unique<DefaultDisplayBufferCompositor>(
         display_sink, *chosen_allocator, std::move(renderer), output_filter, report);
@@ -21,6 +21,7 @@
 #include <mir/frontend/event_sink.h>
 #include <mir/graphics/drm_formats.h>
 #include "multi_threaded_compositor.h"
+#include <mir/recycling_allocator.h>
 #include <boost/throw_exception.hpp>
 #include <algorithm>
 
@@ -35,24 +36,34 @@ struct mc::MultiMonitorArbiter::Submission
     std::shared_ptr<mg::Buffer> buffer;
     geom::Size output_size;
     geom::RectangleD source_sample;
+    /// The buffer that damage is relative to, if known
+    std::optional<mg::BufferID> replaces;
+    geom::Rectangles damage;
 };
 
-namespace
-{
-class TrackingSubmission : public mc::BufferStream::Submission
+class mc::MultiMonitorArbiter::TrackingSubmission : public mc::BufferStream::Submission
 {
 public:
     TrackingSubmission(
-        std::shared_ptr<mc::MultiMonitorArbiter::Submission> submission,
-        std::function<void()> on_claimed)
-        : submission{std::move(submission)},
-          on_claimed{std::move(on_claimed)}
+        std::shared_ptr<MultiMonitorArbiter> arbiter,
+        std::shared_ptr<MultiMonitorArbiter::Submission> submission,
+        CompositorID id)
+        : arbiter{std::move(arbiter)},
+          submission{std::move(submission)},
+          id{id}
     {
     }
 
     auto claim_buffer() -> std::shared_ptr<mg::Buffer> override
     {
-        on_claimed();
+        auto state = arbiter->state.lock();
+        // Ensure we still have the same state
+        if (state->current_submission == submission)
+        {
+            // The compositor is now a user of the current buffer
+            // This means we will try to give it a new buffer next time it asks
+            add_current_buffer_user(*state, id);
+        }
         return submission->buffer;
     }
 
@@ -70,13 +81,23 @@ public:
     {
         return mg::DRMFormat::from_mir_format(submission->buffer->pixel_format());
     }
+
+    auto damage_since(mg::BufferID previous) const -> std::optional<geom::Rectangles> override
+    {
+        if (submission->replaces != previous)
+        {
+            return std::nullopt;
+        }
+        return submission->damage;
+    }
 private:
-    std::shared_ptr<mc::MultiMonitorArbiter::Submission> submission;
-    std::function<void()> on_claimed;
+    std::shared_ptr<MultiMonitorArbiter> const arbiter;
+    std::shared_ptr<MultiMonitorArbiter::Submission> const submission;
+    CompositorID const id;
 };
-}
 
 mc::MultiMonitorArbiter::MultiMonitorArbiter()
+    : tracking_submission_pool{std::make_shared<RecyclingPool>()}
 {
     // We're highly unlikely to have more than 6 outputs
     state.lock()->current_buffer_users.reserve(6);
@@ -109,18 +130,13 @@ auto mc::MultiMonitorArbiter::compositor_acquire(compositor::CompositorID id)
     if (!current_state->current_submission)
         BOOST_THROW_EXCEPTION(std::logic_error("no buffer to give to compositor"));
 
-    return std::make_shared<TrackingSubmission>(
+    // Compositors acquire a submission from every visible surface on every frame,
+    // so recycle the storage rather than going to the heap each time.
+    return std::allocate_shared<TrackingSubmission>(
+        RecyclingAllocator<TrackingSubmission>{tracking_submission_pool},
+        shared_from_this(),
         current_state->current_submission,
-        [me = shared_from_this(), submission = current_state->current_submission, id]()
-        {
-            auto state = me->state.lock();
-            // Ensure we still have the same state
-            if (state->current_submission != submission)
-                return;
-            // The compositor is now a user of the current buffer
-            // This means we will try to give it a new buffer next time it asks
-            add_current_buffer_user(*state, id);
-        });
+        id);
 }
 
 void mc::MultiMonitorArbiter::submit_buffer(
@@ -128,7 +144,32 @@ void mc::MultiMonitorArbiter::submit_buffer(
     geom::Size output_size,
     geom::RectangleD source)
 {
-    state.lock()->next_submission = std::make_shared<Submission>(std::move(buffer), output_size, source);
+    submit_buffer(std::move(buffer), output_size, source, geom::Rectangles{{{}, output_size}});
+}
+
+void mc::MultiMonitorArbiter::submit_buffer(
+    std::shared_ptr<mg::Buffer> buffer,
+    geom::Size output_size,
+    geom::RectangleD source,
+    geom::Rectangles const& damage)
+{
+    auto const submission = std::make_shared<Submission>(std::move(buffer), output_size, source, std::nullopt, damage);
+
+    auto current_state = state.lock();
+    if (auto const& superseded = current_state->next_submission)
+    {
+        // No compositor saw the superseded buffer, so what it changed is still to be shown
+        submission->replaces = superseded->replaces;
+        for (auto const& rect : superseded->damage)
+        {
+            submission->damage.add(rect);
+        }
+    }
+    else if (auto const& current = current_state->current_submission)
+    {
+        submission->replaces = current->buffer->id();
+    }
+    current_state->next_submission = submission;
 }
 
 
@@ -28,6 +28,7 @@
 
 namespace mir
 {
+class RecyclingPool;
 namespace graphics { class Buffer; }
 namespace compositor
 {
@@ -81,8 +82,17 @@ public:
         geometry::Size output_size,
         geometry::RectangleD source_sample);
 
+    /// \param damage  The area, within {{0, 0}, output_size}, that differs from the previous buffer
+    void submit_buffer(
+        std::shared_ptr<graphics::Buffer> buffer,
+        geometry::Size output_size,
+        geometry::RectangleD source_sample,
+        geometry::Rectangles const& damage);
+
     struct Submission;
 private:
+    class TrackingSubmission;
+
     struct State
     {
         std::vector<std::optional<compositor::CompositorID>> current_buffer_users;
@@ -90,6 +100,7 @@ private:
         std::shared_ptr<Submission> next_submission;
     };
     Synchronised<State> state;
+    std::shared_ptr<RecyclingPool> const tracking_submission_pool;
 
     static void add_current_buffer_user(State& state, compositor::CompositorID id);
     static bool is_user_of_current_buffer(State& state, compositor::CompositorID id);
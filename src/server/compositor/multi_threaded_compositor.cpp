@@ -33,6 +33,7 @@
 #include <mir/signal.h>
 #include <mir/log.h>
 
+#include <algorithm>
 #include <atomic>
 #include <thread>
 #include <chrono>
@@ -182,7 +183,12 @@ public:
                     for (auto& tuple : compositors)
                     {
                         auto& compositor = std::get<1>(tuple);
+                        auto const snapshot_start = std::chrono::steady_clock::now();
                         auto scene_elements = scene->scene_elements_for(compositor.get());
+                        report->frame_phase(
+                            compositor.get(),
+                            CompositorReport::FramePhase::scene_snapshot,
+                            std::chrono::steady_clock::now() - snapshot_start);
                         if (cursor->needs_compositing())
                         {
                             if (auto const cursor_renderable = cursor->renderable())
@@ -195,7 +201,35 @@ public:
 
                     // We can skip the post if none of the compositors ended up compositing
                     if (needs_post)
+                    {
+                        auto const post_start = std::chrono::steady_clock::now();
                         group.post();
+                        std::chrono::nanoseconds const post_time = std::chrono::steady_clock::now() - post_start;
+
+                        // post() returns once the frame is (about to be) on screen, so this is
+                        // when surfaces in it should be told to draw their next frame
+                        auto const assumed = assumed_presentation();
+                        for (auto const& [sink, compositor] : compositors)
+                        {
+                            auto const presentation = sink->last_presentation().value_or(assumed);
+                            report->frame_phase(
+                                compositor.get(),
+                                CompositorReport::FramePhase::flip,
+                                flip_time(post_time, presentation));
+                            report->presented_frame(compositor.get(), presentation);
+                            scene->frame_presented(compositor.get(), presentation);
+                        }
+                    }
+
+                    // Some renderers return each frame a composite later; get the last one on screen
+                    for (auto const& [_, compositor] : compositors)
+                    {
+                        if (compositor->needs_another_frame())
+                        {
+                            wakeup.raise();
+                            break;
+                        }
+                    }
 
                     /*
                      * "Predictive bypass" optimization: If the last frame was
@@ -243,6 +277,23 @@ public:
         wakeup.raise();
     }
 
+    /// From starting post() until \a presentation completed (if the sink says when that was)
+    static auto flip_time(std::chrono::nanoseconds post_time, mg::FramePresentation const& presentation)
+        -> std::chrono::nanoseconds
+    {
+        auto const since_completion = mg::Frame::Timestamp::now(presentation.frame.ust.clock_id) - presentation.frame.ust;
+        return std::clamp(post_time - since_completion, std::chrono::nanoseconds::zero(), post_time);
+    }
+
+    /// For sinks that can't tell us how a frame was presented: assume it hit the screen as post() returned
+    auto assumed_presentation() -> mg::FramePresentation
+    {
+        mg::FramePresentation presentation;
+        presentation.frame.msc = ++assumed_msc;
+        presentation.frame.ust = mg::Frame::Timestamp::now(CLOCK_MONOTONIC);
+        return presentation;
+    }
+
     void wait_until_started()
     {
         if (started_future.wait_for(10s) != std::future_status::ready)
@@ -270,6 +321,7 @@ private:
     std::shared_ptr<DisplayListener> const display_listener;
     std::shared_ptr<CompositorReport> const report;
     std::shared_ptr<mg::Cursor> const cursor;
+    int64_t assumed_msc{0};
     std::promise<void> started;
     std::future<void> started_future;
     std::promise<void> stopped;
@@ -392,7 +444,7 @@ void mc::MultiThreadedCompositor::create_compositing_threads()
             display_buffer_compositor_factory, group, scene, display_listener,
             fixed_composite_delay, report, cursor);
 
-        mir::thread_pool_executor.spawn(std::ref(*thread_functor));
+        mir::long_running_executor.spawn(std::ref(*thread_functor));
         thread_functors.push_back(std::move(thread_functor));
     });
 
@@ -15,10 +15,12 @@
  */
 
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/region.h>
 #include <mir/compositor/scene_element.h>
 #include <mir/graphics/renderable.h>
 #include "occlusion.h"
 
+#include <algorithm>
 #include <vector>
 
 using namespace mir::geometry;
@@ -27,78 +29,101 @@ using namespace mir::compositor;
 
 namespace
 {
-bool renderable_is_occluded(
+/**
+ * Set exposed to the exposed region of renderable (std::nullopt if unknown), adding what it
+ * covers to coverage. Returns false if the renderable is occluded.
+ */
+auto expose(
     Renderable const& renderable,
     Rectangle const& area,
-    std::vector<Rectangle>& coverage)
+    Region& coverage,
+    std::optional<Region>& exposed) -> bool
 {
     static glm::mat4 const identity(1);
-    static Rectangle const empty{};
 
     if (renderable.transformation() != identity)
-        return false;  // Weirdly transformed. Assume never occluded.
+    {
+        exposed.reset();
+        return true;  // Weirdly transformed. Assume never occluded.
+    }
 
     auto const& window = renderable.screen_position();
     auto const& clipped_window = intersection_of(window, area);
 
-    if (clipped_window == empty)
-        return true;  // Not in the area; definitely occluded.
+    if (clipped_window.size == Size{})
+        return false;  // Not in the area; definitely occluded.
+
+    if (!exposed)
+        exposed.emplace();
+    *exposed = clipped_window;
+    exposed->subtract(coverage);
+    if (exposed->empty())
+        return false;
 
-    bool occluded = false;
-    for (auto const& r : coverage)
+    if (renderable.shaped())
     {
-        if (r.contains(clipped_window))
+        if (auto const opaque_region = renderable.opaque_region())
         {
-            occluded = true;
-            break;
+            Region opaque{*opaque_region};
+            opaque.intersect(area);
+            coverage.unite(opaque);
         }
+        // Client didn't send an opaque region
     }
-
-    if (!occluded)
+    else if (renderable.alpha() == 1.0f)
     {
-        if (renderable.shaped())
-        {
-            if (auto const opaque_region = renderable.opaque_region())
-            {
-                for (auto const& subregion : *opaque_region)
-                {
-                    auto const clipped_subregion = intersection_of(subregion, area);
-                    coverage.push_back(clipped_subregion);
-                }
-            }
-            // Client didn't send an opaque region
-        }
-        else if (renderable.alpha() == 1.0f)
-        {
-            coverage.push_back(clipped_window);
-        }
+        // Only the exposed part adds to what is already covered
+        coverage.unite(*exposed);
     }
-    return occluded;
+
+    return true;
 }
 }
 
 std::pair<OccludedElementSequence, SceneElementSequence> mir::compositor::split_occluded_and_visible(
     SceneElementSequence&& elements, Rectangle const& area)
 {
-    std::pair<OccludedElementSequence, SceneElementSequence> result{{}, std::move(elements)};
-    std::vector<Rectangle> coverage;
+    auto [occluded, visible, exposed] = split_occluded_and_exposed(std::move(elements), area);
+    return {std::move(occluded), std::move(visible)};
+}
+
+auto mir::compositor::split_occluded_and_exposed(SceneElementSequence&& elements, Rectangle const& area)
+    -> std::tuple<OccludedElementSequence, SceneElementSequence, std::vector<std::optional<Region>>>
+{
+    Exposure result;
+    split_occluded_and_exposed(std::move(elements), area, result);
+    return {std::move(result.occluded), std::move(result.visible), std::move(result.exposed)};
+}
+
+void mir::compositor::split_occluded_and_exposed(
+    SceneElementSequence&& elements, Rectangle const& area, Exposure& result)
+{
+    auto& [occluded, visible, exposed, coverage] = result;
+    occluded.clear();
+    visible.clear();
+    coverage = Rectangle{};
 
-    auto& [occluded, visible] = result;
+    // Regions are written in place (from the top down), so those of the last frame lend their storage
+    if (exposed.size() < elements.size())
+        exposed.resize(elements.size());
 
-    auto it = visible.rbegin();
-    while (it != visible.rend())
+    size_t exposed_count{0};
+    for (auto it = elements.rbegin(); it != elements.rend(); ++it)
     {
-        auto const renderable = (*it)->renderable();
-        if (renderable_is_occluded(*renderable, area, coverage))
+        if (expose(*(*it)->renderable(), area, coverage, exposed[exposed_count]))
         {
-            occluded.insert(occluded.begin(), *it);
-            it = SceneElementSequence::reverse_iterator(visible.erase(std::prev(it.base())));
+            visible.push_back(std::move(*it));
+            ++exposed_count;
         }
         else
         {
-            it++;
+            occluded.push_back(std::move(*it));
         }
     }
 
-    return result;
+    // We visited the elements from the top down
+    std::reverse(occluded.begin(), occluded.end());
+    std::reverse(visible.begin(), visible.end());
+    std::reverse(exposed.begin(), exposed.begin() + exposed_count);
+    exposed.resize(exposed_count);
 }
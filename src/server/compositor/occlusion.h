@@ -18,6 +18,11 @@
 #define MIR_COMPOSITOR_OCCLUSION_H_
 
 #include <mir/compositor/scene.h>
+#include <mir/geometry/region.h>
+
+#include <optional>
+#include <tuple>
+#include <vector>
 
 namespace mir
 {
@@ -28,6 +33,27 @@ using OccludedElementSequence = SceneElementSequence;
 std::pair<OccludedElementSequence, SceneElementSequence> split_occluded_and_visible(
     SceneElementSequence&& list, geometry::Rectangle const& area);
 
+/**
+ * As split_occluded_and_visible(), and also the region of each visible element that
+ * is not covered by opaque elements above it (in the same order as the visible elements).
+ *
+ * The region is std::nullopt for elements whose footprint isn't known (i.e. transformed ones).
+ */
+auto split_occluded_and_exposed(SceneElementSequence&& list, geometry::Rectangle const& area)
+    -> std::tuple<OccludedElementSequence, SceneElementSequence, std::vector<std::optional<geometry::Region>>>;
+
+/// The result of split_occluded_and_exposed(), kept from frame to frame so that its storage is reused
+struct Exposure
+{
+    OccludedElementSequence occluded;
+    SceneElementSequence visible;
+    std::vector<std::optional<geometry::Region>> exposed;
+    /// The area covered by opaque elements (working storage)
+    geometry::Region coverage;
+};
+
+void split_occluded_and_exposed(SceneElementSequence&& list, geometry::Rectangle const& area, Exposure& result);
+
 } // namespace compositor
 } // namespace mir
 
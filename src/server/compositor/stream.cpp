@@ -17,6 +17,7 @@
 #include <mir/compositor/stream.h>
 #include "multi_monitor_arbiter.h"
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <mir/graphics/buffer.h>
 #include <boost/throw_exception.hpp>
 #include <math.h>
@@ -30,7 +31,8 @@ namespace geom = mir::geometry;
 mc::Stream::Stream() :
     arbiter(std::make_shared<mc::MultiMonitorArbiter>()),
     first_frame_posted(false),
-    frame_callback{[](auto){}}
+    frame_callback{[](auto){}},
+    presented_callback{[](mg::FramePresentation const&){}}
 {
 }
 
@@ -40,23 +42,54 @@ void mc::Stream::submit_buffer(
     std::shared_ptr<mg::Buffer> const& buffer,
     geom::Size dst_size,
     geom::RectangleD src_bounds)
+{
+    submit_buffer(buffer, dst_size, src_bounds, geom::Rectangles{{{}, dst_size}});
+}
+
+void mc::Stream::submit_buffer(
+    std::shared_ptr<mg::Buffer> const& buffer,
+    geom::Size dst_size,
+    geom::RectangleD src_bounds,
+    geom::Rectangles const& damage)
 {
     if (!buffer)
         BOOST_THROW_EXCEPTION(std::invalid_argument("cannot submit null buffer"));
 
-    arbiter->submit_buffer(buffer, dst_size, src_bounds);
+    arbiter->submit_buffer(buffer, dst_size, src_bounds, damage);
     first_frame_posted = true;
     {
-        (*frame_callback.lock())(buffer->size());
+        // Observers are notified once per frame, so collapse the damage to its bounds
+        (*frame_callback.lock())(damage.bounding_rectangle());
     }
 }
 
 void mc::Stream::set_frame_posted_callback(
-    std::function<void(geometry::Size const&)> const& callback)
+    std::function<void(geometry::Rectangle const&)> const& callback)
 {
     *frame_callback.lock() = callback;
 }
 
+void mc::Stream::set_frame_presented_callback(
+    std::function<void(mg::FramePresentation const&)> const& callback)
+{
+    *presented_callback.lock() = callback;
+}
+
+void mc::Stream::frame_presented(mg::FramePresentation const& presentation)
+{
+    (*presented_callback.lock())(presentation);
+}
+
+void mc::Stream::set_tearing_allowed(bool allowed)
+{
+    tearing_allowed_ = allowed;
+}
+
+auto mc::Stream::tearing_allowed() const -> bool
+{
+    return tearing_allowed_;
+}
+
 auto mc::Stream::next_submission_for_compositor(void const* id) -> std::shared_ptr<Submission>
 {
     return arbiter->compositor_acquire(id);
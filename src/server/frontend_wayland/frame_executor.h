@@ -32,7 +32,8 @@ class AlarmFactory;
 namespace frontend
 {
 
-/// Runs frame callbacks that do not have a buffer to be attached to.
+/// Runs frame callbacks that cannot be paced by output presentation: those that do not
+/// have a buffer to be attached to, and those of surfaces that are not on screen.
 class FrameExecutor : public Executor
 {
 public:
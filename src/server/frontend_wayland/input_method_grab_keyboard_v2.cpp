@@ -87,7 +87,8 @@ void mf::InputMethodGrabKeyboardV2::send_repeat_info(int32_t rate, int32_t delay
 
 void mf::InputMethodGrabKeyboardV2::send_keymap_xkb_v1(mir::Fd const& fd, size_t length)
 {
-    send_keymap_event(mw::Keyboard::KeymapFormat::xkb_v1, fd, length);
+    // Unlike wl_keyboard v7, this protocol doesn't require the keymap to be mapped MAP_PRIVATE
+    send_keymap_event(mw::Keyboard::KeymapFormat::xkb_v1, private_copy_of_keymap(fd, length), length);
 }
 
 void mf::InputMethodGrabKeyboardV2::send_key(std::shared_ptr<MirKeyboardEvent const> const& event)
@@ -16,19 +16,58 @@
 
 #include "keyboard_helper.h"
 
-#include <mir/anonymous_shm_file.h>
 #include <mir/input/keymap.h>
+#include <mir/input/keymap_cache.h>
 #include <mir/events/keyboard_event.h>
 #include <mir/input/seat.h>
-#include <mir/fatal.h>
+#include <mir/anonymous_shm_file.h>
+
+#include <boost/throw_exception.hpp>
 
-#include <cstring> // memcpy
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
 #include <unordered_set>
+#include <unistd.h>
 
 namespace mf = mir::frontend;
 namespace mw = mir::wayland;
 namespace mi = mir::input;
 
+auto mf::private_copy_of_keymap(mir::Fd const& keymap, size_t length) -> mir::Fd
+{
+    mir::AnonymousShmFile copy{length};
+
+    // pread() leaves the shared file offset alone
+    auto const destination = static_cast<char*>(copy.base_ptr());
+    for (size_t copied = 0; copied != length;)
+    {
+        auto const result = pread(keymap, destination + copied, length - copied, copied);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            BOOST_THROW_EXCEPTION(
+                std::system_error(errno, std::system_category(), "Failed to read keymap file"));
+        }
+        if (result == 0)
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error("Keymap file is shorter than expected"));
+        }
+        copied += result;
+    }
+
+    mir::Fd fd{dup(copy.fd())};
+    if (fd == mir::Fd::invalid)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to duplicate keymap file"));
+    }
+    return fd;
+}
+
 mf::KeyboardHelper::KeyboardHelper(
     KeyboardCallbacks* callbacks,
     std::shared_ptr<mi::Keymap> const& initial_keymap,
@@ -37,15 +76,8 @@ mf::KeyboardHelper::KeyboardHelper(
     int default_repeat_delay)
     : callbacks{callbacks},
       mir_seat{seat},
-      current_keymap{nullptr}, // will be set later in the constructor by set_keymap()
-      compiled_keymap{nullptr, &xkb_keymap_unref},
-      context{xkb_context_new(XKB_CONTEXT_NO_FLAGS), &xkb_context_unref}
+      current_keymap{nullptr} // will be set later in the constructor by set_keymap()
 {
-    if (!context)
-    {
-        fatal_error("Failed to create XKB context");
-    }
-
     /* The wayland::Keyboard constructor has already run, creating the keyboard
      * resource. It is thus safe to send a keymap event to it; the client will receive
      * the keyboard object before this event.
@@ -137,19 +169,10 @@ void mf::KeyboardHelper::set_keymap(std::shared_ptr<mi::Keymap> const& new_keyma
     }
 
     current_keymap = new_keymap;
-    compiled_keymap = new_keymap->make_unique_xkb_keymap(context.get());
-
-    std::unique_ptr<char, void(*)(void*)> buffer{xkb_keymap_get_as_string(
-        compiled_keymap.get(),
-        XKB_KEYMAP_FORMAT_TEXT_V1),
-        free};
-    // so the null terminator is included
-    auto length = strlen(buffer.get()) + 1;
-
-    mir::AnonymousShmFile shm_buffer{length};
-    memcpy(shm_buffer.base_ptr(), buffer.get(), length);
 
-    callbacks->send_keymap_xkb_v1(Fd{IntOwnedFd{shm_buffer.fd()}}, length);
+    // Every keyboard with this keymap is sent the same (sealed) file, unless its callbacks copy it
+    auto const serialised = mi::keymap_cache().serialised(new_keymap);
+    callbacks->send_keymap_xkb_v1(serialised->fd, serialised->size);
 }
 
 void mf::KeyboardHelper::set_modifiers(MirXkbModifiers const& new_modifiers)
@@ -29,9 +29,7 @@ struct MirEvent;
 struct MirKeyboardEvent;
 
 // from <xkbcommon/xkbcommon.h>
-struct xkb_keymap;
 struct xkb_state;
-struct xkb_context;
 
 namespace mir
 {
@@ -64,6 +62,15 @@ private:
     KeyboardCallbacks& operator=(KeyboardCallbacks const&) = delete;
 };
 
+/**
+ * Copy the shared keymap file \a keymap into one that only a single client is sent
+ *
+ * Keymap files are shared by every keyboard with the same keymap. Clients of protocols that don't
+ * require them to be mapped MAP_PRIVATE (wl_keyboard before version 7) may instead read() them,
+ * moving the file offset every other client shares, so they need their own copy.
+ */
+auto private_copy_of_keymap(mir::Fd const& keymap, size_t length) -> mir::Fd;
+
 class KeyboardHelper : public mir::shell::KeyboardHelper
 {
 public:
@@ -96,8 +103,6 @@ private:
     std::shared_ptr<input::Seat> const mir_seat;
     MirXkbModifiers modifiers;
     std::shared_ptr<mir::input::Keymap> current_keymap;
-    std::unique_ptr<xkb_keymap, void (*)(xkb_keymap *)> compiled_keymap;
-    std::unique_ptr<xkb_context, void (*)(xkb_context *)> const context;
 };
 }
 }
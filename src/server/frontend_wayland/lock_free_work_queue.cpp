@@ -0,0 +1,171 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lock_free_work_queue.h"
+
+#include <functional>
+#include <utility>
+
+namespace mf = mir::frontend;
+
+namespace
+{
+/// The index that ends the free list
+uint32_t constexpr no_node{UINT32_MAX};
+
+auto index_of(uint64_t free_top) -> uint32_t
+{
+    return static_cast<uint32_t>(free_top);
+}
+
+auto next_free_top(uint64_t free_top, uint32_t index) -> uint64_t
+{
+    return ((free_top >> 32) + 1) << 32 | index;
+}
+}
+
+mf::LockFreeWorkQueue::LockFreeWorkQueue()
+    : pool{std::make_unique<Node[]>(pool_size)},
+      free_nodes{no_node},
+      head{&stub},
+      tail{&stub}
+{
+    for (auto i = 0u; i != pool_size; ++i)
+    {
+        pool[i].next_free.store(i + 1 == pool_size ? no_node : i + 1, std::memory_order_relaxed);
+    }
+    free_nodes.store(0, std::memory_order_release);
+}
+
+mf::LockFreeWorkQueue::~LockFreeWorkQueue()
+{
+    // There are no producers left, so nothing can be part way through being pushed
+    clear();
+}
+
+auto mf::LockFreeWorkQueue::push(std::function<void()>&& work) -> bool
+{
+    if (!work)
+    {
+        // pop() uses an empty function to mean there's no work
+        return false;
+    }
+
+    auto const node = take_node();
+    node->work = std::move(work);
+    push(node);
+
+    // Only the first push since the consumer last woke needs to wake it. (This exchange orders
+    // the push before the consumer's acknowledge_wakeup(), so the consumer will find the work.)
+    return !wakeup_requested.exchange(true, std::memory_order_acq_rel);
+}
+
+void mf::LockFreeWorkQueue::acknowledge_wakeup()
+{
+    wakeup_requested.exchange(false, std::memory_order_acq_rel);
+}
+
+auto mf::LockFreeWorkQueue::take_node() -> Node*
+{
+    auto top = free_nodes.load(std::memory_order_acquire);
+    while (index_of(top) != no_node)
+    {
+        auto const node = &pool[index_of(top)];
+        // If node has been taken since we loaded top, this is stale; but then the exchange fails
+        auto const next = node->next_free.load(std::memory_order_relaxed);
+        if (free_nodes.compare_exchange_weak(
+                top, next_free_top(top, next), std::memory_order_acquire, std::memory_order_acquire))
+        {
+            return node;
+        }
+    }
+
+    // More work is queued than the pool holds
+    return new Node;
+}
+
+void mf::LockFreeWorkQueue::recycle(Node* node)
+{
+    if (std::less<Node*>{}(node, pool.get()) || !std::less<Node*>{}(node, pool.get() + pool_size))
+    {
+        delete node;
+        return;
+    }
+
+    auto const index = static_cast<uint32_t>(node - pool.get());
+    auto top = free_nodes.load(std::memory_order_relaxed);
+    do
+    {
+        node->next_free.store(index_of(top), std::memory_order_relaxed);
+    }
+    while (!free_nodes.compare_exchange_weak(
+        top, next_free_top(top, index), std::memory_order_release, std::memory_order_relaxed));
+}
+
+void mf::LockFreeWorkQueue::push(Node* node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+    auto const previous = head.exchange(node, std::memory_order_acq_rel);
+    // Between the exchange and this store the node is unreachable from tail; pop() allows for that
+    previous->next.store(node, std::memory_order_release);
+}
+
+auto mf::LockFreeWorkQueue::pop() -> std::function<void()>
+{
+    auto node = tail;
+    auto next = node->next.load(std::memory_order_acquire);
+
+    if (node == &stub)
+    {
+        if (!next)
+        {
+            return {};
+        }
+        tail = next;
+        node = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (!next)
+    {
+        if (node != head.load(std::memory_order_acquire))
+        {
+            // A producer is part way through pushing after node
+            return {};
+        }
+
+        // node is the last in the list: put the stub after it, so taking node leaves the list non-empty
+        push(&stub);
+        next = node->next.load(std::memory_order_acquire);
+        if (!next)
+        {
+            // A producer got in before the stub, and is part way through pushing
+            return {};
+        }
+    }
+
+    tail = next;
+    auto work = std::exchange(node->work, nullptr);
+    recycle(node);
+    return work;
+}
+
+void mf::LockFreeWorkQueue::clear()
+{
+    while (pop())
+    {
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_LOCK_FREE_WORK_QUEUE_H
+#define MIR_FRONTEND_LOCK_FREE_WORK_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace mir
+{
+namespace frontend
+{
+/**
+ * A queue of work that any number of threads can add to, and one thread takes from, without locking
+ *
+ * The queue also tracks whether the consumer needs waking: push() only asks for a wakeup when the
+ * consumer hasn't already been asked since it last called acknowledge_wakeup(). So a consumer that
+ * acknowledges each wakeup, then takes all the work, sees one wakeup per batch of work rather than
+ * one per item.
+ *
+ * This is Dmitry Vyukov's intrusive MPSC queue: pushing is a single atomic exchange. The nodes holding
+ * the work come from a fixed pool, and the consumer returns each to a lock-free free list once it has
+ * taken the work, so a steady flow of work doesn't allocate (the std::function itself is moved in, not
+ * copied). Only when more work is queued than the pool holds are nodes allocated.
+ *
+ * Threadsafety: push() may be called from any thread; the other member functions only from the
+ * (single) consumer thread
+ */
+class LockFreeWorkQueue
+{
+public:
+    LockFreeWorkQueue();
+    ~LockFreeWorkQueue();
+
+    LockFreeWorkQueue(LockFreeWorkQueue const&) = delete;
+    LockFreeWorkQueue& operator=(LockFreeWorkQueue const&) = delete;
+
+    /// Add \a work, returning whether the consumer needs to be woken to take it (empty \a work is ignored)
+    auto push(std::function<void()>&& work) -> bool;
+
+    /// The consumer has been woken: work pushed after this needs a new wakeup
+    void acknowledge_wakeup();
+
+    /**
+     * Take the oldest work
+     *
+     * \return  The work, or an empty function if there is none (or the only work is still being pushed;
+     *          in which case its push() will request a wakeup)
+     */
+    auto pop() -> std::function<void()>;
+
+    /// Discard all the work that can be taken
+    void clear();
+
+private:
+    struct Node
+    {
+        std::atomic<Node*> next{nullptr};
+        std::function<void()> work;
+        /// The index of the next node in the free list, while this one is in it
+        std::atomic<uint32_t> next_free{0};
+    };
+
+    /// Take a node from the free list (or allocate one if it's empty)
+    auto take_node() -> Node*;
+    /// Return a node the consumer has taken the work from
+    void recycle(Node* node);
+
+    void push(Node* node);
+
+    static uint32_t constexpr pool_size{256};
+    std::unique_ptr<Node[]> const pool;
+
+    /**
+     * The top of the free list of pool nodes: the index of the node in the low 32 bits, and a count
+     * of changes in the high 32 bits, so a producer can't mistake a node that has been taken and
+     * returned while it was looking for one that never left (the ABA problem)
+     */
+    alignas(64) std::atomic<uint64_t> free_nodes;
+
+    /// The most recently pushed node (written by producers)
+    alignas(64) std::atomic<Node*> head;
+    std::atomic<bool> wakeup_requested{false};
+
+    /// The next node to take (only touched by the consumer)
+    alignas(64) Node* tail;
+    /// Placeholder that keeps the list non-empty, so producers never need to touch tail
+    Node stub;
+};
+}
+}
+
+#endif // MIR_FRONTEND_LOCK_FREE_WORK_QUEUE_H
@@ -0,0 +1,103 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pointer_motion_coalescer.h"
+
+#include <mir/events/pointer_event.h>
+
+#include <utility>
+
+namespace mf = mir::frontend;
+namespace mev = mir::events;
+
+auto mf::PointerMotionCoalescer::is_motion_only(MirPointerEvent const& event, MirPointerButtons current_buttons)
+    -> bool
+{
+    return event.action() == mir_pointer_action_motion &&
+           event.buttons() == current_buttons &&
+           event.h_scroll() == mev::ScrollAxisH{} &&
+           event.v_scroll() == mev::ScrollAxisV{};
+}
+
+auto mf::PointerMotionCoalescer::motion(std::shared_ptr<MirPointerEvent const> const& event)
+    -> std::optional<Motion>
+{
+    quiet_frame = false;
+    if (!moving)
+    {
+        moving = true;
+        return Motion{event, event->motion()};
+    }
+
+    hold(event);
+    return std::nullopt;
+}
+
+auto mf::PointerMotionCoalescer::frame() -> std::optional<Motion>
+{
+    if (auto motion = take())
+    {
+        return motion;
+    }
+
+    // A single frame without motion is common while the pointer is moving (the device and the client's frames
+    // don't line up), so only a second one means the pointer has stopped
+    if (quiet_frame)
+    {
+        moving = false;
+        quiet_frame = false;
+    }
+    else if (moving)
+    {
+        quiet_frame = true;
+    }
+    return std::nullopt;
+}
+
+auto mf::PointerMotionCoalescer::awaiting_frame() const -> bool
+{
+    return moving;
+}
+
+auto mf::PointerMotionCoalescer::take() -> std::optional<Motion>
+{
+    return std::exchange(held, std::nullopt);
+}
+
+void mf::PointerMotionCoalescer::clear()
+{
+    held = std::nullopt;
+    moving = false;
+    quiet_frame = false;
+}
+
+auto mf::PointerMotionCoalescer::holding() const -> bool
+{
+    return held.has_value();
+}
+
+void mf::PointerMotionCoalescer::hold(std::shared_ptr<MirPointerEvent const> const& event)
+{
+    if (held)
+    {
+        held->latest = event;
+        held->relative = held->relative + event->motion();
+    }
+    else
+    {
+        held = Motion{event, event->motion()};
+    }
+}
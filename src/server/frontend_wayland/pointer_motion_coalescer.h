@@ -0,0 +1,93 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_POINTER_MOTION_COALESCER_H
+#define MIR_FRONTEND_POINTER_MOTION_COALESCER_H
+
+#include <mir/geometry/displacement.h>
+
+#include <memory>
+#include <optional>
+
+struct MirPointerEvent;
+typedef unsigned int MirPointerButtons;
+
+namespace mir
+{
+namespace frontend
+{
+/**
+ * Merges consecutive pointer motion, so a client can be sent one motion per frame
+ *
+ * High rate pointing devices produce several motion events per display frame. Rather than send (and wake the
+ * client for) each, only the first motion after the pointer has been still goes straight out; motion that follows
+ * it is held until the next frame, then only the latest position is sent, along with the relative motion summed
+ * over the held events. The pointer is only still again once a whole frame has passed without motion, so motion
+ * that arrives just after a frame is still paced.
+ *
+ * Threadsafety: This should only be used from the Wayland thread
+ */
+class PointerMotionCoalescer
+{
+public:
+    struct Motion
+    {
+        std::shared_ptr<MirPointerEvent const> latest;  ///< The last event held: its position and time are current
+        geometry::DisplacementF relative;               ///< The relative motion of all the events held
+    };
+
+    /// Whether \a event only moves the pointer: it neither changes \a current_buttons nor scrolls
+    static auto is_motion_only(MirPointerEvent const& event, MirPointerButtons current_buttons) -> bool;
+
+    /**
+     * The pointer has moved (\a event should be motion only)
+     *
+     * \returns the motion to send now if the pointer was still, in which case frame() should be called at the
+     *          next frame. Otherwise the motion is held back, merged with any already held, until then.
+     */
+    auto motion(std::shared_ptr<MirPointerEvent const> const& event) -> std::optional<Motion>;
+
+    /**
+     * A frame has passed since motion was last sent
+     *
+     * \returns the motion held since then (if any) to send now. Whether or not there is any, frame() should be
+     *          called again at the next frame while awaiting_frame().
+     */
+    auto frame() -> std::optional<Motion>;
+
+    /// Whether the pointer is moving, so motion is being paced by frame()
+    auto awaiting_frame() const -> bool;
+
+    /// Take the motion held since the last frame (if any), to send it ahead of other events
+    auto take() -> std::optional<Motion>;
+
+    /// Drop any motion held, and treat the pointer as still (no frame() is expected)
+    void clear();
+
+    /// Whether any motion is held
+    auto holding() const -> bool;
+
+private:
+    void hold(std::shared_ptr<MirPointerEvent const> const& event);
+
+    std::optional<Motion> held;
+    bool moving{false};         ///< Motion has been sent recently enough that more is expected
+    bool quiet_frame{false};    ///< A frame has passed with nothing held; another and the pointer is still
+};
+}
+}
+
+#endif // MIR_FRONTEND_POINTER_MOTION_COALESCER_H
@@ -0,0 +1,157 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "presentation_time.h"
+#include "output_manager.h"
+#include "wl_surface.h"
+
+#include <mir/graphics/display_configuration.h>
+#include <mir/graphics/frame.h>
+
+#include <chrono>
+#include <optional>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mw = mir::wayland;
+namespace geom = mir::geometry;
+
+namespace
+{
+class PresentationInstance : public mw::Presentation
+{
+public:
+    PresentationInstance(wl_resource* resource, mf::OutputManager* output_manager)
+        : Presentation(resource, Version<1>{}),
+          output_manager{output_manager}
+    {
+        send_clock_id_event(mf::WpPresentation::clock_id);
+    }
+
+private:
+    void feedback(wl_resource* surface, wl_resource* callback) override
+    {
+        auto const feedback = new mf::PresentationFeedback(callback, output_manager);
+        mf::WlSurface::from(surface)->add_presentation_feedback(mw::make_weak(feedback));
+    }
+
+    mf::OutputManager* const output_manager;
+};
+
+/// The output the surface is mostly on: the one presentation is reported as synchronised to
+auto main_output_for(mf::OutputManager& output_manager, geom::Rectangle const& surface_extents)
+    -> std::optional<mg::DisplayConfigurationOutputId>
+{
+    std::optional<mg::DisplayConfigurationOutputId> main_output;
+    long largest_area{0};
+
+    output_manager.current_config().for_each_output(
+        [&](mg::DisplayConfigurationOutput const& output)
+        {
+            if (!output.used)
+                return;
+
+            auto const overlap = intersection_of(output.extents(), surface_extents).size;
+            long const area = static_cast<long>(overlap.width.as_int()) * overlap.height.as_int();
+            if (area > largest_area)
+            {
+                largest_area = area;
+                main_output = output.id;
+            }
+        });
+
+    return main_output;
+}
+
+/// Express \a ust in the presentation clock
+auto presentation_clock_ns(mg::Frame::Timestamp const& ust) -> std::chrono::nanoseconds
+{
+    if (ust.clock_id == mf::WpPresentation::clock_id)
+    {
+        return ust.nanoseconds;
+    }
+
+    // Some (older) drivers report flips in CLOCK_REALTIME; keep the age of the timestamp across the change of clock
+    auto const age = mg::Frame::Timestamp::now(ust.clock_id) - ust;
+    return mg::Frame::Timestamp::now(mf::WpPresentation::clock_id).nanoseconds - age;
+}
+}
+
+clockid_t const mf::WpPresentation::clock_id{CLOCK_MONOTONIC};
+
+mf::WpPresentation::WpPresentation(wl_display* display, OutputManager* output_manager)
+    : Global(display, Version<1>{}),
+      output_manager{output_manager}
+{
+}
+
+void mf::WpPresentation::bind(wl_resource* new_wp_presentation)
+{
+    new PresentationInstance(new_wp_presentation, output_manager);
+}
+
+mf::PresentationFeedback::PresentationFeedback(wl_resource* new_feedback, OutputManager* output_manager)
+    : wayland::PresentationFeedback(new_feedback, Version<1>{}),
+      output_manager{output_manager}
+{
+}
+
+void mf::PresentationFeedback::presented(
+    mg::FramePresentation const& presentation,
+    geom::Rectangle const& surface_extents)
+{
+    if (auto const output_id = main_output_for(*output_manager, surface_extents))
+    {
+        if (auto const global = output_manager->output_for(output_id.value()))
+        {
+            global.value()->for_each_output_bound_by(
+                client,
+                [this](OutputInstance* instance)
+                {
+                    send_sync_output_event(instance->resource);
+                });
+        }
+    }
+
+    auto const ns = presentation_clock_ns(presentation.frame.ust).count();
+    uint64_t const tv_sec = ns / 1'000'000'000;
+    uint32_t const tv_nsec = ns % 1'000'000'000;
+    auto const seq = static_cast<uint64_t>(presentation.frame.msc);
+
+    uint32_t flags{0};
+    if (presentation.vsync)
+        flags |= Kind::vsync;
+    if (presentation.hw_clock)
+        flags |= Kind::hw_clock;
+    if (presentation.hw_completion)
+        flags |= Kind::hw_completion;
+    if (presentation.zero_copy)
+        flags |= Kind::zero_copy;
+
+    send_presented_event(
+        tv_sec >> 32, tv_sec & 0xffffffff,
+        tv_nsec,
+        presentation.refresh.count(),
+        seq >> 32, seq & 0xffffffff,
+        flags);
+    destroy_and_delete();
+}
+
+void mf::PresentationFeedback::discarded()
+{
+    send_discarded_event();
+    destroy_and_delete();
+}
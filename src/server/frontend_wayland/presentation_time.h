@@ -0,0 +1,77 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_PRESENTATION_TIME_H
+#define MIR_FRONTEND_PRESENTATION_TIME_H
+
+#include "presentation-time_wrapper.h"
+
+#include <mir/geometry/rectangle.h>
+
+namespace mir
+{
+namespace graphics
+{
+struct FramePresentation;
+}
+namespace frontend
+{
+class OutputManager;
+
+class WpPresentation : public wayland::Presentation::Global
+{
+public:
+    WpPresentation(wl_display* display, OutputManager* output_manager);
+
+    /// The clock presentation timestamps are reported in
+    static clockid_t const clock_id;
+
+private:
+    void bind(wl_resource* new_wp_presentation) override;
+
+    OutputManager* const output_manager;
+};
+
+/**
+ * The wp_presentation_feedback for one content update of a wl_surface
+ *
+ * Delivers exactly one of presented() or discarded(), then destroys itself.
+ *
+ * Threadsafety: This is a Wayland object, and should only be accessed from the Wayland thread
+ */
+class PresentationFeedback : public wayland::PresentationFeedback
+{
+public:
+    PresentationFeedback(wl_resource* new_feedback, OutputManager* output_manager);
+
+    /**
+     * The content update has been presented
+     *
+     * \param presentation      How the frame containing the update reached the screen
+     * \param surface_extents   Where the surface is, to choose the output to report for sync_output
+     */
+    void presented(graphics::FramePresentation const& presentation, geometry::Rectangle const& surface_extents);
+
+    /// The content update was superseded, or its surface destroyed, before it was presented
+    void discarded();
+
+private:
+    OutputManager* const output_manager;
+};
+}
+}
+
+#endif // MIR_FRONTEND_PRESENTATION_TIME_H
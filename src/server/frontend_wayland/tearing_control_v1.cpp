@@ -0,0 +1,94 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tearing_control_v1.h"
+#include "wl_surface.h"
+
+#include <mir/wayland/protocol_error.h>
+
+#include <boost/throw_exception.hpp>
+
+namespace mf = mir::frontend;
+namespace mw = mir::wayland;
+
+namespace
+{
+class TearingControlManagerV1 : public mw::TearingControlManagerV1
+{
+public:
+    class Global : public mw::TearingControlManagerV1::Global
+    {
+    public:
+        explicit Global(wl_display* display)
+            : mw::TearingControlManagerV1::Global{display, Version<1>{}}
+        {
+        }
+
+    private:
+        void bind(wl_resource* new_wp_tearing_control_manager_v1) override
+        {
+            new TearingControlManagerV1{new_wp_tearing_control_manager_v1};
+        }
+    };
+
+    explicit TearingControlManagerV1(wl_resource* resource)
+        : mw::TearingControlManagerV1{resource, Version<1>{}}
+    {
+    }
+
+private:
+    void get_tearing_control(wl_resource* id, wl_resource* surface) override
+    {
+        auto const surf = mf::WlSurface::from(surface);
+        if (surf->get_tearing_control())
+        {
+            BOOST_THROW_EXCEPTION(mw::ProtocolError(
+                resource, Error::tearing_control_exists, "Surface already has a tearing control object"));
+        }
+
+        surf->set_tearing_control(new mf::TearingControlV1{id, surf});
+    }
+};
+}
+
+auto mf::create_tearing_control_manager_v1(wl_display* display)
+    -> std::shared_ptr<mw::TearingControlManagerV1::Global>
+{
+    return std::make_shared<TearingControlManagerV1::Global>(display);
+}
+
+mf::TearingControlV1::TearingControlV1(wl_resource* new_resource, WlSurface* surface)
+    : mw::TearingControlV1{new_resource, Version<1>{}},
+      surface{surface}
+{
+}
+
+mf::TearingControlV1::~TearingControlV1()
+{
+    // Destroying the object reverts the surface to vsync on its next commit
+    if (surface)
+    {
+        surface.value().set_pending_tearing_allowed(false);
+    }
+}
+
+void mf::TearingControlV1::set_presentation_hint(uint32_t hint)
+{
+    if (surface)
+    {
+        surface.value().set_pending_tearing_allowed(hint == PresentationHint::async);
+    }
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_TEARING_CONTROL_V1_H
+#define MIR_FRONTEND_TEARING_CONTROL_V1_H
+
+#include "tearing-control-v1_wrapper.h"
+
+#include <mir/wayland/weak.h>
+
+#include <memory>
+
+namespace mir
+{
+namespace frontend
+{
+class WlSurface;
+
+auto create_tearing_control_manager_v1(wl_display* display)
+    -> std::shared_ptr<wayland::TearingControlManagerV1::Global>;
+
+/**
+ * The wp_tearing_control_v1 of a wl_surface: whether the client accepts tearing to get its content on screen sooner
+ *
+ * Threadsafety: This is a Wayland object, and should only be accessed from the Wayland thread
+ */
+class TearingControlV1 : public wayland::TearingControlV1
+{
+public:
+    TearingControlV1(wl_resource* new_resource, WlSurface* surface);
+    ~TearingControlV1() override;
+
+private:
+    void set_presentation_hint(uint32_t hint) override;
+
+    wayland::Weak<WlSurface> const surface;
+};
+}
+}
+
+#endif // MIR_FRONTEND_TEARING_CONTROL_V1_H
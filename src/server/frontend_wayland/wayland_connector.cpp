@@ -23,6 +23,7 @@
 #include "wayland_utils.h"
 #include "wl_subcompositor.h"
 #include "wl_seat.h"
+#include "wl_surface.h"
 #include "wl_region.h"
 #include "shm.h"
 #include "frame_executor.h"
@@ -31,6 +32,7 @@
 #include "desktop_file_manager.h"
 #include "foreign_toplevel_manager_v1.h"
 #include "wp_viewporter.h"
+#include "presentation_time.h"
 #include "linux_drm_syncobj.h"
 #include "surface_registry.h"
 
@@ -185,7 +187,7 @@ std::shared_ptr<mg::GraphicBufferAllocator> allocator_for_display(
 {
     try
     {
-        buffer_allocator->bind_display(display, std::move(executor));
+        buffer_allocator->bind_display(display, std::move(executor), std::make_shared<mf::WlSurfaceScanoutHints>());
         return buffer_allocator;
     }
     catch (...)
@@ -245,6 +247,7 @@ mf::WaylandConnector::WaylandConnector(
     bool arw_socket,
     std::unique_ptr<WaylandExtensions> extensions_,
     WaylandProtocolExtensionFilter const& extension_filter,
+    PointerMotionCoalescingPolicy const& coalesce_pointer_motion,
     std::shared_ptr<shell::AccessibilityManager> const& accessibility_manager,
     std::shared_ptr<scene::SessionLock> const& session_lock,
     std::shared_ptr<mir::DecorationStrategy> const& decoration_strategy,
@@ -304,7 +307,8 @@ mf::WaylandConnector::WaylandConnector(
         keyboard_observer_registrar,
         seat,
         accessibility_manager,
-        surface_registry);
+        surface_registry,
+        coalesce_pointer_motion);
     output_manager = std::make_unique<mf::OutputManager>(
         display.get(),
         executor,
@@ -349,6 +353,8 @@ mf::WaylandConnector::WaylandConnector(
 
     viewporter = std::make_unique<WpViewporter>(display.get());
 
+    presentation = std::make_unique<WpPresentation>(display.get(), output_manager.get());
+
     {
         std::vector<std::shared_ptr<mg::DRMRenderingProvider>> providers;
         for (auto platform : render_platforms)
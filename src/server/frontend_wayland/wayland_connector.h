@@ -91,6 +91,7 @@ class WlShm;
 class WlSubcompositor;
 class WlSurface;
 class WpViewporter;
+class WpPresentation;
 class LinuxDRMSyncobjManager;
 class DesktopFileManager;
 class SurfaceRegistry;
@@ -150,6 +151,7 @@ class WaylandConnector : public Connector, public WaylandTools
 {
 public:
     using WaylandProtocolExtensionFilter = std::function<bool(std::shared_ptr<scene::Session> const&, char const*)>;
+    using PointerMotionCoalescingPolicy = std::function<bool(std::shared_ptr<scene::Session> const&)>;
 
     WaylandConnector(
         std::shared_ptr<shell::Shell> const& shell,
@@ -174,6 +176,7 @@ public:
         bool arw_socket,
         std::unique_ptr<WaylandExtensions> extensions,
         WaylandProtocolExtensionFilter const& extension_filter,
+        PointerMotionCoalescingPolicy const& coalesce_pointer_motion,
         std::shared_ptr<shell::AccessibilityManager> const& accessibility_manager,
         std::shared_ptr<scene::SessionLock> const& session_lock,
         std::shared_ptr<DecorationStrategy> const& decoration_strategy,
@@ -231,6 +234,7 @@ private:
     std::unique_ptr<WlDataDeviceManager> data_device_manager_global;
     std::unique_ptr<WlShm> shm_global;
     std::unique_ptr<WpViewporter> viewporter;
+    std::unique_ptr<WpPresentation> presentation;
     std::unique_ptr<LinuxDRMSyncobjManager> drm_syncobj;
     std::shared_ptr<Executor> const executor;
     std::shared_ptr<graphics::GraphicBufferAllocator> const allocator;
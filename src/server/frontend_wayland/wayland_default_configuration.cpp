@@ -18,6 +18,7 @@
 
 #include "fractional-scale-v1_wrapper.h"
 #include "fractional_scale_v1.h"
+#include "tearing_control_v1.h"
 #include <mir/default_server_configuration.h>
 
 #include <mir/frontend/wayland.h>
@@ -261,6 +262,10 @@ std::vector<ExtensionBuilder> const internal_extension_builders = {
         {
             return mf::create_fractional_scale_v1(ctx.display);
         }),
+    make_extension_builder<mw::TearingControlManagerV1>([](auto const& ctx)
+        {
+            return mf::create_tearing_control_manager_v1(ctx.display);
+        }),
     make_extension_builder<mw::XdgActivationV1>([](auto const& ctx)
         {
             return mf::create_xdg_activation_v1(
@@ -408,6 +413,7 @@ std::shared_ptr<mf::Connector>
             std::set<std::string> const wayland_extensions(std::ranges::begin(extension_keys), std::ranges::end(extension_keys));
 
             auto const x11_enabled = options->is_set(mo::x11_display_opt) && options->get<bool>(mo::x11_display_opt);
+            auto const coalesce_by_default = options->get<bool>(mo::coalesce_pointer_motion_opt);
 
             return std::make_shared<mf::WaylandConnector>(
                 the_shell(),
@@ -435,6 +441,10 @@ std::shared_ptr<mf::Connector>
                     x11_enabled,
                     wayland_extension_hooks),
                 wayland_extension_filter,
+                [policy = pointer_motion_coalescing_policy, coalesce_by_default](auto const& session)
+                {
+                    return policy ? policy(session) : coalesce_by_default;
+                },
                 the_accessibility_manager(),
                 the_session_lock(),
                 the_decoration_strategy(),
@@ -460,6 +470,12 @@ void mir::DefaultServerConfiguration::set_wayland_extension_policy(
     wayland_extension_policy_map[interface_name] = policy;
 }
 
+void mir::DefaultServerConfiguration::set_pointer_motion_coalescing_policy(
+    PointerMotionCoalescingPolicy const& policy)
+{
+    pointer_motion_coalescing_policy = policy;
+}
+
 auto mir::frontend::get_window(wl_resource* surface) -> std::shared_ptr<ms::Surface>
 {
     if (auto result = get_wl_shell_window(surface))
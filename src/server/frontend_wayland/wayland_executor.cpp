@@ -15,6 +15,7 @@
  */
 
 #include "wayland_executor.h"
+#include "lock_free_work_queue.h"
 
 #include <mir/fd.h>
 #include <mir/log.h>
@@ -25,7 +26,6 @@
 
 #include <atomic>
 #include <cstring>
-#include <deque>
 #include <functional>
 #include <mutex>
 #include <system_error>
@@ -65,24 +65,22 @@ public:
             });
     }
 
-    void enqueue(std::function<void()>&& work)
+    /// Returns whether the Wayland thread needs to be woken to process the work
+    auto enqueue(std::function<void()>&& work) -> bool
     {
         if (on_wayland_thread)
         {
             work();
-            return;
+            return false;
         }
 
         if (state == ExecutionState::Running)
         {
-            std::lock_guard lock{mutex};
-            if (state == ExecutionState::Running)
-            {
-                workqueue.emplace_back(std::move(work));
-            }
+            return workqueue.push(std::move(work));
         }
         // If we've been terminated then drop the work on the floor, letting the
         // std::function destructor clean up any necessary state.
+        return false;
     }
 
     void enqueue_termination(std::function<void()>&& terminator)
@@ -90,34 +88,22 @@ public:
         std::lock_guard lock{mutex};
         if (state == ExecutionState::Running)
         {
-            workqueue.emplace_front(std::move(terminator));
+            this->terminator = std::move(terminator);
             on_wayland_thread = false;
             state = ExecutionState::TerminationRequested;
         }
     }
 
-    std::function<void()> get_work()
-    {
-        std::lock_guard lock{mutex};
-        if (!workqueue.empty())
-        {
-            auto const work = std::move(workqueue.front());
-            workqueue.pop_front();
-            return work;
-        }
-        return {};
-    }
-
     auto drain()
     {
         std::unique_lock lock{mutex};
 
-        if (state == ExecutionState::TerminationRequested)
+        if (state == ExecutionState::TerminationRequested && terminator)
         {
-            // If we've been asked to terminate then the front of the workqueue
-            // will contain the termination request.
+            // If we've been asked to terminate then run the termination request.
             {
-                std::function<void()> const work = std::move(workqueue.front());
+                std::function<void()> const work = std::move(terminator);
+                terminator = nullptr;
                 lock.unlock();
 
                 work();
@@ -134,18 +120,27 @@ public:
 
     static int on_notify(int fd, uint32_t, void* data);
 private:
+    /// The termination request, if it hasn't yet been run (it's run before any other work)
+    auto take_terminator() -> std::function<void()>
+    {
+        std::lock_guard lock{mutex};
+        auto work = std::move(terminator);
+        terminator = nullptr;
+        return work;
+    }
+
     static thread_local bool on_wayland_thread;
+    /// Guards termination; enqueuing work doesn't need it
     std::mutex mutex;
     /*
-     * `state` is atomic because it is used in a double-checked locking pattern in `enqueue()`.
-     * The first check of `state` (outside the mutex) allows fast-path rejection of work when
-     * the executor is not running, avoiding unnecessary locking. The second check (inside the mutex)
-     * ensures correctness in the presence of concurrent state changes. This pattern requires `state`
-     * to be atomic to prevent data races and ensure thread safety.
+     * `state` is atomic because `enqueue()` checks it without taking the mutex. Work enqueued
+     * as the executor stops may still reach the workqueue; it is then destroyed with the State.
      */
     std::atomic<ExecutionState> state{ExecutionState::Running};
     wl_event_loop* const loop;
-    std::deque<std::function<void()>> workqueue;
+    /// Every compositor thread's buffer releases and frame callbacks come through here, so it doesn't lock
+    LockFreeWorkQueue workqueue;
+    std::function<void()> terminator;
 };
 
 thread_local bool mf::WaylandExecutor::State::on_wayland_thread{false};
@@ -242,20 +237,32 @@ int mf::WaylandExecutor::State::on_notify(int fd, uint32_t, void* data)
             err);
     }
 
-    while (auto work = state->get_work())
-    {
-        try
-        {
-            work();
-        }
-        catch (...)
+    // Work enqueued from here on needs another wakeup; everything before it is processed now
+    state->workqueue.acknowledge_wakeup();
+
+    auto const run = [](std::function<void()> const& work)
         {
-            mir::log(
-                mir::logging::Severity::critical,
-                MIR_LOG_COMPONENT,
-                std::current_exception(),
-                "Exception processing Wayland event loop work item");
-        }
+            try
+            {
+                work();
+            }
+            catch (...)
+            {
+                mir::log(
+                    mir::logging::Severity::critical,
+                    MIR_LOG_COMPONENT,
+                    std::current_exception(),
+                    "Exception processing Wayland event loop work item");
+            }
+        };
+
+    if (auto const terminator = state->take_terminator())
+    {
+        run(terminator);
+    }
+    while (auto const work = state->workqueue.pop())
+    {
+        run(work);
     }
     if (state->state != ExecutionState::Running)
     {
@@ -269,7 +276,7 @@ int mf::WaylandExecutor::State::on_notify(int fd, uint32_t, void* data)
 
 mf::WaylandExecutor::WaylandExecutor(wl_event_loop* loop)
     : state{std::make_shared<State>(loop)},
-      notify_fd{eventfd(0, EFD_CLOEXEC | EFD_SEMAPHORE | EFD_NONBLOCK)},
+      notify_fd{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)},
       source{wl_event_loop_add_fd(
           loop,
           notify_fd,
@@ -335,7 +342,11 @@ mf::WaylandExecutor::~WaylandExecutor()
 
 void mf::WaylandExecutor::spawn (std::function<void()>&& work)
 {
-    state->enqueue(std::move(work));
+    // Only the first work since the Wayland thread last woke needs to wake it
+    if (!state->enqueue(std::move(work)))
+    {
+        return;
+    }
 
     if (auto err = eventfd_write(notify_fd, 1))
     {
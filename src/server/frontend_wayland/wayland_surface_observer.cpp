@@ -162,6 +162,17 @@ void mir::frontend::WaylandSurfaceObserver::tiled_edges(scene::Surface const*, F
         });
 }
 
+void mf::WaylandSurfaceObserver::scanout_formats_set_to(
+    ms::Surface const*,
+    std::optional<graphics::ScanoutFormats> const& formats)
+{
+    run_on_wayland_thread_unless_window_destroyed(
+        [formats](Impl*, WindowWlSurfaceRole* window)
+        {
+            window->handle_scanout_formats(formats);
+        });
+}
+
 void mf::WaylandSurfaceObserver::run_on_wayland_thread_unless_window_destroyed(
     std::function<void(Impl* impl, WindowWlSurfaceRole* window)>&& work)
 {
@@ -59,6 +59,9 @@ public:
     void left_output(scene::Surface const*, graphics::DisplayConfigurationOutputId const& id) override;
     void rescale_output(scene::Surface const*, graphics::DisplayConfigurationOutputId const& id) override;
     void tiled_edges(scene::Surface const*, Flags<MirTiledEdge> edges) override;
+    void scanout_formats_set_to(
+        scene::Surface const*,
+        std::optional<graphics::ScanoutFormats> const& formats) override;
     ///@}
 
     /// Should only be called from the Wayland thread
@@ -620,6 +620,14 @@ void mf::WindowWlSurfaceRole::handle_scale_output(graphics::DisplayConfiguration
     }
 }
 
+void mf::WindowWlSurfaceRole::handle_scanout_formats(std::optional<graphics::ScanoutFormats> const& formats)
+{
+    if (surface)
+    {
+        surface.value().set_scanout_formats(formats);
+    }
+}
+
 void mf::WindowWlSurfaceRole::apply_client_size(mir::shell::SurfaceSpecification& mods)
 {
     if ((!committed_width_set_explicitly || !committed_height_set_explicitly) && surface)
@@ -27,6 +27,7 @@
 #include <mir/geometry/size.h>
 #include <mir/geometry/rectangle.h>
 #include <mir/graphics/display_configuration.h>
+#include <mir/graphics/scanout_formats.h>
 
 #include <mir_toolkit/common.h>
 
@@ -105,6 +106,7 @@ public:
     void handle_enter_output(graphics::DisplayConfigurationOutputId id);
     void handle_leave_output(graphics::DisplayConfigurationOutputId id) const;
     void handle_scale_output(graphics::DisplayConfigurationOutputId id);
+    void handle_scanout_formats(std::optional<graphics::ScanoutFormats> const& formats);
 
     /// Gets called after the surface has committed (so current_size() may return the committed buffer size) but before
     /// the Mir window is modified (so if a pending size is set or a spec is applied those changes will take effect)
@@ -96,7 +96,15 @@ void mf::WlKeyboard::send_repeat_info(int32_t rate, int32_t delay)
 
 void mf::WlKeyboard::send_keymap_xkb_v1(mir::Fd const& fd, size_t length)
 {
-    send_keymap_event(KeymapFormat::xkb_v1, fd, length);
+    // Only from version 7 must clients map the keymap MAP_PRIVATE, so only then can they share it
+    if (wl_resource_get_version(resource) >= 7)
+    {
+        send_keymap_event(KeymapFormat::xkb_v1, fd, length);
+    }
+    else
+    {
+        send_keymap_event(KeymapFormat::xkb_v1, private_copy_of_keymap(fd, length), length);
+    }
 }
 
 void mf::WlKeyboard::send_key(std::shared_ptr<MirKeyboardEvent const> const& event)
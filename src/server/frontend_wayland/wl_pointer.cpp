@@ -36,6 +36,9 @@
 
 #include <linux/input-event-codes.h>
 #include <boost/throw_exception.hpp>
+#include <wayland-server-core.h>
+#include <chrono>
+#include <stdexcept>
 #include <string.h> // memcpy
 
 namespace mf = mir::frontend;
@@ -96,6 +99,9 @@ static auto const button_mapping = {
     std::make_pair(mir_pointer_button_extra, BTN_EXTRA)
 };
 
+/// If the client hasn't been told it can draw within this, it has stopped drawing and motion stops waiting for it
+auto const motion_frame_timeout = std::chrono::milliseconds{50};
+
 auto timestamp_of(std::shared_ptr<MirPointerEvent const> const& event) -> uint32_t
 {
     return mir_input_event_get_wayland_timestamp(mir_pointer_event_input_event(event.get()));
@@ -161,14 +167,32 @@ auto mf::WlPointer::linux_button_to_mir_button(int linux_button) -> std::optiona
     return std::nullopt;
 }
 
-mf::WlPointer::WlPointer(wl_resource* new_resource)
+mf::WlPointer::WlPointer(wl_resource* new_resource, bool coalesce_motion)
     : Pointer(new_resource, Version<9>()),
       cursor{std::make_unique<NullCursor>()}
 {
+    if (coalesce_motion)
+    {
+        motion_coalescer.emplace();
+        frame_timer = wl_event_loop_add_timer(
+            wl_display_get_event_loop(wl_client_get_display(client->raw_client())),
+            [](void* data)
+            {
+                static_cast<WlPointer*>(data)->frame_timed_out();
+                return 0;
+            },
+            this);
+        if (!frame_timer)
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error{"Failed to create pointer motion frame timer"});
+        }
+    }
 }
 
 mf::WlPointer::~WlPointer()
 {
+    if (frame_timer)
+        wl_event_source_remove(frame_timer);
     if (surface_under_cursor)
         surface_under_cursor.value().remove_destroy_listener(destroy_listener_id);
 }
@@ -180,6 +204,36 @@ void mir::frontend::WlPointer::set_relative_pointer(mir::wayland::RelativePointe
 
 void mir::frontend::WlPointer::event(std::shared_ptr<MirPointerEvent const> const& event, WlSurface& root_surface)
 {
+    if (motion_coalescer)
+    {
+        if (can_hold_motion(*event, root_surface))
+        {
+            if (auto const motion = motion_coalescer->motion(event))
+            {
+                // The pointer was still, so the client hears of it moving straight away...
+                send_motion(*motion, root_surface);
+                if (root_surface.awaiting_frame())
+                {
+                    await_frame(root_surface);
+                }
+                else
+                {
+                    // ...and if the client isn't drawing there is no frame to wait for, so the rest does too
+                    motion_coalescer->clear();
+                }
+            }
+            else
+            {
+                // ...but motion that follows waits for the frame
+                held_motion_root = mw::make_weak(&root_surface);
+            }
+            return;
+        }
+
+        // Buttons, scrolling and changes of surface are sent straight away, but not ahead of earlier motion
+        send_held_motion();
+    }
+
     switch(mir_pointer_event_action(event.get()))
     {
         case mir_pointer_action_button_down:
@@ -196,7 +250,7 @@ void mir::frontend::WlPointer::event(std::shared_ptr<MirPointerEvent const> cons
             break;
         case mir_pointer_action_motion:
             enter_or_motion(event, root_surface);
-            relative_motion(event);
+            relative_motion(event, event->motion());
             axes(event);
             break;
         case mir_pointer_actions:
@@ -208,6 +262,14 @@ void mir::frontend::WlPointer::event(std::shared_ptr<MirPointerEvent const> cons
 
 void mf::WlPointer::leave(std::optional<std::shared_ptr<MirPointerEvent const>> const& event)
 {
+    if (motion_coalescer)
+    {
+        // Motion over a surface we're leaving is of no further interest, nor are its frames
+        motion_coalescer->clear();
+        held_motion_root = {};
+        stop_awaiting_frame();
+    }
+
     if (!surface_under_cursor)
         return;
     surface_under_cursor.value().remove_destroy_listener(destroy_listener_id);
@@ -307,20 +369,7 @@ void mf::WlPointer::enter_or_motion(std::shared_ptr<MirPointerEvent const> const
     }
 
     auto const root_position = event->local_position().value();
-
-    WlSurface* target_surface;
-    if (current_buttons != 0 && surface_under_cursor)
-    {
-        // If there are pressed buttons, we let the pointer move outside the current surface without leaving it
-        target_surface = &surface_under_cursor.value();
-    }
-    else
-    {
-        // Else choose whatever subsurface we are over top of
-        geom::Point root_point{root_position};
-        target_surface = root_surface.subsurface_at(root_point).value_or(&root_surface);
-    }
-
+    auto const target_surface = target_surface_for(root_position, root_surface);
     auto const position_on_target = root_position - geom::DisplacementF{target_surface->total_offset()};
 
     if (!surface_under_cursor || &surface_under_cursor.value() != target_surface)
@@ -363,26 +412,140 @@ void mf::WlPointer::enter_or_motion(std::shared_ptr<MirPointerEvent const> const
     }
 }
 
-void mf::WlPointer::relative_motion(std::shared_ptr<MirPointerEvent const> const& event)
+auto mf::WlPointer::target_surface_for(geom::PointF root_position, WlSurface& root_surface) -> WlSurface*
+{
+    if (current_buttons != 0 && surface_under_cursor)
+    {
+        // If there are pressed buttons, we let the pointer move outside the current surface without leaving it
+        return &surface_under_cursor.value();
+    }
+    else
+    {
+        // Else choose whatever subsurface we are over top of
+        geom::Point root_point{root_position};
+        return root_surface.subsurface_at(root_point).value_or(&root_surface);
+    }
+}
+
+void mf::WlPointer::relative_motion(
+    std::shared_ptr<MirPointerEvent const> const& event,
+    geom::DisplacementF motion)
 {
     if (!relative_pointer)
     {
         return;
     }
-    auto const motion = std::make_pair(
-        mir_pointer_event_axis_value(event.get(), mir_pointer_axis_relative_x),
-        mir_pointer_event_axis_value(event.get(), mir_pointer_axis_relative_y));
-    if (motion.first || motion.second)
+    if (motion.dx.as_value() || motion.dy.as_value())
     {
         auto const timestamp = timestamp_of(event);
         relative_pointer.value().send_relative_motion_event(
             timestamp, timestamp,
-            motion.first, motion.second,
-            motion.first, motion.second);
+            motion.dx.as_value(), motion.dy.as_value(),
+            motion.dx.as_value(), motion.dy.as_value());
         needs_frame = true;
     }
 }
 
+auto mf::WlPointer::can_hold_motion(MirPointerEvent const& event, WlSurface& root_surface) -> bool
+{
+    // Only motion within the surface already under the cursor can wait: entering a surface can't
+    if (!PointerMotionCoalescer::is_motion_only(event, current_buttons) ||
+        !event.local_position() ||
+        !surface_under_cursor)
+    {
+        return false;
+    }
+
+    if (motion_coalescer->holding() && (!held_motion_root || &held_motion_root.value() != &root_surface))
+    {
+        return false;
+    }
+
+    return target_surface_for(event.local_position().value(), root_surface) == &surface_under_cursor.value();
+}
+
+void mf::WlPointer::send_held_motion()
+{
+    if (auto const motion = motion_coalescer->take())
+    {
+        if (held_motion_root)
+        {
+            send_motion(*motion, held_motion_root.value());
+        }
+        held_motion_root = {};
+    }
+}
+
+void mf::WlPointer::send_motion(PointerMotionCoalescer::Motion const& motion, WlSurface& root_surface)
+{
+    enter_or_motion(motion.latest, root_surface);
+    relative_motion(motion.latest, motion.relative);
+    maybe_frame();
+}
+
+void mf::WlPointer::await_frame(WlSurface& root_surface)
+{
+    frame_root = mw::make_weak(&root_surface);
+    root_surface.call_before_next_frame(
+        [weak_self = mw::make_weak(this), request = ++frame_request]()
+        {
+            // Ignore frames we've stopped waiting for (the pointer left, or we gave up on the client)
+            if (weak_self && weak_self.value().frame_request == request)
+            {
+                weak_self.value().frame_started();
+            }
+        });
+    wl_event_source_timer_update(frame_timer, motion_frame_timeout.count());
+}
+
+void mf::WlPointer::stop_awaiting_frame()
+{
+    ++frame_request;
+    frame_root = {};
+    wl_event_source_timer_update(frame_timer, 0);
+}
+
+void mf::WlPointer::frame_started()
+{
+    auto const root = frame_root;
+    send_motion_for_frame();
+
+    if (motion_coalescer->awaiting_frame() && root)
+    {
+        // The client has been told it can draw, and will commit its next frame callback along with what it draws
+        await_frame(root.value());
+    }
+    else
+    {
+        motion_coalescer->clear();
+    }
+}
+
+void mf::WlPointer::frame_timed_out()
+{
+    // The client has stopped drawing (or isn't being shown), so it has no frames to pace motion by
+    send_motion_for_frame();
+    motion_coalescer->clear();
+}
+
+void mf::WlPointer::send_motion_for_frame()
+{
+    stop_awaiting_frame();
+
+    auto const motion = motion_coalescer->frame();
+    auto const root = std::exchange(held_motion_root, {});
+
+    if (motion && root)
+    {
+        send_motion(*motion, root.value());
+    }
+    else if (motion)
+    {
+        // The surface has gone, and the motion with it
+        motion_coalescer->clear();
+    }
+}
+
 void mf::WlPointer::maybe_frame()
 {
     if (needs_frame)
@@ -19,17 +19,20 @@
 
 
 #include "wayland_wrapper.h"
+#include "pointer_motion_coalescer.h"
 #include <mir/wayland/weak.h>
 #include <mir/geometry/point.h>
 #include <mir/geometry/displacement.h>
 #include <mir/events/scroll_axis.h>
 
 #include <chrono>
+#include <cstdint>
 #include <functional>
 #include <optional>
 #include <set>
 
 struct MirInputEvent;
+struct wl_event_source;
 typedef unsigned int MirPointerButtons;
 
 struct MirPointerEvent;
@@ -65,7 +68,8 @@ class WlPointer : public wayland::Pointer, private CommitHandler
 public:
     static auto linux_button_to_mir_button(int linux_button) -> std::optional<MirPointerButtons>;
 
-    WlPointer(wl_resource* new_resource);
+    /// \param coalesce_motion Whether to send the client (at most) one motion event per frame of the surface it is over
+    WlPointer(wl_resource* new_resource, bool coalesce_motion);
 
     ~WlPointer();
 
@@ -90,7 +94,26 @@ private:
     /// Giving it an already transformed surface and position is also fine
     void enter_or_motion(std::shared_ptr<MirPointerEvent const> const& event, WlSurface& root_surface);
     /// Sends relative motion only if the relative pointer is set
-    void relative_motion(std::shared_ptr<MirPointerEvent const> const& event);
+    void relative_motion(std::shared_ptr<MirPointerEvent const> const& event, geometry::DisplacementF motion);
+    /// The surface (root_surface or one of its subsurfaces) the event should be sent to
+    auto target_surface_for(geometry::PointF root_position, WlSurface& root_surface) -> WlSurface*;
+    /// Whether the event can be held back and merged with later motion, rather than sent now
+    auto can_hold_motion(MirPointerEvent const& event, WlSurface& root_surface) -> bool;
+    /// Sends any motion held back by the coalescer, followed by a frame event
+    void send_held_motion();
+    /// Sends the (possibly merged) motion, followed by a frame event
+    void send_motion(PointerMotionCoalescer::Motion const& motion, WlSurface& root_surface);
+    /// Has frame_started() called when the client is next told it can draw root_surface, or frame_timed_out() if
+    /// that doesn't happen soon
+    void await_frame(WlSurface& root_surface);
+    /// Neither frame_started() nor frame_timed_out() is called for the frame being waited for (if any)
+    void stop_awaiting_frame();
+    /// The client is about to draw the surface motion was sent to: send the motion held since
+    void frame_started();
+    /// The client hasn't drawn for a while: send the motion held, and stop pacing motion until it draws again
+    void frame_timed_out();
+    /// Sends the motion held since the last frame (if any)
+    void send_motion_for_frame();
     /// Sends a frame event only if needed, leaves needs_frame false
     void maybe_frame();
     /// The cursor surface has committed
@@ -114,6 +137,13 @@ private:
     std::unique_ptr<Cursor> cursor;
     wayland::Weak<wayland::RelativePointerV1> relative_pointer;
     geometry::Displacement cursor_hotspot;
+
+    /// Only set if motion is coalesced, in which case the frames of the surface under the cursor pace motion
+    std::optional<PointerMotionCoalescer> motion_coalescer;
+    wayland::Weak<WlSurface> held_motion_root; ///< The root surface the held motion was sent to
+    wayland::Weak<WlSurface> frame_root;        ///< The root surface whose frames are being waited for
+    uint64_t frame_request{0};                  ///< Identifies the latest await_frame(), so earlier ones are ignored
+    wl_event_source* frame_timer{nullptr};      ///< Calls frame_timed_out() if the client doesn't draw
 };
 
 }
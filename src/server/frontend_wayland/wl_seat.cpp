@@ -199,7 +199,8 @@ mf::WlSeat::WlSeat(
     std::shared_ptr<ObserverRegistrar<input::KeyboardObserver>> const& keyboard_observer_registrar,
     std::shared_ptr<mi::Seat> const& seat,
     std::shared_ptr<shell::AccessibilityManager> const& accessibility_manager,
-    std::shared_ptr<mf::SurfaceRegistry> const& surface_registry)
+    std::shared_ptr<mf::SurfaceRegistry> const& surface_registry,
+    std::function<bool(std::shared_ptr<scene::Session> const&)> const& coalesce_pointer_motion)
     :   Global(display, Version<9>()),
         keymap{std::make_shared<input::ParameterKeymap>()},
         config_observer{
@@ -218,7 +219,8 @@ mf::WlSeat::WlSeat(
         clock{clock},
         input_hub{input_hub},
         seat{seat},
-        accessibility_manager{accessibility_manager}
+        accessibility_manager{accessibility_manager},
+        coalesce_pointer_motion{coalesce_pointer_motion}
 {
     input_hub->add_observer(config_observer);
     keyboard_observer_registrar->register_interest(keyboard_observer, wayland_executor);
@@ -325,7 +327,7 @@ mf::WlSeat::Instance::Instance(wl_resource* new_resource, mf::WlSeat* seat)
 
 void mf::WlSeat::Instance::get_pointer(wl_resource* new_pointer)
 {
-    auto const pointer = new WlPointer{new_pointer};
+    auto const pointer = new WlPointer{new_pointer, seat->coalesce_pointer_motion(client->client_session())};
     auto dispatcher = std::make_shared<PointerEventDispatcher>(pointer);
 
     seat->pointer_listeners->register_listener(client, dispatcher.get());
@@ -36,6 +36,10 @@ class Seat;
 class Keymap;
 class KeyboardObserver;
 }
+namespace scene
+{
+class Session;
+}
 namespace shell
 {
 class AccessibilityManager;
@@ -80,7 +84,8 @@ public:
         std::shared_ptr<ObserverRegistrar<input::KeyboardObserver>> const& keyboard_observer_registrar,
         std::shared_ptr<mir::input::Seat> const& seat,
         std::shared_ptr<shell::AccessibilityManager> const& accessibility_manager,
-        std::shared_ptr<SurfaceRegistry> const& surface_registry);
+        std::shared_ptr<SurfaceRegistry> const& surface_registry,
+        std::function<bool(std::shared_ptr<scene::Session> const&)> const& coalesce_pointer_motion);
 
     ~WlSeat();
 
@@ -140,6 +145,9 @@ private:
 
     std::shared_ptr<shell::AccessibilityManager> const accessibility_manager;
 
+    /// Whether a client's pointers send (at most) one motion event per frame
+    std::function<bool(std::shared_ptr<scene::Session> const&)> const coalesce_pointer_motion;
+
     void bind(wl_resource* new_wl_seat) override;
 };
 }
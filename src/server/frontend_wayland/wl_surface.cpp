@@ -27,6 +27,7 @@
 #include "shm.h"
 #include "resource_lifetime_tracker.h"
 #include "linux_drm_syncobj.h"
+#include "presentation_time.h"
 
 #include "wayland_wrapper.h"
 
@@ -35,6 +36,7 @@
 #include <mir/wayland/protocol_error.h>
 #include <mir/wayland/client.h>
 #include <mir/graphics/buffer_properties.h>
+#include <mir/graphics/frame.h>
 #include <mir/scene/session.h>
 #include <mir/frontend/wayland.h>
 #include <mir/compositor/buffer_stream.h>
@@ -50,8 +52,10 @@
 #include <boost/throw_exception.hpp>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <limits>
 #include <optional>
+#include <utility>
 #include <wayland-server-core.h>
 #include <wayland-server-protocol.h>
 
@@ -60,6 +64,30 @@ namespace geom = mir::geometry;
 namespace mw = mir::wayland;
 namespace msh = mir::shell;
 
+namespace
+{
+/// Clients commonly send INT32_MAX sized damage to mean "everything", so clamp the extents to avoid overflow
+auto damage_rect(int32_t x, int32_t y, int32_t width, int32_t height) -> std::optional<geom::Rectangle>
+{
+    if (width <= 0 || height <= 0)
+        return std::nullopt;
+
+    int64_t const max = std::numeric_limits<int32_t>::max();
+    auto const right = std::min(int64_t{x} + width, max);
+    auto const bottom = std::min(int64_t{y} + height, max);
+    return geom::Rectangle{{x, y}, {static_cast<int>(right - x), static_cast<int>(bottom - y)}};
+}
+
+void add_damage(std::optional<geom::Rectangles>& damage, std::optional<geom::Rectangle> const& rect)
+{
+    if (!rect)
+        return;
+    if (!damage)
+        damage.emplace();
+    damage->add(*rect);
+}
+}
+
 struct mf::WlSurface::PendingBufferState
 {
     WlSurface* surf;
@@ -86,6 +114,9 @@ void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
     if (source.mirror_mode)
         mirror_mode = source.mirror_mode;
 
+    if (source.tearing_allowed)
+        tearing_allowed = source.tearing_allowed;
+
     if (source.offset)
         offset = source.offset;
 
@@ -96,9 +127,37 @@ void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
                            begin(source.frame_callbacks),
                            end(source.frame_callbacks));
 
+    if (source.buffer)
+    {
+        // The content update these were for has been replaced before it could be shown
+        for (auto const& feedback : presentation_feedbacks)
+        {
+            if (feedback)
+            {
+                feedback.value().discarded();
+            }
+        }
+        presentation_feedbacks.clear();
+    }
+    presentation_feedbacks.insert(end(presentation_feedbacks),
+                                  begin(source.presentation_feedbacks),
+                                  end(source.presentation_feedbacks));
+
     if (source.viewport)
         viewport = source.viewport;
 
+    for (auto const& [damage, source_damage] :
+        {std::pair{&surface_damage, &source.surface_damage}, std::pair{&buffer_damage, &source.buffer_damage}})
+    {
+        if (*source_damage)
+        {
+            if (!*damage)
+                damage->emplace();
+            for (auto const& rect : source_damage->value())
+                damage->value().add(rect);
+        }
+    }
+
     if (source.surface_data_invalidated)
         surface_data_invalidated = true;
 
@@ -127,6 +186,19 @@ mf::WlSurface::WlSurface(
         null_role{this},
         role{&null_role}
 {
+    stream->set_frame_presented_callback(
+        [executor = wayland_executor, weak_self = mw::make_weak(this)](graphics::FramePresentation const& presentation)
+        {
+            executor->spawn([weak_self, presentation]()
+                {
+                    if (weak_self)
+                    {
+                        auto& self = weak_self.value();
+                        self.send_frame_callbacks(self.presentation_callbacks);
+                        self.send_presented(self.consumed_feedbacks, presentation);
+                    }
+                });
+        });
 }
 
 mf::WlSurface::~WlSurface()
@@ -139,6 +211,13 @@ mf::WlSurface::~WlSurface()
         // Destroy the buffer stream first, as surface_destroyed() may throw
         session->destroy_buffer_stream(stream);
         role->surface_destroyed();
+
+        if (!client->is_being_destroyed())
+        {
+            send_discarded(pending.presentation_feedbacks);
+            send_discarded(committed_feedbacks);
+            send_discarded(consumed_feedbacks);
+        }
     }
     catch (...)
     {
@@ -217,6 +296,7 @@ void mf::WlSurface::add_subsurface(WlSubsurface* child)
     }
 
     children.push_back(child);
+    child->get_surface()->set_scanout_formats(scanout_formats);
 }
 
 void mf::WlSurface::remove_subsurface(WlSubsurface* child)
@@ -355,7 +435,21 @@ mf::WlSurface* mf::WlSurface::from(wl_resource* resource)
 
 void mf::WlSurface::send_frame_callbacks(CallbackList& list)
 {
-    for (auto const& frame : list)
+    if (list.empty())
+    {
+        return;
+    }
+
+    // The client is no longer waiting on these, whatever the actions do
+    auto const frames = std::exchange(list, {});
+
+    // Whatever the actions send reaches the client before it starts on its next frame
+    for (auto const& action : std::exchange(next_frame_actions, {}))
+    {
+        action();
+    }
+
+    for (auto const& frame : frames)
     {
         if (frame)
         {
@@ -365,9 +459,138 @@ void mf::WlSurface::send_frame_callbacks(CallbackList& list)
             frame.value().destroy_and_delete();
         }
     }
+}
+
+void mf::WlSurface::call_before_next_frame(std::function<void()>&& action)
+{
+    next_frame_actions.push_back(std::move(action));
+}
+
+auto mf::WlSurface::awaiting_frame() const -> bool
+{
+    return !frame_callbacks.empty() || !presentation_callbacks.empty() || !heartbeat_quirk_frame_callbacks.empty();
+}
+
+void mf::WlSurface::send_presented(FeedbackList& list, graphics::FramePresentation const& presentation)
+{
+    if (list.empty())
+    {
+        return;
+    }
+
+    geom::Rectangle extents;
+    if (auto const surface = scene_surface(); surface && surface.value())
+    {
+        extents = {surface.value()->top_left() + total_offset(), surface.value()->window_size()};
+    }
+
+    for (auto const& feedback : list)
+    {
+        if (feedback)
+        {
+            feedback.value().presented(presentation, extents);
+        }
+    }
+    list.clear();
+}
+
+void mf::WlSurface::send_discarded(FeedbackList& list)
+{
+    for (auto const& feedback : list)
+    {
+        if (feedback)
+        {
+            feedback.value().discarded();
+        }
+    }
     list.clear();
 }
 
+void mf::WlSurface::add_presentation_feedback(wayland::Weak<PresentationFeedback> feedback)
+{
+    pending.presentation_feedbacks.push_back(std::move(feedback));
+}
+
+void mf::WlSurface::set_scanout_formats(std::optional<graphics::ScanoutFormats> const& formats)
+{
+    if (formats == scanout_formats)
+    {
+        return;
+    }
+    scanout_formats = formats;
+
+    // Subsurfaces are composited (or not) along with their parent
+    for (auto const& child : children)
+    {
+        child->get_surface()->set_scanout_formats(formats);
+    }
+
+    std::erase_if(scanout_listeners, [](auto const& listener) { return listener.expired(); });
+    for (auto const& weak_listener : scanout_listeners)
+    {
+        if (auto const listener = weak_listener.lock())
+        {
+            (*listener)(scanout_formats);
+        }
+    }
+}
+
+void mf::WlSurface::add_scanout_listener(std::weak_ptr<graphics::SurfaceScanoutHints::Listener> const& listener)
+{
+    if (auto const live = listener.lock())
+    {
+        scanout_listeners.push_back(listener);
+        (*live)(scanout_formats);
+    }
+}
+
+void mf::WlSurface::frame_consumed()
+{
+    consumed_feedbacks.insert(end(consumed_feedbacks), begin(committed_feedbacks), end(committed_feedbacks));
+    committed_feedbacks.clear();
+
+    if (frame_callbacks.empty() && consumed_feedbacks.empty())
+    {
+        return;
+    }
+
+    bool const new_frame_callbacks = !frame_callbacks.empty();
+    presentation_callbacks.insert(end(presentation_callbacks), begin(frame_callbacks), end(frame_callbacks));
+    frame_callbacks.clear();
+
+    /* A surface that is on an output will be told when the frame it is in has been presented,
+     * so clients are paced by the refresh rate of the output(s) they are actually on. A surface
+     * that isn't on screen won't get that, so fall back to the frame executor's timer.
+     */
+    auto const surface = scene_surface();
+    bool const on_screen =
+        surface && surface.value() &&
+        surface.value()->query(mir_window_attrib_visibility) == mir_window_visibility_exposed;
+
+    if (!on_screen)
+    {
+        // ...and its content was never seen
+        send_discarded(consumed_feedbacks);
+    }
+
+    if (!on_screen && new_frame_callbacks)
+    {
+        frame_callback_executor->spawn(
+            [executor = wayland_executor, weak_self = mw::make_weak(this)]
+            {
+                executor->spawn(
+                    [weak_self]()
+                    {
+                        if (weak_self)
+                        {
+                            auto& self = weak_self.value();
+                            self.send_frame_callbacks(self.presentation_callbacks);
+                        }
+                    });
+            });
+    }
+}
+
 void mf::WlSurface::attach(std::optional<wl_resource*> const& buffer, int32_t x, int32_t y)
 {
     if (x != 0 || y != 0)
@@ -380,20 +603,109 @@ void mf::WlSurface::attach(std::optional<wl_resource*> const& buffer, int32_t x,
 
 void mf::WlSurface::damage(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    add_damage(pending.surface_damage, damage_rect(x, y, width, height));
 }
 
 void mf::WlSurface::damage_buffer(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    add_damage(pending.buffer_damage, damage_rect(x, y, width, height));
+}
+
+auto mf::WlSurface::damage_for_submission(
+    WlSurfaceState const& state,
+    geom::Size logical_size,
+    bool content_remapped) const -> geom::Rectangles
+{
+    geom::Rectangle const surface_rect{{}, logical_size};
+
+    bool const whole_surface =
+        content_remapped ||
+        std::make_optional(logical_size) != buffer_size_ ||
+        (state.buffer_damage && (viewport || buffer_transformed));
+
+    geom::Rectangles damage;
+    if (!whole_surface)
+    {
+        if (state.surface_damage)
+        {
+            for (auto const& rect : *state.surface_damage)
+            {
+                if (auto const clipped = intersection_of(rect, surface_rect); clipped.size != geom::Size{})
+                    damage.add(clipped);
+            }
+        }
+
+        if (state.buffer_damage)
+        {
+            for (auto const& rect : *state.buffer_damage)
+            {
+                // Round outwards so that partially covered logical pixels are included
+                auto const left = static_cast<int>(std::floor(rect.left().as_int() / scale));
+                auto const top = static_cast<int>(std::floor(rect.top().as_int() / scale));
+                auto const right = static_cast<int>(std::ceil(rect.right().as_int() / scale));
+                auto const bottom = static_cast<int>(std::ceil(rect.bottom().as_int() / scale));
+                geom::Rectangle const logical{{left, top}, {right - left, bottom - top}};
+                if (auto const clipped = intersection_of(logical, surface_rect); clipped.size != geom::Size{})
+                    damage.add(clipped);
+            }
+        }
+    }
+
+    /* Frame callbacks are only sent once the compositor has consumed the buffer, so a new buffer with
+     * no damage (or from a client that never sends damage) must still be composited.
+     */
+    if (damage.size() == 0)
+    {
+        damage.add(surface_rect);
+    }
+
+    return damage;
+}
+
+auto mf::WlSurface::damage_for_upload(WlSurfaceState const& state) const -> std::optional<geom::Rectangles>
+{
+    if (!state.surface_damage && !state.buffer_damage)
+    {
+        // Clients that don't report damage can't be trusted to not have changed anything
+        return std::nullopt;
+    }
+
+    geom::Rectangles damage;
+    if (state.surface_damage)
+    {
+        if (viewport || buffer_transformed)
+        {
+            // We don't map surface damage back through the viewport or buffer transform
+            return std::nullopt;
+        }
+
+        // Round outwards so that partially covered buffer pixels are included, and keep within the buffer's quadrant
+        double const max = std::numeric_limits<int32_t>::max();
+        auto const lower = [&](int coord) { return static_cast<int>(std::clamp(std::floor(coord * scale), 0.0, max)); };
+        auto const upper = [&](int coord) { return static_cast<int>(std::clamp(std::ceil(coord * scale), 0.0, max)); };
+
+        for (auto const& rect : *state.surface_damage)
+        {
+            auto const left = lower(rect.left().as_int());
+            auto const top = lower(rect.top().as_int());
+            auto const right = upper(rect.right().as_int());
+            auto const bottom = upper(rect.bottom().as_int());
+            if (right > left && bottom > top)
+            {
+                damage.add(geom::Rectangle{{left, top}, {right - left, bottom - top}});
+            }
+        }
+    }
+
+    if (state.buffer_damage)
+    {
+        for (auto const& rect : *state.buffer_damage)
+        {
+            damage.add(rect);
+        }
+    }
+
+    return damage;
 }
 
 void mf::WlSurface::frame(wl_resource* new_callback)
@@ -439,12 +751,24 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     if (state.scale)
         scale = state.scale.value();
 
+    if (state.orientation || state.mirror_mode)
+    {
+        buffer_transformed =
+            state.orientation.value_or(mir_orientation_normal) != mir_orientation_normal ||
+            state.mirror_mode.value_or(mir_mirror_mode_none) != mir_mirror_mode_none;
+    }
+
     if (state.viewport)
     {
         viewport = std::move(state.viewport);
     }
 
-    bool needs_buffer_submission =
+    if (state.tearing_allowed)
+    {
+        stream->set_tearing_allowed(state.tearing_allowed.value());
+    }
+
+    bool const content_remapped =
         state.scale ||                                               // If the scale has changed, or...
         state.viewport ||                                            // ...we've added a viewport, or...
         state.orientation ||                                         // ...we've changed orientation, or...
@@ -452,6 +776,7 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
         (viewport && viewport.value().changed_since_last_resolve()); // ...the viewport has changed...
                                                                      // ...then we'll need to submit a new frame, even if the client hasn't
                                                                      // attached a new buffer.
+    bool needs_buffer_submission = content_remapped;
 
     if (role)
     {
@@ -473,13 +798,20 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
         // callbacks should be sent at once.
         frame_callbacks.insert(end(frame_callbacks), begin(state.frame_callbacks), end(state.frame_callbacks));
 
+        // Any content update the compositor hasn't picked up yet is superseded by this one
+        send_discarded(committed_feedbacks);
+        committed_feedbacks = state.presentation_feedbacks;
+
         mw::Weak<ResourceLifetimeTracker> const& weak_buffer = state.buffer.value();
 
         if (!weak_buffer)
         {
             // TODO: unmap surface, and unmap all subsurfaces
             buffer_size_ = std::nullopt;
+            send_frame_callbacks(presentation_callbacks);
             send_frame_callbacks(frame_callbacks);
+            send_discarded(committed_feedbacks);
+            send_discarded(consumed_feedbacks);
         }
         else
         {
@@ -506,23 +838,25 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                 };
             }
 
-            auto executor_send_frame_callbacks = [executor = wayland_executor, weak_self = mw::make_weak(this)]()
+            auto executor_frame_consumed = [executor = wayland_executor, weak_self = mw::make_weak(this)]()
                 {
                     executor->spawn([weak_self]()
                         {
                             if (weak_self)
                             {
-                                auto& self = weak_self.value();
-                                self.send_frame_callbacks(self.frame_callbacks);
+                                weak_self.value().frame_consumed();
                             }
                         });
                 };
 
             if (auto const shm_buffer = ShmBuffer::from(weak_buffer.value()))
             {
-                current_buffer = allocator->buffer_from_shm(
+                // Passing the buffer being replaced allows its texture to be reused, uploading only the damage
+                current_buffer = allocator->buffer_from_shm_update(
                     shm_buffer->data(),
-                    std::move(executor_send_frame_callbacks),
+                    current_buffer,
+                    damage_for_upload(state),
+                    std::move(executor_frame_consumed),
                     std::move(release_buffer));
                 tracepoint(
                     mir_server_wayland,
@@ -534,7 +868,7 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             {
                 current_buffer = allocator->buffer_from_resource(
                     weak_buffer.value(),
-                    std::move(executor_send_frame_callbacks),
+                    std::move(executor_frame_consumed),
                     std::move(release_buffer));
                 tracepoint(
                     mir_server_wayland,
@@ -556,6 +890,10 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             "Timeline release sync point set, but no buffer committed"};
         }
 
+        // Without a new buffer there's no frame to report the presentation of
+        FeedbackList no_new_content{state.presentation_feedbacks};
+        send_discarded(no_new_content);
+
         /*
          * Frame request committed with no associated buffer.
          * The Wayland protocol says that
@@ -620,7 +958,7 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             logical_size = current_buffer->size() / scale;
         }
 
-        stream->submit_buffer(current_buffer, logical_size, src_sample);
+        stream->submit_buffer(current_buffer, logical_size, src_sample, damage_for_submission(state, logical_size, content_remapped));
 
         if (std::make_optional(logical_size) != buffer_size_)
         {
@@ -863,6 +1201,26 @@ auto mf::WlSurface::get_fractional_scale() const -> wayland::Weak<FractionalScal
     return fractional_scale;
 }
 
+void mf::WlSurface::set_tearing_control(TearingControlV1* tearing_control)
+{
+    this->tearing_control = wayland::Weak{tearing_control};
+}
+
+auto mf::WlSurface::get_tearing_control() const -> wayland::Weak<TearingControlV1>
+{
+    return tearing_control;
+}
+
+void mf::WlSurface::set_pending_tearing_allowed(bool allowed)
+{
+    pending.tearing_allowed = allowed;
+}
+
 void mf::NullWlSurfaceRole::refresh_surface_data_now() {}
 void mf::NullWlSurfaceRole::commit(WlSurfaceState const& state) { surface->commit(state); }
 void mf::NullWlSurfaceRole::surface_destroyed() {}
+
+void mf::WlSurfaceScanoutHints::register_listener(wl_resource* surface, std::weak_ptr<Listener> const& listener)
+{
+    WlSurface::from(surface)->add_scanout_listener(listener);
+}
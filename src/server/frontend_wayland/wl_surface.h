@@ -18,6 +18,7 @@
 #define MIR_FRONTEND_WL_SURFACE_H
 
 #include "fractional_scale_v1.h"
+#include "tearing_control_v1.h"
 #include <mir/geometry/forward.h>
 #include "wayland_wrapper.h"
 #include <mir/wayland/weak.h>
@@ -30,6 +31,7 @@
 #include <mir/geometry/rectangle.h>
 #include <mir/geometry/rectangles.h>
 #include <mir/shell/surface_specification.h>
+#include <mir/graphics/scanout_formats.h>
 #include "linux_drm_syncobj.h"
 
 #include <atomic>
@@ -45,6 +47,7 @@ namespace graphics
 {
 class GraphicBufferAllocator;
 class Buffer;
+struct FramePresentation;
 }
 namespace scene
 {
@@ -65,6 +68,7 @@ class WlSubsurface;
 class ResourceLifetimeTracker;
 class Viewport;
 class SyncTimeline;
+class PresentationFeedback;
 
 struct WlSurfaceState
 {
@@ -93,8 +97,15 @@ struct WlSurfaceState
     std::optional<geometry::Rectangles> opaque_region;
     std::optional<MirOrientation> orientation;
     std::optional<MirMirrorMode> mirror_mode;
+    /// Whether the client accepts tearing (wp_tearing_control_v1), if it has changed
+    std::optional<bool> tearing_allowed;
     std::vector<wayland::Weak<Callback>> frame_callbacks;
+    std::vector<wayland::Weak<PresentationFeedback>> presentation_feedbacks;
     wayland::Weak<Viewport> viewport;
+    /// Damage in surface-local (logical) coordinates, as set by wl_surface.damage
+    std::optional<geometry::Rectangles> surface_damage;
+    /// Damage in buffer coordinates, as set by wl_surface.damage_buffer
+    std::optional<geometry::Rectangles> buffer_damage;
 
     std::optional<SyncPoint> release_fence;
 
@@ -119,6 +130,13 @@ private:
     WlSurface* const surface;
 };
 
+/// Tells linux-dmabuf the scanout formats of WlSurfaces
+class WlSurfaceScanoutHints : public graphics::SurfaceScanoutHints
+{
+public:
+    void register_listener(wl_resource* surface, std::weak_ptr<Listener> const& listener) override;
+};
+
 class WlSurface : public wayland::Surface
 {
 public:
@@ -163,6 +181,11 @@ public:
     void set_fractional_scale(FractionalScaleV1* fractional_scale);
     auto get_fractional_scale() const -> wayland::Weak<FractionalScaleV1>;
 
+    void set_tearing_control(TearingControlV1* tearing_control);
+    auto get_tearing_control() const -> wayland::Weak<TearingControlV1>;
+    /// Set whether the content of the next commit may be presented with tearing
+    void set_pending_tearing_allowed(bool allowed);
+
     /**
      * Associate a viewport (buffer scale & crop metadata) with this surface
      *
@@ -181,6 +204,24 @@ public:
      */
     void associate_sync_timeline(wayland::Weak<SyncTimeline> timeline);
 
+    /// Request wp_presentation feedback for the content update of the next commit
+    void add_presentation_feedback(wayland::Weak<PresentationFeedback> feedback);
+
+    /// The formats the surface (and its subsurfaces) could be scanned out in, if it is a scanout candidate
+    void set_scanout_formats(std::optional<graphics::ScanoutFormats> const& formats);
+    /// Call \a listener with the scanout formats now, and whenever they change until it expires
+    void add_scanout_listener(std::weak_ptr<graphics::SurfaceScanoutHints::Listener> const& listener);
+
+    /**
+     * Call \a action when the client is next told it can draw (its frame callbacks are done), just before it is told
+     *
+     * If the client hasn't yet requested a frame callback, \a action waits for the one it next requests.
+     */
+    void call_before_next_frame(std::function<void()>&& action);
+
+    /// Whether the client has committed a frame callback that hasn't been done yet
+    auto awaiting_frame() const -> bool;
+
     class TimelineAlreadyAssociated : public std::logic_error
     {
     public:
@@ -229,18 +270,41 @@ private:
     std::optional<std::list<WlSubsurface*>> pending_surface_order;
     geometry::Displacement offset_;
     float scale{1};
+    bool buffer_transformed{false};
     std::optional<geometry::Size> buffer_size_;
 
     using CallbackList = std::vector<wayland::Weak<WlSurfaceState::Callback>>;
     CallbackList frame_callbacks;
+    /// Callbacks whose buffer the compositor has consumed, to be sent once that frame is on screen
+    CallbackList presentation_callbacks;
     CallbackList heartbeat_quirk_frame_callbacks;
+
+    using FeedbackList = std::vector<wayland::Weak<PresentationFeedback>>;
+    /// Feedback for the committed content update the compositor hasn't yet consumed
+    FeedbackList committed_feedbacks;
+    /// Feedback for consumed content, to be sent once that frame is on screen
+    FeedbackList consumed_feedbacks;
     std::optional<std::vector<mir::geometry::Rectangle>> input_shape;
     std::vector<SceneSurfaceCreatedCallback> scene_surface_created_callbacks;
     wayland::Weak<Viewport> viewport;
     wayland::Weak<FractionalScaleV1> fractional_scale;
+    wayland::Weak<TearingControlV1> tearing_control;
     wayland::Weak<SyncTimeline> sync_timeline;
+    std::optional<graphics::ScanoutFormats> scanout_formats;
+    std::vector<std::weak_ptr<graphics::SurfaceScanoutHints::Listener>> scanout_listeners;
+    std::vector<std::function<void()>> next_frame_actions;
 
     void send_frame_callbacks(CallbackList& list);
+    void send_presented(FeedbackList& list, graphics::FramePresentation const& presentation);
+    static void send_discarded(FeedbackList& list);
+    /// The compositor has consumed the current buffer; the pending frame callbacks now wait for it to be presented
+    void frame_consumed();
+    /// The area of a new submission that needs to be recomposited
+    /// (all of it if content_remapped, i.e. the way the buffer maps onto the surface has changed)
+    auto damage_for_submission(WlSurfaceState const& state, geometry::Size logical_size, bool content_remapped) const
+        -> geometry::Rectangles;
+    /// The area of a new buffer that differs from the current one, in buffer coordinates (std::nullopt if unknown)
+    auto damage_for_upload(WlSurfaceState const& state) const -> std::optional<geometry::Rectangles>;
 
     void attach(std::optional<wl_resource*> const& buffer, int32_t x, int32_t y) override;
     void damage(int32_t x, int32_t y, int32_t width, int32_t height) override;
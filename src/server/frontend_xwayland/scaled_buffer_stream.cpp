@@ -17,8 +17,12 @@
 #include "scaled_buffer_stream.h"
 #include <mir/geometry/forward.h>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
+
+#include <cmath>
 
 namespace mf = mir::frontend;
+namespace mg = mir::graphics;
 namespace geom = mir::geometry;
 
 mf::ScaledBufferStream::ScaledBufferStream(std::shared_ptr<compositor::BufferStream>&& inner, float scale)
@@ -35,12 +39,44 @@ void mf::ScaledBufferStream::submit_buffer(
     inner->submit_buffer(buffer, dest_size * scale, src_bounds);
 }
 
-void mf::ScaledBufferStream::set_frame_posted_callback(std::function<void(geometry::Size const&)> const& callback)
+void mf::ScaledBufferStream::submit_buffer(
+    std::shared_ptr<graphics::Buffer> const& buffer,
+    geom::Size dest_size,
+    geom::RectangleD src_bounds,
+    geom::Rectangles const& damage)
+{
+    geom::Rectangles scaled_damage;
+    for (auto const& rect : damage)
+    {
+        // Round outwards so that scaling never shrinks the damaged area
+        auto const left = std::floor(rect.left().as_int() * scale);
+        auto const top = std::floor(rect.top().as_int() * scale);
+        auto const right = std::ceil(rect.right().as_int() * scale);
+        auto const bottom = std::ceil(rect.bottom().as_int() * scale);
+        scaled_damage.add({
+            {static_cast<int>(left), static_cast<int>(top)},
+            {static_cast<int>(right - left), static_cast<int>(bottom - top)}});
+    }
+    inner->submit_buffer(buffer, dest_size * scale, src_bounds, scaled_damage);
+}
+
+void mf::ScaledBufferStream::set_frame_posted_callback(std::function<void(geometry::Rectangle const&)> const& callback)
 {
     // Does this need to be scaled? I don't ? think ? so? compositor::Stream seems to leave it unscaled.
     inner->set_frame_posted_callback(callback);
 }
 
+void mf::ScaledBufferStream::set_frame_presented_callback(
+    std::function<void(mg::FramePresentation const&)> const& callback)
+{
+    inner->set_frame_presented_callback(callback);
+}
+
+void mf::ScaledBufferStream::set_tearing_allowed(bool allowed)
+{
+    inner->set_tearing_allowed(allowed);
+}
+
 auto mf::ScaledBufferStream::next_submission_for_compositor(void const* user_id) -> std::shared_ptr<Submission>
 {
     return inner->next_submission_for_compositor(user_id);
@@ -50,3 +86,13 @@ auto mf::ScaledBufferStream::has_submitted_buffer() const -> bool
 {
     return inner->has_submitted_buffer();
 }
+
+void mf::ScaledBufferStream::frame_presented(mg::FramePresentation const& presentation)
+{
+    inner->frame_presented(presentation);
+}
+
+auto mf::ScaledBufferStream::tearing_allowed() const -> bool
+{
+    return inner->tearing_allowed();
+}
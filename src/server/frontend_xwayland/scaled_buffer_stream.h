@@ -39,13 +39,23 @@ public:
         std::shared_ptr<graphics::Buffer> const& buffer,
         geometry::Size dst_size,
         geometry::RectangleD src_bounds);
-    void set_frame_posted_callback(std::function<void(geometry::Size const&)> const& callback);
+    void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Size dst_size,
+        geometry::RectangleD src_bounds,
+        geometry::Rectangles const& damage);
+    void set_frame_posted_callback(std::function<void(geometry::Rectangle const&)> const& callback);
+    void set_frame_presented_callback(
+        std::function<void(graphics::FramePresentation const&)> const& callback);
+    void set_tearing_allowed(bool allowed);
     /// @}
 
     /// Overrides from compositor::BufferStream
     /// @{
     auto next_submission_for_compositor(void const* user_id) -> std::shared_ptr<Submission>;
     auto has_submitted_buffer() const -> bool;
+    void frame_presented(graphics::FramePresentation const& presentation);
+    auto tearing_allowed() const -> bool;
     /// @}
 
 private:
@@ -35,6 +35,7 @@
 #include <mir/input/input_probe.h>
 #include <mir/input/platform.h>
 #include <mir/input/xkb_mapper_registrar.h>
+#include <mir/input/keymap_cache.h>
 #include <mir/input/vt_filter.h>
 #include <mir/input/device.h>
 #include <mir/input/input_event_transformer.h>
@@ -351,21 +352,34 @@ std::shared_ptr<mi::DefaultInputDeviceHub> mir::DefaultServerConfiguration::the_
        });
 }
 
+namespace
+{
+auto make_xkb_mapper_registrar(mir::Executor& executor, mir::options::Option const& options)
+-> std::shared_ptr<mi::receiver::XKBMapperRegistrar>
+{
+    if (options.is_set(mir::options::keymap_cache_dir_opt))
+    {
+        mi::keymap_cache().persist_to(options.get<std::string>(mir::options::keymap_cache_dir_opt));
+    }
+    return std::make_shared<mi::receiver::XKBMapperRegistrar>(executor);
+}
+}
+
 std::shared_ptr<mi::KeyMapper> mir::DefaultServerConfiguration::the_key_mapper()
 {
     return xkb_mapper_registrar(
-       [default_executor=the_main_loop()]()
+       [default_executor=the_main_loop(), options=the_options()]()
        {
-           return std::make_shared<mi::receiver::XKBMapperRegistrar>(*default_executor);
+           return make_xkb_mapper_registrar(*default_executor, *options);
        });
 }
 
 std::shared_ptr<mi::LedObserverRegistrar> mir::DefaultServerConfiguration::the_led_observer_registrar()
 {
     return xkb_mapper_registrar(
-        [default_executor=the_main_loop()]()
+        [default_executor=the_main_loop(), options=the_options()]()
         {
-            return std::make_shared<mi::receiver::XKBMapperRegistrar>(*default_executor);
+            return make_xkb_mapper_registrar(*default_executor, *options);
         });
 }
 
@@ -31,6 +31,7 @@
 #include <mir_toolkit/event.h>
 
 #include <linux/input.h>
+#include <functional>
 #include <vector>
 #include <memory>
 #include <mutex>
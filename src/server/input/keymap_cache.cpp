@@ -0,0 +1,278 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "keymap-cache"
+
+#include <mir/input/keymap_cache.h>
+#include <mir/input/buffer_keymap.h>
+#include <mir/input/parameter_keymap.h>
+#include <mir/log.h>
+
+#include <boost/throw_exception.hpp>
+#include <xkbcommon/xkbcommon.h>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <system_error>
+
+namespace mi = mir::input;
+
+namespace
+{
+/// When \a path was last modified, or "-" if it doesn't exist
+auto modification_time_of(std::filesystem::path const& path) -> std::string
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+    {
+        return "-";
+    }
+    return std::to_string(info.st_mtim.tv_sec) + "." + std::to_string(info.st_mtim.tv_nsec);
+}
+
+/**
+ * Identifies the libxkbcommon and XKB data that \a context compiles keymaps with
+ *
+ * libxkbcommon has no version query, but the file its soname resolves to is named for
+ * the version (e.g. libxkbcommon.so.0.8.2).
+ */
+auto xkb_data_identity(xkb_context* context) -> std::string
+{
+    std::string identity;
+
+    Dl_info library;
+    if (dladdr(reinterpret_cast<void*>(&xkb_context_new), &library) && library.dli_fname)
+    {
+        std::error_code ignored;
+        auto const path = std::filesystem::canonical(library.dli_fname, ignored);
+        identity += "libxkbcommon " + path.string() + " " + modification_time_of(path) + "\n";
+    }
+
+    for (auto i = 0u; i != xkb_context_num_include_paths(context); ++i)
+    {
+        std::filesystem::path const root{xkb_context_include_path_get(context, i)};
+        identity += "include " + root.string() + " " + modification_time_of(root);
+        // Package upgrades replace the files in these directories, which updates them rather than root
+        for (auto const component : {"rules", "keycodes", "types", "compat", "symbols"})
+        {
+            identity += " " + modification_time_of(root / component);
+        }
+        identity += "\n";
+    }
+
+    return identity;
+}
+
+/**
+ * Identifies keymaps that can be persisted, or nullopt for keymaps that can't be
+ *
+ * The identity includes the XKB data the keymap is compiled from, so that persisted keymaps
+ * go stale when xkeyboard-config or libxkbcommon is upgraded.
+ */
+auto persistent_identity_of(mi::Keymap const& keymap, xkb_context* context) -> std::optional<std::string>
+{
+    if (auto const parameters = dynamic_cast<mi::ParameterKeymap const*>(&keymap))
+    {
+        return xkb_data_identity(context) + "rmlvo\n" + parameters->identity();
+    }
+    if (auto const buffer = dynamic_cast<mi::BufferKeymap const*>(&keymap))
+    {
+        return xkb_data_identity(context) + "buffer\n" + buffer->identity();
+    }
+    return std::nullopt;
+}
+
+/// Persisted files hold the length of the identity, the identity and then the serialised keymap
+auto path_for(std::string const& directory, std::string const& identity) -> std::filesystem::path
+{
+    std::ostringstream name;
+    name << std::hex << std::hash<std::string>{}(identity) << ".xkb";
+    return std::filesystem::path{directory} / name.str();
+}
+
+auto load(std::string const& directory, std::string const& identity) -> std::optional<std::string>
+{
+    std::ifstream file{path_for(directory, identity), std::ios::binary};
+    size_t identity_length;
+    if (!(file >> identity_length) || file.get() != '\n' || identity_length != identity.size())
+    {
+        return std::nullopt;
+    }
+
+    std::string stored_identity(identity_length, '\0');
+    if (!file.read(stored_identity.data(), identity_length) || stored_identity != identity)
+    {
+        // A different keymap with the same hash
+        return std::nullopt;
+    }
+
+    std::string text{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    if (text.empty() || text.back() != '\0')
+    {
+        return std::nullopt;
+    }
+    return text;
+}
+
+void store(std::string const& directory, std::string const& identity, std::string const& text)
+{
+    auto const path = path_for(directory, identity);
+    auto const temporary = path.string() + "." + std::to_string(getpid());
+
+    std::filesystem::create_directories(directory);
+    {
+        std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+        file << identity.size() << '\n' << identity << text;
+        if (!file.flush())
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error("Failed to write " + temporary));
+        }
+    }
+    // Renaming into place means readers never see a partly written file
+    std::filesystem::rename(temporary, path);
+}
+
+auto sealed_file_containing(std::string const& text) -> mir::Fd
+{
+    mir::Fd fd{memfd_create("mir-keymap", MFD_CLOEXEC | MFD_ALLOW_SEALING)};
+    if (fd == mir::Fd::invalid)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to create keymap file"));
+    }
+
+    for (size_t written = 0; written != text.size();)
+    {
+        auto const result = write(fd, text.data() + written, text.size() - written);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            BOOST_THROW_EXCEPTION(
+                std::system_error(errno, std::system_category(), "Failed to write keymap file"));
+        }
+        written += result;
+    }
+
+    // Every client is sent the same file, so none of them may change it
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == -1)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "Failed to seal keymap file"));
+    }
+
+    return fd;
+}
+}
+
+mi::KeymapCache::KeymapCache(size_t capacity)
+    : capacity{capacity},
+      context{xkb_context_new(XKB_CONTEXT_NO_FLAGS), &xkb_context_unref}
+{
+    if (!context)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Failed to create XKB context"));
+    }
+}
+
+mi::KeymapCache::~KeymapCache() = default;
+
+auto mi::KeymapCache::serialised(std::shared_ptr<Keymap const> const& keymap) -> std::shared_ptr<Serialised const>
+{
+    std::lock_guard lock{mutex};
+
+    for (auto i = entries.begin(); i != entries.end(); ++i)
+    {
+        if (i->keymap == keymap || i->keymap->matches(*keymap))
+        {
+            entries.splice(entries.begin(), entries, i);
+            return i->serialised;
+        }
+    }
+
+    auto const text = serialise(*keymap);
+    auto result = std::make_shared<Serialised const>(Serialised{sealed_file_containing(text), text.size()});
+
+    entries.push_front(Entry{keymap, result});
+    if (entries.size() > capacity)
+    {
+        entries.pop_back();
+    }
+
+    return result;
+}
+
+void mi::KeymapCache::persist_to(std::optional<std::string> const& directory)
+{
+    std::lock_guard lock{mutex};
+    this->directory = directory;
+}
+
+auto mi::KeymapCache::serialise(Keymap const& keymap) -> std::string
+{
+    auto const identity = directory ? persistent_identity_of(keymap, context.get()) : std::nullopt;
+
+    if (identity)
+    {
+        if (auto text = load(*directory, *identity))
+        {
+            return std::move(*text);
+        }
+    }
+
+    auto const compiled = keymap.make_unique_xkb_keymap(context.get());
+    std::unique_ptr<char, void(*)(void*)> const buffer{
+        xkb_keymap_get_as_string(compiled.get(), XKB_KEYMAP_FORMAT_TEXT_V1),
+        free};
+    if (!buffer)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Failed to serialise keymap for " + keymap.model()));
+    }
+
+    // so the null terminator is included
+    std::string text{buffer.get(), strlen(buffer.get()) + 1};
+
+    if (identity)
+    {
+        try
+        {
+            store(*directory, *identity, text);
+        }
+        catch (std::exception const& error)
+        {
+            log_warning("Failed to persist keymap in %s: %s", directory->c_str(), error.what());
+        }
+    }
+
+    return text;
+}
+
+auto mi::keymap_cache() -> KeymapCache&
+{
+    static KeymapCache cache;
+    return cache;
+}
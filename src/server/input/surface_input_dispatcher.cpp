@@ -128,7 +128,7 @@ void deliver_without_relative_motion(std::shared_ptr<mi::Surface> const& surface
         0.0f);
 
     set_local_positions_based_on_surface_input_bounds(*to_deliver, bounds);
-    surface->consume(std::move(to_deliver));
+    surface->consume(mev::share_event(std::move(to_deliver)));
 }
 
 void deliver(std::shared_ptr<mi::Surface> const& surface, MirEvent const* ev)
@@ -137,7 +137,7 @@ void deliver(std::shared_ptr<mi::Surface> const& surface, MirEvent const* ev)
 
     auto const& bounds = surface->input_bounds();
     set_local_positions_based_on_surface_input_bounds(*to_deliver, bounds);
-    surface->consume(std::move(to_deliver));
+    surface->consume(mev::share_event(std::move(to_deliver)));
 }
 
 }
@@ -422,7 +422,7 @@ void mi::SurfaceInputDispatcher::send_enter_exit_event(std::shared_ptr<mi::Surfa
         set_local_positions_based_on_surface_input_bounds(*event, surface->input_bounds());
     }
 
-    surface->consume(std::move(event));
+    surface->consume(mev::share_event(std::move(event)));
 }
 
 mi::SurfaceInputDispatcher::TouchInputState& mi::SurfaceInputDispatcher::ensure_touch_state(MirInputDeviceId id)
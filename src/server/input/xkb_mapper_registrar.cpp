@@ -246,8 +246,8 @@ void mircv::XKBMapperRegistrar::set_keymap_for_all_devices(std::shared_ptr<Keyma
 void mircv::XKBMapperRegistrar::set_keymap(std::shared_ptr<Keymap> new_keymap)
 {
     std::lock_guard lg(guard);
+    default_compiled_keymap = compile(*new_keymap);
     default_keymap = std::move(new_keymap);
-    default_compiled_keymap = default_keymap->make_unique_xkb_keymap(context.get());
     device_mapping.clear();
 }
 
@@ -260,7 +260,7 @@ void mircv::XKBMapperRegistrar::set_keymap(MirInputDeviceId id, std::shared_ptr<
 {
     std::lock_guard lg(guard);
 
-    auto compiled_keymap = new_keymap->make_unique_xkb_keymap(context.get());
+    auto compiled_keymap = compile(*new_keymap);
     auto mapping_state = std::make_unique<XkbMappingState>(std::move(new_keymap), std::move(compiled_keymap), executor);
 
     device_mapping.erase(id);
@@ -270,6 +270,23 @@ void mircv::XKBMapperRegistrar::set_keymap(MirInputDeviceId id, std::shared_ptr<
         std::forward_as_tuple(std::move(mapping_state)));
 }
 
+auto mircv::XKBMapperRegistrar::compile(Keymap const& keymap) const -> std::shared_ptr<xkb_keymap>
+{
+    // Devices usually share a few keymaps, and compiling one is expensive
+    if (default_keymap && default_keymap->matches(keymap))
+    {
+        return default_compiled_keymap;
+    }
+    for (auto const& [_, mapping_state] : device_mapping)
+    {
+        if (auto compiled = mapping_state->compiled_keymap_matching(keymap))
+        {
+            return compiled;
+        }
+    }
+    return keymap.make_unique_xkb_keymap(context.get());
+}
+
 void mircv::XKBMapperRegistrar::clear_all_keymaps()
 {
     std::lock_guard lg(guard);
@@ -416,6 +433,12 @@ mircv::XKBMapperRegistrar::XkbMappingState::XkbMappingStateLedRegistrar& mircv::
     return registrar;
 }
 
+auto mircv::XKBMapperRegistrar::XkbMappingState::compiled_keymap_matching(Keymap const& other) const
+-> std::shared_ptr<xkb_keymap>
+{
+    return keymap->matches(other) ? compiled_keymap : nullptr;
+}
+
 auto mircv::XKBMapperRegistrar::XkbMappingState::update_state(
     uint32_t scan_code,
     MirKeyboardAction action,
@@ -17,6 +17,8 @@
 #include "compositor_report.h"
 #include <mir/logging/logger.h>
 
+#include <ostream>
+
 using namespace mir::time;
 namespace ml = mir::logging;
 namespace mrl = mir::report::logging;
@@ -25,6 +27,31 @@ namespace
 {
     const char * const component = "compositor";
     const auto min_report_interval = std::chrono::seconds(1);
+    const auto timing_report_interval = std::chrono::seconds(10);
+
+    auto name_of(mir::compositor::CompositorReport::FramePhase phase) -> char const*
+    {
+        using FramePhase = mir::compositor::CompositorReport::FramePhase;
+
+        switch (phase)
+        {
+        case FramePhase::scene_snapshot: return "scene_snapshot";
+        case FramePhase::occlusion: return "occlusion";
+        case FramePhase::overlay_decision: return "overlay_decision";
+        case FramePhase::texture_upload: return "texture_upload";
+        case FramePhase::render: return "render";
+        case FramePhase::commit: return "commit";
+        case FramePhase::flip: return "flip";
+        case FramePhase::buffer_release: return "buffer_release";
+        }
+
+        return "unknown";
+    }
+
+    auto to_msec(std::chrono::microseconds usec) -> std::pair<long, long>
+    {
+        return {usec.count() / 1000, usec.count() % 1000};
+    }
 }
 
 mrl::CompositorReport::CompositorReport(
@@ -32,7 +59,8 @@ mrl::CompositorReport::CompositorReport(
     std::shared_ptr<Clock> const& clock)
     : logger(logger),
       clock(clock),
-      last_report(now())
+      last_report(now()),
+      last_timing_report(last_report)
 {
 }
 
@@ -130,6 +158,32 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
     last_reported_bypassed = nbypassed;
 }
 
+void mrl::CompositorReport::Instance::log_timings(ml::Logger& logger, SubCompositorId id)
+{
+    for (auto phase = 0; phase != frame_phase_count; ++phase)
+    {
+        auto& recent = phases[phase].recent;
+        if (recent.count() == 0)
+            continue;
+
+        auto const [p50_ms, p50_us] = to_msec(recent.percentile(50));
+        auto const [p95_ms, p95_us] = to_msec(recent.percentile(95));
+        auto const [p99_ms, p99_us] = to_msec(recent.percentile(99));
+        auto const [max_ms, max_us] = to_msec(recent.max());
+
+        char msg[192];
+        snprintf(msg, sizeof msg, "Display %p %s: "
+                 "p50 %ld.%03ld ms, p95 %ld.%03ld ms, p99 %ld.%03ld ms, max %ld.%03ld ms "
+                 "over %llu frames",
+                 id, name_of(static_cast<FramePhase>(phase)),
+                 p50_ms, p50_us, p95_ms, p95_us, p99_ms, p99_us, max_ms, max_us,
+                 static_cast<unsigned long long>(recent.count()));
+
+        logger.log(ml::Severity::informational, msg, component);
+        recent.reset();
+    }
+}
+
 void mrl::CompositorReport::finished_frame(SubCompositorId id)
 {
     std::lock_guard lock(mutex);
@@ -154,6 +208,15 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
             i.second.log(*logger, i.first);
     }
 
+    // Tail latencies need more samples than an average, so summarise them less often
+    if ((t - last_timing_report) >= timing_report_interval)
+    {
+        last_timing_report = t;
+
+        for (auto& i : instance)
+            i.second.log_timings(*logger, i.first);
+    }
+
     if (inst.bypassed != inst.prev_bypassed || inst.nframes == 1)
     {
         char msg[128];
@@ -164,6 +227,66 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
     inst.prev_bypassed = inst.bypassed;
 }
 
+void mrl::CompositorReport::presented_frame(SubCompositorId id, mir::graphics::FramePresentation const& presentation)
+{
+    char const* const mode =
+        presentation.vsync ? "vsync" :
+        presentation.hw_completion ? "async (tearing)" :
+        "unsynchronised";
+
+    std::lock_guard lock(mutex);
+    auto& inst = instance[id];
+
+    // Only log changes; a line for every frame would drown everything else
+    if (mode != inst.presentation_mode)
+    {
+        inst.presentation_mode = mode;
+
+        char msg[128];
+        snprintf(msg, sizeof msg, "Display %p presenting frames: %s", id, mode);
+        logger->log(ml::Severity::informational, msg, component);
+    }
+}
+
+void mrl::CompositorReport::frame_phase(SubCompositorId id, FramePhase phase, std::chrono::nanoseconds duration)
+{
+    std::lock_guard lock(mutex);
+    auto& times = instance[id].phases[static_cast<int>(phase)];
+    times.recent.record(duration);
+    times.total.record(duration);
+}
+
+void mrl::CompositorReport::dump_timings(std::ostream& out)
+{
+    std::lock_guard lock(mutex);
+
+    out << "{\"displays\":[";
+    char const* display_separator = "";
+    for (auto const& [id, inst] : instance)
+    {
+        char id_str[32];
+        snprintf(id_str, sizeof id_str, "%p", id);
+
+        out << display_separator << "{\"id\":\"" << id_str << "\",\"phases\":{";
+        char const* phase_separator = "";
+        for (auto phase = 0; phase != frame_phase_count; ++phase)
+        {
+            auto const& total = inst.phases[phase].total;
+            out << phase_separator
+                << "\"" << name_of(static_cast<FramePhase>(phase)) << "\":{"
+                << "\"count\":" << total.count() << ","
+                << "\"p50_us\":" << total.percentile(50).count() << ","
+                << "\"p95_us\":" << total.percentile(95).count() << ","
+                << "\"p99_us\":" << total.percentile(99).count() << ","
+                << "\"max_us\":" << total.max().count() << "}";
+            phase_separator = ",";
+        }
+        out << "}}";
+        display_separator = ",";
+    }
+    out << "]}\n";
+}
+
 void mrl::CompositorReport::started()
 {
     logger->log(ml::Severity::informational, "Started", component);
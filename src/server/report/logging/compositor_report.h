@@ -17,8 +17,12 @@
 #ifndef MIR_REPORT_LOGGING_COMPOSITOR_REPORT_H_
 #define MIR_REPORT_LOGGING_COMPOSITOR_REPORT_H_
 
+#include "latency_histogram.h"
+
 #include <mir/compositor/compositor_report.h>
 #include <mir/time/clock.h>
+#include <array>
+#include <iosfwd>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -45,10 +49,21 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void presented_frame(SubCompositorId id, graphics::FramePresentation const& presentation) override;
+    void frame_phase(SubCompositorId id, FramePhase phase, std::chrono::nanoseconds duration) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
 
+    /**
+     * Write the frame phase timings of every display, since it was added, as JSON
+     *
+     * The output is an object with a "displays" array; each display has a
+     * "phases" object giving the count, p50, p95, p99 and max (in microseconds)
+     * of each phase.
+     */
+    void dump_timings(std::ostream& out);
+
 private:
     std::shared_ptr<mir::logging::Logger> const logger;
     std::shared_ptr<time::Clock> const clock;
@@ -67,6 +82,7 @@ private:
         long nbypassed = 0;
         bool bypassed = true;
         bool prev_bypassed = false;
+        char const* presentation_mode = nullptr;    //< How the last frame was presented
 
         TimePoint last_reported_total_time_sum;
         TimePoint last_reported_render_time_sum;
@@ -74,13 +90,22 @@ private:
         long last_reported_nframes = 0;
         long last_reported_bypassed = 0;
 
+        struct PhaseTimes
+        {
+            LatencyHistogram recent;    //< Since the last timing summary was logged
+            LatencyHistogram total;     //< Since the display was added
+        };
+        std::array<PhaseTimes, frame_phase_count> phases;
+
         void log(mir::logging::Logger& logger, SubCompositorId id);
+        void log_timings(mir::logging::Logger& logger, SubCompositorId id);
     };
 
     std::mutex mutex; // Protects the following...
     std::unordered_map<SubCompositorId, Instance> instance;
     TimePoint last_scheduled;
     TimePoint last_report;
+    TimePoint last_timing_report;
 };
 
 } // namespace logging
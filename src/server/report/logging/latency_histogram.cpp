@@ -0,0 +1,98 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace mrl = mir::report::logging;
+
+auto mrl::LatencyHistogram::bucket_for(uint64_t usec) -> int
+{
+    if (usec < sub_buckets)
+        return static_cast<int>(usec);
+
+    // Values in [2^octave, 2^(octave+1)) are split into sub_buckets equal parts
+    int const octave = std::bit_width(usec) - 1;
+    if (octave >= max_octave)
+        return bucket_count - 1;
+
+    int const shift = octave - sub_bucket_bits;
+    int const sub_bucket = static_cast<int>(usec >> shift) - sub_buckets;
+    return sub_buckets + shift * sub_buckets + sub_bucket;
+}
+
+auto mrl::LatencyHistogram::upper_bound_of(int bucket) -> uint64_t
+{
+    if (bucket < sub_buckets)
+        return bucket;
+
+    if (bucket == bucket_count - 1)
+        return std::numeric_limits<uint64_t>::max();    // Also holds everything too big for a bucket
+
+    int const shift = (bucket - sub_buckets) / sub_buckets;
+    uint64_t const sub_bucket = (bucket - sub_buckets) % sub_buckets;
+    return ((sub_buckets + sub_bucket + 1) << shift) - 1;
+}
+
+void mrl::LatencyHistogram::record(std::chrono::nanoseconds duration)
+{
+    auto const usec = static_cast<uint64_t>(
+        std::max(std::chrono::duration_cast<std::chrono::microseconds>(duration).count(), int64_t{0}));
+
+    ++buckets[bucket_for(usec)];
+    ++total;
+    max_usec = std::max(max_usec, usec);
+}
+
+void mrl::LatencyHistogram::reset()
+{
+    buckets.fill(0);
+    total = 0;
+    max_usec = 0;
+}
+
+auto mrl::LatencyHistogram::count() const -> uint64_t
+{
+    return total;
+}
+
+auto mrl::LatencyHistogram::max() const -> std::chrono::microseconds
+{
+    return std::chrono::microseconds{max_usec};
+}
+
+auto mrl::LatencyHistogram::percentile(double percent) const -> std::chrono::microseconds
+{
+    if (total == 0)
+        return std::chrono::microseconds{0};
+
+    auto const fraction = std::clamp(percent, 0.0, 100.0) / 100.0;
+    auto const rank = std::max(static_cast<uint64_t>(std::ceil(total * fraction)), uint64_t{1});
+
+    uint64_t seen{0};
+    for (int bucket = 0; bucket != bucket_count; ++bucket)
+    {
+        seen += buckets[bucket];
+        if (seen >= rank)
+            return std::chrono::microseconds{std::min(upper_bound_of(bucket), max_usec)};
+    }
+
+    return max();
+}
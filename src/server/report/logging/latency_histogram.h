@@ -0,0 +1,75 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_LOGGING_LATENCY_HISTOGRAM_H_
+#define MIR_REPORT_LOGGING_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace mir
+{
+namespace report
+{
+namespace logging
+{
+/**
+ * A fixed-size histogram of durations, for reporting percentiles
+ *
+ * Durations are counted in microsecond buckets that widen with the value
+ * (16 buckets per power of two), so any percentile is accurate to within
+ * about 6% while the histogram never allocates. The maximum is kept exactly.
+ *
+ * Threadsafety: None; callers must serialise access.
+ */
+class LatencyHistogram
+{
+public:
+    void record(std::chrono::nanoseconds duration);
+
+    /// Forget everything recorded so far
+    void reset();
+
+    auto count() const -> uint64_t;
+    auto max() const -> std::chrono::microseconds;
+
+    /**
+     * The duration that \a percent of the recorded durations do not exceed
+     *
+     * This is the upper bound of the bucket the percentile falls in (but no
+     * more than max()), so it never under-reports tail latency.
+     */
+    auto percentile(double percent) const -> std::chrono::microseconds;
+
+private:
+    static int const sub_buckets{16};
+    static int const sub_bucket_bits{4};
+    static int const max_octave{36};    // Values beyond 2^36µs (~19 hours) share the last bucket
+    static int const bucket_count{sub_buckets + (max_octave - sub_bucket_bits) * sub_buckets};
+
+    static auto bucket_for(uint64_t usec) -> int;
+    static auto upper_bound_of(int bucket) -> uint64_t;
+
+    std::array<uint64_t, bucket_count> buckets{};
+    uint64_t total{0};
+    uint64_t max_usec{0};
+};
+}
+}
+}
+
+#endif // MIR_REPORT_LOGGING_LATENCY_HISTOGRAM_H_
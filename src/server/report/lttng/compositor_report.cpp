@@ -60,3 +60,22 @@ void mir::report::lttng::CompositorReport::finished_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, finished_frame, id);
 }
+
+void mir::report::lttng::CompositorReport::presented_frame(
+    SubCompositorId id, graphics::FramePresentation const& presentation)
+{
+    mir_tracepoint(
+        mir_server_compositor,
+        presented_frame,
+        id,
+        presentation.vsync,
+        presentation.hw_completion,
+        presentation.zero_copy,
+        presentation.frame.msc);
+}
+
+void mir::report::lttng::CompositorReport::frame_phase(
+    SubCompositorId id, FramePhase phase, std::chrono::nanoseconds duration)
+{
+    mir_tracepoint(mir_server_compositor, frame_phase, id, static_cast<int>(phase), duration.count());
+}
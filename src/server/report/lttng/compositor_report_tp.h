@@ -78,6 +78,30 @@ TRACEPOINT_EVENT_INSTANCE(
     TP_ARGS(void const*, id)
 )
 
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    presented_frame,
+    TP_ARGS(void const*, id, int, vsync, int, hw_completion, int, zero_copy, int64_t, msc),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(int, vsync, vsync)
+        ctf_integer(int, hw_completion, hw_completion)
+        ctf_integer(int, zero_copy, zero_copy)
+        ctf_integer(int64_t, msc, msc)
+    )
+)
+
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    frame_phase,
+    TP_ARGS(void const*, id, int, phase, int64_t, duration_ns),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(int, phase, phase)
+        ctf_integer(int64_t, duration_ns, duration_ns)
+    )
+)
+
 TRACEPOINT_EVENT(
     mir_server_compositor,
     buffers_in_frame,
@@ -38,6 +38,14 @@ void mrn::CompositorReport::finished_frame(SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::presented_frame(SubCompositorId, mir::graphics::FramePresentation const&)
+{
+}
+
+void mrn::CompositorReport::frame_phase(SubCompositorId, FramePhase, std::chrono::nanoseconds)
+{
+}
+
 void mrn::CompositorReport::started()
 {
 }
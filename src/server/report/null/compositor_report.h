@@ -34,6 +34,8 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void presented_frame(SubCompositorId id, graphics::FramePresentation const& presentation) override;
+    void frame_phase(SubCompositorId id, FramePhase phase, std::chrono::nanoseconds duration) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
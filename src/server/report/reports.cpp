@@ -19,19 +19,28 @@
 #include <mir/default_server_configuration.h>
 #include <mir/options/option.h>
 #include "logging/display_configuration_report.h"
+#include "logging/compositor_report.h"
 #include <mir/observer_multiplexer.h>
 #include <mir/options/configuration.h>
 #include <mir/abnormal_exit.h>
+#include <mir/main_loop.h>
+#include <mir/logging/logger.h>
 
 #include "report_factory.h"
 #include "lttng_report_factory.h"
 #include "logging_report_factory.h"
 #include "null_report_factory.h"
 
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <sstream>
 #include <string>
 
 namespace mo = mir::options;
 namespace mr = mir::report;
+namespace ml = mir::logging;
 
 namespace
 {
@@ -105,6 +114,40 @@ std::shared_ptr<mir::input::SeatObserver> create_seat_reports(
         std::throw_with_nested(mir::AbnormalExit("Failed to create report for "s + mo::seat_report_opt));
     }
 }
+
+/// On SIGUSR2, dump the frame timings of a logging compositor report (to a file, if configured)
+void dump_compositor_timings_on_signal(mir::DefaultServerConfiguration& config, mo::Option const& options)
+{
+    auto const report = std::dynamic_pointer_cast<mr::logging::CompositorReport>(config.the_compositor_report());
+    if (!report)
+        return;
+
+    std::optional<std::string> const file = options.is_set(mo::compositor_timings_file_opt) ?
+        std::optional{options.get<std::string>(mo::compositor_timings_file_opt)} : std::nullopt;
+
+    config.the_main_loop()->register_signal_handler(
+        {SIGUSR2},
+        [report, file, logger = config.the_logger()](int)
+        {
+            if (!file)
+            {
+                std::ostringstream out;
+                report->dump_timings(out);
+                logger->log(ml::Severity::informational, out.str(), "compositor");
+                return;
+            }
+
+            // Replace the file atomically, so readers never see a partial dump
+            auto const partial = *file + ".partial";
+            std::ofstream out{partial};
+            report->dump_timings(out);
+            out.close();
+            if (out && std::rename(partial.c_str(), file->c_str()) == 0)
+                return;
+
+            logger->log(ml::Severity::warning, "Failed to write compositor timings to " + *file, "compositor");
+        });
+}
 }
 
 mir::report::Reports::Reports(
@@ -117,4 +160,5 @@ mir::report::Reports::Reports(
 {
     display_configuration_multiplexer->register_interest(display_configuration_report);
     seat_observer_multiplexer->register_interest(seat_report);
+    dump_compositor_timings_on_signal(server, options);
 }
@@ -23,6 +23,7 @@
 #include <mir/geometry/displacement.h>
 #include <mir/renderer/sw/pixel_source.h>
 #include <mir/observer_multiplexer.h>
+#include <mir/recycling_allocator.h>
 #include <mir/scene/surface_observer.h>
 
 #include <mir/scene/scene_report.h>
@@ -184,6 +185,16 @@ public:
     {
         for_each_observer(&SurfaceObserver::tiled_edges, surf, edges);
     }
+
+    void scanout_formats_set_to(Surface const* surf, std::optional<graphics::ScanoutFormats> const& formats) override
+    {
+        for_each_observer(&SurfaceObserver::scanout_formats_set_to, surf, formats);
+    }
+
+    void input_region_set_to(Surface const* surf, std::vector<geometry::Rectangle> const& region) override
+    {
+        for_each_observer(&SurfaceObserver::input_region_set_to, surf, region);
+    }
 };
 
 ms::BasicSurface::BasicSurface(
@@ -210,6 +221,7 @@ ms::BasicSurface::BasicSurface(
     },
     observers(std::make_shared<Multiplexer>()),
     report(report),
+    snapshot_pool{std::make_shared<RecyclingPool>()},
     parent_(parent),
     display_config_registrar{display_config_registrar},
     display_config_monitor{std::make_shared<DisplayConfigurationEarlyListener>(this)}
@@ -310,6 +322,7 @@ mir::geometry::Size ms::BasicSurface::content_size() const
 void ms::BasicSurface::set_input_region(std::vector<geom::Rectangle> const& input_rectangles)
 {
     synchronised_state.lock()->custom_input_rectangles = input_rectangles;
+    observers->input_region_set_to(this, input_rectangles);
 }
 
 std::vector<geom::Rectangle> ms::BasicSurface::get_input_region() const
@@ -320,7 +333,9 @@ std::vector<geom::Rectangle> ms::BasicSurface::get_input_region() const
 
 void ms::BasicSurface::set_opaque_region(geom::Rectangles const& region)
 {
-    synchronised_state.lock()->opaque_region = region;
+    auto state = synchronised_state.lock();
+    state->opaque_region = std::make_shared<geom::Rectangles const>(region);
+    state->placed_opaque_region.region.reset();
 }
 
 void ms::BasicSurface::resize(geom::Size const& desired_size)
@@ -729,25 +744,20 @@ std::shared_ptr<ms::Surface> ms::BasicSurface::parent() const
 
 namespace
 {
-auto translate_opaque_region(
-    std::optional<mir::geometry::Rectangles> const& opaque_region, geom::Displacement translation)
-    -> std::optional<mir::geometry::Rectangles>
+auto translate_opaque_region(geom::Rectangles const& opaque_region, geom::Displacement translation)
+    -> mir::geometry::Rectangles
 {
-    return opaque_region.transform(
-        [&translation](auto const r)
-        {
-            auto region = geom::Rectangles{};
-            for (auto const& subregion : r)
-            {
-                auto const translated_top_left = geom::Point{
-                    subregion.top_left.x + translation.dx,
-                    subregion.top_left.y + translation.dy,
-                };
-                region.add(geom::Rectangle{translated_top_left, subregion.size});
-            }
+    auto region = geom::Rectangles{};
+    for (auto const& subregion : opaque_region)
+    {
+        auto const translated_top_left = geom::Point{
+            subregion.top_left.x + translation.dx,
+            subregion.top_left.y + translation.dy,
+        };
+        region.add(geom::Rectangle{translated_top_left, subregion.size});
+    }
 
-            return region;
-        });
+    return region;
 }
 //This class avoids locking for long periods of time by copying (or lazy-copying)
 class SurfaceSnapshot : public mg::Renderable
@@ -763,7 +773,8 @@ public:
         float alpha,
         mg::Renderable::ID id,
         ms::Surface const* surface,
-        std::optional<geom::Rectangles> opaque_region) :
+        std::shared_ptr<geom::Rectangles const> opaque_region,  ///< Already translated to top_left
+        bool tearing_allowed) :
         entry{std::move(buffer)},
         alpha_{alpha},
         screen_position_{top_left, entry->size()},
@@ -773,8 +784,8 @@ public:
         mirror_mode_{mirror_mode},
         id_{id},
         surface{surface},
-        opaque_region_{translate_opaque_region(
-            opaque_region, mir::geometry::generic::as_displacement(screen_position_.top_left))}
+        opaque_region_{std::move(opaque_region)},
+        tearing_allowed{tearing_allowed}
     {
     }
 
@@ -823,7 +834,38 @@ public:
 
     std::optional<geom::Rectangles> opaque_region() const override
     {
-        return opaque_region_;
+        if (opaque_region_)
+        {
+            return *opaque_region_;
+        }
+        return geom::Rectangles{};
+    }
+
+    auto allows_tearing() const -> bool override
+    {
+        return tearing_allowed;
+    }
+
+    auto damage_since(mg::BufferID previous) const -> std::optional<geom::Rectangles> override
+    {
+        auto const damage = entry->damage_since(previous);
+        if (!damage)
+        {
+            return std::nullopt;
+        }
+
+        geom::Rectangles result;
+        for (auto const& rect : *damage)
+        {
+            auto const on_screen = intersection_of(
+                geom::Rectangle{rect.top_left + as_displacement(screen_position_.top_left), rect.size},
+                screen_position_);
+            if (on_screen.size != geom::Size{})
+            {
+                result.add(on_screen);
+            }
+        }
+        return result;
     }
 
 private:
@@ -836,7 +878,8 @@ private:
     MirMirrorMode mirror_mode_;
     mg::Renderable::ID const id_;
     ms::Surface const* surface;
-    std::optional<geom::Rectangles> const opaque_region_;
+    std::shared_ptr<geom::Rectangles const> const opaque_region_;
+    bool const tearing_allowed;
 };
 }
 
@@ -878,13 +921,20 @@ void ms::BasicSurface::set_streams(std::list<StreamInfo> const& s)
 
 mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) const
 {
-    auto state = synchronised_state.lock();
     mg::RenderableList list;
+    append_renderables(id, list);
+    return list;
+}
+
+void ms::BasicSurface::append_renderables(mc::CompositorID id, mg::RenderableList& list) const
+{
+    // Updates the translated opaque region cached in the state
+    auto state = synchronised_state.lock_mut();
 
     if (state->clip_area)
     {
         if (!state->surface_rect.overlaps(state->clip_area.value()))
-            return list;
+            return;
     }
 
     auto const content_top_left_ = content_top_left(*state);
@@ -893,9 +943,23 @@ mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) c
     {
         if (info.stream->has_submitted_buffer())
         {
-            list.emplace_back(std::make_shared<SurfaceSnapshot>(
+            auto const top_left = content_top_left_ + info.displacement;
+
+            // The opaque region is only translated again when the surface moves
+            auto& placed = state->placed_opaque_region;
+            if (state->opaque_region && (!placed.region || placed.top_left != top_left))
+            {
+                placed.top_left = top_left;
+                placed.region = std::make_shared<geom::Rectangles const>(
+                    translate_opaque_region(*state->opaque_region, as_displacement(top_left)));
+            }
+
+            // Snapshots are taken for every visible surface on every frame;
+            // recycle their storage rather than going to the heap each time.
+            list.emplace_back(std::allocate_shared<SurfaceSnapshot>(
+                mir::RecyclingAllocator<SurfaceSnapshot>{snapshot_pool},
                 info.stream->next_submission_for_compositor(id),
-                content_top_left_ + info.displacement,
+                top_left,
                 state->clip_area,
                 state->transformation_matrix,
                 state->orientation,
@@ -903,10 +967,24 @@ mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) c
                 state->surface_alpha,
                 info.stream.get(),
                 this,
-                state->opaque_region));
+                state->opaque_region ? placed.region : nullptr,
+                info.stream->tearing_allowed()));
         }
     }
-    return list;
+}
+
+void ms::BasicSurface::frame_presented(mg::FramePresentation const& presentation)
+{
+    auto state = synchronised_state.lock();
+    for (auto const& info : state->layers)
+    {
+        info.stream->frame_presented(presentation);
+    }
+}
+
+void ms::BasicSurface::set_scanout_formats(std::optional<mg::ScanoutFormats> const& formats)
+{
+    observers->scanout_formats_set_to(this, formats);
 }
 
 void ms::BasicSurface::set_confine_pointer_state(MirPointerConfinementState state)
@@ -1147,11 +1225,13 @@ void mir::scene::BasicSurface::update_frame_posted_callbacks(State& state)
         auto const surface_local_position = geom::Point{} + state.margins.left + state.margins.top + layer.displacement;
         layer.stream->set_frame_posted_callback(
             [this, observers=std::weak_ptr{observers}, surface_local_position]
-                (auto const& size)
+                (geom::Rectangle const& damage)
             {
                 if (auto const o = observers.lock())
                 {
-                    o->frame_posted(this, geom::Rectangle{surface_local_position, size});
+                    o->frame_posted(
+                        this,
+                        geom::Rectangle{surface_local_position + as_displacement(damage.top_left), damage.size});
                 }
             });
     }
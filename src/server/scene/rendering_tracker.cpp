@@ -24,6 +24,7 @@
 
 namespace ms = mir::scene;
 namespace mc = mir::compositor;
+namespace mg = mir::graphics;
 
 ms::RenderingTracker::RenderingTracker(
     std::weak_ptr<ms::Surface> const& weak_surface)
@@ -39,6 +40,9 @@ void ms::RenderingTracker::rendered_in(mc::CompositorID cid)
 
     occlusions.erase(cid);
 
+    if (std::find(awaiting_presentation.begin(), awaiting_presentation.end(), cid) == awaiting_presentation.end())
+        awaiting_presentation.push_back(cid);
+
     configure_visibility(mir_window_visibility_exposed);
 }
 
@@ -50,6 +54,9 @@ void ms::RenderingTracker::occluded_in(mc::CompositorID cid)
 
     occlusions.insert(cid);
 
+    if (scanout_candidacy.erase(cid))
+        update_scanout_formats();
+
     if (occluded_in_all_active_compositors())
         configure_visibility(mir_window_visibility_occluded);
 }
@@ -61,6 +68,9 @@ void ms::RenderingTracker::active_compositors(std::set<mc::CompositorID> const&
     active_compositors_ = cids;
 
     remove_occlusions_for_inactive_compositors();
+    std::erase_if(awaiting_presentation, [&](auto cid) { return !active_compositors_.contains(cid); });
+    if (std::erase_if(scanout_candidacy, [&](auto const& entry) { return !active_compositors_.contains(entry.first); }))
+        update_scanout_formats();
 
     if (occluded_in_all_active_compositors())
         configure_visibility(mir_window_visibility_occluded);
@@ -78,6 +88,44 @@ bool ms::RenderingTracker::is_exposed_in(mc::CompositorID cid) const
     return occlusions.find(cid) == occlusions.end();
 }
 
+void ms::RenderingTracker::presented_in(mc::CompositorID cid, mg::FramePresentation const& presentation)
+{
+    {
+        std::lock_guard lock{guard};
+
+        auto const pending = std::find(awaiting_presentation.begin(), awaiting_presentation.end(), cid);
+        if (pending == awaiting_presentation.end())
+            return;
+
+        awaiting_presentation.erase(pending);
+    }
+
+    if (auto const surface = weak_surface.lock())
+        surface->frame_presented(presentation);
+}
+
+void ms::RenderingTracker::scanout_candidate_in(mc::CompositorID cid, std::optional<mg::ScanoutFormats> const& formats)
+{
+    std::lock_guard lock{guard};
+
+    ensure_is_active_compositor(cid);
+
+    if (formats)
+    {
+        auto const current = scanout_candidacy.find(cid);
+        if (current != scanout_candidacy.end() && current->second == *formats)
+            return;
+
+        scanout_candidacy.insert_or_assign(cid, *formats);
+    }
+    else if (!scanout_candidacy.erase(cid))
+    {
+        return;
+    }
+
+    update_scanout_formats();
+}
+
 bool ms::RenderingTracker::occluded_in_all_active_compositors()
 {
     return occlusions == active_compositors_;
@@ -89,6 +137,21 @@ void ms::RenderingTracker::configure_visibility(MirWindowVisibility visibility)
         surface->configure(mir_window_attrib_visibility, visibility);
 }
 
+void ms::RenderingTracker::update_scanout_formats()
+{
+    // Any output that could scan the surface out will do
+    std::optional<mg::ScanoutFormats> formats;
+    if (!scanout_candidacy.empty())
+        formats = scanout_candidacy.begin()->second;
+
+    if (formats == notified_scanout_formats)
+        return;
+
+    notified_scanout_formats = formats;
+    if (auto const surface = weak_surface.lock())
+        surface->set_scanout_formats(formats);
+}
+
 void ms::RenderingTracker::remove_occlusions_for_inactive_compositors()
 {
     std::set<mc::CompositorID> new_occlusions;
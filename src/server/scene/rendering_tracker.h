@@ -18,15 +18,23 @@
 #define MIR_SCENE_RENDERING_TRACKER_H_
 
 #include <mir/compositor/compositor_id.h>
+#include <mir/graphics/scanout_formats.h>
 
+#include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <mutex>
+#include <vector>
 
 #include <mir_toolkit/common.h>
 
 namespace mir
 {
+namespace graphics
+{
+struct FramePresentation;
+}
 namespace scene
 {
 
@@ -41,16 +49,27 @@ public:
     void occluded_in(compositor::CompositorID cid);
     void active_compositors(std::set<compositor::CompositorID> const& cids);
     bool is_exposed_in(compositor::CompositorID cid) const;
+    /// Tell the surface it is on screen if it was rendered into the frame \a cid just presented
+    void presented_in(compositor::CompositorID cid, graphics::FramePresentation const& presentation);
+    /// Tell the surface the formats it could be scanned out in, if any compositor would scan it out
+    void scanout_candidate_in(compositor::CompositorID cid, std::optional<graphics::ScanoutFormats> const& formats);
 
 private:
     bool occluded_in_all_active_compositors();
     void configure_visibility(MirWindowVisibility visibility);
     void remove_occlusions_for_inactive_compositors();
     void ensure_is_active_compositor(compositor::CompositorID cid) const;
+    /// Tell the surface its scanout formats if they have changed since it was last told
+    void update_scanout_formats();
 
     std::weak_ptr<Surface> const weak_surface;
     std::set<compositor::CompositorID> occlusions;
     std::set<compositor::CompositorID> active_compositors_;
+    /// Compositors that have rendered the surface into a frame that is not yet on screen
+    std::vector<compositor::CompositorID> awaiting_presentation;
+    /// The compositors that could scan the surface out, and in which formats
+    std::map<compositor::CompositorID, graphics::ScanoutFormats> scanout_candidacy;
+    std::optional<graphics::ScanoutFormats> notified_scanout_formats;
     std::mutex mutable guard;
 };
 
@@ -0,0 +1,236 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "surface_spatial_index.h"
+
+#include <mir/scene/surface.h>
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace ms = mir::scene;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// Surfaces spanning more cells than this are checked at every point instead
+int const max_cells_per_surface{1024};
+
+auto cell_key(int x, int y) -> uint64_t
+{
+    return (uint64_t{static_cast<uint32_t>(x)} << 32) | static_cast<uint32_t>(y);
+}
+
+/// Division rounding towards negative infinity, so negative coordinates land in the right cell
+auto cell_of(int coordinate, int cell_size) -> int
+{
+    return coordinate >= 0 ? coordinate / cell_size : -((-coordinate + cell_size - 1) / cell_size);
+}
+
+/// A rectangle containing all of the surface's input area
+auto input_extents_of(ms::Surface const& surface) -> geom::Rectangle
+{
+    auto const bounds = surface.input_bounds();
+    auto const region = surface.get_input_region();
+
+    if (region.empty())
+    {
+        return bounds;
+    }
+
+    // A custom input region is relative to the content, may extend beyond it, and is rotated to match the
+    // surface's orientation (which isn't visible from here). So allow for it being rotated either way.
+    auto const window_size = surface.window_size();
+    int reach = std::max(window_size.width.as_int(), window_size.height.as_int());
+    int furthest = 0;
+    for (auto const& rectangle : region)
+    {
+        furthest = std::max({
+            furthest,
+            std::abs(rectangle.left().as_int()),
+            std::abs(rectangle.top().as_int()),
+            std::abs(rectangle.right().as_int()),
+            std::abs(rectangle.bottom().as_int())});
+    }
+    reach += furthest;
+
+    return {bounds.top_left - geom::Displacement{reach, reach}, geom::Size{2 * reach, 2 * reach}};
+}
+
+auto by_rank_topmost_first = [](auto const* lhs, auto const* rhs) { return lhs->rank > rhs->rank; };
+}
+
+ms::SurfaceSpatialIndex::SurfaceSpatialIndex(int cell_size)
+    : cell_size{cell_size}
+{
+    if (cell_size <= 0)
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Spatial index cell size must be positive"));
+    }
+}
+
+void ms::SurfaceSpatialIndex::set_stacking_order(std::vector<std::vector<std::shared_ptr<Surface>>> const& layers)
+{
+    std::lock_guard lock{mutex};
+
+    // Rank every surface in the new order (from 1, so 0 marks surfaces no longer in the stack)
+    for (auto& [_, entry] : entries)
+    {
+        entry.rank = 0;
+    }
+
+    unsigned rank{0};
+    for (auto const& layer : layers)
+    {
+        for (auto const& surface : layer)
+        {
+            auto const [i, added] = entries.try_emplace(surface.get(), Entry{surface, 0, true, {}});
+            i->second.rank = ++rank;
+            if (added)
+            {
+                insert(i->second);
+            }
+        }
+    }
+
+    for (auto i = entries.begin(); i != entries.end();)
+    {
+        if (i->second.rank == 0)
+        {
+            erase(i->second);
+            i = entries.erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    sort_by_rank();
+}
+
+void ms::SurfaceSpatialIndex::update(Surface const* surface)
+{
+    std::lock_guard lock{mutex};
+
+    if (auto const i = entries.find(surface); i != entries.end())
+    {
+        erase(i->second);
+        insert(i->second);
+    }
+}
+
+auto ms::SurfaceSpatialIndex::topmost_at(
+    geom::Point point,
+    std::function<bool(std::shared_ptr<Surface> const&)> const& accept) const -> std::shared_ptr<Surface>
+{
+    std::lock_guard lock{mutex};
+
+    static std::vector<Entry*> const no_entries;
+    auto const cell = cells.find(cell_key(cell_of(point.x.as_int(), cell_size), cell_of(point.y.as_int(), cell_size)));
+    auto const& nearby = cell != cells.end() ? cell->second : no_entries;
+
+    // Both lists are topmost first, so merge them to visit candidates from the top down
+    auto i = nearby.begin();
+    auto j = everywhere.begin();
+    while (i != nearby.end() || j != everywhere.end())
+    {
+        Entry const* const next =
+            j == everywhere.end() || (i != nearby.end() && (*i)->rank > (*j)->rank) ? *i++ : *j++;
+
+        if (accept(next->surface))
+        {
+            return next->surface;
+        }
+    }
+
+    return {};
+}
+
+void ms::SurfaceSpatialIndex::insert(Entry& entry)
+{
+    auto const extents = input_extents_of(*entry.surface);
+
+    if (extents.size.width.as_int() <= 0 || extents.size.height.as_int() <= 0)
+    {
+        // An empty input area can't contain anything
+        entry.everywhere = false;
+        entry.cells = {};
+        return;
+    }
+
+    entry.cells = Cells{
+        cell_of(extents.left().as_int(), cell_size),
+        cell_of(extents.top().as_int(), cell_size),
+        cell_of(extents.right().as_int() - 1, cell_size) + 1,
+        cell_of(extents.bottom().as_int() - 1, cell_size) + 1};
+
+    auto const cell_count =
+        int64_t{entry.cells.right - entry.cells.left} * (entry.cells.bottom - entry.cells.top);
+    entry.everywhere = cell_count > max_cells_per_surface;
+
+    auto const add_to = [&](std::vector<Entry*>& list)
+        {
+            list.insert(std::lower_bound(list.begin(), list.end(), &entry, by_rank_topmost_first), &entry);
+        };
+
+    if (entry.everywhere)
+    {
+        add_to(everywhere);
+        return;
+    }
+
+    for (auto x = entry.cells.left; x != entry.cells.right; ++x)
+    {
+        for (auto y = entry.cells.top; y != entry.cells.bottom; ++y)
+        {
+            add_to(cells[cell_key(x, y)]);
+        }
+    }
+}
+
+void ms::SurfaceSpatialIndex::erase(Entry& entry)
+{
+    if (entry.everywhere)
+    {
+        std::erase(everywhere, &entry);
+        return;
+    }
+
+    for (auto x = entry.cells.left; x != entry.cells.right; ++x)
+    {
+        for (auto y = entry.cells.top; y != entry.cells.bottom; ++y)
+        {
+            // Empty cells are kept, so surfaces moving back and forth don't reallocate them
+            if (auto const cell = cells.find(cell_key(x, y)); cell != cells.end())
+            {
+                std::erase(cell->second, &entry);
+            }
+        }
+    }
+}
+
+void ms::SurfaceSpatialIndex::sort_by_rank()
+{
+    for (auto& [_, list] : cells)
+    {
+        std::sort(list.begin(), list.end(), by_rank_topmost_first);
+    }
+    std::sort(everywhere.begin(), everywhere.end(), by_rank_topmost_first);
+}
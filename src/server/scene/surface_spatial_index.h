@@ -0,0 +1,98 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SCENE_SURFACE_SPATIAL_INDEX_H_
+#define MIR_SCENE_SURFACE_SPATIAL_INDEX_H_
+
+#include <mir/geometry/rectangle.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace scene
+{
+class Surface;
+
+/**
+ * Finds the surfaces whose input area might contain a point, without visiting every surface
+ *
+ * Surfaces are bucketed by the extent of their input area into a uniform grid of cells. Each
+ * cell lists the surfaces overlapping it topmost first, so a lookup only visits the surfaces
+ * near the point. The index is kept up to date by telling it when surfaces are restacked and
+ * when their input area may have changed (they move, resize or set an input region).
+ *
+ * Threadsafety: All member functions are threadsafe
+ */
+class SurfaceSpatialIndex
+{
+public:
+    explicit SurfaceSpatialIndex(int cell_size = 256);
+
+    /**
+     * Index exactly the surfaces in \a layers, in that stacking order
+     *
+     * \param layers    The depth layers bottom to top, each listing its surfaces bottom to top
+     */
+    void set_stacking_order(std::vector<std::vector<std::shared_ptr<Surface>>> const& layers);
+
+    /// The input area of \a surface may have changed (surfaces that aren't indexed are ignored)
+    void update(Surface const* surface);
+
+    /**
+     * The topmost surface that might have \a point in its input area and is accepted by \a accept
+     *
+     * Only surfaces near \a point are offered to \a accept, which should check the input area itself.
+     */
+    auto topmost_at(
+        geometry::Point point,
+        std::function<bool(std::shared_ptr<Surface> const&)> const& accept) const -> std::shared_ptr<Surface>;
+
+private:
+    /// A range of cells [left, right) × [top, bottom)
+    struct Cells
+    {
+        int left, top, right, bottom;
+    };
+
+    struct Entry
+    {
+        std::shared_ptr<Surface> surface;
+        unsigned rank;          ///< The stacking position: higher ranks are above lower
+        bool everywhere;        ///< Whether the surface is listed in `everywhere` rather than `cells`
+        Cells cells;            ///< Only meaningful if !everywhere
+    };
+
+    void insert(Entry& entry);
+    void erase(Entry& entry);
+    void sort_by_rank();
+
+    int const cell_size;
+
+    std::mutex mutable mutex;
+    std::unordered_map<Surface const*, Entry> entries;
+    std::unordered_map<uint64_t, std::vector<Entry*>> cells;    ///< Indexed by cell_key(), each topmost first
+    std::vector<Entry*> everywhere;                             ///< Surfaces spanning too many cells, topmost first
+};
+}
+}
+
+#endif /* MIR_SCENE_SURFACE_SPATIAL_INDEX_H_ */
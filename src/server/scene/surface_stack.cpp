@@ -24,6 +24,7 @@
 #include <mir/depth_layer.h>
 #include <mir/executor.h>
 #include <mir/log.h>
+#include <mir/recycling_allocator.h>
 
 #include <boost/throw_exception.hpp>
 
@@ -47,14 +48,12 @@ class SurfaceSceneElement : public mc::SceneElement
 {
 public:
     SurfaceSceneElement(
-        std::string name,
-        std::shared_ptr<mg::Renderable> const& renderable,
+        std::shared_ptr<mg::Renderable> renderable,
         std::shared_ptr<ms::RenderingTracker> const& tracker,
         mc::CompositorID id)
-        : renderable_{renderable},
+        : renderable_{std::move(renderable)},
           tracker{tracker},
-          cid{id},
-          surface_name(name)
+          cid{id}
     {
     }
 
@@ -73,11 +72,15 @@ public:
         tracker->occluded_in(cid);
     }
 
+    void scanout_candidate(std::optional<mg::ScanoutFormats> const& formats) override
+    {
+        tracker->scanout_candidate_in(cid, formats);
+    }
+
 private:
     std::shared_ptr<mg::Renderable> const renderable_;
     std::shared_ptr<ms::RenderingTracker> const tracker;
     mc::CompositorID cid;
-    std::string const surface_name;
 };
 
 //note: something different than a 2D/HWC overlay
@@ -108,12 +111,13 @@ private:
 };
 
 /**
- * A SurfaceDepthLayerObserver must not outlive the SurfaceStack it was created for
+ * A SurfaceStackObserver must not outlive the SurfaceStack it was created for
  */
-struct SurfaceDepthLayerObserver : ms::NullSurfaceObserver
+struct SurfaceStackObserver : ms::NullSurfaceObserver
 {
-    SurfaceDepthLayerObserver(ms::SurfaceStack* stack)
-        : stack{stack}
+    SurfaceStackObserver(ms::SurfaceStack* stack, ms::SurfaceSpatialIndex* spatial_index)
+        : stack{stack},
+          spatial_index{spatial_index}
     {
     }
 
@@ -123,21 +127,45 @@ struct SurfaceDepthLayerObserver : ms::NullSurfaceObserver
         stack->raise(surface);
     }
 
+    void window_resized_to(ms::Surface const* surface, geom::Size const& /*window_size*/) override
+    {
+        spatial_index->update(surface);
+    }
+
+    void content_resized_to(ms::Surface const* surface, geom::Size const& /*content_size*/) override
+    {
+        spatial_index->update(surface);
+    }
+
+    void moved_to(ms::Surface const* surface, geom::Point const& /*top_left*/) override
+    {
+        spatial_index->update(surface);
+    }
+
+    void input_region_set_to(ms::Surface const* surface, std::vector<geom::Rectangle> const& /*region*/) override
+    {
+        spatial_index->update(surface);
+    }
+
 private:
     ms::SurfaceStack* stack;
+    ms::SurfaceSpatialIndex* spatial_index;
 };
 }
 
 ms::SurfaceStack::SurfaceStack(std::shared_ptr<SceneReport> const& report) :
+    published{std::make_shared<Snapshot const>()},
     report{report},
-    surface_observer{std::make_shared<SurfaceDepthLayerObserver>(this)},
+    surface_element_pool{std::make_shared<RecyclingPool>()},
+    overlay_element_pool{std::make_shared<RecyclingPool>()},
+    surface_observer{std::make_shared<SurfaceStackObserver>(this, &spatial_index)},
     multiplexer(linearising_executor)
 {
 }
 
 ms::SurfaceStack::~SurfaceStack() noexcept(true)
 {
-    RecursiveWriteLock lg(guard);
+    std::lock_guard lg(guard);
     for (auto const& layer : surface_layers)
     {
         for (auto const& surface : layer)
@@ -149,37 +177,67 @@ ms::SurfaceStack::~SurfaceStack() noexcept(true)
 
 mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID id)
 {
-    RecursiveReadLock lg(guard);
+    auto const scene = published.load();
 
-    mc::SceneElementSequence elements;
-    for (auto const& layer : surface_layers)
+    // Gather the renderables first so the sequence can be sized exactly. The scratch
+    // storage is per-thread (each compositor has its own thread) and keeps its
+    // capacity between frames.
+    thread_local mg::RenderableList renderables;
+    thread_local std::vector<std::shared_ptr<RenderingTracker> const*> trackers;
+    renderables.clear();
+    trackers.clear();
+
+    for (auto const& layer : scene->surface_layers)
     {
-        for (auto const& surface : layer)
+        for (auto const& [surface, tracker] : layer)
         {
             if (surface_can_be_shown(surface) && surface->visible())
             {
-                for (auto& renderable : surface->generate_renderables(id))
-                {
-                    elements.emplace_back(
-                        std::make_shared<SurfaceSceneElement>(
-                            surface->name(),
-                            renderable,
-                            rendering_trackers[surface.get()],
-                            id));
-                }
+                surface->append_renderables(id, renderables);
+                trackers.resize(renderables.size(), &tracker);
             }
         }
     }
-    for (auto const& renderable : overlays)
+
+    mc::SceneElementSequence elements;
+    elements.reserve(renderables.size() + scene->overlays.size());
+    for (auto i = 0u; i != renderables.size(); ++i)
     {
-        elements.emplace_back(std::make_shared<OverlaySceneElement>(renderable));
+        elements.emplace_back(
+            std::allocate_shared<SurfaceSceneElement>(
+                RecyclingAllocator<SurfaceSceneElement>{surface_element_pool},
+                std::move(renderables[i]),
+                *trackers[i],
+                id));
+    }
+    renderables.clear();
+
+    for (auto const& renderable : scene->overlays)
+    {
+        elements.emplace_back(
+            std::allocate_shared<OverlaySceneElement>(
+                RecyclingAllocator<OverlaySceneElement>{overlay_element_pool},
+                renderable));
     }
     return elements;
 }
 
+void ms::SurfaceStack::frame_presented(mc::CompositorID id, mg::FramePresentation const& presentation)
+{
+    auto const scene = published.load();
+
+    for (auto const& layer : scene->surface_layers)
+    {
+        for (auto const& [_, tracker] : layer)
+        {
+            tracker->presented_in(id, presentation);
+        }
+    }
+}
+
 void ms::SurfaceStack::register_compositor(mc::CompositorID cid)
 {
-    RecursiveWriteLock lg(guard);
+    std::lock_guard lg(guard);
 
     registered_compositors.insert(cid);
 
@@ -188,7 +246,7 @@ void ms::SurfaceStack::register_compositor(mc::CompositorID cid)
 
 void ms::SurfaceStack::unregister_compositor(mc::CompositorID cid)
 {
-    RecursiveWriteLock lg(guard);
+    std::lock_guard lg(guard);
 
     registered_compositors.erase(cid);
 
@@ -199,8 +257,9 @@ void ms::SurfaceStack::add_input_visualization(
     std::shared_ptr<mg::Renderable> const& overlay)
 {
     {
-        RecursiveWriteLock lg(guard);
+        std::lock_guard lg(guard);
         overlays.push_back(overlay);
+        publish();
     }
     emit_scene_changed();
 }
@@ -210,13 +269,14 @@ void ms::SurfaceStack::remove_input_visualization(
 {
     auto overlay = weak_overlay.lock();
     {
-        RecursiveWriteLock lg(guard);
+        std::lock_guard lg(guard);
         auto const p = std::find(overlays.begin(), overlays.end(), overlay);
         if (p == overlays.end())
         {
             BOOST_THROW_EXCEPTION(std::runtime_error("Attempt to remove an overlay which was never added or which has been previously removed"));
         }
         overlays.erase(p);
+        publish();
     }
 
     emit_scene_changed();
@@ -232,10 +292,11 @@ void ms::SurfaceStack::add_surface(
     mi::InputReceptionMode input_mode)
 {
     {
-        RecursiveWriteLock lg(guard);
+        std::lock_guard lg(guard);
         insert_surface_at_top_of_depth_layer(surface);
         create_rendering_tracker_for(surface);
         surface->register_interest(surface_observer, immediate_executor);
+        stacking_order_changed();
     }
     surface->set_reception_mode(input_mode);
     observers.surface_added(surface);
@@ -249,7 +310,7 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
 
     bool found_surface = false;
     {
-        RecursiveWriteLock lg(guard);
+        std::lock_guard lg(guard);
 
         for (auto& layer : surface_layers)
         {
@@ -265,6 +326,11 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
             }
         }
 
+        if (found_surface)
+        {
+            stacking_order_changed();
+        }
+
         std::erase_if(focus_order, [&](auto const& s)
         {
             return s.lock() == keep_alive;
@@ -279,37 +345,19 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
     // TODO: error logging when surface not found
 }
 
-namespace
-{
-template <typename Container>
-struct InReverse {
-    Container& container;
-    auto begin() -> decltype(container.rbegin()) { return container.rbegin(); }
-    auto end() -> decltype(container.rend()) { return container.rend(); }
-};
-
-template <typename Container>
-InReverse<Container> in_reverse(Container& container) { return InReverse<Container>{container}; }
-}
-
 auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
 -> std::shared_ptr<Surface>
 {
-    RecursiveReadLock lg(guard);
-    for (auto const& layer : in_reverse(surface_layers))
-    {
-        for (auto const& surface : in_reverse(layer))
+    return spatial_index.topmost_at(
+        cursor,
+        [this, cursor](std::shared_ptr<Surface> const& surface)
         {
             // TODO There's a lack of clarity about how the input area will
             // TODO be maintained and whether this test will detect clicks on
             // TODO decorations (it should) as these may be outside the area
             // TODO known to the client.  But it works for now.
-            if (surface_can_be_shown(surface) && surface->input_area_contains(cursor))
-                    return surface;
-        }
-    }
-
-    return {};
+            return surface_can_be_shown(surface) && surface->input_area_contains(cursor);
+        });
 }
 
 auto ms::SurfaceStack::input_surface_at(geometry::Point point) const -> std::shared_ptr<input::Surface>
@@ -322,7 +370,7 @@ void ms::SurfaceStack::raise(Surface const* surface)
     SurfaceSet affected_surfaces;
 
     {
-        RecursiveWriteLock ul(guard);
+        std::lock_guard ul(guard);
         for (auto& layer : surface_layers)
         {
             auto const p = std::find_if(
@@ -339,6 +387,7 @@ void ms::SurfaceStack::raise(Surface const* surface)
                 layer.erase(p);
                 insert_surface_at_top_of_depth_layer(surface_shared);
                 affected_surfaces.insert(surface_shared);
+                stacking_order_changed();
                 break;
             }
         }
@@ -364,7 +413,7 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
 {
     bool surfaces_reordered{false};
     {
-        RecursiveWriteLock ul(guard);
+        std::lock_guard ul(guard);
         for (auto& layer : surface_layers)
         {
             auto const old_layer = layer;
@@ -389,6 +438,9 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
             if (old_layer != layer)
                 surfaces_reordered = true;
         }
+
+        if (surfaces_reordered)
+            stacking_order_changed();
     }
 
     if (surfaces_reordered)
@@ -400,7 +452,7 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
 void ms::SurfaceStack::swap_z_order(SurfaceSet const& first, SurfaceSet const& second)
 {
     {
-        RecursiveWriteLock ul(guard);
+        std::lock_guard ul(guard);
         for (auto& layer : surface_layers)
         {
             // The goal is to swap the first set with the second set such that their Z-order is swapped.
@@ -455,6 +507,8 @@ void ms::SurfaceStack::swap_z_order(SurfaceSet const& first, SurfaceSet const& s
                     return to_back.count(s2) == 0;
             });
         }
+
+        stacking_order_changed();
     }
 
     observers.surfaces_reordered(first);
@@ -465,7 +519,7 @@ void ms::SurfaceStack::send_to_back(const mir::scene::SurfaceSet &ss)
 {
     bool surfaces_reordered{false};
     {
-        RecursiveWriteLock ul(guard);
+        std::lock_guard ul(guard);
         for (auto& layer : surface_layers)
         {
             // Only reorder if "layer" contains at least one surface
@@ -489,6 +543,9 @@ void ms::SurfaceStack::send_to_back(const mir::scene::SurfaceSet &ss)
                 surfaces_reordered = true;
             }
         }
+
+        if (surfaces_reordered)
+            stacking_order_changed();
     }
 
     if (surfaces_reordered)
@@ -499,7 +556,6 @@ void ms::SurfaceStack::send_to_back(const mir::scene::SurfaceSet &ss)
 
 auto ms::SurfaceStack::is_above(std::weak_ptr<scene::Surface> const& a, std::weak_ptr<scene::Surface> const& b) const -> bool
 {
-    RecursiveReadLock lg(guard);
     if (a.expired())
         return false;
     else if (b.expired())
@@ -512,12 +568,13 @@ auto ms::SurfaceStack::is_above(std::weak_ptr<scene::Surface> const& a, std::wea
     else if (shared_a->depth_layer() > shared_b->depth_layer())
         return true;
 
-    auto const& layer = surface_layers[shared_a->depth_layer()];
+    auto const scene = published.load();
+    auto const& layer = scene->surface_layers[shared_a->depth_layer()];
     bool found_b = false;
     for (auto const& entry : layer)
     {
-        if (entry == shared_b) found_b = true;
-        if (entry == shared_a) return found_b;
+        if (entry.surface == shared_b) found_b = true;
+        if (entry.surface == shared_a) return found_b;
     }
 
     return false;
@@ -527,15 +584,12 @@ void ms::SurfaceStack::create_rendering_tracker_for(std::shared_ptr<Surface> con
 {
     auto const tracker = std::make_shared<RenderingTracker>(surface);
 
-    RecursiveWriteLock ul(guard);
     tracker->active_compositors(registered_compositors);
     rendering_trackers[surface.get()] = tracker;
 }
 
 void ms::SurfaceStack::update_rendering_tracker_compositors()
 {
-    RecursiveReadLock ul(guard);
-
     for (auto const& pair : rendering_trackers)
         pair.second->active_compositors(registered_compositors);
 }
@@ -558,6 +612,31 @@ void ms::SurfaceStack::insert_surface_at_top_of_depth_layer(std::shared_ptr<Surf
     focus_order.push_back(surface);
 }
 
+void ms::SurfaceStack::stacking_order_changed()
+{
+    spatial_index.set_stacking_order(surface_layers);
+    publish();
+}
+
+void ms::SurfaceStack::publish()
+{
+    auto scene = std::make_shared<Snapshot>();
+
+    scene->surface_layers.reserve(surface_layers.size());
+    for (auto const& layer : surface_layers)
+    {
+        auto& stacked = scene->surface_layers.emplace_back();
+        stacked.reserve(layer.size());
+        for (auto const& surface : layer)
+        {
+            stacked.push_back({surface, rendering_trackers.at(surface.get())});
+        }
+    }
+    scene->overlays = overlays;
+
+    published.store(std::move(scene));
+}
+
 auto ms::SurfaceStack::surface_can_be_shown(std::shared_ptr<Surface> const& surface) const -> bool
 {
     return !is_locked || surface->visible_on_lock_screen();
@@ -570,9 +649,14 @@ void ms::SurfaceStack::add_observer(std::shared_ptr<ms::Observer> const& observe
     // Notify observer of existing surfaces.
     //
     // The surfaces are sent with the most-recently focused first and the
-    // least-recently focused last.
-    RecursiveReadLock lk(guard);
-    for (auto const& surface : std::ranges::reverse_view(focus_order))
+    // least-recently focused last. (The observer is notified without holding
+    // the guard, so it may call back into the stack.)
+    decltype(focus_order) existing;
+    {
+        std::lock_guard lk(guard);
+        existing = focus_order;
+    }
+    for (auto const& surface : std::ranges::reverse_view(existing))
     {
         if (auto const locked = surface.lock())
             observer->surface_exists(locked);
@@ -594,10 +678,10 @@ auto ms::SurfaceStack::stacking_order_of(SurfaceSet const& surfaces) const -> Su
 {
     SurfaceList result;
 
-    RecursiveReadLock lk(guard);
-    for (auto const& layer : surface_layers)
+    auto const scene = published.load();
+    for (auto const& layer : scene->surface_layers)
     {
-        for (auto const& surface : layer)
+        for (auto const& [surface, _] : layer)
         {
             if (surfaces.find(surface) != surfaces.end())
             {
@@ -23,9 +23,10 @@
 #include <mir/compositor/scene.h>
 #include <mir/scene/observer.h>
 #include <mir/input/scene.h>
-#include <mir/recursive_read_write_mutex.h>
 #include <mir/scene/session_lock.h>
 
+#include "surface_spatial_index.h"
+
 #include <mir/basic_observers.h>
 #include <mir/scene/surface_observer.h>
 #include <mir/observer_multiplexer.h>
@@ -33,11 +34,13 @@
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <vector>
 
 namespace mir
 {
+class RecyclingPool;
 class Executor;
 namespace graphics
 {
@@ -88,6 +91,7 @@ public:
 
     // From Scene
     compositor::SceneElementSequence scene_elements_for(compositor::CompositorID id) override;
+    void frame_presented(compositor::CompositorID id, graphics::FramePresentation const& presentation) override;
     void register_compositor(compositor::CompositorID id) override;
     void unregister_compositor(compositor::CompositorID id) override;
 
@@ -141,8 +145,33 @@ private:
     void update_rendering_tracker_compositors();
     void insert_surface_at_top_of_depth_layer(std::shared_ptr<Surface> const& surface);
     auto surface_can_be_shown(std::shared_ptr<Surface> const& surface) const -> bool;
+    /// Bring spatial_index into line with surface_layers and publish the result (call with guard held)
+    void stacking_order_changed();
+    /// Publish a snapshot of the current surface_layers, rendering_trackers and overlays (call with guard held)
+    void publish();
 
-    RecursiveReadWriteMutex mutable guard;
+    /**
+     * What compositors and input read: an immutable copy of the scene
+     *
+     * A new snapshot is built and published whenever the scene changes, so readers only need
+     * to load the latest one and never wait for (or hold up) a change in progress.
+     */
+    struct Snapshot
+    {
+        struct StackedSurface
+        {
+            std::shared_ptr<Surface> surface;
+            std::shared_ptr<RenderingTracker> tracker;
+        };
+
+        /// As surface_layers
+        std::vector<std::vector<StackedSurface>> surface_layers;
+        std::vector<std::shared_ptr<graphics::Renderable>> overlays;
+    };
+
+    /// Serialises changes to the scene; readers use the published snapshot instead
+    std::mutex mutable guard;
+    std::atomic<std::shared_ptr<Snapshot const>> published;
 
     std::shared_ptr<SceneReport> const report;
 
@@ -155,6 +184,9 @@ private:
      */
     std::vector<std::vector<std::shared_ptr<Surface>>> surface_layers;
 
+    /// Where the surfaces in surface_layers take input, so surface_at() needn't check every surface
+    SurfaceSpatialIndex spatial_index;
+
     /// Surface focus order that's maintained parallel to [surface_layers]. Whereas [surface_layers]
     /// provides a model of how the surface will be rendered into a scene, this list provides
     /// the relative focus order of surfaces, with the most-recently focused surfaces appearing at
@@ -166,6 +198,10 @@ private:
 
     std::vector<std::shared_ptr<graphics::Renderable>> overlays;
 
+    /// Storage recycled between the scene elements handed to compositors each frame
+    std::shared_ptr<RecyclingPool> const surface_element_pool;
+    std::shared_ptr<RecyclingPool> const overlay_element_pool;
+
     Observers observers;
     /// If not expired the screen is locked (and only surfaces that appear on the lock screen should be shown)
     std::atomic<bool> is_locked = false;
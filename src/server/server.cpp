@@ -539,6 +539,15 @@ void mir::Server::set_wayland_extension_policy(
     }
 }
 
+void mir::Server::set_pointer_motion_coalescing_policy(
+    std::function<bool(std::shared_ptr<scene::Session> const&)> const& policy)
+{
+    if (auto const config = self->server_config)
+    {
+        config->set_pointer_motion_coalescing_policy(policy);
+    }
+}
+
 auto mir::Server::open_client_wayland(ConnectHandler const& connect_handler) -> int
 {
     if (auto const config = self->server_config)
@@ -370,9 +370,13 @@ void msd::BasicDecoration::update(
         renderer_strategy->update_state(*window_state, *input_state);
     }
 
-    std::vector<std::pair<
-        std::shared_ptr<mc::BufferStream>,
-        std::optional<std::shared_ptr<mg::Buffer>>>> new_buffers;
+    struct Submission
+    {
+        std::shared_ptr<mc::BufferStream> stream;
+        std::optional<std::shared_ptr<mg::Buffer>> buffer;
+        std::optional<geom::Rectangles> damage{};   ///< std::nullopt if the whole buffer changed
+    };
+    std::vector<Submission> new_buffers;
 
     if (window_updated({
             &WindowState::focused_state,
@@ -380,12 +384,12 @@ void msd::BasicDecoration::update(
             &WindowState::side_border_height,
             &WindowState::scale}))
     {
-        new_buffers.emplace_back(
+        new_buffers.push_back({
             buffer_streams->left_border,
-            renderer_strategy->render_left_border());
-        new_buffers.emplace_back(
+            renderer_strategy->render_left_border()});
+        new_buffers.push_back({
             buffer_streams->right_border,
-            renderer_strategy->render_right_border());
+            renderer_strategy->render_right_border()});
     }
 
     if (window_updated({
@@ -394,9 +398,9 @@ void msd::BasicDecoration::update(
             &WindowState::bottom_border_height,
             &WindowState::scale}))
     {
-        new_buffers.emplace_back(
+        new_buffers.push_back({
             buffer_streams->bottom_border,
-            renderer_strategy->render_bottom_border());
+            renderer_strategy->render_bottom_border()});
     }
 
     if (window_updated({
@@ -407,18 +411,35 @@ void msd::BasicDecoration::update(
         input_updated({
             &InputState::buttons}))
     {
-        new_buffers.emplace_back(
+        auto titlebar = renderer_strategy->render_titlebar();
+        new_buffers.push_back({
             buffer_streams->titlebar,
-            renderer_strategy->render_titlebar());
+            std::move(titlebar),
+            renderer_strategy->titlebar_damage()});
     }
 
     float inv_scale = 1.0f / window_state->scale();
-    for (auto const& pair : new_buffers)
+    for (auto const& submission : new_buffers)
     {
-        if (pair.second)
-            pair.first->submit_buffer(
-                pair.second.value(),
-                pair.second.value()->size() * inv_scale,
-                {{0, 0}, geom::SizeD{pair.second.value()->size()}});
+        if (!submission.buffer)
+            continue;
+
+        auto const& buffer = submission.buffer.value();
+        if (submission.damage)
+        {
+            // Only part of the buffer changed (such as a button being hovered)
+            submission.stream->submit_buffer(
+                buffer,
+                buffer->size() * inv_scale,
+                {{0, 0}, geom::SizeD{buffer->size()}},
+                submission.damage.value());
+        }
+        else
+        {
+            submission.stream->submit_buffer(
+                buffer,
+                buffer->size() * inv_scale,
+                {{0, 0}, geom::SizeD{buffer->size()}});
+        }
     }
 }
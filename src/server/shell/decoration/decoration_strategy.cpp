@@ -30,11 +30,15 @@
 #include FT_FREETYPE_H
 #include <endian.h>
 
+#include <algorithm>
 #include <locale>
 #include <codecvt>
 #include <filesystem>
+#include <functional>
 #include <map>
 #include <mutex>
+#include <tuple>
+#include <vector>
 
 namespace ms = mir::scene;
 namespace geom = mir::geometry;
@@ -116,6 +120,32 @@ inline void render_row(
         *i = color;
 }
 
+/// Copies \a image into the buffer with its top left at \a top_left, clipped to the buffer
+inline void render_image(
+    uint32_t* const data,
+    geom::Size buf_size,
+    geom::Point top_left,
+    uint32_t const* image,
+    geom::Size image_size)
+{
+    geom::X const left = std::max(top_left.x, geom::X{});
+    geom::X const right = std::min(top_left.x + as_delta(image_size.width), as_x(buf_size.width));
+    geom::Y const top = std::max(top_left.y, geom::Y{});
+    geom::Y const bottom = std::min(top_left.y + as_delta(image_size.height), as_y(buf_size.height));
+    if (left >= right)
+        return;
+
+    for (geom::Y y = top; y < bottom; y += geom::DeltaY{1})
+    {
+        uint32_t const* const image_row =
+            image + (y - top_left.y).as_int() * image_size.width.as_int() + (left - top_left.x).as_int();
+        std::copy(
+            image_row,
+            image_row + (right - left).as_int(),
+            data + y.as_int() * buf_size.width.as_int() + left.as_int());
+    }
+}
+
 inline void render_close_icon(
     uint32_t* const data,
     geom::Size buf_size,
@@ -172,10 +202,58 @@ inline void render_minimize_icon(
     }
 }
 
+/// Rendered titlebar buttons, shared by all the decorations of a strategy
+class ButtonImages
+{
+public:
+    using Image = std::vector<msd::Pixel>;
+
+    /// The image of a button, drawn by \a draw (into an image of \a size) if it isn't already cached
+    auto image(
+        msd::Button::Function function,
+        bool active,
+        geom::Size size,
+        float scale,
+        std::function<void(Image&)> const& draw) -> std::shared_ptr<Image const>;
+
+private:
+    /// Enough for every button at a few sizes and scales; more than this and the cache is emptied
+    static size_t constexpr max_images{64};
+
+    std::mutex mutex;
+    std::map<std::tuple<msd::Button::Function, bool, int, int, float>, std::shared_ptr<Image const>> images;
+};
+
+auto ButtonImages::image(
+    msd::Button::Function function,
+    bool active,
+    geom::Size size,
+    float scale,
+    std::function<void(Image&)> const& draw) -> std::shared_ptr<Image const>
+{
+    auto const key = std::make_tuple(function, active, size.width.as_int(), size.height.as_int(), scale);
+
+    std::lock_guard lock{mutex};
+    if (auto const cached = images.find(key); cached != images.end())
+    {
+        return cached->second;
+    }
+
+    auto image = std::make_shared<Image>(area(size));
+    draw(*image);
+
+    if (images.size() >= max_images)
+    {
+        images.clear();
+    }
+    return images[key] = std::move(image);
+}
+
 struct RendererStrategy : public msd::RendererStrategy
 {
     RendererStrategy(
         std::shared_ptr<StaticGeometry> const& static_geometry,
+        std::shared_ptr<ButtonImages> const& button_images,
         std::shared_ptr<mir::graphics::GraphicBufferAllocator> const& allocator);
 
     void update_state(WindowState const& window_state, InputState const& input_state) override;
@@ -183,11 +261,13 @@ struct RendererStrategy : public msd::RendererStrategy
     auto render_left_border() -> std::optional<std::shared_ptr<mir::graphics::Buffer>> override;
     auto render_right_border() -> std::optional<std::shared_ptr<mir::graphics::Buffer>> override;
     auto render_bottom_border() -> std::optional<std::shared_ptr<mir::graphics::Buffer>> override;
+    auto titlebar_damage() const -> std::optional<geom::Rectangles> override;
 
 private:
     using Pixel = msd::Pixel;
 
     std::shared_ptr<StaticGeometry> const static_geometry;
+    std::shared_ptr<ButtonImages> const button_images;
 
     /// A visual theme for a decoration
     /// Focused and unfocused windows use a different theme
@@ -255,17 +335,53 @@ private:
     std::unique_ptr<Pixel[]> titlebar_pixels; // can be nullptr
 
     bool needs_titlebar_redraw{true};
-    bool needs_titlebar_buttons_redraw{true};
 
     std::vector<msd::Button> buttons;
 
+    /// What a titlebar looks like, given its size, the window name and the button layout
+    struct TitlebarAppearance
+    {
+        Theme const* theme;
+        std::vector<msd::Button::State> button_states;
+
+        auto operator==(TitlebarAppearance const&) const -> bool = default;
+    };
+
+    /// A buffer that has been handed out, and so must not be changed, but can be handed out again
+    template<typename Appearance>
+    struct Rendered
+    {
+        Appearance appearance;
+        std::shared_ptr<mir::graphics::Buffer> buffer;
+    };
+
+    /// Buffers are only reused while nothing but the appearance changes: keep the current and previous, for
+    /// toggling between two (e.g. focus, or hovering over a button)
+    static size_t constexpr max_rendered_titlebars{2};
+
+    std::optional<TitlebarAppearance> drawn_titlebar;      ///< What is drawn in titlebar_pixels
+    std::optional<TitlebarAppearance> submitted_titlebar;  ///< What the last render_titlebar() returned
+    std::optional<geom::Rectangles> submitted_titlebar_damage;
+    std::vector<Rendered<TitlebarAppearance>> rendered_titlebars;   ///< Most recently used first
+
+    /// A border's (scaled) size and color
+    using BorderAppearance = std::pair<geom::Size, Pixel>;
+
+    /// Borders of a size and color (the left and right border usually share one)
+    std::vector<Rendered<BorderAppearance>> rendered_borders;
+
     void update_solid_color_pixels();
 
     void set_focus_state(MirWindowFocusState focus_state);
 
+    /// The titlebar layout changed, so nothing drawn or rendered for it can be reused
+    void invalidate_titlebar();
+    auto titlebar_appearance() const -> TitlebarAppearance;
+    auto render_border(geom::Size size) -> std::optional<std::shared_ptr<mir::graphics::Buffer>>;
+
     void redraw_titlebar_background(geom::Size scaled_titlebar_size);
     void redraw_titlebar_text(geom::Size scaled_titlebar_size);
-    void redraw_titlebar_buttons(geom::Size scaled_titlebar_size);
+    void redraw_titlebar_button(geom::Size scaled_titlebar_size, msd::Button const& button);
 
     static auto alloc_pixels(geom::Size size) -> std::unique_ptr<Pixel[]>;
     auto make_buffer(MirPixelFormat, mir::geometry::Size, Pixel const* pixels) const
@@ -292,6 +408,7 @@ public:
 
 private:
     std::shared_ptr<mir::graphics::GraphicBufferAllocator> const allocator;
+    std::shared_ptr<ButtonImages> const button_images;
 };
 
 auto DecorationStrategy::resize_corner_input_size() const -> geom::Size
@@ -410,16 +527,33 @@ public:
         Pixel color) override;
 
 private:
+    /// A rasterized glyph, as FreeType rendered it
+    struct Glyph
+    {
+        geom::Displacement bearing;     ///< From the pen position to the top left of the bitmap
+        geom::Displacement advance;     ///< From the pen position to the next pen position
+        geom::Size size;
+        std::vector<unsigned char> alpha;   ///< Coverage of each pixel, row by row
+    };
+
+    /// Titles are mostly drawn from a small set of characters; more than this and the cache is emptied
+    static size_t constexpr max_cached_glyphs{1024};
+
     std::mutex mutex;
     FT_Library library;
     FT_Face face;
+    std::optional<geom::Height> char_size;
+
+    /// Every title is drawn in the one face, and the scale is part of the pixel height, so these identify a glyph
+    std::map<std::pair<int, char32_t>, Glyph> glyphs;
 
     void set_char_size(geom::Height height);
     void rasterize_glyph(char32_t glyph);
+    auto glyph_for(char32_t glyph, geom::Height height) -> Glyph const&;
     void render_glyph(
         Pixel* buf,
         geom::Size buf_size,
-        FT_Bitmap const* glyph,
+        Glyph const& glyph,
         geom::Point top_left,
         Pixel color);
 
@@ -515,34 +649,15 @@ void RendererStrategy::Text::Impl::render(
         return;
     }
 
-    try
-    {
-        set_char_size(height_pixels);
-    }
-    catch (std::runtime_error const& error)
-    {
-        mir::log_warning("%s", error.what());
-        return;
-    }
-
     auto const utf32 = utf8_to_utf32(text);
 
-    for (char32_t const glyph : utf32)
+    for (char32_t const character : utf32)
     {
         try
         {
-            rasterize_glyph(glyph);
-
-            geom::Point glyph_top_left =
-                top_left +
-                geom::Displacement{
-                    face->glyph->bitmap_left,
-                    height_pixels.as_int() - face->glyph->bitmap_top};
-            render_glyph(buf, buf_size, &face->glyph->bitmap, glyph_top_left, color);
-
-            top_left += geom::Displacement{
-                face->glyph->advance.x / 64,
-                face->glyph->advance.y / 64};
+            auto const& glyph = glyph_for(character, height_pixels);
+            render_glyph(buf, buf_size, glyph, top_left + glyph.bearing, color);
+            top_left += glyph.advance;
         }
         catch (std::runtime_error const& error)
         {
@@ -551,6 +666,41 @@ void RendererStrategy::Text::Impl::render(
     }
 }
 
+auto RendererStrategy::Text::Impl::glyph_for(char32_t character, geom::Height height) -> Glyph const&
+{
+    auto const key = std::make_pair(height.as_int(), character);
+    if (auto const cached = glyphs.find(key); cached != glyphs.end())
+    {
+        return cached->second;
+    }
+
+    if (char_size != height)
+    {
+        set_char_size(height);
+        char_size = height;
+    }
+    rasterize_glyph(character);
+
+    auto const& slot = *face->glyph;
+    Glyph glyph{
+        geom::Displacement{slot.bitmap_left, height.as_int() - slot.bitmap_top},
+        geom::Displacement{slot.advance.x / 64, slot.advance.y / 64},
+        geom::Size{slot.bitmap.width, slot.bitmap.rows},
+        {}};
+    glyph.alpha.reserve(area(glyph.size));
+    for (unsigned row = 0; row < slot.bitmap.rows; row++)
+    {
+        unsigned char const* const bitmap_row = slot.bitmap.buffer + static_cast<int>(row) * slot.bitmap.pitch;
+        glyph.alpha.insert(glyph.alpha.end(), bitmap_row, bitmap_row + slot.bitmap.width);
+    }
+
+    if (glyphs.size() >= max_cached_glyphs)
+    {
+        glyphs.clear();
+    }
+    return glyphs.emplace(key, std::move(glyph)).first->second;
+}
+
 void RendererStrategy::Text::Impl::set_char_size(geom::Height height)
 {
     if (auto const error = FT_Set_Pixel_Sizes(face, 0, height.as_int()))
@@ -594,15 +744,15 @@ void RendererStrategy::Text::Impl::rasterize_glyph(char32_t glyph)
 void RendererStrategy::Text::Impl::render_glyph(
     Pixel* buf,
     geom::Size buf_size,
-    FT_Bitmap const* glyph,
+    Glyph const& glyph,
     geom::Point top_left,
     Pixel color)
 {
     geom::X const buffer_left = std::max(top_left.x, geom::X{});
-    geom::X const buffer_right = std::min(top_left.x + geom::DeltaX{glyph->width}, as_x(buf_size.width));
+    geom::X const buffer_right = std::min(top_left.x + as_delta(glyph.size.width), as_x(buf_size.width));
 
     geom::Y const buffer_top = std::max(top_left.y, geom::Y{});
-    geom::Y const buffer_bottom = std::min(top_left.y + geom::DeltaY{glyph->rows}, as_y(buf_size.height));
+    geom::Y const buffer_bottom = std::min(top_left.y + as_delta(glyph.size.height), as_y(buf_size.height));
 
     geom::Displacement const glyph_offset = as_displacement(top_left);
 
@@ -612,7 +762,7 @@ void RendererStrategy::Text::Impl::render_glyph(
     for (geom::Y buffer_y = buffer_top; buffer_y < buffer_bottom; buffer_y += geom::DeltaY{1})
     {
         geom::Y const glyph_y = buffer_y - glyph_offset.dy;
-        unsigned char* const glyph_row = glyph->buffer + glyph_y.as_int() * glyph->pitch;
+        unsigned char const* const glyph_row = glyph.alpha.data() + glyph_y.as_int() * glyph.size.width.as_int();
         Pixel* const buffer_row = buf + buffer_y.as_int() * buf_size.width.as_int();
 
         for (geom::X buffer_x = buffer_left; buffer_x < buffer_right; buffer_x += geom::DeltaX{1})
@@ -668,8 +818,10 @@ auto RendererStrategy::Text::Impl::utf8_to_utf32(std::string const& text) -> std
 
 RendererStrategy::RendererStrategy(
     std::shared_ptr<StaticGeometry> const& static_geometry,
+    std::shared_ptr<ButtonImages> const& button_images,
     std::shared_ptr<mir::graphics::GraphicBufferAllocator> const& allocator) :
     static_geometry{static_geometry},
+    button_images{button_images},
     focused_theme{
         default_focused_background,
         default_focused_text},
@@ -707,16 +859,21 @@ void RendererStrategy::update_state(WindowState const& window_state, InputState
 
         needs_solid_color_redraw = true;
         solid_color_pixels.reset(); // force a reallocation next time it's needed
+        rendered_borders.clear();
 
-        needs_titlebar_redraw = true;
         titlebar_pixels.reset(); // force a reallocation next time it's needed
-
-        needs_titlebar_buttons_redraw = true;
+        invalidate_titlebar();
     }
 
-    left_border_size = window_state.left_border_rect().size;
-    right_border_size = window_state.right_border_rect().size;
-    bottom_border_size = window_state.bottom_border_rect().size;
+    if (window_state.left_border_rect().size != left_border_size ||
+        window_state.right_border_rect().size != right_border_size ||
+        window_state.bottom_border_rect().size != bottom_border_size)
+    {
+        left_border_size = window_state.left_border_rect().size;
+        right_border_size = window_state.right_border_rect().size;
+        bottom_border_size = window_state.bottom_border_rect().size;
+        rendered_borders.clear();
+    }
 
     size_t length{0};
     length = std::max(length, area(left_border_size));
@@ -736,6 +893,7 @@ void RendererStrategy::update_state(WindowState const& window_state, InputState
     {
         titlebar_size = window_state.titlebar_rect().size;
         titlebar_pixels.reset(); // force a reallocation next time it's needed
+        invalidate_titlebar();
     }
 
     auto const focus_state = window_state.focused_state();
@@ -744,27 +902,27 @@ void RendererStrategy::update_state(WindowState const& window_state, InputState
     if (window_state.window_name() != name)
     {
         name = window_state.window_name();
-        needs_titlebar_redraw = true;
+        invalidate_titlebar();
     }
 
     if (input_state.buttons != buttons)
     {
         // If the number of buttons or their location changed, redraw the whole titlebar
-        // Otherwise if the buttons are in the same place, just redraw them
+        // Otherwise if the buttons are in the same place, just the buttons that changed are redrawn
         if (input_state.buttons.size() != buttons.size())
         {
-            needs_titlebar_redraw = true;
+            invalidate_titlebar();
         }
         else
         {
             for (unsigned i = 0; i < buttons.size(); i++)
             {
-                if (input_state.buttons[i].rect != buttons[i].rect)
-                    needs_titlebar_redraw = true;
+                if (input_state.buttons[i].rect != buttons[i].rect ||
+                    input_state.buttons[i].function != buttons[i].function)
+                    invalidate_titlebar();
             }
         }
         buttons = input_state.buttons;
-        needs_titlebar_buttons_redraw = true;
     }
 }
 
@@ -775,55 +933,106 @@ auto RendererStrategy::render_titlebar() -> std::optional<std::shared_ptr<mir::g
     if (!area(scaled_titlebar_size))
         return std::nullopt;
 
-    if (!titlebar_pixels)
-    {
-        titlebar_pixels = alloc_pixels(scaled_titlebar_size);
-        needs_titlebar_redraw = true;
-    }
+    auto const appearance = titlebar_appearance();
 
-    if (needs_titlebar_redraw)
+    auto rendered = std::ranges::find(rendered_titlebars, appearance, &Rendered<TitlebarAppearance>::appearance);
+    if (rendered == rendered_titlebars.end())
     {
-        redraw_titlebar_background(scaled_titlebar_size);
+        if (!titlebar_pixels)
+        {
+            titlebar_pixels = alloc_pixels(scaled_titlebar_size);
+            needs_titlebar_redraw = true;
+        }
 
-        redraw_titlebar_text(scaled_titlebar_size);
+        if (needs_titlebar_redraw || !drawn_titlebar || drawn_titlebar->theme != appearance.theme)
+        {
+            redraw_titlebar_background(scaled_titlebar_size);
+            redraw_titlebar_text(scaled_titlebar_size);
+            for (auto const& button : buttons)
+            {
+                redraw_titlebar_button(scaled_titlebar_size, button);
+            }
+        }
+        else
+        {
+            for (unsigned i = 0; i < buttons.size(); i++)
+            {
+                if (buttons[i].state != drawn_titlebar->button_states[i])
+                    redraw_titlebar_button(scaled_titlebar_size, buttons[i]);
+            }
+        }
+
+        needs_titlebar_redraw = false;
+        drawn_titlebar = appearance;
+
+        auto const buffer = make_buffer(static_geometry->buffer_format, scaled_titlebar_size, titlebar_pixels.get());
+        if (!buffer)
+            return std::nullopt;
+
+        if (rendered_titlebars.size() >= max_rendered_titlebars)
+            rendered_titlebars.pop_back();
+        rendered = rendered_titlebars.insert(rendered_titlebars.begin(), {appearance, buffer.value()});
+    }
+    else
+    {
+        std::rotate(rendered_titlebars.begin(), rendered, rendered + 1);
+        rendered = rendered_titlebars.begin();
     }
 
-    if (needs_titlebar_redraw || needs_titlebar_buttons_redraw)
+    // Only the buttons changed since the last titlebar handed out, if the theme didn't change too
+    submitted_titlebar_damage.reset();
+    if (submitted_titlebar && submitted_titlebar->theme == appearance.theme)
     {
-        redraw_titlebar_buttons(scaled_titlebar_size);
+        submitted_titlebar_damage.emplace();
+        for (unsigned i = 0; i < buttons.size(); i++)
+        {
+            if (buttons[i].state != submitted_titlebar->button_states[i])
+                submitted_titlebar_damage->add(buttons[i].rect);
+        }
     }
+    submitted_titlebar = appearance;
 
-    needs_titlebar_redraw = false;
-    needs_titlebar_buttons_redraw = false;
+    return rendered->buffer;
+}
 
-    return make_buffer(static_geometry->buffer_format, scaled_titlebar_size, titlebar_pixels.get());
+auto RendererStrategy::titlebar_damage() const -> std::optional<geom::Rectangles>
+{
+    return submitted_titlebar_damage;
 }
 
 auto RendererStrategy::render_left_border() -> std::optional<std::shared_ptr<mir::graphics::Buffer>>
 {
-    auto const scaled_left_border_size{left_border_size * scale};
-    if (!area(scaled_left_border_size))
-        return std::nullopt;
-    update_solid_color_pixels();
-    return make_buffer(static_geometry->buffer_format, scaled_left_border_size, solid_color_pixels.get());
+    return render_border(left_border_size);
 }
 
 auto RendererStrategy::render_right_border() -> std::optional<std::shared_ptr<mir::graphics::Buffer>>
 {
-    auto const scaled_right_border_size{right_border_size * scale};
-    if (!area(scaled_right_border_size))
-        return std::nullopt;
-    update_solid_color_pixels();
-    return make_buffer(static_geometry->buffer_format, scaled_right_border_size, solid_color_pixels.get());
+    return render_border(right_border_size);
 }
 
 auto RendererStrategy::render_bottom_border() -> std::optional<std::shared_ptr<mir::graphics::Buffer>>
 {
-    auto const scaled_bottom_border_size{bottom_border_size * scale};
-    if (!area(scaled_bottom_border_size))
+    return render_border(bottom_border_size);
+}
+
+auto RendererStrategy::render_border(geom::Size size) -> std::optional<std::shared_ptr<mir::graphics::Buffer>>
+{
+    auto const scaled_size{size * scale};
+    if (!area(scaled_size))
         return std::nullopt;
+
+    BorderAppearance const appearance{scaled_size, current_theme->background_color};
+    if (auto const rendered = std::ranges::find(rendered_borders, appearance, &Rendered<BorderAppearance>::appearance);
+        rendered != rendered_borders.end())
+    {
+        return rendered->buffer;
+    }
+
     update_solid_color_pixels();
-    return make_buffer(static_geometry->buffer_format, scaled_bottom_border_size, solid_color_pixels.get());
+    auto const buffer = make_buffer(static_geometry->buffer_format, scaled_size, solid_color_pixels.get());
+    if (buffer)
+        rendered_borders.push_back({appearance, buffer.value()});
+    return buffer;
 }
 
 void RendererStrategy::update_solid_color_pixels()
@@ -845,6 +1054,23 @@ void RendererStrategy::update_solid_color_pixels()
     needs_solid_color_redraw = false;
 }
 
+void RendererStrategy::invalidate_titlebar()
+{
+    needs_titlebar_redraw = true;
+    rendered_titlebars.clear();
+    submitted_titlebar.reset();
+}
+
+auto RendererStrategy::titlebar_appearance() const -> TitlebarAppearance
+{
+    TitlebarAppearance appearance{current_theme, {}};
+    for (auto const& button : buttons)
+    {
+        appearance.button_states.push_back(button.state);
+    }
+    return appearance;
+}
+
 void RendererStrategy::redraw_titlebar_background(geom::Size const scaled_titlebar_size)
 {
     for (geom::Y y{0}; y < as_y(scaled_titlebar_size.height); y += geom::DeltaY{1})
@@ -869,46 +1095,49 @@ void RendererStrategy::redraw_titlebar_text(geom::Size const scaled_titlebar_siz
         current_theme->text_color);
 }
 
-void RendererStrategy::redraw_titlebar_buttons(geom::Size const scaled_titlebar_size)
+void RendererStrategy::redraw_titlebar_button(geom::Size const scaled_titlebar_size, msd::Button const& button)
 {
-    for (auto const& button : buttons)
+    geom::Rectangle scaled_button_rect{
+        geom::Point{
+            button.rect.left().as_value() * scale,
+            button.rect.top().as_value() * scale},
+        button.rect.size * scale};
+    auto const icon = button_icons.find(button.function);
+    if (icon == button_icons.end())
     {
-        geom::Rectangle scaled_button_rect{
-            geom::Point{
-                button.rect.left().as_value() * scale,
-                button.rect.top().as_value() * scale},
-            button.rect.size * scale};
-        auto const icon = button_icons.find(button.function);
-        if (icon != button_icons.end())
+        mir::log_warning("Could not render decoration button with unknown function %d\n", static_cast<int>(button.function));
+        return;
+    }
+
+    bool const active = button.state == msd::Button::Hovered;
+    auto const image = button_images->image(
+        button.function,
+        active,
+        scaled_button_rect.size,
+        scale,
+        [&](ButtonImages::Image& image)
         {
-            Pixel button_color = icon->second.normal_color;
-            if (button.state == msd::Button::Hovered)
-                button_color = icon->second.active_color;
-            for (geom::Y y{scaled_button_rect.top()}; y < scaled_button_rect.bottom(); y += geom::DeltaY{1})
-            {
-                render_row(
-                    titlebar_pixels.get(),
-                    scaled_titlebar_size,
-                    {scaled_button_rect.left(), y},
-                    scaled_button_rect.size.width,
-                    button_color);
-            }
+            auto const image_size = scaled_button_rect.size;
+            Pixel const button_color = active ? icon->second.active_color : icon->second.normal_color;
+            std::fill(image.begin(), image.end(), button_color);
             geom::Rectangle const icon_rect = {
-                scaled_button_rect.top_left + static_geometry->icon_padding * scale, {
-                    scaled_button_rect.size.width - static_geometry->icon_padding.dx * scale * 2,
-                    scaled_button_rect.size.height - static_geometry->icon_padding.dy * scale * 2}};
+                geom::Point{} + static_geometry->icon_padding * scale, {
+                    image_size.width - static_geometry->icon_padding.dx * scale * 2,
+                    image_size.height - static_geometry->icon_padding.dy * scale * 2}};
             icon->second.render_icon(
-                titlebar_pixels.get(),
-                scaled_titlebar_size,
+                image.data(),
+                image_size,
                 icon_rect,
                 static_geometry->icon_line_width * scale,
                 icon->second.icon_color);
-        }
-        else
-        {
-            mir::log_warning("Could not render decoration button with unknown function %d\n", static_cast<int>(button.function));
-        }
-    }
+        });
+
+    render_image(
+        titlebar_pixels.get(),
+        scaled_titlebar_size,
+        scaled_button_rect.top_left,
+        image->data(),
+        scaled_button_rect.size);
 }
 
 void RendererStrategy::set_focus_state(MirWindowFocusState focus_state)
@@ -919,8 +1148,8 @@ void RendererStrategy::set_focus_state(MirWindowFocusState focus_state)
 
     if (new_theme != current_theme)
     {
+        // The titlebar and borders are redrawn (unless already rendered in this theme) when next rendered
         current_theme = new_theme;
-        needs_titlebar_redraw = true;
         needs_solid_color_redraw = true;
     }
 }
@@ -958,7 +1187,8 @@ auto RendererStrategy::make_buffer(MirPixelFormat format, mir::geometry::Size si
 }
 
 DecorationStrategy::DecorationStrategy(std::shared_ptr<mir::graphics::GraphicBufferAllocator> const& allocator)
-    : allocator{allocator}
+    : allocator{allocator},
+      button_images{std::make_shared<ButtonImages>()}
 {
 }
 
@@ -982,7 +1212,7 @@ auto DecorationStrategy::static_geometry() const -> std::shared_ptr<StaticGeomet
 
 auto DecorationStrategy::render_strategy() const -> std::unique_ptr<mir::shell::decoration::RendererStrategy>
 {
-    return std::make_unique<::RendererStrategy>(static_geometry(), allocator);
+    return std::make_unique<::RendererStrategy>(static_geometry(), button_images, allocator);
 }
 
 auto DecorationStrategy::button_placement(unsigned n, const WindowState& ws) const -> geom::Rectangle
@@ -20,6 +20,7 @@
 #include <mir/geometry/displacement.h>
 #include <mir/geometry/point.h>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <mir/geometry/size.h>
 #include <mir_toolkit/client_types.h>
 
@@ -131,6 +132,10 @@ public:
     virtual auto render_left_border() -> std::optional<std::shared_ptr<graphics::Buffer>> = 0;
     virtual auto render_right_border() -> std::optional<std::shared_ptr<graphics::Buffer>> = 0;
     virtual auto render_bottom_border() -> std::optional<std::shared_ptr<graphics::Buffer>> = 0;
+
+    /// The area (in logical titlebar coordinates) that differs between the titlebar buffers returned by
+    /// the last two render_titlebar() calls, or std::nullopt if all of it may differ
+    virtual auto titlebar_damage() const -> std::optional<geometry::Rectangles> = 0;
 };
 
 /// Customization point for decorations
@@ -105,6 +105,32 @@ public:
         buf = b;
     }
 
+    /// Show \a b, which differs from the buffer with ID \a previous only in \a damage
+    void set_buffer(
+        std::shared_ptr<graphics::Buffer> b,
+        graphics::BufferID previous,
+        geometry::Rectangles const& damage)
+    {
+        buf = b;
+        damage_ = std::make_pair(previous, damage);
+    }
+
+    void set_allows_tearing(bool allowed)
+    {
+        tearing_allowed = allowed;
+    }
+
+    void set_clip_area(std::optional<geometry::Rectangle> const& area)
+    {
+        clip = area;
+    }
+
+    /// Sample only \a bounds of the buffer, as a wp_viewport source would
+    void set_src_bounds(std::optional<geometry::RectangleD> const& bounds)
+    {
+        src = bounds;
+    }
+
     std::shared_ptr<graphics::Buffer> buffer() const override
     {
         return buf;
@@ -117,12 +143,12 @@ public:
 
     geometry::RectangleD src_bounds() const override
     {
-        return {{0, 0}, buf->size()};
+        return src.value_or(geometry::RectangleD{{0, 0}, buf->size()});
     }
 
     std::optional<geometry::Rectangle> clip_area() const override
     {
-        return std::optional<geometry::Rectangle>();
+        return clip;
     }
 
     auto surface_if_any() const
@@ -136,12 +162,30 @@ public:
         return opaque_region_;
     }
 
+    auto allows_tearing() const -> bool override
+    {
+        return tearing_allowed;
+    }
+
+    auto damage_since(graphics::BufferID previous) const -> std::optional<geometry::Rectangles> override
+    {
+        if (damage_ && damage_->first == previous)
+        {
+            return damage_->second;
+        }
+        return std::nullopt;
+    }
+
 private:
     std::shared_ptr<graphics::Buffer> buf;
     mir::geometry::Rectangle rect;
     float opacity;
     bool rectangular;
     std::optional<mir::geometry::Rectangles> const opaque_region_;
+    bool tearing_allowed{false};
+    std::optional<geometry::Rectangle> clip;
+    std::optional<geometry::RectangleD> src;
+    std::optional<std::pair<graphics::BufferID, geometry::Rectangles>> damage_;
 };
 
 } // namespace doubles
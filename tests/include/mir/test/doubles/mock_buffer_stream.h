@@ -19,6 +19,7 @@
 
 #include <mir/compositor/buffer_stream.h>
 #include <mir/graphics/drm_formats.h>
+#include <mir/graphics/frame.h>
 #include <mir_toolkit/common.h>
 #include "stub_buffer.h"
 #include <gmock/gmock.h>
@@ -40,7 +41,7 @@ struct MockBufferStream : public compositor::BufferStream
     };
 
     int buffers_ready_{0};
-    std::function<void(geometry::Size const&)> frame_posted_callback;
+    std::function<void(geometry::Rectangle const&)> frame_posted_callback;
     int buffers_ready(void const*)
     {
         if (buffers_ready_)
@@ -71,14 +72,23 @@ struct MockBufferStream : public compositor::BufferStream
     std::shared_ptr<StubBuffer> buffer { std::make_shared<StubBuffer>() };
     std::shared_ptr<MockSubmission> submission { std::make_shared<testing::NiceMock<MockSubmission>>() };
     MOCK_METHOD(std::shared_ptr<Submission>, next_submission_for_compositor, (void const*), (override));
-    MOCK_METHOD(void, set_frame_posted_callback, (std::function<void(geometry::Size const&)> const&), (override));
+    MOCK_METHOD(void, set_frame_posted_callback, (std::function<void(geometry::Rectangle const&)> const&), (override));
+    MOCK_METHOD(void, set_frame_presented_callback, (std::function<void(graphics::FramePresentation const&)> const&), (override));
 
     MOCK_METHOD(
         void,
         submit_buffer,
         (std::shared_ptr<graphics::Buffer> const&, geometry::Size, geometry::RectangleD),
         (override));
+    MOCK_METHOD(
+        void,
+        submit_buffer,
+        (std::shared_ptr<graphics::Buffer> const&, geometry::Size, geometry::RectangleD, geometry::Rectangles const&),
+        (override));
     MOCK_METHOD(bool, has_submitted_buffer, (), (const override));
+    MOCK_METHOD(void, frame_presented, (graphics::FramePresentation const&), (override));
+    MOCK_METHOD(void, set_tearing_allowed, (bool), (override));
+    MOCK_METHOD(bool, tearing_allowed, (), (const override));
 };
 }
 }
@@ -36,6 +36,11 @@ public:
                  (compositor::CompositorReport::SubCompositorId, graphics::RenderableList const&), (override));
     MOCK_METHOD(void, rendered_frame, (compositor::CompositorReport::SubCompositorId), (override));
     MOCK_METHOD(void, finished_frame, (compositor::CompositorReport::SubCompositorId), (override));
+    MOCK_METHOD(void, presented_frame,
+                 (compositor::CompositorReport::SubCompositorId, graphics::FramePresentation const&), (override));
+    MOCK_METHOD(void, frame_phase,
+                 (compositor::CompositorReport::SubCompositorId, compositor::CompositorReport::FramePhase,
+                  std::chrono::nanoseconds), (override));
     MOCK_METHOD(void, started, (), (override));
     MOCK_METHOD(void, stopped, (), (override));
     MOCK_METHOD(void, scheduled, (), (override));
@@ -41,9 +41,12 @@ public:
     MOCK_METHOD(geometry::Rectangle, view_area, (), (const override));
     MOCK_METHOD(geometry::Size, pixel_size, (), (const override));
     MOCK_METHOD(bool, overlay, (std::vector<graphics::DisplayElement> const&), (override));
+    MOCK_METHOD(std::vector<bool>, overlay_where_possible, (std::vector<graphics::DisplayElement> const&), (override));
     MOCK_METHOD(void, set_next_image, (std::unique_ptr<graphics::Framebuffer>), (override));
     MOCK_METHOD(glm::mat2, transformation, (), (const override));
     MOCK_METHOD(graphics::DisplayAllocator*, maybe_create_allocator, (graphics::DisplayAllocator::Tag const&), (override));
+    MOCK_METHOD(std::optional<graphics::FramePresentation>, last_presentation, (), (const override));
+    MOCK_METHOD(std::optional<graphics::ScanoutFormats>, scanout_formats, (), (const override));
 };
 
 }
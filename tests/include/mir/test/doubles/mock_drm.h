@@ -26,6 +26,7 @@
 #include <xf86drm.h>
 #include <xf86drmMode.h>
 #include <unordered_map>
+#include <vector>
 
 namespace mir
 {
@@ -82,6 +83,17 @@ private:
     std::vector<uint32_t> connector_encoder_ids;
 };
 
+/// A property set in an atomic request
+struct AtomicProperty
+{
+    uint32_t object_id;
+    uint32_t property_id;
+    uint64_t value;
+};
+
+/// The properties added to \a req, in the order they were added
+auto atomic_request_properties(drmModeAtomicReqPtr req) -> std::vector<AtomicProperty>;
+
 class MockDRM
 {
 public:
@@ -132,6 +144,11 @@ public:
     MOCK_METHOD(drmModePropertyPtr, drmModeGetProperty, (int fd, uint32_t propertyId));
     MOCK_METHOD(void, drmModeFreeProperty, (drmModePropertyPtr));
     MOCK_METHOD(int, drmModeConnectorSetProperty, (int fd, uint32_t connector_id, uint32_t property_id, uint64_t value));
+    MOCK_METHOD(int, drmModeCreatePropertyBlob, (int fd, void const* data, size_t size, uint32_t* id));
+    MOCK_METHOD(int, drmModeDestroyPropertyBlob, (int fd, uint32_t id));
+
+    // Atomic requests themselves are real enough to inspect with atomic_request_properties()
+    MOCK_METHOD(int, drmModeAtomicCommit, (int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data));
 
     MOCK_METHOD(int, drmGetMagic, (int fd, drm_magic_t *magic));
     MOCK_METHOD(int, drmAuthMagic, (int fd, drm_magic_t magic));
@@ -32,6 +32,10 @@ public:
     MOCK_METHOD(std::unique_ptr<graphics::Framebuffer>, commit, (), (override));
     MOCK_METHOD(mir::geometry::Size, size, (), (const override));
     MOCK_METHOD(Layout, layout, (), (const override));
+    MOCK_METHOD(int, buffer_age, (), (const override));
+    MOCK_METHOD(void, set_damage, (std::optional<geometry::Rectangle> const&), (override));
+    MOCK_METHOD(bool, has_pending_frame, (), (const override));
+    MOCK_METHOD(void, discard_pending_frame, (), (override));
 };
 }
 
@@ -35,6 +35,7 @@ struct MockRenderer : public renderer::Renderer
     MOCK_METHOD(void, set_output_filter, (MirOutputFilter filter));
     MOCK_METHOD(std::unique_ptr<graphics::Framebuffer>, render, (graphics::RenderableList const&), (const override));
     MOCK_METHOD(void, suspend, ());
+    MOCK_METHOD(bool, has_pending_frame, (), (const override));
 
     ~MockRenderer() noexcept {}
 };
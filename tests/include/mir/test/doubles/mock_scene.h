@@ -18,6 +18,7 @@
 #define MIR_TEST_DOUBLES_MOCK_SCENE_H_
 
 #include <mir/compositor/scene.h>
+#include <mir/graphics/frame.h>
 #include <gmock/gmock.h>
 
 namespace mir
@@ -39,6 +40,7 @@ public:
     MOCK_METHOD(compositor::SceneElementSequence, scene_elements_for, (compositor::CompositorID), (override));
     MOCK_METHOD(void, register_compositor, (compositor::CompositorID), (override));
     MOCK_METHOD(void, unregister_compositor, (compositor::CompositorID), (override));
+    MOCK_METHOD(void, frame_presented, (compositor::CompositorID, graphics::FramePresentation const&), (override));
 
     MOCK_METHOD(void, add_observer, (std::shared_ptr<scene::Observer> const&), (override));
     MOCK_METHOD(void, remove_observer, (std::weak_ptr<scene::Observer> const&), (override));
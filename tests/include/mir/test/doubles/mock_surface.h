@@ -77,6 +77,8 @@ struct MockSurface : public scene::BasicSurface
     MOCK_METHOD(void, register_interest, (std::weak_ptr<scene::SurfaceObserver> const&));
     MOCK_METHOD(void, unregister_interest, (scene::SurfaceObserver const&));
     MOCK_METHOD(void, consume, (std::shared_ptr<MirEvent const> const& event));
+    MOCK_METHOD(void, frame_presented, (graphics::FramePresentation const&));
+    MOCK_METHOD(void, set_scanout_formats, (std::optional<graphics::ScanoutFormats> const&));
 
     MOCK_METHOD(std::list<scene::StreamInfo>, get_streams, (), (const));
     MOCK_METHOD(void, set_streams, (std::list<scene::StreamInfo> const&));
@@ -34,7 +34,10 @@ public:
 
     auto supported_pixel_formats() -> std::vector<MirPixelFormat> override;
 
-    void bind_display(wl_display*, std::shared_ptr<mir::Executor>) override;
+    void bind_display(
+        wl_display*,
+        std::shared_ptr<mir::Executor>,
+        std::shared_ptr<graphics::SurfaceScanoutHints>) override;
 
     void unbind_display(wl_display*) override;
 
@@ -81,8 +81,20 @@ public:
     {
         if (b) ++nready;
     }
-    void set_frame_posted_callback(std::function<void(geometry::Size const&)> const&) override {}
+    void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& b,
+        geometry::Size /*dst_size*/,
+        geometry::RectangleD /*src_bounds*/,
+        geometry::Rectangles const& /*damage*/) override
+    {
+        if (b) ++nready;
+    }
+    void set_frame_posted_callback(std::function<void(geometry::Rectangle const&)> const&) override {}
+    void set_frame_presented_callback(std::function<void(graphics::FramePresentation const&)> const&) override {}
     bool has_submitted_buffer() const override { return true; }
+    void frame_presented(graphics::FramePresentation const&) override {}
+    void set_tearing_allowed(bool) override {}
+    auto tearing_allowed() const -> bool override { return false; }
 
     std::shared_ptr<graphics::Buffer> stub_compositor_buffer;
     int nready = 0;
@@ -40,6 +40,9 @@ public:
     void unregister_compositor(compositor::CompositorID) override
     {
     }
+    void frame_presented(compositor::CompositorID, graphics::FramePresentation const&) override
+    {
+    }
     void add_observer(std::shared_ptr<scene::Observer> const&) override
     {
     }
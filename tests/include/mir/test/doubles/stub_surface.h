@@ -52,6 +52,8 @@ struct StubSurface : scene::Surface
     void set_transformation(glm::mat4 const&) override {}
     bool visible() const override { return false; }
     graphics::RenderableList generate_renderables(compositor::CompositorID) const override { return {}; }
+    void frame_presented(graphics::FramePresentation const&) override {}
+    void set_scanout_formats(std::optional<graphics::ScanoutFormats> const&) override {}
     MirWindowType type() const override { return mir_window_type_normal; }
     auto state_tracker() const -> scene::SurfaceStateTracker override
     {
@@ -409,6 +409,14 @@ mtd::MockDRM::MockDRM()
                     return 0;
                 })));
 
+    ON_CALL(*this, drmModeCreatePropertyBlob(_, _, _, _))
+        .WillByDefault(
+            [next_blob_id = uint32_t{1000}](auto, auto, auto, uint32_t* id) mutable
+            {
+                *id = next_blob_id++;
+                return 0;
+            });
+
     ON_CALL(*this, drmGetCap(_, DRM_CAP_DUMB_BUFFER, _))
         .WillByDefault(
             [](auto, auto, uint64_t* value)
@@ -547,6 +555,16 @@ testing::Matcher<int> mtd::IsFdOfDevice(char const* device)
     return ::testing::MakeMatcher(new mtd::MockDRM::IsFdOfDeviceMatcher(device));
 }
 
+struct _drmModeAtomicReq
+{
+    std::vector<mtd::AtomicProperty> properties;
+};
+
+auto mtd::atomic_request_properties(drmModeAtomicReqPtr req) -> std::vector<AtomicProperty>
+{
+    return req->properties;
+}
+
 // The signature of drmModeCrtcSetGamma() changes from passing the gamma as `uint16_t*` to `uint16_t const*`
 // We need to provide a definition that matches
 namespace
@@ -664,6 +682,37 @@ drmModePropertyPtr drmModeGetProperty(int fd, uint32_t propertyId)
     return global_mock->drmModeGetProperty(fd, propertyId);
 }
 
+int drmModeCreatePropertyBlob(int fd, void const* data, size_t size, uint32_t* id)
+{
+    return global_mock->drmModeCreatePropertyBlob(fd, data, size, id);
+}
+
+int drmModeDestroyPropertyBlob(int fd, uint32_t id)
+{
+    return global_mock->drmModeDestroyPropertyBlob(fd, id);
+}
+
+drmModeAtomicReqPtr drmModeAtomicAlloc()
+{
+    return new _drmModeAtomicReq;
+}
+
+void drmModeAtomicFree(drmModeAtomicReqPtr req)
+{
+    delete req;
+}
+
+int drmModeAtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value)
+{
+    req->properties.push_back({object_id, property_id, value});
+    return static_cast<int>(req->properties.size());
+}
+
+int drmModeAtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data)
+{
+    return global_mock->drmModeAtomicCommit(fd, req, flags, user_data);
+}
+
 int drmModeConnectorSetProperty(int fd, uint32_t connector_id, uint32_t property_id, uint64_t value)
 {
     return global_mock->drmModeConnectorSetProperty(fd, connector_id, property_id, value);
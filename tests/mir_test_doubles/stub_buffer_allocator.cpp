@@ -42,7 +42,10 @@ auto mtd::StubBufferAllocator::supported_pixel_formats() -> std::vector<MirPixel
     return { mir_pixel_format_argb_8888 };
 }
 
-void mtd::StubBufferAllocator::bind_display(wl_display*, std::shared_ptr<mir::Executor>)
+void mtd::StubBufferAllocator::bind_display(
+    wl_display*,
+    std::shared_ptr<mir::Executor>,
+    std::shared_ptr<mg::SurfaceScanoutHints>)
 {
 }
 
@@ -0,0 +1,65 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "allocation_counting.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace mt = mir::test;
+
+namespace
+{
+std::atomic<bool> counting_allocations{false};
+std::atomic<std::size_t> allocations{0};
+}
+
+// Count every heap allocation made while counting_allocations is set
+void* operator new(std::size_t size)
+{
+    if (counting_allocations)
+    {
+        ++allocations;
+    }
+    if (auto const p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void mt::start_counting_allocations()
+{
+    allocations = 0;
+    counting_allocations = true;
+}
+
+auto mt::stop_counting_allocations() -> std::size_t
+{
+    counting_allocations = false;
+    return allocations;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_TEST_ALLOCATION_COUNTING_H_
+#define MIR_TEST_ALLOCATION_COUNTING_H_
+
+#include <cstddef>
+
+namespace mir
+{
+namespace test
+{
+/**
+ * Count the heap allocations (on any thread) from now until stop_counting_allocations()
+ *
+ * Counting works by replacing the global operator new, so executables using this need to be kept separate
+ * from other tests.
+ */
+void start_counting_allocations();
+
+/// Stop counting heap allocations, returning the number made since start_counting_allocations()
+auto stop_counting_allocations() -> std::size_t;
+}
+}
+
+#endif // MIR_TEST_ALLOCATION_COUNTING_H_
@@ -0,0 +1,330 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "microbenchmark.h"
+
+#include "src/server/compositor/occlusion.h"
+#include "src/server/compositor/multi_monitor_arbiter.h"
+#include "src/platforms/common/server/cpu_copy_output_surface.h"
+#include "src/platforms/common/server/shm_buffer.h"
+
+#include <mir/graphics/egl_context_executor.h>
+#include <mir/graphics/egl_error.h>
+#include <mir/graphics/egl_extensions.h>
+#include <mir/renderer/gl/context.h>
+#include <mir/renderers/gl/renderer.h>
+#include <mir/renderers/software/renderer.h>
+#include <mir/renderer/sw/pixel_source.h>
+#include <mir/test/doubles/fake_renderable.h>
+#include <mir/test/doubles/null_gl_config.h>
+#include <mir/test/doubles/stub_buffer.h>
+#include <mir/test/doubles/stub_display_sink.h>
+#include <mir/test/doubles/stub_gl_rendering_provider.h>
+#include <mir/test/doubles/stub_scene_element.h>
+
+#include <boost/throw_exception.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mgc = mir::graphics::common;
+namespace mrs = mir::renderer::software;
+namespace mtb = mir::test::benchmark;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Rectangle const output_area{{0, 0}, {1920, 1080}};
+
+/// Overlapping windows spread over the output, as a busy desktop might have them
+auto window_area(int i) -> geom::Rectangle
+{
+    return {{(i * 37) % 1280, (i * 23) % 600}, {640, 480}};
+}
+
+void split_occluded_and_exposed(mtb::State& state)
+{
+    auto const windows = state.parameter("windows");
+
+    mc::SceneElementSequence elements;
+    for (auto i = 0; i != windows; ++i)
+    {
+        elements.push_back(
+            std::make_shared<mtd::StubSceneElement>(std::make_shared<mtd::FakeRenderable>(window_area(i))));
+    }
+
+    while (state.keep_running())
+    {
+        // The compositor hands over its snapshot; copying the sequence stands in for taking one
+        auto snapshot = elements;
+        mc::split_occluded_and_exposed(std::move(snapshot), output_area);
+    }
+}
+
+void multi_monitor_arbiter_acquire(mtb::State& state)
+{
+    auto const outputs = state.parameter("outputs");
+
+    auto const arbiter = std::make_shared<mc::MultiMonitorArbiter>();
+    std::vector<std::shared_ptr<mg::Buffer>> const buffers{
+        std::make_shared<mtd::StubBuffer>(),
+        std::make_shared<mtd::StubBuffer>(),
+        std::make_shared<mtd::StubBuffer>()};
+    std::vector<int> compositor_ids(outputs);
+
+    uint64_t frame{0};
+    while (state.keep_running())
+    {
+        // A client submits a new frame, which every output then picks up
+        auto const& buffer = buffers[frame++ % buffers.size()];
+        arbiter->submit_buffer(buffer, buffer->size(), {{0, 0}, geom::SizeD{buffer->size()}});
+
+        for (auto const& id : compositor_ids)
+        {
+            arbiter->compositor_acquire(&id)->claim_buffer();
+        }
+    }
+}
+
+/// Windows whose clients draw with shm buffers
+class ShmClients
+{
+public:
+    explicit ShmClients(int windows)
+    {
+        for (auto i = 0; i != windows; ++i)
+        {
+            renderables.push_back(std::make_shared<mtd::FakeRenderable>(geom::Rectangle{window_area(i).top_left, window_size}));
+            content.emplace_back(window_size.width.as_int() * window_size.height.as_int(), 0xff000000 | (i * 0x010203));
+            renderable_list.push_back(renderables.back());
+        }
+    }
+
+    /// Every client draws a new frame into a new buffer from its shm pool
+    void draw_new_frames()
+    {
+        auto const row_bytes = window_size.width.as_int() * sizeof(uint32_t);
+        for (auto i = 0u; i != renderables.size(); ++i)
+        {
+            auto const buffer = std::make_shared<mgc::MemoryBackedShmBuffer>(window_size, mir_pixel_format_argb_8888);
+            auto const mapping = buffer->map_writeable();
+            for (auto y = 0; y != window_size.height.as_int(); ++y)
+            {
+                std::memcpy(
+                    mapping->data() + y * mapping->stride().as_int(),
+                    content[i].data() + y * window_size.width.as_int(),
+                    row_bytes);
+            }
+            renderables[i]->set_buffer(buffer);
+        }
+    }
+
+    mg::RenderableList renderable_list;
+
+private:
+    geom::Size const window_size{256, 256};
+    std::vector<std::shared_ptr<mtd::FakeRenderable>> renderables;
+    std::vector<std::vector<uint32_t>> content;
+};
+
+/**
+ * Composite shm buffers with the software renderer: the path that, without a GPU,
+ * uploads client content to the screen.
+ *
+ * Compare with shm_gl_composite, which does the same with GL on llvmpipe.
+ */
+void shm_software_composite(mtb::State& state)
+{
+    ShmClients clients{state.parameter("windows")};
+
+    mtd::DummyCPUAddressableDisplayAllocator allocator{output_area.size};
+    mrs::Renderer renderer{allocator};
+    renderer.set_viewport(output_area);
+
+    while (state.keep_running())
+    {
+        state.pause_timing();
+        clients.draw_new_frames();
+        state.resume_timing();
+
+        renderer.render(clients.renderable_list);
+    }
+}
+
+/// A display on Mesa's surfaceless EGL platform, rendered by llvmpipe; EGL_NO_DISPLAY if there is none
+auto llvmpipe_display() -> EGLDisplay
+{
+    static EGLDisplay const dpy = []
+        {
+            if (!mg::has_egl_client_extension("EGL_EXT_platform_base") ||
+                !mg::has_egl_client_extension("EGL_MESA_platform_surfaceless"))
+            {
+                return EGL_NO_DISPLAY;
+            }
+
+            // Mesa would otherwise use a GPU, if there is one
+            setenv("LIBGL_ALWAYS_SOFTWARE", "1", true);
+
+            mg::EGLExtensions ext;
+            auto const dpy = ext.platform_base->eglGetPlatformDisplay(
+                EGL_PLATFORM_SURFACELESS_MESA,
+                EGL_DEFAULT_DISPLAY,
+                nullptr);
+            EGLint major, minor;
+            if (dpy == EGL_NO_DISPLAY || eglInitialize(dpy, &major, &minor) != EGL_TRUE)
+            {
+                return EGL_NO_DISPLAY;
+            }
+            return dpy;
+        }();
+    return dpy;
+}
+
+class SurfacelessEGLContext : public mir::renderer::gl::Context
+{
+public:
+    SurfacelessEGLContext(EGLDisplay dpy, EGLContext share_with)
+        : dpy{dpy},
+          ctx{create_context(dpy, share_with)}
+    {
+    }
+
+    ~SurfacelessEGLContext() override
+    {
+        eglDestroyContext(dpy, ctx);
+    }
+
+    void make_current() const override
+    {
+        if (eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx) != EGL_TRUE)
+        {
+            BOOST_THROW_EXCEPTION(mg::egl_error("Failed to make context current"));
+        }
+    }
+
+    void release_current() const override
+    {
+        eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
+    auto make_share_context() const -> std::unique_ptr<Context> override
+    {
+        return std::make_unique<SurfacelessEGLContext>(dpy, ctx);
+    }
+
+    explicit operator EGLContext() override
+    {
+        return ctx;
+    }
+
+private:
+    static auto create_context(EGLDisplay dpy, EGLContext share_with) -> EGLContext
+    {
+        eglBindAPI(EGL_OPENGL_ES_API);
+        EGLint const attribs[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+        auto const ctx = eglCreateContext(dpy, EGL_NO_CONFIG_KHR, share_with, attribs);
+        if (ctx == EGL_NO_CONTEXT)
+        {
+            BOOST_THROW_EXCEPTION(mg::egl_error("Failed to create EGL context"));
+        }
+        return ctx;
+    }
+
+    EGLDisplay const dpy;
+    EGLContext const ctx;
+};
+
+/// Textures shm buffers as the EGL rendering platform does
+class ShmTextureProvider : public mtd::StubGlRenderingProvider
+{
+public:
+    explicit ShmTextureProvider(std::shared_ptr<mgc::EGLContextExecutor> egl_delegate)
+        : egl_delegate{std::move(egl_delegate)}
+    {
+    }
+
+    auto as_texture(std::shared_ptr<mg::Buffer> buffer) -> std::shared_ptr<mg::gl::Texture> override
+    {
+        std::shared_ptr<mg::NativeBufferBase> native_buffer{buffer, buffer->native_buffer_base()};
+        return std::dynamic_pointer_cast<mgc::ShmBuffer>(native_buffer)->texture_for_provider(egl_delegate, this);
+    }
+
+private:
+    std::shared_ptr<mgc::EGLContextExecutor> const egl_delegate;
+};
+
+/**
+ * Composite shm buffers with the GL renderer on llvmpipe, reading each frame back for a
+ * CPU-addressable display: the GL path without a GPU, to compare with shm_software_composite.
+ */
+void shm_gl_composite(mtb::State& state)
+{
+    auto const dpy = llvmpipe_display();
+    if (dpy == EGL_NO_DISPLAY || !mg::has_egl_extension(dpy, "EGL_KHR_no_config_context"))
+    {
+        state.skip_with_error("Needs a surfaceless EGL display with EGL_KHR_no_config_context");
+        return;
+    }
+
+    ShmClients clients{state.parameter("windows")};
+
+    SurfacelessEGLContext share_ctx{dpy, EGL_NO_CONTEXT};
+    auto const egl_delegate = std::make_shared<mgc::EGLContextExecutor>(share_ctx.make_share_context());
+    mtd::DummyCPUAddressableDisplayAllocator allocator{output_area.size};
+    mtd::NullGLConfig const gl_config;
+    mir::renderer::gl::Renderer renderer{
+        std::make_shared<ShmTextureProvider>(egl_delegate),
+        std::make_unique<mgc::CPUCopyOutputSurface>(
+            dpy,
+            static_cast<EGLContext>(share_ctx),
+            allocator,
+            gl_config,
+            mgc::OutputReadback::synchronous)};
+    renderer.set_viewport(output_area);
+
+    while (state.keep_running())
+    {
+        state.pause_timing();
+        clients.draw_new_frames();
+        state.resume_timing();
+
+        renderer.render(clients.renderable_list);
+    }
+}
+
+mtb::Registration const occlusion{
+    "compositor/split_occluded_and_exposed",
+    split_occluded_and_exposed,
+    mtb::scaled_by({{"windows", {1, 10, 100, 1000}}})};
+
+mtb::Registration const arbiter{
+    "compositor/MultiMonitorArbiter::compositor_acquire",
+    multi_monitor_arbiter_acquire,
+    mtb::scaled_by({{"outputs", {1, 2, 4}}})};
+
+mtb::Registration const shm_composite{
+    "compositor/shm_software_composite",
+    shm_software_composite,
+    mtb::scaled_by({{"windows", {1, 10, 50}}})};
+
+mtb::Registration const shm_gl_composite_on_llvmpipe{
+    "compositor/shm_gl_composite",
+    shm_gl_composite,
+    mtb::scaled_by({{"windows", {1, 10, 50}}})};
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "microbenchmark.h"
+
+#include "src/server/input/surface_input_dispatcher.h"
+#include "src/server/scene/surface_stack.h"
+#include "src/server/report/null_report_factory.h"
+
+#include <mir/events/event_builders.h>
+#include <mir/scene/basic_surface.h>
+#include <mir/compositor/stream.h>
+#include <mir/input/input_reception_mode.h>
+#include <mir/test/doubles/fake_display_configuration_observer_registrar.h>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mi = mir::input;
+namespace ms = mir::scene;
+namespace mr = mir::report;
+namespace mev = mir::events;
+namespace mtb = mir::test::benchmark;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+namespace
+{
+void dispatch_pointer_motion(mtb::State& state)
+{
+    auto const windows = state.parameter("windows");
+
+    auto const stack = std::make_shared<ms::SurfaceStack>(mr::null_scene_report());
+    std::vector<std::shared_ptr<ms::Surface>> surfaces;
+    for (auto i = 0; i != windows; ++i)
+    {
+        auto const surface = std::make_shared<ms::BasicSurface>(
+            "window",
+            geom::Rectangle{{(i * 37) % 1280, (i * 23) % 600}, {640, 480}},
+            mir_pointer_unconfined,
+            std::list<ms::StreamInfo>{{std::make_shared<mc::Stream>(), {}}},
+            std::shared_ptr<mg::CursorImage>{},
+            mr::null_scene_report(),
+            std::make_shared<mtd::FakeDisplayConfigurationObserverRegistrar>());
+        stack->add_surface(surface, mi::InputReceptionMode::normal);
+        surfaces.push_back(surface);
+    }
+
+    mi::SurfaceInputDispatcher dispatcher{stack};
+    dispatcher.start();
+
+    // A pointer sweeping diagonally across the output, entering and leaving windows
+    std::vector<std::shared_ptr<MirEvent const>> motion;
+    for (auto step = 0; step != 256; ++step)
+    {
+        motion.emplace_back(mev::make_pointer_event(
+            MirInputDeviceId{0}, std::chrono::nanoseconds{step},
+            0, mir_pointer_action_motion, 0,
+            step * 7.5f, step * 4.2f,
+            0, 0, 0, 0));
+    }
+
+    uint64_t event{0};
+    while (state.keep_running())
+    {
+        dispatcher.dispatch(motion[event++ % motion.size()]);
+    }
+
+    dispatcher.stop();
+    for (auto const& surface : surfaces)
+    {
+        stack->remove_surface(surface);
+    }
+}
+
+mtb::Registration const dispatch{
+    "input/SurfaceInputDispatcher::dispatch",
+    dispatch_pointer_motion,
+    mtb::scaled_by({{"windows", {1, 10, 100}}})};
+}
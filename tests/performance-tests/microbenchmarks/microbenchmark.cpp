@@ -0,0 +1,370 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "microbenchmark.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <stdexcept>
+#include <thread>
+
+#include <unistd.h>
+
+namespace mtb = mir::test::benchmark;
+
+namespace
+{
+struct Benchmark
+{
+    std::string name;
+    mtb::Function function;
+    std::vector<mtb::Parameters> runs;
+};
+
+auto registry() -> std::vector<Benchmark>&
+{
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+auto thread_cpu_time() -> std::chrono::nanoseconds
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds{ts.tv_sec} + std::chrono::nanoseconds{ts.tv_nsec};
+}
+
+auto full_name(std::string const& name, mtb::Parameters const& parameters) -> std::string
+{
+    auto result = name;
+    for (auto const& [parameter, value] : parameters)
+    {
+        result += "/" + parameter + ":" + std::to_string(value);
+    }
+    return result;
+}
+
+auto json_string(std::string const& text) -> std::string
+{
+    std::string result{"\""};
+    for (auto const c : text)
+    {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+    return result + "\"";
+}
+
+struct Result
+{
+    std::string name;
+    int family_index;
+    int instance_index;
+    uint64_t iterations;
+    double real_ns;     ///< Per iteration
+    double cpu_ns;      ///< Per iteration
+    std::vector<std::pair<std::string, double>> counters;
+    std::optional<std::string> error;
+};
+
+void write_json(std::ostream& out, char const* executable, std::vector<Result> const& results)
+{
+    char host[256]{};
+    gethostname(host, sizeof host - 1);
+
+    char date[64]{};
+    auto const now = std::time(nullptr);
+    tm local;
+    std::strftime(date, sizeof date, "%FT%T%z", localtime_r(&now, &local));
+
+    out << "{\n"
+        << "  \"context\": {\n"
+        << "    \"date\": " << json_string(date) << ",\n"
+        << "    \"host_name\": " << json_string(host) << ",\n"
+        << "    \"executable\": " << json_string(executable) << ",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+        << "    \"library_build_type\": \"release\"\n"
+#else
+        << "    \"library_build_type\": \"debug\"\n"
+#endif
+        << "  },\n"
+        << "  \"benchmarks\": [";
+
+    char const* separator = "\n";
+    for (auto const& result : results)
+    {
+        out << separator
+            << "    {\n"
+            << "      \"name\": " << json_string(result.name) << ",\n"
+            << "      \"family_index\": " << result.family_index << ",\n"
+            << "      \"per_family_instance_index\": " << result.instance_index << ",\n"
+            << "      \"run_name\": " << json_string(result.name) << ",\n"
+            << "      \"run_type\": \"iteration\",\n"
+            << "      \"repetitions\": 1,\n"
+            << "      \"repetition_index\": 0,\n"
+            << "      \"threads\": 1,\n"
+            << "      \"iterations\": " << result.iterations << ",\n"
+            << "      \"real_time\": " << result.real_ns << ",\n"
+            << "      \"cpu_time\": " << result.cpu_ns << ",\n";
+        if (result.error)
+        {
+            out << "      \"error_occurred\": true,\n"
+                << "      \"error_message\": " << json_string(*result.error) << ",\n";
+        }
+        for (auto const& [counter, value] : result.counters)
+        {
+            out << "      " << json_string(counter) << ": " << value << ",\n";
+        }
+        out
+            << "      \"time_unit\": \"ns\"\n"
+            << "    }";
+        separator = ",\n";
+    }
+    out << "\n  ]\n}\n";
+}
+
+/// Run \a benchmark with increasing iteration counts until it takes at least \a min_time
+auto measure(Benchmark const& benchmark, mtb::Parameters const& parameters, std::chrono::duration<double> min_time)
+    -> mtb::State
+{
+    uint64_t iterations{1};
+    for (;;)
+    {
+        mtb::State state{parameters, iterations};
+        benchmark.function(state);
+
+        if (state.error() || state.elapsed() >= min_time || iterations >= 1'000'000'000)
+            return state;
+
+        // Aim a little beyond the minimum, so we rarely need another attempt
+        auto const elapsed = std::max(std::chrono::duration<double>{state.elapsed()}.count(), 1e-9);
+        auto const multiplier = std::clamp(1.4 * min_time.count() / elapsed, 2.0, 100.0);
+        iterations = static_cast<uint64_t>(iterations * multiplier);
+    }
+}
+}
+
+mtb::State::State(Parameters const& parameters, uint64_t iterations)
+    : parameters{parameters},
+      total_iterations{iterations},
+      remaining{iterations}
+{
+}
+
+auto mtb::State::keep_running() -> bool
+{
+    if (!timing && remaining == total_iterations)
+    {
+        start_timing();
+    }
+
+    if (remaining == 0)
+    {
+        if (timing)
+            stop_timing();
+        return false;
+    }
+
+    --remaining;
+    return true;
+}
+
+auto mtb::State::parameter(std::string const& name) const -> int
+{
+    for (auto const& [parameter, value] : parameters)
+    {
+        if (parameter == name)
+            return value;
+    }
+
+    BOOST_THROW_EXCEPTION(std::logic_error{"Benchmark has no parameter \"" + name + "\""});
+}
+
+void mtb::State::set_counter(std::string const& name, double value)
+{
+    for (auto& [counter, current] : counters_)
+    {
+        if (counter == name)
+        {
+            current = value;
+            return;
+        }
+    }
+    counters_.emplace_back(name, value);
+}
+
+void mtb::State::skip_with_error(std::string const& message)
+{
+    if (timing)
+        stop_timing();
+    remaining = 0;
+    error_message = message;
+}
+
+void mtb::State::pause_timing()
+{
+    if (timing)
+        stop_timing();
+}
+
+void mtb::State::resume_timing()
+{
+    if (!timing)
+        start_timing();
+}
+
+void mtb::State::start_timing()
+{
+    timing = true;
+    cpu_start = thread_cpu_time();
+    real_start = std::chrono::steady_clock::now();
+}
+
+void mtb::State::stop_timing()
+{
+    elapsed_real += std::chrono::steady_clock::now() - real_start;
+    elapsed_thread_cpu += thread_cpu_time() - cpu_start;
+    timing = false;
+}
+
+auto mtb::scaled_by(std::vector<std::pair<std::string, std::vector<int>>> const& axes) -> std::vector<Parameters>
+{
+    std::vector<Parameters> result{{}};
+    for (auto const& [parameter, values] : axes)
+    {
+        std::vector<Parameters> scaled;
+        for (auto const& partial : result)
+        {
+            for (auto const value : values)
+            {
+                scaled.push_back(partial);
+                scaled.back().emplace_back(parameter, value);
+            }
+        }
+        result = std::move(scaled);
+    }
+    return result;
+}
+
+mtb::Registration::Registration(std::string const& name, Function const& function, std::vector<Parameters> const& runs)
+{
+    registry().push_back({name, function, runs});
+}
+
+auto mtb::run_benchmarks(int argc, char const* argv[]) -> int
+{
+    std::regex filter{".*"};
+    std::chrono::duration<double> min_time{0.5};
+    std::string json_file;
+    bool list_only{false};
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        std::string const arg{argv[i]};
+        auto const value_of = [&](char const* option) { return arg.substr(std::strlen(option)); };
+
+        if (arg.starts_with("--filter="))
+            filter = std::regex{value_of("--filter=")};
+        else if (arg.starts_with("--min-time="))
+            min_time = std::chrono::duration<double>{std::stod(value_of("--min-time="))};
+        else if (arg.starts_with("--json="))
+            json_file = value_of("--json=");
+        else if (arg == "--list")
+            list_only = true;
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--filter=REGEX] [--min-time=SECONDS] [--json=FILE] [--list]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!list_only)
+    {
+        std::printf("%-60s %17s %17s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+    }
+
+    std::vector<Result> results;
+    int family_index{0};
+    for (auto const& benchmark : registry())
+    {
+        int instance_index{0};
+        for (auto const& parameters : benchmark.runs)
+        {
+            auto const name = full_name(benchmark.name, parameters);
+            if (!std::regex_search(name, filter))
+                continue;
+
+            if (list_only)
+            {
+                std::cout << name << '\n';
+                continue;
+            }
+
+            auto const state = measure(benchmark, parameters, min_time);
+            auto const iterations = std::max(state.iterations(), uint64_t{1});
+            results.push_back({
+                name,
+                family_index,
+                instance_index++,
+                state.iterations(),
+                static_cast<double>(state.elapsed().count()) / iterations,
+                static_cast<double>(state.elapsed_cpu().count()) / iterations,
+                state.counters(),
+                state.error()});
+
+            if (state.error())
+            {
+                std::printf("%-60s SKIPPED: %s\n", name.c_str(), state.error()->c_str());
+                std::fflush(stdout);
+                continue;
+            }
+
+            std::printf(
+                "%-60s %14.0f ns %14.0f ns %12llu",
+                name.c_str(), results.back().real_ns, results.back().cpu_ns,
+                static_cast<unsigned long long>(state.iterations()));
+            for (auto const& [counter, value] : state.counters())
+            {
+                std::printf(" %s=%g", counter.c_str(), value);
+            }
+            std::printf("\n");
+            std::fflush(stdout);
+        }
+        ++family_index;
+    }
+
+    if (!json_file.empty())
+    {
+        std::ofstream out{json_file};
+        write_json(out, argv[0], results);
+        if (!out)
+        {
+            std::cerr << "Failed to write " << json_file << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_TEST_MICROBENCHMARK_H_
+#define MIR_TEST_MICROBENCHMARK_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mir
+{
+namespace test
+{
+namespace benchmark
+{
+/// The scaling parameters of one run of a benchmark, e.g. {{"windows", 100}, {"outputs", 2}}
+using Parameters = std::vector<std::pair<std::string, int>>;
+
+/**
+ * Controls the timed loop of a benchmark
+ *
+ * A benchmark does any setup, then repeats the operation being measured while
+ * keep_running() returns true:
+ * \code
+ *   while (state.keep_running())
+ *   {
+ *       do_the_thing();
+ *   }
+ * \endcode
+ */
+class State
+{
+public:
+    State(Parameters const& parameters, uint64_t iterations);
+
+    /// Whether to run (and time) another iteration
+    auto keep_running() -> bool;
+
+    /// The value of the scaling parameter \a name
+    auto parameter(std::string const& name) const -> int;
+
+    /// Exclude the work until resume_timing() (e.g. per-iteration setup) from the measurement
+    void pause_timing();
+    void resume_timing();
+
+    /// Report a figure other than time alongside the results (e.g. wakeups per frame)
+    void set_counter(std::string const& name, double value);
+
+    /// Give up on the benchmark (e.g. because the environment can't support it); keep_running() returns false
+    void skip_with_error(std::string const& message);
+
+    auto iterations() const -> uint64_t { return total_iterations; }
+    auto counters() const -> std::vector<std::pair<std::string, double>> const& { return counters_; }
+    auto elapsed() const -> std::chrono::nanoseconds { return elapsed_real; }
+    auto elapsed_cpu() const -> std::chrono::nanoseconds { return elapsed_thread_cpu; }
+    auto error() const -> std::optional<std::string> const& { return error_message; }
+
+private:
+    void start_timing();
+    void stop_timing();
+
+    Parameters const parameters;
+    uint64_t const total_iterations;
+    uint64_t remaining;
+    bool timing{false};
+
+    std::chrono::steady_clock::time_point real_start;
+    std::chrono::nanoseconds cpu_start{0};
+    std::chrono::nanoseconds elapsed_real{0};
+    std::chrono::nanoseconds elapsed_thread_cpu{0};
+
+    std::vector<std::pair<std::string, double>> counters_;
+    std::optional<std::string> error_message;
+};
+
+using Function = std::function<void(State& state)>;
+
+/// Every combination of the values given for each scaling parameter
+auto scaled_by(std::vector<std::pair<std::string, std::vector<int>>> const& axes) -> std::vector<Parameters>;
+
+/**
+ * Adds a benchmark to those run by run_benchmarks()
+ *
+ * Intended for static initialisation:
+ * \code
+ *   Registration const occlusion{"occlusion", benchmark_occlusion, scaled_by({{"windows", {1, 10, 100}}})};
+ * \endcode
+ */
+class Registration
+{
+public:
+    Registration(std::string const& name, Function const& function, std::vector<Parameters> const& runs = {{}});
+};
+
+/**
+ * Runs the registered benchmarks, as directed by the command line
+ *
+ *  --filter=REGEX     only run benchmarks whose full name (e.g. "occlusion/windows:100") matches
+ *  --min-time=SECS    run each benchmark for at least this long (default 0.5; 0 runs one iteration)
+ *  --json=FILE        also write the results to FILE in Google Benchmark's JSON format
+ *  --list             list the benchmarks, without running them
+ */
+auto run_benchmarks(int argc, char const* argv[]) -> int;
+}
+}
+}
+
+#endif // MIR_TEST_MICROBENCHMARK_H_
@@ -0,0 +1,138 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "microbenchmark.h"
+
+#include <mir/observer_multiplexer.h>
+#include <mir/thread_safe_list.h>
+
+#include <atomic>
+#include <thread>
+
+namespace mtb = mir::test::benchmark;
+
+namespace
+{
+class Observer
+{
+public:
+    virtual ~Observer() = default;
+
+    virtual void notified(int value) = 0;
+};
+
+struct Counter : Observer
+{
+    void notified(int value) override { total += value; }
+
+    int total{0};
+};
+
+class Multiplexer : public mir::ObserverMultiplexer<Observer>
+{
+public:
+    Multiplexer()
+        : ObserverMultiplexer{mir::immediate_executor}
+    {
+    }
+
+    void notified(int value) override
+    {
+        for_each_observer(&Observer::notified, value);
+    }
+};
+
+/// Notifying observers that make their observations immediately (as surface and cursor observers mostly do)
+void for_each_observer(mtb::State& state)
+{
+    Multiplexer multiplexer;
+    std::vector<std::shared_ptr<Counter>> observers;
+    for (auto i = 0; i != state.parameter("observers"); ++i)
+    {
+        observers.push_back(std::make_shared<Counter>());
+        multiplexer.register_interest(observers.back());
+    }
+
+    while (state.keep_running())
+    {
+        multiplexer.notified(1);
+    }
+}
+
+/**
+ * Notifying observers while another thread keeps adding and removing one
+ *
+ * The difference between real and CPU time is how long notifications spend waiting for the changes.
+ */
+void for_each_observer_while_registering(mtb::State& state)
+{
+    Multiplexer multiplexer;
+    std::vector<std::shared_ptr<Counter>> observers;
+    for (auto i = 0; i != state.parameter("observers"); ++i)
+    {
+        observers.push_back(std::make_shared<Counter>());
+        multiplexer.register_interest(observers.back());
+    }
+
+    std::atomic<bool> stop{false};
+    std::thread registrar{[&]
+        {
+            auto const transient = std::make_shared<Counter>();
+            while (!stop)
+            {
+                multiplexer.register_interest(transient);
+                multiplexer.unregister_interest(*transient);
+            }
+        }};
+
+    while (state.keep_running())
+    {
+        multiplexer.notified(1);
+    }
+
+    stop = true;
+    registrar.join();
+}
+
+void thread_safe_list_for_each(mtb::State& state)
+{
+    mir::ThreadSafeList<std::shared_ptr<Counter>> list;
+    for (auto i = 0; i != state.parameter("elements"); ++i)
+    {
+        list.add(std::make_shared<Counter>());
+    }
+
+    while (state.keep_running())
+    {
+        list.for_each([](std::shared_ptr<Counter> const& counter) { counter->notified(1); });
+    }
+}
+
+mtb::Registration const multiplexer{
+    "observers/ObserverMultiplexer::for_each_observer",
+    for_each_observer,
+    mtb::scaled_by({{"observers", {1, 10, 100}}})};
+
+mtb::Registration const multiplexer_while_registering{
+    "observers/ObserverMultiplexer::for_each_observer_while_registering",
+    for_each_observer_while_registering,
+    mtb::scaled_by({{"observers", {10}}})};
+
+mtb::Registration const list{
+    "observers/ThreadSafeList::for_each",
+    thread_safe_list_for_each,
+    mtb::scaled_by({{"elements", {1, 10, 100}}})};
+}
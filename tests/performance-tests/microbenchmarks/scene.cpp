@@ -0,0 +1,202 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "microbenchmark.h"
+
+#include "src/server/scene/surface_stack.h"
+#include "src/server/report/null_report_factory.h"
+
+#include <mir/scene/basic_surface.h>
+#include <mir/compositor/stream.h>
+#include <mir/compositor/scene_element.h>
+#include <mir/graphics/renderable.h>
+#include <mir/input/input_reception_mode.h>
+#include <mir/test/doubles/stub_buffer.h>
+#include <mir/test/doubles/fake_display_configuration_observer_registrar.h>
+
+#include <atomic>
+#include <thread>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mi = mir::input;
+namespace ms = mir::scene;
+namespace mr = mir::report;
+namespace mtb = mir::test::benchmark;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// A SurfaceStack holding a window (with content) for each of a number of clients
+struct PopulatedSurfaceStack
+{
+    explicit PopulatedSurfaceStack(int windows)
+    {
+        for (auto i = 0; i != windows; ++i)
+        {
+            auto const stream = std::make_shared<mc::Stream>();
+            auto const surface = std::make_shared<ms::BasicSurface>(
+                "window",
+                geom::Rectangle{{(i * 37) % 1280, (i * 23) % 600}, {640, 480}},
+                mir_pointer_unconfined,
+                std::list<ms::StreamInfo>{{stream, {}}},
+                std::shared_ptr<mg::CursorImage>{},
+                mr::null_scene_report(),
+                std::make_shared<mtd::FakeDisplayConfigurationObserverRegistrar>());
+            stack->add_surface(surface, mi::InputReceptionMode::normal);
+
+            streams.push_back(stream);
+            surfaces.push_back(surface);
+        }
+        submit_new_buffers();
+    }
+
+    ~PopulatedSurfaceStack()
+    {
+        for (auto const& surface : surfaces)
+        {
+            stack->remove_surface(surface);
+        }
+    }
+
+    void submit_new_buffers()
+    {
+        for (auto const& stream : streams)
+        {
+            auto const buffer = std::make_shared<mtd::StubBuffer>(geom::Size{640, 480});
+            stream->submit_buffer(buffer, buffer->size(), {{0, 0}, geom::SizeD{buffer->size()}});
+        }
+    }
+
+    std::shared_ptr<ms::SurfaceStack> const stack = std::make_shared<ms::SurfaceStack>(mr::null_scene_report());
+    std::vector<std::shared_ptr<mc::Stream>> streams;
+    std::vector<std::shared_ptr<ms::Surface>> surfaces;
+};
+
+void scene_elements_for(mtb::State& state)
+{
+    auto const outputs = state.parameter("outputs");
+    PopulatedSurfaceStack scene{state.parameter("windows")};
+
+    std::vector<int> compositor_ids(outputs);
+    for (auto const& id : compositor_ids)
+    {
+        scene.stack->register_compositor(&id);
+    }
+
+    while (state.keep_running())
+    {
+        // Between frames every client submits new content...
+        state.pause_timing();
+        scene.submit_new_buffers();
+        state.resume_timing();
+
+        // ...then each output takes (and uses) its snapshot of the scene
+        for (auto const& id : compositor_ids)
+        {
+            for (auto const& element : scene.stack->scene_elements_for(&id))
+            {
+                element->renderable()->buffer();
+                element->rendered();
+            }
+        }
+    }
+
+    for (auto const& id : compositor_ids)
+    {
+        scene.stack->unregister_compositor(&id);
+    }
+}
+
+/**
+ * Compositing while the shell restacks the scene as fast as it can (e.g. a burst of workspace switches)
+ *
+ * The difference between real and CPU time is how long the compositor spends waiting for the shell.
+ */
+void scene_elements_for_while_restacking(mtb::State& state)
+{
+    PopulatedSurfaceStack scene{state.parameter("windows")};
+
+    int const id{0};
+    scene.stack->register_compositor(&id);
+
+    std::atomic<bool> stop{false};
+    std::thread shell{[&]
+        {
+            // Alternately raise each half of the windows as a batch
+            ms::SurfaceSet first_half, second_half;
+            for (auto i = 0u; i != scene.surfaces.size(); ++i)
+            {
+                (i < scene.surfaces.size() / 2 ? first_half : second_half).insert(scene.surfaces[i]);
+            }
+
+            while (!stop)
+            {
+                scene.stack->raise(first_half);
+                scene.stack->raise(second_half);
+            }
+        }};
+
+    while (state.keep_running())
+    {
+        for (auto const& element : scene.stack->scene_elements_for(&id))
+        {
+            element->rendered();
+        }
+    }
+
+    stop = true;
+    shell.join();
+    scene.stack->unregister_compositor(&id);
+}
+
+/// Hit-testing as the pointer sweeps across a wall of outputs tiled with windows
+void surface_at(mtb::State& state)
+{
+    geom::Size const wall{7680, 4320};
+    auto const windows = state.parameter("windows");
+    PopulatedSurfaceStack scene{windows};
+
+    for (auto i = 0; i != windows; ++i)
+    {
+        scene.surfaces[i]->move_to({(i * 641) % (wall.width.as_int() - 640), (i * 487) % (wall.height.as_int() - 480)});
+    }
+
+    int step{0};
+    while (state.keep_running())
+    {
+        geom::Point const pointer{(step * 97) % wall.width.as_int(), (step * 61) % wall.height.as_int()};
+        ++step;
+        scene.stack->surface_at(pointer);
+    }
+}
+
+mtb::Registration const elements_for{
+    "scene/SurfaceStack::scene_elements_for",
+    scene_elements_for,
+    mtb::scaled_by({{"windows", {1, 10, 100}}, {"outputs", {1, 2, 4}}})};
+
+mtb::Registration const elements_for_while_restacking{
+    "scene/SurfaceStack::scene_elements_for_while_restacking",
+    scene_elements_for_while_restacking,
+    mtb::scaled_by({{"windows", {10, 100}}})};
+
+mtb::Registration const hit_test{
+    "scene/SurfaceStack::surface_at",
+    surface_at,
+    mtb::scaled_by({{"windows", {10, 100, 1000}}})};
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "microbenchmark.h"
+
+#include "src/server/frontend_wayland/wl_client.h"
+#include "src/server/frontend_wayland/wl_region.h"
+#include "src/server/frontend_wayland/wayland_executor.h"
+#include "wayland_wrapper.h"
+
+#include <mir/test/doubles/stub_shell.h>
+#include <mir/test/doubles/stub_session_authorizer.h>
+
+#include <wayland-client.h>
+#include <wayland-server-core.h>
+
+#include <boost/throw_exception.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/socket.h>
+
+namespace mf = mir::frontend;
+namespace mw = mir::wayland;
+namespace mtb = mir::test::benchmark;
+namespace mtd = mir::test::doubles;
+
+namespace
+{
+/// Just enough of wl_compositor to create Mir's wl_regions
+class Compositor : public mw::Compositor::Global
+{
+public:
+    explicit Compositor(wl_display* display)
+        : Global(display, Version<6>())
+    {
+    }
+
+private:
+    class Instance : mw::Compositor
+    {
+    public:
+        explicit Instance(wl_resource* new_resource)
+            : mw::Compositor{new_resource, Version<6>()}
+        {
+        }
+
+    private:
+        void create_surface(wl_resource*) override
+        {
+            // Not used by the benchmark
+        }
+
+        void create_region(wl_resource* new_region) override
+        {
+            new mf::WlRegion{new_region};
+        }
+    };
+
+    void bind(wl_resource* new_resource) override
+    {
+        new Instance{new_resource};
+    }
+};
+
+/// A Wayland server, dispatching on its own thread, with clients connected over socketpairs
+class Server
+{
+public:
+    explicit Server(int clients)
+    {
+        mf::WlClient::setup_new_client_handler(
+            display,
+            std::make_shared<mtd::StubShell>(),
+            std::make_shared<mtd::StubSessionAuthorizer>(),
+            [](mf::WlClient&) {});
+
+        for (auto i = 0; i != clients; ++i)
+        {
+            int fds[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+            {
+                BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create socketpair"}));
+            }
+            wl_client_create(display, fds[0]);
+            client_fds.push_back(fds[1]);
+        }
+
+        dispatch_thread = std::thread{[this] { wl_display_run(display); }};
+    }
+
+    ~Server()
+    {
+        wl_display_terminate(display);
+        dispatch_thread.join();
+        wl_display_destroy_clients(display);
+        compositor.reset();
+        wl_display_destroy(display);
+    }
+
+    wl_display* const display{wl_display_create()};
+    std::unique_ptr<Compositor> compositor{std::make_unique<Compositor>(display)};
+    std::vector<int> client_fds;
+
+private:
+    std::thread dispatch_thread;
+};
+
+class Client
+{
+public:
+    explicit Client(int fd)
+        : display{wl_display_connect_to_fd(fd)}
+    {
+        if (!display)
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error{"Failed to connect Wayland client"});
+        }
+
+        auto const registry = wl_display_get_registry(display);
+        wl_registry_add_listener(registry, &registry_listener, this);
+        wl_display_roundtrip(display);
+        wl_registry_destroy(registry);
+
+        if (!compositor)
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error{"Server has no wl_compositor"});
+        }
+    }
+
+    ~Client()
+    {
+        wl_compositor_destroy(compositor);
+        wl_display_disconnect(display);
+    }
+
+    /// Queue the requests a client might make to describe an opaque or input region
+    void send_region(int rectangles)
+    {
+        auto const region = wl_compositor_create_region(compositor);
+        for (auto i = 0; i != rectangles; ++i)
+        {
+            wl_region_add(region, i * 10, i * 10, 100, 100);
+        }
+        wl_region_destroy(region);
+        wl_display_flush(display);
+    }
+
+    wl_display* const display;
+
+private:
+    static void handle_global(void* data, wl_registry* registry, uint32_t name, char const* interface, uint32_t)
+    {
+        if (strcmp(interface, wl_compositor_interface.name) == 0)
+        {
+            auto const self = static_cast<Client*>(data);
+            self->compositor = static_cast<wl_compositor*>(wl_registry_bind(registry, name, &wl_compositor_interface, 4));
+        }
+    }
+
+    static void handle_global_remove(void*, wl_registry*, uint32_t)
+    {
+    }
+
+    static constexpr wl_registry_listener registry_listener{&handle_global, &handle_global_remove};
+
+    wl_compositor* compositor{nullptr};
+};
+
+void dispatch_requests(mtb::State& state)
+{
+    Server server{state.parameter("clients")};
+
+    std::vector<std::unique_ptr<Client>> clients;
+    for (auto const fd : server.client_fds)
+    {
+        clients.push_back(std::make_unique<Client>(fd));
+    }
+
+    while (state.keep_running())
+    {
+        // Every client sends a burst of requests, then waits until the server has dispatched them
+        for (auto const& client : clients)
+        {
+            client->send_region(16);
+        }
+        for (auto const& client : clients)
+        {
+            wl_display_roundtrip(client->display);
+        }
+    }
+}
+
+/**
+ * Compositor-thread work (frame callbacks and buffer releases) handed to the Wayland thread
+ *
+ * Each iteration is a frame in which every animating client gets a frame callback and a buffer
+ * release. Reports how often the Wayland thread is woken per frame.
+ */
+void executor_frame_work(mtb::State& state)
+{
+    auto const clients = state.parameter("clients");
+    auto const loop = wl_event_loop_create();
+    auto executor = std::make_unique<mf::WaylandExecutor>(loop);
+
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> wakeups{0};
+    std::thread wayland_thread{[&]
+        {
+            while (running)
+            {
+                wl_event_loop_dispatch(loop, -1);
+                ++wakeups;
+            }
+        }};
+
+    std::atomic<int> completed{0};
+    auto const complete = [&completed]
+        {
+            ++completed;
+            completed.notify_one();
+        };
+
+    auto const wakeups_before = wakeups.load();
+    while (state.keep_running())
+    {
+        completed = 0;
+        for (auto i = 0; i != clients; ++i)
+        {
+            executor->spawn(complete);  // wl_callback.done
+            executor->spawn(complete);  // wl_buffer.release
+        }
+
+        for (auto done = completed.load(); done != 2 * clients; done = completed.load())
+        {
+            completed.wait(done);
+        }
+    }
+    state.set_counter(
+        "wakeups_per_frame",
+        static_cast<double>(wakeups - wakeups_before) / std::max(state.iterations(), uint64_t{1}));
+
+    running = false;
+    executor->spawn([] {});
+    wayland_thread.join();
+    executor.reset();
+    wl_event_loop_destroy(loop);
+}
+
+mtb::Registration const dispatch{
+    "wayland/dispatch_requests",
+    dispatch_requests,
+    mtb::scaled_by({{"clients", {1, 4, 16}}})};
+
+mtb::Registration const executor_frame{
+    "wayland/WaylandExecutor::spawn",
+    executor_frame_work,
+    mtb::scaled_by({{"clients", {1, 50}}})};
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "microbenchmark.h"
+
+#include "test_window_manager_tools.h"
+
+#include <mir/shell/surface_specification.h>
+#include <mir/scene/surface.h>
+
+#include <memory>
+#include <vector>
+
+namespace msh = mir::shell;
+namespace ms = mir::scene;
+namespace mt = mir::test;
+namespace mtb = mir::test::benchmark;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// The window management of a server with the canonical policy, a number of outputs, and no real surfaces
+struct WindowManagement : mt::TestWindowManagerTools
+{
+    explicit WindowManagement(int outputs)
+    {
+        std::vector<miral::Rectangle> output_areas;
+        for (auto i = 0; i != outputs; ++i)
+        {
+            output_areas.push_back({{1920 * i, 0}, {1920, 1080}});
+        }
+        notify_configuration_applied(create_fake_display_configuration(output_areas));
+        basic_window_manager.add_session(session);
+    }
+
+    ~WindowManagement()
+    {
+        basic_window_manager.remove_session(session);
+    }
+
+    auto add_window() -> std::shared_ptr<ms::Surface>
+    {
+        msh::SurfaceSpecification params;
+        params.set_size({640, 480});
+        params.name = "window";
+        return basic_window_manager.add_surface(session, params, &create_surface);
+    }
+
+    void TestBody() override {}
+};
+
+void place_new_window(mtb::State& state)
+{
+    WindowManagement window_management{state.parameter("outputs")};
+
+    std::vector<std::shared_ptr<ms::Surface>> existing;
+    for (auto i = 0; i != state.parameter("windows"); ++i)
+    {
+        existing.push_back(window_management.add_window());
+    }
+
+    while (state.keep_running())
+    {
+        auto const surface = window_management.add_window();
+
+        // Keep the number of windows steady: the next iteration should place among the same windows
+        state.pause_timing();
+        window_management.basic_window_manager.remove_surface(window_management.session, surface);
+        state.resume_timing();
+    }
+
+    for (auto const& surface : existing)
+    {
+        window_management.basic_window_manager.remove_surface(window_management.session, surface);
+    }
+}
+
+mtb::Registration const placement{
+    "window_management/BasicWindowManager::add_surface",
+    place_new_window,
+    mtb::scaled_by({{"windows", {1, 10, 100}}, {"outputs", {1, 2, 4}}})};
+}
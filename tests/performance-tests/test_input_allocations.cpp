@@ -0,0 +1,147 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "allocation_counting.h"
+
+#include "src/server/input/surface_input_dispatcher.h"
+
+#include <mir/events/event_builders.h>
+#include <mir/input/surface.h>
+#include <mir/input/input_reception_mode.h>
+#include <mir/test/doubles/stub_input_scene.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace mg = mir::graphics;
+namespace mi = mir::input;
+namespace mev = mir::events;
+namespace mt = mir::test;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+/// An input surface that accepts the events delivered to it, and lets them go
+struct StubInputSurface : mi::Surface
+{
+    explicit StubInputSurface(geom::Rectangle const& bounds)
+        : bounds{bounds}
+    {
+    }
+
+    std::string name() const override { return "surface"; }
+    geom::Rectangle input_bounds() const override { return bounds; }
+    bool input_area_contains(geom::Point const& point) const override { return bounds.contains(point); }
+    std::shared_ptr<mg::CursorImage> cursor_image() const override { return {}; }
+    mi::InputReceptionMode reception_mode() const override { return mi::InputReceptionMode::normal; }
+    void consume(std::shared_ptr<MirEvent const> const&) override { ++consumed; }
+    auto visible_on_lock_screen() const -> bool override { return false; }
+
+    geom::Rectangle const bounds;
+    int consumed{0};
+};
+
+struct StubInputScene : mtd::StubInputScene
+{
+    auto input_surface_at(geom::Point point) const -> std::shared_ptr<mi::Surface> override
+    {
+        for (auto const& surface : surfaces)
+        {
+            if (surface->input_area_contains(point))
+            {
+                return surface;
+            }
+        }
+        return nullptr;
+    }
+
+    std::vector<std::shared_ptr<StubInputSurface>> surfaces;
+};
+
+struct InputAllocations : Test
+{
+    InputAllocations()
+    {
+        for (auto i = 0; i != surface_count; ++i)
+        {
+            scene->surfaces.push_back(std::make_shared<StubInputSurface>(geom::Rectangle{{100 * i, 50 * i}, {80, 40}}));
+        }
+        dispatcher.start();
+    }
+
+    ~InputAllocations()
+    {
+        dispatcher.stop();
+    }
+
+    /// Move the pointer diagonally across the surfaces (entering and leaving them) as a device would
+    void sweep_pointer()
+    {
+        for (auto step = 0; step != steps_per_sweep; ++step)
+        {
+            dispatcher.dispatch(mev::share_event(mev::make_pointer_event(
+                MirInputDeviceId{1}, std::chrono::nanoseconds{step},
+                mir_input_event_modifier_none, mir_pointer_action_motion, 0,
+                step * 4.0f, step * 2.0f,
+                0, 0, 4.0f, 2.0f)));
+        }
+    }
+
+    static int const surface_count = 10;
+    static int const steps_per_sweep = 256;
+
+    std::shared_ptr<StubInputScene> const scene = std::make_shared<StubInputScene>();
+    mi::SurfaceInputDispatcher dispatcher{scene};
+};
+}
+
+TEST_F(InputAllocations, steady_state_pointer_motion_makes_no_allocations)
+{
+    // Warm up: let the event pool reach its working size
+    sweep_pointer();
+    ASSERT_THAT(scene->surfaces.front()->consumed, Gt(0));
+
+    for (auto sweep = 0; sweep != 3; ++sweep)
+    {
+        mt::start_counting_allocations();
+        sweep_pointer();
+        auto const allocations = mt::stop_counting_allocations();
+
+        EXPECT_THAT(allocations, Eq(0u))
+            << double(allocations) / steps_per_sweep << " allocations per event, in sweep " << sweep;
+    }
+}
+
+TEST_F(InputAllocations, cloned_events_are_recycled)
+{
+    auto const event = mev::make_pointer_event(
+        MirInputDeviceId{1}, std::chrono::nanoseconds{0},
+        mir_input_event_modifier_none, mir_pointer_action_motion, 0,
+        1.0f, 1.0f, 0, 0, 1.0f, 1.0f);
+    mev::share_event(mev::clone_event(*event));
+
+    mt::start_counting_allocations();
+    for (auto i = 0; i != 100; ++i)
+    {
+        mev::share_event(mev::clone_event(*event));
+    }
+    auto const allocations = mt::stop_counting_allocations();
+
+    EXPECT_THAT(allocations, Eq(0u));
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "allocation_counting.h"
+
+#include "src/server/scene/surface_stack.h"
+#include "src/server/compositor/default_display_buffer_compositor.h"
+#include "src/server/compositor/occlusion.h"
+#include "src/server/report/null_report_factory.h"
+
+#include <mir/scene/basic_surface.h>
+#include <mir/compositor/stream.h>
+#include <mir/compositor/scene_element.h>
+#include <mir/graphics/renderable.h>
+#include <mir/input/input_reception_mode.h>
+#include <mir/test/doubles/stub_buffer.h>
+#include <mir/test/doubles/stub_display_sink.h>
+#include <mir/test/doubles/stub_gl_rendering_provider.h>
+#include <mir/test/doubles/stub_output_filter.h>
+#include <mir/test/doubles/stub_renderer.h>
+#include <mir/test/doubles/fake_display_configuration_observer_registrar.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mi = mir::input;
+namespace ms = mir::scene;
+namespace mr = mir::report;
+namespace mt = mir::test;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+struct SceneAllocations : Test
+{
+    SceneAllocations()
+    {
+        stack->register_compositor(compositor_id);
+
+        for (auto i = 0; i != surface_count; ++i)
+        {
+            auto const stream = std::make_shared<mc::Stream>();
+            auto const surface = std::make_shared<ms::BasicSurface>(
+                "surface",
+                geom::Rectangle{{10 * i, 0}, {100, 100}},
+                mir_pointer_unconfined,
+                std::list<ms::StreamInfo>{{stream, {}}},
+                std::shared_ptr<mg::CursorImage>{},
+                mr::null_scene_report(),
+                std::make_shared<mtd::FakeDisplayConfigurationObserverRegistrar>());
+            stack->add_surface(surface, mi::InputReceptionMode::normal);
+
+            streams.push_back(stream);
+            surfaces.push_back(surface);
+        }
+    }
+
+    ~SceneAllocations()
+    {
+        for (auto const& surface : surfaces)
+        {
+            stack->remove_surface(surface);
+        }
+        stack->unregister_compositor(compositor_id);
+    }
+
+    void submit_new_buffers()
+    {
+        for (auto const& stream : streams)
+        {
+            // Opaque, so the surfaces (which overlap) partly occlude each other
+            auto const buffer = std::make_shared<mtd::StubBuffer>(geom::Size{100, 100}, mir_pixel_format_xbgr_8888);
+            stream->submit_buffer(buffer, buffer->size(), {{0, 0}, geom::SizeD{buffer->size()}});
+        }
+    }
+
+    /// Do what a compositor does with the scene each frame, returning the number of elements
+    auto composite_frame() -> std::size_t
+    {
+        auto const elements = stack->scene_elements_for(compositor_id);
+        for (auto const& element : elements)
+        {
+            auto const renderable = element->renderable();
+            renderable->buffer();
+            renderable->screen_position();
+            element->rendered();
+        }
+        return elements.size();
+    }
+
+    /// Warm up: let the recycled storage reach its working size
+    template<typename Frame>
+    void warm_up(Frame frame)
+    {
+        for (auto i = 0; i != 3; ++i)
+        {
+            submit_new_buffers();
+            frame();
+        }
+    }
+
+    static int const surface_count = 20;
+    geom::Rectangle const output_area{{0, 0}, {1000, 1000}};
+
+    std::shared_ptr<ms::SurfaceStack> const stack = std::make_shared<ms::SurfaceStack>(mr::null_scene_report());
+    mc::CompositorID const compositor_id{this};
+    std::vector<std::shared_ptr<mc::Stream>> streams;
+    std::vector<std::shared_ptr<ms::Surface>> surfaces;
+};
+}
+
+TEST_F(SceneAllocations, steady_state_frame_makes_no_per_surface_allocations)
+{
+    submit_new_buffers();
+
+    // Warm up: let the recycled storage reach its working size
+    for (auto i = 0; i != 3; ++i)
+    {
+        ASSERT_THAT(composite_frame(), Eq(surface_count));
+    }
+
+    for (auto frame = 0; frame != 10; ++frame)
+    {
+        // New client content arrives between frames, as it would in a running session...
+        submit_new_buffers();
+
+        mt::start_counting_allocations();
+        auto const element_count = composite_frame();
+        auto const allocations = mt::stop_counting_allocations();
+
+        // ...but taking the snapshot should only allocate the returned sequence itself
+        EXPECT_THAT(element_count, Eq(surface_count));
+        EXPECT_THAT(allocations, Le(1u)) << "in frame " << frame;
+    }
+}
+
+TEST_F(SceneAllocations, occlusion_filtering_of_steady_frame_makes_no_per_surface_allocations)
+{
+    mc::Exposure exposure;
+    auto const filter_frame = [&]
+        {
+            mc::split_occluded_and_exposed(stack->scene_elements_for(compositor_id), output_area, exposure);
+            return exposure.visible.size();
+        };
+
+    warm_up(filter_frame);
+
+    for (auto frame = 0; frame != 10; ++frame)
+    {
+        submit_new_buffers();
+
+        mt::start_counting_allocations();
+        auto const visible_count = filter_frame();
+        auto const allocations = mt::stop_counting_allocations();
+
+        // The snapshot allocates the returned sequence; filtering it should reuse last frame's storage
+        EXPECT_THAT(visible_count, Eq(surface_count));
+        EXPECT_THAT(allocations, Le(1u)) << "in frame " << frame;
+    }
+}
+
+TEST_F(SceneAllocations, composite_of_steady_frame_makes_no_per_surface_allocations)
+{
+    mtd::StubDisplaySink display_sink{output_area};
+    mtd::StubGlRenderingProvider gl_provider;
+    mc::DefaultDisplayBufferCompositor compositor{
+        display_sink,
+        gl_provider,
+        std::make_shared<mtd::StubRenderer>(),
+        std::make_shared<mtd::StubOutputFilter>(),
+        mr::null_compositor_report()};
+    auto const composite_frame = [&] { return compositor.composite(stack->scene_elements_for(compositor_id)); };
+
+    warm_up(composite_frame);
+
+    for (auto frame = 0; frame != 10; ++frame)
+    {
+        submit_new_buffers();
+
+        mt::start_counting_allocations();
+        auto const composited = composite_frame();
+        auto const allocations = mt::stop_counting_allocations();
+
+        // As above: only the scene's sequence of elements is new
+        EXPECT_TRUE(composited);
+        EXPECT_THAT(allocations, Le(1u)) << "in frame " << frame;
+    }
+}
@@ -31,6 +31,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <sys/sysmacros.h>
+
 namespace mg = mir::graphics;
 namespace mc = mir::compositor;
 namespace geom = mir::geometry;
@@ -92,11 +94,14 @@ struct DefaultDisplayBufferCompositor : public testing::Test
             .WillByDefault(Return(screen));
         ON_CALL(display_sink, overlay(_))
             .WillByDefault(Return(false));
+        ON_CALL(display_sink, scanout_formats())
+            .WillByDefault(Return(scanout_formats));
     }
 
     testing::NiceMock<mtd::MockRenderer> mock_renderer;
     geom::Rectangle screen{{0, 0}, {1366, 768}};
     testing::NiceMock<mtd::MockDisplaySink> display_sink;
+    mg::ScanoutFormats const scanout_formats{makedev(226, 0), {{0x34325258 /* XRGB8888 */, 0 /* LINEAR */}}};
     mtd::StubGlRenderingProvider gl_provider;
     std::shared_ptr<mtd::FakeRenderable> small;
     std::shared_ptr<mtd::FakeRenderable> big;
@@ -174,6 +179,27 @@ TEST_F(DefaultDisplayBufferCompositor, all_expected_reports_are_received_during_
     compositor.composite(make_scene_elements({big}));
 }
 
+TEST_F(DefaultDisplayBufferCompositor, reports_timings_of_each_phase_of_a_composited_frame)
+{
+    using namespace testing;
+    using FramePhase = mc::CompositorReport::FramePhase;
+    auto report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+
+    for (auto phase : {FramePhase::occlusion, FramePhase::overlay_decision, FramePhase::texture_upload,
+                       FramePhase::render, FramePhase::commit, FramePhase::buffer_release})
+    {
+        EXPECT_CALL(*report, frame_phase(_, phase, Ge(std::chrono::nanoseconds::zero()))).Times(1);
+    }
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        std::make_shared<mtd::StubOutputFilter>(),
+        report);
+    compositor.composite(make_scene_elements({big}));
+}
+
 TEST_F(DefaultDisplayBufferCompositor, elements_provided_to_composite_are_rendered_in_order)
 {
     using namespace testing;
@@ -292,6 +318,7 @@ struct MockSceneElement : mc::SceneElement
     MOCK_METHOD(std::shared_ptr<mir::graphics::Renderable>, renderable, (), (const, override));
     MOCK_METHOD(void, rendered, (), (override));
     MOCK_METHOD(void, occluded, (), (override));
+    MOCK_METHOD(void, scanout_candidate, (std::optional<mg::ScanoutFormats> const&), (override));
 };
 }
 
@@ -341,3 +368,269 @@ TEST_F(DefaultDisplayBufferCompositor, marks_occluded_scene_elements)
 
     compositor.composite({element0_occluded, element1_rendered, element2_occluded});
 }
+
+TEST_F(DefaultDisplayBufferCompositor, tells_elements_covering_the_output_they_are_scanout_candidates)
+{
+    using namespace testing;
+
+    auto const covering = std::make_shared<NiceMock<MockSceneElement>>(
+        std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{-10, -10}, {1400, 800}}));
+    auto const windowed = std::make_shared<NiceMock<MockSceneElement>>(small);
+
+    EXPECT_CALL(*covering, scanout_candidate(Optional(scanout_formats)));
+    EXPECT_CALL(*windowed, scanout_candidate(Eq(std::nullopt)));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        std::make_shared<mtd::StubOutputFilter>(),
+        mr::null_compositor_report());
+
+    compositor.composite({covering, windowed});
+}
+
+TEST_F(DefaultDisplayBufferCompositor, translucent_elements_are_not_scanout_candidates)
+{
+    using namespace testing;
+
+    auto const translucent = std::make_shared<NiceMock<MockSceneElement>>(
+        std::make_shared<mtd::FakeRenderable>(screen, 0.5f));
+
+    EXPECT_CALL(*translucent, scanout_candidate(Eq(std::nullopt)));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        std::make_shared<mtd::StubOutputFilter>(),
+        mr::null_compositor_report());
+
+    compositor.composite({translucent});
+}
+
+TEST_F(DefaultDisplayBufferCompositor, elements_are_not_scanout_candidates_when_the_sink_cannot_scan_out)
+{
+    using namespace testing;
+
+    ON_CALL(display_sink, scanout_formats())
+        .WillByDefault(Return(std::nullopt));
+    auto const element = std::make_shared<NiceMock<MockSceneElement>>(fullscreen);
+
+    EXPECT_CALL(*element, scanout_candidate(_)).Times(0);
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        std::make_shared<mtd::StubOutputFilter>(),
+        mr::null_compositor_report());
+
+    compositor.composite({element});
+}
+
+namespace
+{
+struct StubFramebuffer : mg::Framebuffer
+{
+    auto size() const -> geom::Size override { return {}; }
+};
+
+/// Offers every buffer not rendered translucently for scanout
+struct ScanoutGlRenderingProvider : mtd::StubGlRenderingProvider
+{
+    auto make_framebuffer_provider(mg::DisplaySink& /*sink*/)
+        -> std::unique_ptr<FramebufferProvider> override
+    {
+        class StubFramebufferProvider : public FramebufferProvider
+        {
+        public:
+            explicit StubFramebufferProvider(int& imports)
+                : imports{imports}
+            {
+            }
+
+            auto buffer_to_framebuffer(std::shared_ptr<mg::Buffer>)
+                -> std::unique_ptr<mg::Framebuffer> override
+            {
+                ++imports;
+                return std::make_unique<StubFramebuffer>();
+            }
+
+        private:
+            int& imports;
+        };
+        return std::make_unique<StubFramebufferProvider>(imports);
+    }
+
+    int imports{0};
+};
+
+struct DefaultDisplayBufferCompositorWithOverlays : DefaultDisplayBufferCompositor
+{
+    ScanoutGlRenderingProvider scanout_provider;
+    mc::DefaultDisplayBufferCompositor compositor{
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        std::make_shared<mtd::StubOutputFilter>(),
+        mr::null_compositor_report()};
+};
+}
+
+TEST_F(DefaultDisplayBufferCompositorWithOverlays, composites_only_elements_not_placed_on_overlays)
+{
+    using namespace testing;
+
+    EXPECT_CALL(display_sink, overlay_where_possible(SizeIs(2)))
+        .WillOnce(Return(std::vector<bool>{false, true}));
+    EXPECT_CALL(mock_renderer, render(ContainerEq(mg::RenderableList{big})));
+
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositorWithOverlays, does_not_redraw_beneath_overlays_when_composited_elements_are_unchanged)
+{
+    using namespace testing;
+
+    ON_CALL(display_sink, overlay_where_possible(_))
+        .WillByDefault(Return(std::vector<bool>{false, true}));
+    EXPECT_CALL(mock_renderer, render(_)).Times(1);
+    EXPECT_CALL(display_sink, set_next_image(_)).Times(1);
+
+    compositor.composite(make_scene_elements({big, small}));
+    small->set_buffer(std::make_shared<mtd::StubBuffer>());
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositorWithOverlays, redraws_beneath_overlays_when_composited_elements_change)
+{
+    using namespace testing;
+
+    ON_CALL(display_sink, overlay_where_possible(_))
+        .WillByDefault(Return(std::vector<bool>{false, true}));
+    EXPECT_CALL(mock_renderer, render(_)).Times(2);
+
+    compositor.composite(make_scene_elements({big, small}));
+    big->set_buffer(std::make_shared<mtd::StubBuffer>());
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositorWithOverlays, redraws_when_nothing_is_placed_on_overlays)
+{
+    using namespace testing;
+
+    ON_CALL(display_sink, overlay_where_possible(_))
+        .WillByDefault(Return(std::vector<bool>{}));
+    EXPECT_CALL(mock_renderer, render(_)).Times(2);
+
+    compositor.composite(make_scene_elements({big, small}));
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositorWithOverlays, redraws_beneath_overlays_while_renderer_has_a_pending_frame)
+{
+    using namespace testing;
+
+    ON_CALL(display_sink, overlay_where_possible(_))
+        .WillByDefault(Return(std::vector<bool>{false, true}));
+    ON_CALL(mock_renderer, has_pending_frame()).WillByDefault(Return(true));
+    EXPECT_CALL(mock_renderer, render(_)).Times(2);
+
+    compositor.composite(make_scene_elements({big, small}));
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositorWithOverlays, needs_another_frame_only_while_renderer_has_a_pending_frame)
+{
+    using namespace testing;
+
+    EXPECT_CALL(mock_renderer, has_pending_frame())
+        .WillOnce(Return(true))
+        .WillOnce(Return(false));
+
+    EXPECT_TRUE(compositor.needs_another_frame());
+    EXPECT_FALSE(compositor.needs_another_frame());
+}
+
+TEST_F(DefaultDisplayBufferCompositorWithOverlays, imports_each_buffer_for_scanout_only_once)
+{
+    compositor.composite(make_scene_elements({big, small}));
+    compositor.composite(make_scene_elements({big, small}));
+    compositor.composite(make_scene_elements({big, small}));
+
+    EXPECT_THAT(scanout_provider.imports, testing::Eq(2));
+}
+
+TEST_F(DefaultDisplayBufferCompositorWithOverlays, does_not_offer_translucent_elements_for_overlays)
+{
+    using namespace testing;
+
+    auto const translucent = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{10, 20},{30, 40}}, 0.5f);
+
+    EXPECT_CALL(display_sink, overlay(_)).Times(0);
+    EXPECT_CALL(display_sink, overlay_where_possible(ElementsAre(
+            Field(&mg::DisplayElement::buffer, NotNull()),
+            Field(&mg::DisplayElement::buffer, IsNull()))))
+        .WillOnce(Return(std::vector<bool>{false, false}));
+
+    compositor.composite(make_scene_elements({big, translucent}));
+}
+
+TEST_F(DefaultDisplayBufferCompositorWithOverlays, does_not_offer_cropped_elements_for_overlays)
+{
+    using namespace testing;
+
+    // A video player showing only part of its buffer, through wp_viewporter
+    auto const cropped = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{10, 20},{30, 40}});
+    cropped->set_src_bounds(geom::RectangleD{{2, 2}, {10, 10}});
+
+    EXPECT_CALL(display_sink, overlay(_)).Times(0);
+    EXPECT_CALL(display_sink, overlay_where_possible(ElementsAre(
+            Field(&mg::DisplayElement::buffer, NotNull()),
+            Field(&mg::DisplayElement::buffer, IsNull()))))
+        .WillOnce(Return(std::vector<bool>{false, false}));
+
+    compositor.composite(make_scene_elements({big, cropped}));
+}
+
+TEST_F(DefaultDisplayBufferCompositorWithOverlays, cropped_fullscreen_element_is_not_a_scanout_candidate)
+{
+    using namespace testing;
+
+    fullscreen->set_src_bounds(geom::RectangleD{{0, 0}, {10, 10}});
+    auto const element = std::make_shared<NiceMock<MockSceneElement>>(fullscreen);
+
+    EXPECT_CALL(*element, scanout_candidate(Eq(std::nullopt)));
+
+    compositor.composite({element});
+}
+
+TEST_F(DefaultDisplayBufferCompositorWithOverlays, offers_elements_to_the_display_with_their_tearing_hint)
+{
+    using namespace testing;
+
+    big->set_allows_tearing(true);
+
+    EXPECT_CALL(display_sink, overlay(ElementsAre(
+            Field(&mg::DisplayElement::allow_tearing, IsTrue()),
+            Field(&mg::DisplayElement::allow_tearing, IsFalse()))))
+        .WillOnce(Return(false));
+
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositorWithOverlays, tells_elements_placed_on_overlays_they_are_scanout_candidates)
+{
+    using namespace testing;
+
+    auto const composited = std::make_shared<NiceMock<MockSceneElement>>(big);
+    auto const on_overlay = std::make_shared<NiceMock<MockSceneElement>>(small);
+
+    ON_CALL(display_sink, overlay_where_possible(_))
+        .WillByDefault(Return(std::vector<bool>{false, true}));
+    EXPECT_CALL(*composited, scanout_candidate(Eq(std::nullopt)));
+    EXPECT_CALL(*on_overlay, scanout_candidate(Optional(scanout_formats)));
+
+    compositor.composite({composited, on_overlay});
+}
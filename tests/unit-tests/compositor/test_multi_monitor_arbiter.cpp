@@ -424,3 +424,47 @@ TEST_F(MultiMonitorArbiter, second_compositor_advances_schedule_after_both_aquir
     auto cbuffer4 = arbiter->compositor_acquire(&comp_id2)->claim_buffer();
     EXPECT_THAT(cbuffer1, Not(IsSameBufferAs(cbuffer4)));
 }
+
+TEST_F(MultiMonitorArbiter, submission_is_damaged_relative_to_the_buffer_it_replaced)
+{
+    auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
+    arbiter->submit_buffer(buffer, size, source);
+    arbiter->compositor_acquire(this)->claim_buffer();
+
+    geom::Rectangle const damage{{1, 2}, {3, 4}};
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
+    arbiter->submit_buffer(buffer, size, source, geom::Rectangles{damage});
+    auto const submission = arbiter->compositor_acquire(this);
+
+    EXPECT_THAT(submission->damage_since(buffers[0]->id()), Eq(geom::Rectangles{damage}));
+    EXPECT_THAT(submission->damage_since(buffers[2]->id()), Eq(std::nullopt));
+}
+
+TEST_F(MultiMonitorArbiter, damage_of_superseded_submission_is_kept)
+{
+    auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
+    arbiter->submit_buffer(buffer, size, source);
+    arbiter->compositor_acquire(this)->claim_buffer();
+
+    geom::Rectangle const first_damage{{1, 2}, {3, 4}};
+    geom::Rectangle const second_damage{{5, 6}, {7, 8}};
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
+    arbiter->submit_buffer(buffer, size, source, geom::Rectangles{first_damage});
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[2]);
+    arbiter->submit_buffer(buffer, size, source, geom::Rectangles{second_damage});
+    auto const submission = arbiter->compositor_acquire(this);
+
+    auto const damage = submission->damage_since(buffers[0]->id());
+    ASSERT_THAT(damage, Ne(std::nullopt));
+    EXPECT_THAT(
+        std::vector<geom::Rectangle>(damage->begin(), damage->end()),
+        UnorderedElementsAre(first_damage, second_damage));
+}
+
+TEST_F(MultiMonitorArbiter, first_submission_has_unknown_damage)
+{
+    auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
+    arbiter->submit_buffer(buffer, size, source, geom::Rectangles{{{1, 2}, {3, 4}}});
+
+    EXPECT_THAT(arbiter->compositor_acquire(this)->damage_since(buffers[1]->id()), Eq(std::nullopt));
+}
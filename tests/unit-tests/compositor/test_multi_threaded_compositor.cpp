@@ -24,7 +24,10 @@
 #include <mir/scene/observer.h>
 #include <mir/raii.h>
 
+#include <mir/graphics/frame.h>
+
 #include <mir/test/current_thread_name.h>
+#include <mir/test/signal.h>
 #include <mir/test/doubles/null_display.h>
 #include <mir/test/doubles/null_display_sink.h>
 #include <mir/test/doubles/mock_cursor.h>
@@ -816,6 +819,91 @@ TEST(MultiThreadedCompositor, registers_and_unregisters_with_scene)
     compositor.stop();
 }
 
+TEST(MultiThreadedCompositor, tells_scene_how_each_posted_frame_was_presented)
+{
+    using namespace testing;
+    auto display = std::make_shared<StubDisplayWithMockBuffers>(1);
+    auto mock_scene = std::make_shared<NiceMock<mtd::MockScene>>();
+    auto db_compositor_factory = std::make_shared<mtd::NullDisplayBufferCompositorFactory>();
+    auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
+    mt::Signal presented;
+
+    mg::FramePresentation const flip{{1234, {CLOCK_MONOTONIC, 5678ns}}, 16'666'667ns, true, true, true, false};
+    display->for_each_mock_buffer(
+        [&](mtd::MockDisplaySink& sink)
+        {
+            ON_CALL(sink, last_presentation()).WillByDefault(Return(flip));
+        });
+
+    EXPECT_CALL(*mock_scene, frame_presented(_, Field(&mg::FramePresentation::frame, Field(&mg::Frame::msc, Eq(1234)))))
+        .WillOnce(InvokeWithoutArgs([&] { presented.raise(); }))
+        .WillRepeatedly(Return());
+
+    mc::MultiThreadedCompositor compositor{
+        display, db_compositor_factory, mock_scene, null_display_listener, mock_report, stub_cursor, default_delay, true};
+
+    compositor.start();
+    EXPECT_TRUE(presented.wait_for(10s));
+    compositor.stop();
+}
+
+TEST(MultiThreadedCompositor, reports_how_each_posted_frame_was_presented)
+{
+    using namespace testing;
+    auto display = std::make_shared<StubDisplayWithMockBuffers>(1);
+    auto stub_scene = std::make_shared<NiceMock<mtd::MockScene>>();
+    auto db_compositor_factory = std::make_shared<mtd::NullDisplayBufferCompositorFactory>();
+    auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
+    mt::Signal reported;
+
+    // An asynchronous flip: the hardware completed it, but not at a vblank
+    mg::FramePresentation const torn_flip{{1234, {CLOCK_MONOTONIC, 5678ns}}, 16'666'667ns, false, false, true, true};
+    display->for_each_mock_buffer(
+        [&](mtd::MockDisplaySink& sink)
+        {
+            ON_CALL(sink, last_presentation()).WillByDefault(Return(torn_flip));
+        });
+
+    EXPECT_CALL(*mock_report, presented_frame(_, AllOf(
+            Field(&mg::FramePresentation::vsync, IsFalse()),
+            Field(&mg::FramePresentation::hw_completion, IsTrue()))))
+        .WillOnce(InvokeWithoutArgs([&] { reported.raise(); }))
+        .WillRepeatedly(Return());
+
+    mc::MultiThreadedCompositor compositor{
+        display, db_compositor_factory, stub_scene, null_display_listener, mock_report, stub_cursor, default_delay, true};
+
+    compositor.start();
+    EXPECT_TRUE(reported.wait_for(10s));
+    compositor.stop();
+}
+
+TEST(MultiThreadedCompositor, assumes_frame_presented_on_post_when_display_cannot_tell)
+{
+    using namespace testing;
+    auto display = std::make_shared<StubDisplayWithMockBuffers>(1);
+    auto mock_scene = std::make_shared<NiceMock<mtd::MockScene>>();
+    auto db_compositor_factory = std::make_shared<mtd::NullDisplayBufferCompositorFactory>();
+    auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
+    mt::Signal presented;
+
+    auto const assumed = AllOf(
+        Field(&mg::FramePresentation::frame, Field(&mg::Frame::msc, Gt(0))),
+        Field(&mg::FramePresentation::vsync, IsFalse()),
+        Field(&mg::FramePresentation::hw_clock, IsFalse()));
+
+    EXPECT_CALL(*mock_scene, frame_presented(_, assumed))
+        .WillOnce(InvokeWithoutArgs([&] { presented.raise(); }))
+        .WillRepeatedly(Return());
+
+    mc::MultiThreadedCompositor compositor{
+        display, db_compositor_factory, mock_scene, null_display_listener, mock_report, stub_cursor, default_delay, true};
+
+    compositor.start();
+    EXPECT_TRUE(presented.wait_for(10s));
+    compositor.stop();
+}
+
 TEST(MultiThreadedCompositor, notifies_about_display_additions_and_removals)
 {
     using namespace testing;
@@ -203,3 +203,32 @@ TEST_F(OcclusionFilterTest,
     EXPECT_THAT(renderables_from(occlusions), ElementsAre(partially_onscreen));
     EXPECT_THAT(renderables_from(elements), ElementsAre(covering));
 }
+
+TEST_F(OcclusionFilterTest, window_covered_by_several_windows_together_is_occluded)
+{
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(100, 100, 200, 200);
+    auto const left = std::make_shared<mtd::FakeRenderable>(0, 0, 200, 400);
+    auto const right = std::make_shared<mtd::FakeRenderable>(200, 0, 200, 400);
+
+    auto const& [occlusions, elements] =
+        split_occluded_and_visible(scene_elements_from({bottom, left, right}), monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(bottom));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(left, right));
+}
+
+TEST_F(OcclusionFilterTest, visible_windows_report_their_exposed_region)
+{
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(0, 0, 200, 200);
+    auto const top = std::make_shared<mtd::FakeRenderable>(100, 0, 200, 200);
+    auto const translucent = std::make_shared<mtd::FakeRenderable>(Rectangle{{0, 150}, {50, 50}}, 0.5f);
+
+    auto const& [occlusions, elements, exposed] =
+        split_occluded_and_exposed(scene_elements_from({bottom, top, translucent}), monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    ASSERT_THAT(exposed.size(), Eq(3u));
+    EXPECT_THAT(exposed[0], Optional(Region{Rectangle{{0, 0}, {100, 200}}}));
+    EXPECT_THAT(exposed[1], Optional(Region{Rectangle{{100, 0}, {200, 200}}}));
+    EXPECT_THAT(exposed[2], Optional(Region{Rectangle{{0, 150}, {50, 50}}}));
+}
@@ -16,6 +16,7 @@
 
 #include <mir/test/doubles/stub_buffer.h>
 #include <mir/compositor/stream.h>
+#include <mir/graphics/frame.h>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -73,6 +74,24 @@ TEST_F(Stream, calls_frame_callback_after_scheduling_on_submissions)
     EXPECT_THAT(frame_count, Eq(1));
 }
 
+TEST_F(Stream, calls_presented_callback_when_frame_is_presented)
+{
+    std::vector<int64_t> presented_mscs;
+    stream.set_frame_presented_callback(
+        [&presented_mscs](mg::FramePresentation const& presentation)
+        {
+            presented_mscs.push_back(presentation.frame.msc);
+        });
+
+    mg::FramePresentation presentation;
+    presentation.frame.msc = 7;
+    stream.frame_presented(presentation);
+    stream.set_frame_presented_callback([](mg::FramePresentation const&) {});
+    stream.frame_presented(presentation);
+
+    EXPECT_THAT(presented_mscs, ElementsAre(7));
+}
+
 TEST_F(Stream, frame_callback_is_called_without_scheduling_lock)
 {
     stream.set_frame_posted_callback(
@@ -97,3 +116,27 @@ TEST_F(Stream, throws_on_nullptr_submissions)
     }, std::invalid_argument);
     EXPECT_FALSE(stream.has_submitted_buffer());
 }
+
+TEST_F(Stream, frame_callback_reports_whole_buffer_as_damaged_when_no_damage_is_given)
+{
+    geom::Size const dest_size{22, 1};
+    geom::Rectangle damage;
+    stream.set_frame_posted_callback([&damage](auto const& posted) { damage = posted; });
+    stream.submit_buffer(
+            buffers[0],
+            dest_size,
+            {{0, 0}, geom::SizeD{buffers[0]->size()}} );
+    EXPECT_THAT(damage, Eq(geom::Rectangle{{0, 0}, dest_size}));
+}
+
+TEST_F(Stream, frame_callback_reports_bounds_of_submitted_damage)
+{
+    geom::Rectangle damage;
+    stream.set_frame_posted_callback([&damage](auto const& posted) { damage = posted; });
+    stream.submit_buffer(
+            buffers[0],
+            buffers[0]->size(),
+            {{0, 0}, geom::SizeD{buffers[0]->size()}},
+            geom::Rectangles{{{2, 0}, {3, 1}}, {{10, 1}, {4, 1}}});
+    EXPECT_THAT(damage, Eq(geom::Rectangle{{2, 0}, {12, 2}}));
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/lock_free_work_queue.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace mf = mir::frontend;
+
+using namespace testing;
+
+namespace
+{
+struct LockFreeWorkQueue : Test
+{
+    /// Run all the work that can be taken, returning how much there was
+    auto run_all() -> int
+    {
+        int count{0};
+        while (auto const work = queue.pop())
+        {
+            work();
+            ++count;
+        }
+        return count;
+    }
+
+    mf::LockFreeWorkQueue queue;
+};
+}
+
+TEST_F(LockFreeWorkQueue, has_no_work_to_begin_with)
+{
+    EXPECT_FALSE(queue.pop());
+}
+
+TEST_F(LockFreeWorkQueue, work_is_taken_in_the_order_it_was_pushed)
+{
+    std::vector<int> order;
+    for (auto i = 0; i != 5; ++i)
+    {
+        queue.push([&order, i] { order.push_back(i); });
+    }
+
+    run_all();
+
+    EXPECT_THAT(order, ElementsAre(0, 1, 2, 3, 4));
+    EXPECT_FALSE(queue.pop());
+}
+
+TEST_F(LockFreeWorkQueue, can_be_reused_after_being_emptied)
+{
+    int runs{0};
+    queue.push([&runs] { ++runs; });
+    run_all();
+    queue.push([&runs] { ++runs; });
+    run_all();
+
+    EXPECT_THAT(runs, Eq(2));
+}
+
+TEST_F(LockFreeWorkQueue, holds_more_work_than_fits_in_its_node_pool)
+{
+    constexpr int const work_items{1000};
+
+    std::vector<int> order;
+    for (auto round = 0; round != 2; ++round)
+    {
+        order.clear();
+        for (auto i = 0; i != work_items; ++i)
+        {
+            queue.push([&order, i] { order.push_back(i); });
+        }
+
+        EXPECT_THAT(run_all(), Eq(work_items));
+        ASSERT_THAT(order.size(), Eq(work_items));
+        for (auto i = 0; i != work_items; ++i)
+        {
+            EXPECT_THAT(order[i], Eq(i));
+        }
+    }
+}
+
+TEST_F(LockFreeWorkQueue, only_first_push_before_wakeup_requests_wakeup)
+{
+    EXPECT_TRUE(queue.push([] {}));
+    EXPECT_FALSE(queue.push([] {}));
+    EXPECT_FALSE(queue.push([] {}));
+}
+
+TEST_F(LockFreeWorkQueue, push_after_wakeup_is_acknowledged_requests_another)
+{
+    queue.push([] {});
+    queue.acknowledge_wakeup();
+
+    EXPECT_TRUE(queue.push([] {}));
+}
+
+TEST_F(LockFreeWorkQueue, ignores_empty_work)
+{
+    EXPECT_FALSE(queue.push(std::function<void()>{}));
+    EXPECT_FALSE(queue.pop());
+}
+
+TEST_F(LockFreeWorkQueue, clear_destroys_queued_work)
+{
+    auto const state = std::make_shared<int>();
+    queue.push([state] {});
+    queue.push([state] {});
+
+    queue.clear();
+
+    EXPECT_THAT(state.use_count(), Eq(1));
+    EXPECT_FALSE(queue.pop());
+}
+
+TEST(LockFreeWorkQueueLifetime, destroying_queue_destroys_queued_work)
+{
+    auto const state = std::make_shared<int>();
+    {
+        mf::LockFreeWorkQueue queue;
+        queue.push([state] {});
+    }
+
+    EXPECT_THAT(state.use_count(), Eq(1));
+}
+
+TEST_F(LockFreeWorkQueue, work_pushed_from_many_threads_is_all_taken_in_order_for_each_thread)
+{
+    constexpr int const producers{4};
+    constexpr int const work_per_producer{20000};
+
+    std::vector<int> last_taken(producers, -1);
+    std::atomic<bool> out_of_order{false};
+    std::atomic<int> wakeups{0};
+
+    std::vector<std::thread> threads;
+    for (auto producer = 0; producer != producers; ++producer)
+    {
+        threads.emplace_back(
+            [&, producer]
+            {
+                for (auto i = 0; i != work_per_producer; ++i)
+                {
+                    auto const wakeup = queue.push(
+                        [&, producer, i]
+                        {
+                            if (last_taken[producer] != i - 1)
+                            {
+                                out_of_order = true;
+                            }
+                            last_taken[producer] = i;
+                        });
+                    if (wakeup)
+                    {
+                        ++wakeups;
+                    }
+                }
+            });
+    }
+
+    int taken{0};
+    while (taken != producers * work_per_producer)
+    {
+        queue.acknowledge_wakeup();
+        taken += run_all();
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_FALSE(out_of_order);
+    EXPECT_THAT(last_taken, Each(Eq(work_per_producer - 1)));
+    EXPECT_THAT(wakeups.load(), Lt(producers * work_per_producer));
+}
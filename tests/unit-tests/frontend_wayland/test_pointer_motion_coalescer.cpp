@@ -0,0 +1,211 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/pointer_motion_coalescer.h"
+
+#include <mir/events/event_builders.h>
+#include <mir/events/event.h>
+#include <mir/events/input_event.h>
+#include <mir/events/pointer_event.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+namespace mev = mir::events;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+auto pointer_event(
+    MirPointerAction action,
+    MirPointerButtons buttons,
+    geom::PointF position,
+    geom::DisplacementF motion,
+    float vscroll = 0.0f) -> std::shared_ptr<MirPointerEvent const>
+{
+    std::shared_ptr<MirEvent const> const event = mev::make_pointer_event(
+        MirInputDeviceId{0}, std::chrono::nanoseconds{0}, mir_input_event_modifier_none,
+        action, buttons,
+        position.x.as_value(), position.y.as_value(),
+        0.0f, vscroll,
+        motion.dx.as_value(), motion.dy.as_value());
+    return {event, event->to_input()->to_pointer()};
+}
+
+auto motion_to(geom::PointF position, geom::DisplacementF motion) -> std::shared_ptr<MirPointerEvent const>
+{
+    return pointer_event(mir_pointer_action_motion, 0, position, motion);
+}
+
+struct PointerMotionCoalescer : Test
+{
+    mf::PointerMotionCoalescer coalescer;
+};
+}
+
+TEST_F(PointerMotionCoalescer, holds_nothing_initially)
+{
+    EXPECT_FALSE(coalescer.holding());
+    EXPECT_THAT(coalescer.take(), Eq(std::nullopt));
+}
+
+TEST_F(PointerMotionCoalescer, isolated_motion_is_sent_straight_away)
+{
+    auto const event = motion_to({1, 1}, {1, 1});
+
+    auto const motion = coalescer.motion(event);
+
+    ASSERT_TRUE(motion);
+    EXPECT_THAT(motion->latest, Eq(event));
+    EXPECT_THAT(motion->relative, Eq(geom::DisplacementF{1, 1}));
+    EXPECT_FALSE(coalescer.holding());
+}
+
+TEST_F(PointerMotionCoalescer, motion_following_within_the_frame_is_held)
+{
+    coalescer.motion(motion_to({1, 1}, {1, 1}));
+
+    EXPECT_THAT(coalescer.motion(motion_to({2, 2}, {1, 1})), Eq(std::nullopt));
+    EXPECT_THAT(coalescer.motion(motion_to({3, 3}, {1, 1})), Eq(std::nullopt));
+    EXPECT_TRUE(coalescer.holding());
+}
+
+TEST_F(PointerMotionCoalescer, frame_sends_latest_event_with_relative_motion_summed)
+{
+    auto const latest = motion_to({10, 20}, {-1, 4});
+    coalescer.motion(motion_to({5, 9}, {1, 1}));
+    coalescer.motion(motion_to({7, 12}, {2, 3}));
+    coalescer.motion(motion_to({9, 16}, {0.5, 1}));
+    coalescer.motion(latest);
+
+    auto const motion = coalescer.frame();
+
+    ASSERT_TRUE(motion);
+    EXPECT_THAT(motion->latest, Eq(latest));
+    EXPECT_THAT(motion->relative, Eq(geom::DisplacementF{1.5, 8}));
+    EXPECT_FALSE(coalescer.holding());
+}
+
+TEST_F(PointerMotionCoalescer, motion_after_frame_with_motion_is_held_for_next_frame)
+{
+    coalescer.motion(motion_to({1, 1}, {1, 1}));
+    coalescer.motion(motion_to({2, 2}, {1, 1}));
+    coalescer.frame();
+
+    EXPECT_THAT(coalescer.motion(motion_to({3, 3}, {1, 1})), Eq(std::nullopt));
+    EXPECT_TRUE(coalescer.frame());
+}
+
+TEST_F(PointerMotionCoalescer, pointer_keeps_moving_across_one_frame_without_motion)
+{
+    coalescer.motion(motion_to({1, 1}, {1, 1}));
+    EXPECT_THAT(coalescer.frame(), Eq(std::nullopt));
+
+    EXPECT_TRUE(coalescer.awaiting_frame());
+    EXPECT_THAT(coalescer.motion(motion_to({2, 2}, {1, 1})), Eq(std::nullopt));
+    EXPECT_TRUE(coalescer.frame());
+}
+
+TEST_F(PointerMotionCoalescer, motion_after_two_frames_without_motion_is_sent_straight_away)
+{
+    coalescer.motion(motion_to({1, 1}, {1, 1}));
+    EXPECT_THAT(coalescer.frame(), Eq(std::nullopt));
+    EXPECT_THAT(coalescer.frame(), Eq(std::nullopt));
+
+    EXPECT_FALSE(coalescer.awaiting_frame());
+    EXPECT_TRUE(coalescer.motion(motion_to({2, 2}, {1, 1})));
+}
+
+TEST_F(PointerMotionCoalescer, frame_with_motion_restarts_the_count_of_frames_without)
+{
+    coalescer.motion(motion_to({1, 1}, {1, 1}));
+    coalescer.frame();
+    coalescer.motion(motion_to({2, 2}, {1, 1}));
+    coalescer.frame();
+
+    EXPECT_THAT(coalescer.frame(), Eq(std::nullopt));
+    EXPECT_TRUE(coalescer.awaiting_frame());
+}
+
+TEST_F(PointerMotionCoalescer, still_pointer_awaits_no_frame)
+{
+    EXPECT_FALSE(coalescer.awaiting_frame());
+
+    coalescer.motion(motion_to({1, 1}, {1, 1}));
+    EXPECT_TRUE(coalescer.awaiting_frame());
+
+    coalescer.clear();
+    EXPECT_FALSE(coalescer.awaiting_frame());
+}
+
+TEST_F(PointerMotionCoalescer, take_sends_held_motion_before_the_frame)
+{
+    coalescer.motion(motion_to({1, 1}, {1, 1}));
+    coalescer.motion(motion_to({2, 2}, {1, 1}));
+
+    EXPECT_TRUE(coalescer.take());
+    EXPECT_FALSE(coalescer.holding());
+    EXPECT_THAT(coalescer.frame(), Eq(std::nullopt));
+}
+
+TEST_F(PointerMotionCoalescer, motion_after_clear_is_sent_straight_away)
+{
+    coalescer.motion(motion_to({1, 1}, {1, 1}));
+    coalescer.motion(motion_to({2, 2}, {1, 1}));
+
+    coalescer.clear();
+
+    EXPECT_FALSE(coalescer.holding());
+    EXPECT_TRUE(coalescer.motion(motion_to({3, 3}, {1, 1})));
+}
+
+TEST_F(PointerMotionCoalescer, plain_motion_is_motion_only)
+{
+    auto const event = pointer_event(mir_pointer_action_motion, mir_pointer_button_primary, {1, 1}, {1, 1});
+
+    EXPECT_TRUE(mf::PointerMotionCoalescer::is_motion_only(*event, mir_pointer_button_primary));
+}
+
+TEST_F(PointerMotionCoalescer, motion_changing_buttons_is_not_motion_only)
+{
+    auto const event = pointer_event(mir_pointer_action_motion, mir_pointer_button_primary, {1, 1}, {1, 1});
+
+    EXPECT_FALSE(mf::PointerMotionCoalescer::is_motion_only(*event, 0));
+}
+
+TEST_F(PointerMotionCoalescer, motion_with_scroll_is_not_motion_only)
+{
+    auto const event = pointer_event(mir_pointer_action_motion, 0, {1, 1}, {1, 1}, 2.0f);
+
+    EXPECT_FALSE(mf::PointerMotionCoalescer::is_motion_only(*event, 0));
+}
+
+TEST_F(PointerMotionCoalescer, other_actions_are_not_motion_only)
+{
+    for (auto const action : {
+        mir_pointer_action_button_down,
+        mir_pointer_action_button_up,
+        mir_pointer_action_enter,
+        mir_pointer_action_leave})
+    {
+        auto const event = pointer_event(action, 0, {1, 1}, {0, 0});
+
+        EXPECT_FALSE(mf::PointerMotionCoalescer::is_motion_only(*event, 0)) << "action " << action;
+    }
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <mir/geometry/region.h>
+#include <mir/geometry/rectangles.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace mir::geometry;
+using namespace testing;
+
+TEST(Region, default_region_is_empty)
+{
+    Region const region;
+
+    EXPECT_TRUE(region.empty());
+    EXPECT_THAT(region.rectangles(), IsEmpty());
+    EXPECT_EQ(Rectangle{}, region.bounding_rectangle());
+}
+
+TEST(Region, empty_rectangle_gives_empty_region)
+{
+    EXPECT_TRUE(Region{Rectangle({10, 10}, {0, 5})}.empty());
+}
+
+TEST(Region, overlapping_rectangles_are_made_disjoint)
+{
+    Region const region{Rectangles{{{0, 0}, {10, 10}}, {{5, 5}, {10, 10}}}};
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(
+        Rectangle{{0, 0}, {10, 5}},
+        Rectangle{{0, 5}, {15, 5}},
+        Rectangle{{5, 10}, {10, 5}}));
+}
+
+TEST(Region, adjacent_rectangles_are_merged)
+{
+    Region const side_by_side{Rectangles{{{0, 0}, {10, 10}}, {{10, 0}, {10, 10}}}};
+    Region const stacked{Rectangles{{{0, 0}, {10, 10}}, {{0, 10}, {10, 10}}}};
+
+    EXPECT_THAT(side_by_side.rectangles(), ElementsAre(Rectangle{{0, 0}, {20, 10}}));
+    EXPECT_THAT(stacked.rectangles(), ElementsAre(Rectangle{{0, 0}, {10, 20}}));
+}
+
+TEST(Region, representation_is_independent_of_construction_order)
+{
+    Rectangle const a{{0, 0}, {30, 10}};
+    Rectangle const b{{10, 5}, {5, 20}};
+    Rectangle const c{{-5, 20}, {10, 10}};
+
+    EXPECT_EQ(Region(Rectangles{a, b, c}), Region(Rectangles{c, a, b}));
+    EXPECT_EQ(union_of(union_of(a, b), c), union_of(a, union_of(c, b)));
+}
+
+TEST(Region, tiled_rectangles_contain_rectangle_neither_contains_alone)
+{
+    Rectangle const left{{0, 0}, {50, 100}};
+    Rectangle const right{{50, 0}, {50, 100}};
+    Rectangle const middle{{25, 25}, {50, 50}};
+
+    EXPECT_FALSE(Region{left}.contains(middle));
+    EXPECT_FALSE(Region{right}.contains(middle));
+    EXPECT_TRUE(union_of(left, right).contains(middle));
+}
+
+TEST(Region, does_not_contain_partially_covered_rectangle)
+{
+    Region const region{Rectangles{{{0, 0}, {50, 50}}, {{60, 0}, {50, 50}}}};
+
+    EXPECT_FALSE(region.contains({{25, 25}, {50, 10}}));
+    EXPECT_TRUE(region.overlaps({{25, 25}, {50, 10}}));
+    EXPECT_FALSE(region.overlaps({{50, 0}, {10, 50}}));
+}
+
+TEST(Region, subtracting_punches_a_hole)
+{
+    auto const region = difference_of(Rectangle{{0, 0}, {30, 30}}, Rectangle{{10, 10}, {10, 10}});
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(
+        Rectangle{{0, 0}, {30, 10}},
+        Rectangle{{0, 10}, {10, 10}},
+        Rectangle{{20, 10}, {10, 10}},
+        Rectangle{{0, 20}, {30, 10}}));
+    EXPECT_EQ((Rectangle{{0, 0}, {30, 30}}), region.bounding_rectangle());
+    EXPECT_FALSE(region.overlaps({{12, 12}, {2, 2}}));
+}
+
+TEST(Region, subtracting_everything_leaves_nothing)
+{
+    auto region = Region{Rectangle{{5, 5}, {10, 10}}};
+    region.subtract(Rectangle{{0, 0}, {20, 20}});
+
+    EXPECT_TRUE(region.empty());
+}
+
+TEST(Region, intersection_is_common_area)
+{
+    Region const a{Rectangles{{{0, 0}, {20, 20}}, {{40, 0}, {20, 20}}}};
+    Region const b{Rectangle{{10, 10}, {40, 20}}};
+
+    EXPECT_THAT(intersection_of(a, b).rectangles(), ElementsAre(
+        Rectangle{{10, 10}, {10, 10}},
+        Rectangle{{40, 10}, {10, 10}}));
+}
+
+TEST(Region, assigning_a_rectangle_replaces_the_region)
+{
+    Region region{Rectangles{{{0, 0}, {10, 10}}, {{20, 20}, {10, 10}}}};
+
+    region = Rectangle{{5, 5}, {10, 10}};
+    EXPECT_THAT(region.rectangles(), ElementsAre(Rectangle{{5, 5}, {10, 10}}));
+
+    region = Rectangle{{5, 5}, {0, 10}};
+    EXPECT_TRUE(region.empty());
+}
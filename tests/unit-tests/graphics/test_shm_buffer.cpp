@@ -99,6 +99,7 @@ struct ShmBufferTest : public testing::Test
             std::make_shared<mgc::EGLContextExecutor>(
                 std::make_unique<DumbGLContext>(dummy))}
     {
+        mock_egl.provide_egl_extensions();
     }
 
     testing::NiceMock<mtd::MockEGL> mock_egl;
@@ -388,3 +389,151 @@ TEST_F(ShmBufferTest, texture_is_destroyed_on_thread_with_current_context)
         eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
     }
 }
+
+namespace
+{
+auto successor_of(
+    std::shared_ptr<mg::Buffer> const& predecessor,
+    std::shared_ptr<mir::renderer::software::RWMappable> data,
+    std::optional<geom::Rectangles> const& damage) -> std::shared_ptr<mgc::NotifyingMappableBackedShmBuffer>
+{
+    return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
+        std::move(data),
+        predecessor,
+        damage,
+        [](){},
+        [](){});
+}
+}
+
+TEST_F(ShmBufferTest, successor_uploads_only_accumulated_damage_into_retired_texture)
+{
+    auto const format = mir_pixel_format_abgr_8888;
+    auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(format);
+    auto const data = std::make_shared<PlatformlessShmBuffer>(size, format);
+    auto const stride = bytes_per_pixel * size.width.as_int();
+    geom::Rectangle const first_damage{{10, 20}, {30, 40}};
+    geom::Rectangle const second_damage{{5, 6}, {7, 8}};
+
+    std::shared_ptr<mg::Buffer> first = successor_of(nullptr, data, std::nullopt);
+    std::shared_ptr<mg::Buffer> second = successor_of(first, data, geom::Rectangles{{first_damage}});
+
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, _, _, _, _, _, _)).Times(2);
+    for (auto const& buffer : {first, second})
+    {
+        std::dynamic_pointer_cast<mgc::ShmBuffer>(buffer)
+            ->texture_for_provider(egl_delegate, rendering_provider.get())->bind();
+    }
+    Mock::VerifyAndClearExpectations(&mock_gl);
+
+    // Retire the first buffer's texture; the third buffer can bring it up to date with a partial upload
+    first.reset();
+    auto const third = successor_of(second, data, geom::Rectangles{{second_damage}});
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    for (auto const& rect : {first_damage, second_damage})
+    {
+        EXPECT_CALL(
+            mock_gl,
+            glTexSubImage2D(
+                GL_TEXTURE_2D, 0,
+                rect.left().as_int(), rect.top().as_int(),
+                rect.size.width.as_int(), rect.size.height.as_int(),
+                _, _,
+                data->pixel_buffer() + rect.top().as_int() * stride + rect.left().as_int() * bytes_per_pixel));
+    }
+
+    third->texture_for_provider(egl_delegate, rendering_provider.get())->bind();
+}
+
+TEST_F(ShmBufferTest, successor_with_unknown_damage_uploads_everything)
+{
+    auto const format = mir_pixel_format_abgr_8888;
+    auto const data = std::make_shared<PlatformlessShmBuffer>(size, format);
+
+    std::shared_ptr<mg::Buffer> first = successor_of(nullptr, data, std::nullopt);
+    first = successor_of(first, data, std::nullopt);
+    std::dynamic_pointer_cast<mgc::ShmBuffer>(first)->texture_for_provider(egl_delegate, rendering_provider.get());
+    first = successor_of(first, data, std::nullopt);
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(
+        mock_gl,
+        glTexImage2D(
+            GL_TEXTURE_2D, 0, _,
+            size.width.as_int(), size.height.as_int(),
+            0, _, _,
+            data->pixel_buffer()));
+
+    std::dynamic_pointer_cast<mgc::ShmBuffer>(first)
+        ->texture_for_provider(egl_delegate, rendering_provider.get())->bind();
+}
+
+TEST_F(ShmBufferTest, texture_uploaded_ahead_is_used_by_provider_sharing_the_context)
+{
+    auto const data = std::make_shared<PlatformlessShmBuffer>(size, mir_pixel_format_abgr_8888);
+    bool consumed{false};
+    auto const buffer = std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
+        data,
+        [&consumed]() { consumed = true; },
+        [](){});
+
+    EXPECT_CALL(
+        mock_gl,
+        glTexImage2D(
+            GL_TEXTURE_2D, 0, _,
+            size.width.as_int(), size.height.as_int(),
+            0, _, _,
+            data->pixel_buffer())).Times(1);
+
+    buffer->upload_ahead(egl_delegate);
+    wait_for_egl_thread(*egl_delegate);
+
+    // Uploading ahead must not tell the client its buffer has been consumed…
+    EXPECT_FALSE(consumed);
+
+    buffer->texture_for_provider(egl_delegate, rendering_provider.get())->bind();
+
+    // …but using it does
+    EXPECT_TRUE(consumed);
+}
+
+TEST_F(ShmBufferTest, upload_into_reclaimed_texture_waits_for_draws_from_another_context)
+{
+    auto const format = mir_pixel_format_abgr_8888;
+    auto const data = std::make_shared<PlatformlessShmBuffer>(size, format);
+    EGLContext const renderer_ctx{reinterpret_cast<EGLContext>(0x66221144)};
+    EGLSyncKHR const draw_sync{reinterpret_cast<EGLSyncKHR>(0xfe9ce)};
+
+    ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+        .WillByDefault(Return("EGL_KHR_fence_sync"));
+    ON_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _))
+        .WillByDefault(Return(draw_sync));
+
+    std::shared_ptr<mg::Buffer> first = successor_of(nullptr, data, std::nullopt);
+    auto const second = successor_of(first, data, geom::Rectangles{{{{10, 20}, {30, 40}}}});
+
+    // Draw the first buffer from the "renderer" context, then retire it
+    eglMakeCurrent(mock_egl.fake_egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, renderer_ctx);
+    {
+        auto const texture = std::dynamic_pointer_cast<mgc::ShmBuffer>(first)
+            ->texture_for_provider(egl_delegate, rendering_provider.get());
+        texture->bind();
+        texture->add_syncpoint();
+    }
+    first.reset();
+
+    // The upload context must not overwrite the texture until the GPU has finished those draws
+    Sequence seq;
+    EXPECT_CALL(mock_egl, eglClientWaitSyncKHR(_, draw_sync, _, _))
+        .Times(AtLeast(1))
+        .InSequence(seq)
+        .WillRepeatedly(Return(EGL_CONDITION_SATISFIED_KHR));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _))
+        .InSequence(seq);
+
+    second->upload_ahead(egl_delegate);
+    wait_for_egl_thread(*egl_delegate);
+
+    eglMakeCurrent(mock_egl.fake_egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
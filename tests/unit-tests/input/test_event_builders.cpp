@@ -224,3 +224,28 @@ TEST_F(InputEventBuilder, when_creating_input_device_state_event_it_has_supplied
     EXPECT_THAT(mir_input_device_state_event_device_pressed_keys_count(ids_event, 1), Eq(0));
     EXPECT_THAT(mir_input_device_state_event_device_pointer_buttons(ids_event, 1), Eq(button_state));
 }
+
+TEST_F(InputEventBuilder, cloned_pointer_event_keeps_its_properties_after_being_shared)
+{
+    auto const original = mev::make_pointer_event(
+        device_id, timestamp, modifiers,
+        mir_pointer_action_motion, mir_pointer_button_primary, 3.5f, 7.5f,
+        0.0f, 0.0f, 1.0f, 2.0f);
+
+    auto const shared = mev::share_event(mev::clone_event(*original));
+
+    ASSERT_THAT(mir_event_get_type(shared.get()), Eq(mir_event_type_input));
+    auto const pev = mir_input_event_get_pointer_event(mir_event_get_input_event(shared.get()));
+    EXPECT_THAT(mir_pointer_event_modifiers(pev), Eq(modifiers));
+    EXPECT_THAT(mir_pointer_event_action(pev), Eq(mir_pointer_action_motion));
+    EXPECT_THAT(mir_pointer_event_buttons(pev), Eq(mir_pointer_button_primary));
+    EXPECT_THAT(mir_pointer_event_axis_value(pev, mir_pointer_axis_x), Eq(3.5f));
+    EXPECT_THAT(mir_pointer_event_axis_value(pev, mir_pointer_axis_y), Eq(7.5f));
+    EXPECT_THAT(mir_pointer_event_axis_value(pev, mir_pointer_axis_relative_x), Eq(1.0f));
+    EXPECT_THAT(mir_pointer_event_axis_value(pev, mir_pointer_axis_relative_y), Eq(2.0f));
+}
+
+TEST_F(InputEventBuilder, sharing_no_event_gives_no_event)
+{
+    EXPECT_THAT(mev::share_event(mir::EventUPtr{nullptr, [](MirEvent*){}}), IsNull());
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <mir/input/keymap_cache.h>
+#include <mir/input/parameter_keymap.h>
+
+#include <xkbcommon/xkbcommon.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+
+namespace mi = mir::input;
+
+using namespace ::testing;
+
+namespace
+{
+struct CountingKeymap : mi::ParameterKeymap
+{
+    CountingKeymap(std::string const& layout, std::atomic<int>& compilations)
+        : ParameterKeymap{default_model, layout, "", ""},
+          compilations{compilations}
+    {
+    }
+
+    auto make_unique_xkb_keymap(xkb_context* context) const -> mi::XKBKeymapPtr override
+    {
+        ++compilations;
+        return ParameterKeymap::make_unique_xkb_keymap(context);
+    }
+
+    std::atomic<int>& compilations;
+};
+
+auto contents_of(mi::KeymapCache::Serialised const& serialised) -> std::string
+{
+    std::string text(serialised.size, '\0');
+    EXPECT_THAT(pread(serialised.fd, text.data(), text.size(), 0), Eq(static_cast<ssize_t>(text.size())));
+    return text;
+}
+
+struct KeymapCache : Test
+{
+    auto keymap(std::string const& layout) -> std::shared_ptr<CountingKeymap>
+    {
+        return std::make_shared<CountingKeymap>(layout, compilations);
+    }
+
+    std::atomic<int> compilations{0};
+    mi::KeymapCache cache{2};
+};
+}
+
+TEST_F(KeymapCache, serialises_keymap_as_text_with_terminating_nul)
+{
+    auto const serialised = cache.serialised(keymap("us"));
+
+    auto const text = contents_of(*serialised);
+
+    ASSERT_THAT(text, Not(IsEmpty()));
+    EXPECT_THAT(text.back(), Eq('\0'));
+    EXPECT_THAT(text, StartsWith("xkb_keymap"));
+}
+
+TEST_F(KeymapCache, compiles_matching_keymaps_once)
+{
+    auto const first = cache.serialised(keymap("us"));
+    auto const second = cache.serialised(keymap("us"));
+
+    EXPECT_THAT(compilations, Eq(1));
+    EXPECT_THAT(second, Eq(first));
+}
+
+TEST_F(KeymapCache, compiles_different_keymaps_separately)
+{
+    auto const us = cache.serialised(keymap("us"));
+    auto const gb = cache.serialised(keymap("gb"));
+
+    EXPECT_THAT(compilations, Eq(2));
+    EXPECT_THAT(contents_of(*gb), Ne(contents_of(*us)));
+}
+
+TEST_F(KeymapCache, drops_least_recently_used_keymap_when_full)
+{
+    cache.serialised(keymap("us"));
+    cache.serialised(keymap("gb"));
+    cache.serialised(keymap("us"));
+    cache.serialised(keymap("de"));
+    compilations = 0;
+
+    cache.serialised(keymap("us"));
+    EXPECT_THAT(compilations, Eq(0));
+    cache.serialised(keymap("gb"));
+    EXPECT_THAT(compilations, Eq(1));
+}
+
+TEST_F(KeymapCache, serialised_keymap_cannot_be_modified)
+{
+    auto const serialised = cache.serialised(keymap("us"));
+
+    auto const seals = fcntl(serialised->fd, F_GET_SEALS);
+
+    EXPECT_THAT(seals & F_SEAL_WRITE, Ne(0));
+    EXPECT_THAT(seals & F_SEAL_SHRINK, Ne(0));
+    EXPECT_THAT(seals & F_SEAL_GROW, Ne(0));
+    EXPECT_THAT(pwrite(serialised->fd, "x", 1, 0), Eq(-1));
+}
+
+TEST_F(KeymapCache, persisted_keymaps_are_not_recompiled)
+{
+    std::filesystem::path const directory{std::filesystem::temp_directory_path() / std::tmpnam(nullptr)};
+    cache.persist_to(directory.string());
+    auto const original = contents_of(*cache.serialised(keymap("us")));
+
+    mi::KeymapCache later_cache;
+    later_cache.persist_to(directory.string());
+    compilations = 0;
+    auto const restored = contents_of(*later_cache.serialised(keymap("us")));
+
+    EXPECT_THAT(compilations, Eq(0));
+    EXPECT_THAT(restored, Eq(original));
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(KeymapCache, persisted_keymaps_are_not_used_for_other_keymaps)
+{
+    std::filesystem::path const directory{std::filesystem::temp_directory_path() / std::tmpnam(nullptr)};
+    cache.persist_to(directory.string());
+    auto const us = contents_of(*cache.serialised(keymap("us")));
+
+    mi::KeymapCache later_cache;
+    later_cache.persist_to(directory.string());
+    auto const gb = contents_of(*later_cache.serialised(keymap("gb")));
+
+    EXPECT_THAT(gb, Ne(us));
+
+    std::filesystem::remove_all(directory);
+}
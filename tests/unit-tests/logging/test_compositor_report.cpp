@@ -19,7 +19,9 @@
 #include <mir/test/doubles/advanceable_clock.h>
 
 #include <gtest/gtest.h>
+#include <gmock/gmock.h>
 #include <string>
+#include <sstream>
 #include <cstdio>
 
 using namespace std;
@@ -169,6 +171,36 @@ TEST_F(LoggingCompositorReport, reports_bypass_only_when_changed)
     report.stopped();
 }
 
+TEST_F(LoggingCompositorReport, reports_presentation_mode_only_when_changed)
+{
+    const void* const id = "My Screen";
+
+    mir::graphics::FramePresentation vsynced;
+    vsynced.vsync = true;
+    vsynced.hw_completion = true;
+
+    mir::graphics::FramePresentation torn;
+    torn.vsync = false;
+    torn.hw_completion = true;
+
+    report.started();
+
+    report.presented_frame(id, vsynced);
+    EXPECT_TRUE(recorder->last_message_contains("presenting frames: vsync"))
+        << recorder->last_message();
+
+    report.started();
+    report.presented_frame(id, vsynced);
+    EXPECT_FALSE(recorder->last_message_contains("presenting frames"))
+        << recorder->last_message();
+
+    report.presented_frame(id, torn);
+    EXPECT_TRUE(recorder->last_message_contains("presenting frames: async (tearing)"))
+        << recorder->last_message();
+
+    report.stopped();
+}
+
 TEST_F(LoggingCompositorReport, bypass_has_no_render_time)
 {  // Regression test for LP: #1408906
     const void* const id = "My Screen";
@@ -187,3 +219,52 @@ TEST_F(LoggingCompositorReport, bypass_has_no_render_time)
 
     report.stopped();
 }
+
+TEST_F(LoggingCompositorReport, periodically_logs_frame_phase_percentiles)
+{
+    const void* const id = "My Screen";
+    using FramePhase = mir::compositor::CompositorReport::FramePhase;
+
+    report.started();
+
+    for (int usec = 1; usec <= 100; ++usec)
+    {
+        report.began_frame(id);
+        report.frame_phase(id, FramePhase::render, chrono::microseconds(usec));
+        report.rendered_frame(id);
+        report.finished_frame(id);
+    }
+    EXPECT_FALSE(recorder->last_message_contains("render: p50"))
+        << recorder->last_message();
+
+    clock->advance_by(chrono::seconds(10));
+    report.began_frame(id);
+    report.rendered_frame(id);
+    report.finished_frame(id);
+
+    EXPECT_TRUE(recorder->last_message_contains("render: p50 0.051 ms"))
+        << recorder->last_message();
+    EXPECT_TRUE(recorder->last_message_contains("max 0.100 ms over 100 frames"))
+        << recorder->last_message();
+
+    report.stopped();
+}
+
+TEST_F(LoggingCompositorReport, dumps_frame_phase_timings_as_json)
+{
+    const void* const id = "My Screen";
+    using FramePhase = mir::compositor::CompositorReport::FramePhase;
+
+    for (int usec = 1; usec <= 100; ++usec)
+    {
+        report.frame_phase(id, FramePhase::flip, chrono::microseconds(usec));
+    }
+
+    std::ostringstream json;
+    report.dump_timings(json);
+
+    EXPECT_THAT(json.str(), testing::StartsWith("{\"displays\":[{\"id\":"));
+    EXPECT_THAT(json.str(), testing::HasSubstr(
+        "\"flip\":{\"count\":100,\"p50_us\":51,\"p95_us\":95,\"p99_us\":99,\"max_us\":100}"));
+    EXPECT_THAT(json.str(), testing::HasSubstr("\"render\":{\"count\":0,"));
+}
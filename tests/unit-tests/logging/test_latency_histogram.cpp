@@ -0,0 +1,94 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/report/logging/latency_histogram.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+namespace mrl = mir::report::logging;
+
+TEST(LatencyHistogram, is_empty_initially)
+{
+    mrl::LatencyHistogram histogram;
+
+    EXPECT_THAT(histogram.count(), Eq(0u));
+    EXPECT_THAT(histogram.percentile(99), Eq(0us));
+    EXPECT_THAT(histogram.max(), Eq(0us));
+}
+
+TEST(LatencyHistogram, small_durations_are_exact)
+{
+    mrl::LatencyHistogram histogram;
+
+    for (auto usec = 1; usec <= 10; ++usec)
+        histogram.record(std::chrono::microseconds{usec});
+
+    EXPECT_THAT(histogram.count(), Eq(10u));
+    EXPECT_THAT(histogram.percentile(50), Eq(5us));
+    EXPECT_THAT(histogram.percentile(90), Eq(9us));
+    EXPECT_THAT(histogram.percentile(100), Eq(10us));
+}
+
+TEST(LatencyHistogram, percentiles_are_within_a_bucket_of_the_truth)
+{
+    mrl::LatencyHistogram histogram;
+
+    for (auto usec = 1; usec <= 100'000; ++usec)
+        histogram.record(std::chrono::microseconds{usec});
+
+    for (auto percent : {50.0, 95.0, 99.0, 99.9})
+    {
+        auto const exact = 1000.0 * percent;
+        auto const reported = histogram.percentile(percent).count();
+        EXPECT_THAT(reported, Ge(exact)) << percent;
+        EXPECT_THAT(reported, Le(exact * 1.07)) << percent;
+    }
+}
+
+TEST(LatencyHistogram, keeps_exact_maximum)
+{
+    mrl::LatencyHistogram histogram;
+
+    histogram.record(16'667us);
+    histogram.record(123'457us);
+
+    EXPECT_THAT(histogram.max(), Eq(123'457us));
+    EXPECT_THAT(histogram.percentile(100), Eq(123'457us));
+}
+
+TEST(LatencyHistogram, copes_with_huge_durations)
+{
+    mrl::LatencyHistogram histogram;
+
+    histogram.record(std::chrono::hours{24 * 365});
+
+    EXPECT_THAT(histogram.count(), Eq(1u));
+    EXPECT_THAT(histogram.percentile(50), Eq(histogram.max()));
+}
+
+TEST(LatencyHistogram, reset_forgets_everything)
+{
+    mrl::LatencyHistogram histogram;
+    histogram.record(1ms);
+
+    histogram.reset();
+
+    EXPECT_THAT(histogram.count(), Eq(0u));
+    EXPECT_THAT(histogram.max(), Eq(0us));
+}
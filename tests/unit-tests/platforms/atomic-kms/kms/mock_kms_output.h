@@ -37,7 +37,14 @@ public:
     MOCK_METHOD(bool, set_crtc, (graphics::FBHandle const&), (override));
     MOCK_METHOD(bool, has_crtc_mismatch, (), (override));
     MOCK_METHOD(void, clear_crtc, (), (override));
-    MOCK_METHOD(bool, page_flip, (graphics::FBHandle const&), (override));
+    MOCK_METHOD((std::vector<std::pair<uint32_t, uint64_t>>), primary_plane_formats, (), (const, override));
+    MOCK_METHOD(std::vector<graphics::atomic::OverlayPlane>, overlay_planes, (), (const, override));
+    MOCK_METHOD(bool, test_layers,
+        (graphics::FBHandle const&, std::vector<graphics::atomic::OverlayLayer> const&), (override));
+    MOCK_METHOD(bool, schedule_page_flip,
+        (graphics::FBHandle const&, std::vector<graphics::atomic::OverlayLayer> const&), (override));
+    MOCK_METHOD(bool, schedule_async_page_flip, (graphics::FBHandle const&), (override));
+    MOCK_METHOD(std::optional<graphics::FramePresentation>, wait_for_page_flip, (), (override));
     MOCK_METHOD(void, set_cursor_image, (gbm_bo*), (override));
     MOCK_METHOD(void, move_cursor, (geometry::Point), (override));
     MOCK_METHOD(bool, clear_cursor, (), (override));
@@ -0,0 +1,434 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kms/atomic_kms_output.h"
+#include "kms/overlay_planes.h"
+#include "kms-utils/drm_event_handler.h"
+#include "src/platforms/common/server/kms_framebuffer.h"
+
+#include <mir/test/doubles/mock_drm.h>
+
+#include <drm_fourcc.h>
+#include <fcntl.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mg = mir::graphics;
+namespace mga = mir::graphics::atomic;
+namespace mgk = mir::graphics::kms;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+using namespace ::testing;
+
+namespace
+{
+class StubDRMEventHandler : public mgk::DRMEventHandler
+{
+public:
+    void const* drm_event_data() const override
+    {
+        return this;
+    }
+
+    std::future<void> expect_flip_event(
+        KMSCrtcId,
+        std::function<void(unsigned int, std::chrono::milliseconds)>) override
+    {
+        std::promise<void> flipped;
+        flipped.set_value();
+        return flipped.get_future();
+    }
+
+    void cancel_flip_events(KMSCrtcId) override
+    {
+    }
+};
+
+class StubFBHandle : public mg::FBHandle
+{
+public:
+    StubFBHandle(uint32_t fb_id, geom::Size size)
+        : fb_id{fb_id},
+          size_{size}
+    {
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return size_;
+    }
+
+    operator uint32_t() const override
+    {
+        return fb_id;
+    }
+
+private:
+    uint32_t const fb_id;
+    geom::Size const size_;
+};
+
+/// Every property gets an id of its own, whichever objects have it
+std::vector<std::string> const property_names{
+    "type", "zpos",
+    "SRC_X", "SRC_Y", "SRC_W", "SRC_H",
+    "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H",
+    "CRTC_ID", "FB_ID",
+    "MODE_ID", "ACTIVE"};
+
+auto property_id(std::string const& name) -> uint32_t
+{
+    auto const found = std::find(property_names.begin(), property_names.end(), name);
+    return 100 + std::distance(property_names.begin(), found);
+}
+
+struct FakeObject
+{
+    std::vector<uint32_t> ids;
+    std::vector<uint64_t> values;
+    drmModeObjectProperties props;
+};
+
+class AtomicKMSOutputTest : public Test
+{
+public:
+    AtomicKMSOutputTest()
+    {
+        mock_drm.reset(drm_device);
+        mock_drm.add_crtc(drm_device, other_crtc_id, mode);
+        mock_drm.add_crtc(drm_device, crtc_id, mode);
+        mock_drm.add_encoder(drm_device, encoder_id, crtc_id, 0x3);
+        mock_drm.add_connector(
+            drm_device,
+            connector_id,
+            DRM_MODE_CONNECTOR_HDMIA,
+            DRM_MODE_CONNECTED,
+            encoder_id,
+            modes,
+            encoder_ids,
+            geom::Size{597, 336});
+        mock_drm.prepare(drm_device);
+
+        for (auto const id : {other_crtc_id, crtc_id})
+        {
+            auto& crtc = crtcs[id];
+            crtc.crtc_id = id;
+            crtc.mode = mode;
+            crtc.mode_valid = 1;
+            crtc.width = mode.hdisplay;
+            crtc.height = mode.vdisplay;
+            add_object(id, {{"MODE_ID", 0}, {"ACTIVE", 1}});
+        }
+        add_object(connector_id, {{"CRTC_ID", crtc_id}});
+        add_plane(primary_plane_id, DRM_PLANE_TYPE_PRIMARY, our_crtc_only, 1);
+
+        for (auto const& name : property_names)
+        {
+            auto& prop = properties[property_id(name)];
+            prop.prop_id = property_id(name);
+            strncpy(prop.name, name.c_str(), DRM_PROP_NAME_LEN - 1);
+        }
+
+        ON_CALL(mock_drm, drmModeGetCrtc(_, _))
+            .WillByDefault([this](auto, uint32_t id) { return &crtcs.at(id); });
+        ON_CALL(mock_drm, drmModeGetPlaneResources(_))
+            .WillByDefault(
+                [this](auto)
+                {
+                    plane_res.count_planes = plane_ids.size();
+                    plane_res.planes = plane_ids.data();
+                    return &plane_res;
+                });
+        ON_CALL(mock_drm, drmModeGetPlane(_, _))
+            .WillByDefault([this](auto, uint32_t id) { return &planes.at(id); });
+        ON_CALL(mock_drm, drmModeObjectGetProperties(_, _, _))
+            .WillByDefault([this](auto, uint32_t id, auto) { return &objects.at(id).props; });
+        ON_CALL(mock_drm, drmModeGetProperty(_, _))
+            .WillByDefault([this](auto, uint32_t id) { return &properties.at(id); });
+    }
+
+    void add_object(uint32_t id, std::vector<std::pair<std::string, uint64_t>> const& props)
+    {
+        auto& object = objects[id];
+        for (auto const& [name, value] : props)
+        {
+            object.ids.push_back(property_id(name));
+            object.values.push_back(value);
+        }
+        object.props.count_props = object.ids.size();
+        object.props.props = object.ids.data();
+        object.props.prop_values = object.values.data();
+    }
+
+    void add_plane(uint32_t id, uint64_t type, uint32_t possible_crtcs, std::optional<uint64_t> zpos)
+    {
+        auto& plane = planes[id];
+        plane.plane_id = id;
+        plane.possible_crtcs = possible_crtcs;
+        plane.count_formats = 1;
+        plane.formats = &plane_format;
+        plane_ids.push_back(id);
+
+        std::vector<std::pair<std::string, uint64_t>> props{
+            {"type", type},
+            {"SRC_X", 0}, {"SRC_Y", 0}, {"SRC_W", 0}, {"SRC_H", 0},
+            {"CRTC_X", 0}, {"CRTC_Y", 0}, {"CRTC_W", 0}, {"CRTC_H", 0},
+            {"CRTC_ID", 0}, {"FB_ID", 0}};
+        if (zpos)
+        {
+            props.emplace_back("zpos", *zpos);
+        }
+        add_object(id, props);
+    }
+
+    auto make_output() -> std::unique_ptr<mga::AtomicKMSOutput>
+    {
+        auto output = std::make_unique<mga::AtomicKMSOutput>(
+            drm_fd,
+            mgk::get_connector(drm_fd, connector_id),
+            std::make_shared<StubDRMEventHandler>());
+        output->configure({0, 0}, 0);
+        return output;
+    }
+
+    /// Record the properties of the next commit with \a flags, which returns \a result
+    void expect_commit(uint32_t flags, int result = 0)
+    {
+        EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, flags, _))
+            .WillOnce(
+                [this, result](auto, drmModeAtomicReqPtr req, auto, auto)
+                {
+                    committed.push_back(mtd::atomic_request_properties(req));
+                    return result;
+                })
+            .RetiresOnSaturation();
+    }
+
+    /// The value commit \a commit set on \a object_id's \a name property, if it set one
+    auto committed_value(size_t commit, uint32_t object_id, std::string const& name) -> std::optional<uint64_t>
+    {
+        std::optional<uint64_t> value;
+        for (auto const& prop : committed.at(commit))
+        {
+            if (prop.object_id == object_id && prop.property_id == property_id(name))
+            {
+                value = prop.value;
+            }
+        }
+        return value;
+    }
+
+    auto layer(uint32_t plane_id, std::shared_ptr<StubFBHandle> fb, geom::Rectangle destination, geom::RectangleF source)
+        -> mga::OverlayLayer
+    {
+        return {plane_id, std::move(fb), destination, source};
+    }
+
+    char const* const drm_device = "/dev/dri/card0";
+    NiceMock<mtd::MockDRM> mock_drm;
+    // The fake DRM device owns its fd
+    mir::Fd const drm_fd{mir::IntOwnedFd{open(drm_device, O_RDWR | O_CLOEXEC)}};
+
+    uint32_t const other_crtc_id{10};
+    uint32_t const crtc_id{11};
+    uint32_t const encoder_id{21};
+    uint32_t const connector_id{31};
+    uint32_t const primary_plane_id{40};
+    uint32_t const our_crtc_only{0x2};   //< The second CRTC's bit
+    uint32_t const any_crtc{0x3};
+    uint32_t plane_format{DRM_FORMAT_XRGB8888};
+
+    drmModeModeInfo const mode{
+        mtd::FakeDRMResources::create_mode(1920, 1080, 138500, 2080, 1111, mtd::FakeDRMResources::PreferredMode)};
+    std::vector<drmModeModeInfo> modes{mode};
+    std::vector<uint32_t> encoder_ids{encoder_id};
+
+    std::map<uint32_t, drmModeCrtc> crtcs;
+    std::map<uint32_t, drmModePlane> planes;
+    std::vector<uint32_t> plane_ids;
+    drmModePlaneRes plane_res{};
+    std::map<uint32_t, FakeObject> objects;
+    std::map<uint32_t, drmModePropertyRes> properties;
+
+    std::vector<std::vector<mtd::AtomicProperty>> committed;
+
+    std::shared_ptr<StubFBHandle> const primary_fb{std::make_shared<StubFBHandle>(1, geom::Size{1920, 1080})};
+    std::shared_ptr<StubFBHandle> const overlay_fb{std::make_shared<StubFBHandle>(2, geom::Size{300, 150})};
+};
+
+auto plane_ids_of(std::vector<mga::OverlayPlane> const& planes) -> std::vector<uint32_t>
+{
+    std::vector<uint32_t> ids;
+    for (auto const& plane : planes)
+    {
+        ids.push_back(plane.id);
+    }
+    return ids;
+}
+}
+
+TEST_F(AtomicKMSOutputTest, offers_planes_only_its_crtc_can_use_cursor_then_topmost_first)
+{
+    add_plane(41, DRM_PLANE_TYPE_OVERLAY, our_crtc_only, 3);
+    add_plane(42, DRM_PLANE_TYPE_OVERLAY, our_crtc_only, 2);
+    add_plane(43, DRM_PLANE_TYPE_CURSOR, our_crtc_only, 4);
+    add_plane(44, DRM_PLANE_TYPE_OVERLAY, any_crtc, 5);
+    add_plane(45, DRM_PLANE_TYPE_OVERLAY, 0x1, 5);
+
+    auto const output = make_output();
+    auto const overlays = output->overlay_planes();
+
+    EXPECT_THAT(plane_ids_of(overlays), ElementsAre(43, 41, 42));
+    EXPECT_TRUE(overlays[0].cursor);
+    EXPECT_THAT(overlays[1].formats, ElementsAre(Pair(DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_INVALID)));
+}
+
+TEST_F(AtomicKMSOutputTest, does_not_offer_planes_beneath_the_primary_plane)
+{
+    add_plane(41, DRM_PLANE_TYPE_OVERLAY, our_crtc_only, 2);
+    add_plane(42, DRM_PLANE_TYPE_OVERLAY, our_crtc_only, 1);
+    add_plane(43, DRM_PLANE_TYPE_OVERLAY, our_crtc_only, 0);
+
+    auto const output = make_output();
+
+    EXPECT_THAT(plane_ids_of(output->overlay_planes()), ElementsAre(41));
+}
+
+TEST_F(AtomicKMSOutputTest, offers_a_single_overlay_when_their_stacking_is_unknown)
+{
+    add_plane(41, DRM_PLANE_TYPE_OVERLAY, our_crtc_only, std::nullopt);
+    add_plane(42, DRM_PLANE_TYPE_OVERLAY, our_crtc_only, std::nullopt);
+    add_plane(43, DRM_PLANE_TYPE_CURSOR, our_crtc_only, std::nullopt);
+
+    auto const output = make_output();
+
+    EXPECT_THAT(plane_ids_of(output->overlay_planes()), ElementsAre(43, 41));
+}
+
+TEST_F(AtomicKMSOutputTest, test_layers_only_tests_the_commit)
+{
+    add_plane(41, DRM_PLANE_TYPE_OVERLAY, our_crtc_only, 2);
+    auto const output = make_output();
+
+    expect_commit(DRM_MODE_ATOMIC_TEST_ONLY);
+    EXPECT_TRUE(output->test_layers(*primary_fb, {layer(41, overlay_fb, {{10, 20}, {200, 100}}, {{0, 0}, {300, 150}})}));
+
+    EXPECT_THAT(committed_value(0, 41, "FB_ID"), Optional(2u));
+    EXPECT_THAT(committed_value(0, primary_plane_id, "FB_ID"), Optional(1u));
+}
+
+TEST_F(AtomicKMSOutputTest, test_layers_fails_when_the_hardware_rejects_them)
+{
+    add_plane(41, DRM_PLANE_TYPE_OVERLAY, our_crtc_only, 2);
+    auto const output = make_output();
+
+    expect_commit(DRM_MODE_ATOMIC_TEST_ONLY, -EINVAL);
+    EXPECT_FALSE(output->test_layers(*primary_fb, {layer(41, overlay_fb, {{10, 20}, {200, 100}}, {{0, 0}, {300, 150}})}));
+}
+
+TEST_F(AtomicKMSOutputTest, elements_the_hardware_rejects_are_composited)
+{
+    add_plane(41, DRM_PLANE_TYPE_OVERLAY, our_crtc_only, 3);
+    add_plane(42, DRM_PLANE_TYPE_OVERLAY, our_crtc_only, 2);
+    auto const output = make_output();
+
+    // This hardware can only manage one overlay at a time
+    ON_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillByDefault(
+            [](auto, drmModeAtomicReqPtr req, auto, auto)
+            {
+                auto const props = mtd::atomic_request_properties(req);
+                auto const lit = std::count_if(
+                    props.begin(),
+                    props.end(),
+                    [](auto const& prop) { return prop.property_id == property_id("FB_ID") && prop.value; });
+                return lit > 2 ? -EINVAL : 0;
+            });
+
+    auto const candidate = [this](geom::Rectangle destination) -> mga::OverlayCandidate
+        {
+            return {overlay_fb, DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_LINEAR, destination, {{0, 0}, {300, 150}}};
+        };
+    auto const assignment = mga::assign_overlay_planes(
+        {candidate({{0, 0}, {300, 150}}), candidate({{500, 500}, {300, 150}})},
+        output->overlay_planes(),
+        [&](std::vector<mga::OverlayLayer> const& layers) { return output->test_layers(*primary_fb, layers); });
+
+    EXPECT_THAT(assignment.on_plane, ElementsAre(false, true));
+    ASSERT_THAT(assignment.layers, SizeIs(1));
+    EXPECT_THAT(assignment.layers[0].plane_id, Eq(41u));
+}
+
+TEST_F(AtomicKMSOutputTest, page_flip_shows_layers_on_their_planes)
+{
+    add_plane(41, DRM_PLANE_TYPE_OVERLAY, our_crtc_only, 2);
+    auto const output = make_output();
+
+    expect_commit(DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT);
+    EXPECT_TRUE(output->schedule_page_flip(
+        *primary_fb,
+        {layer(41, overlay_fb, {{10, 20}, {200, 100}}, {{1.5f, 0}, {297, 150}})}));
+
+    // Source rectangles are 16.16 fixed point
+    EXPECT_THAT(committed_value(0, 41, "SRC_X"), Optional(98304u));
+    EXPECT_THAT(committed_value(0, 41, "SRC_Y"), Optional(0u));
+    EXPECT_THAT(committed_value(0, 41, "SRC_W"), Optional(297u << 16));
+    EXPECT_THAT(committed_value(0, 41, "SRC_H"), Optional(150u << 16));
+    EXPECT_THAT(committed_value(0, 41, "CRTC_X"), Optional(10u));
+    EXPECT_THAT(committed_value(0, 41, "CRTC_Y"), Optional(20u));
+    EXPECT_THAT(committed_value(0, 41, "CRTC_W"), Optional(200u));
+    EXPECT_THAT(committed_value(0, 41, "CRTC_H"), Optional(100u));
+    EXPECT_THAT(committed_value(0, 41, "CRTC_ID"), Optional(crtc_id));
+    EXPECT_THAT(committed_value(0, 41, "FB_ID"), Optional(2u));
+
+    EXPECT_THAT(committed_value(0, primary_plane_id, "SRC_W"), Optional(1920u << 16));
+    EXPECT_THAT(committed_value(0, primary_plane_id, "CRTC_W"), Optional(1920u));
+}
+
+TEST_F(AtomicKMSOutputTest, page_flip_switches_off_planes_no_longer_used)
+{
+    add_plane(41, DRM_PLANE_TYPE_OVERLAY, our_crtc_only, 2);
+    auto const output = make_output();
+
+    expect_commit(DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT);
+    expect_commit(DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT);
+    output->schedule_page_flip(*primary_fb, {layer(41, overlay_fb, {{10, 20}, {200, 100}}, {{0, 0}, {300, 150}})});
+    output->schedule_page_flip(*primary_fb, {});
+
+    EXPECT_THAT(committed_value(1, 41, "FB_ID"), Optional(0u));
+    EXPECT_THAT(committed_value(1, 41, "CRTC_ID"), Optional(0u));
+}
+
+TEST_F(AtomicKMSOutputTest, tested_layers_are_not_left_on)
+{
+    add_plane(41, DRM_PLANE_TYPE_OVERLAY, our_crtc_only, 2);
+    auto const output = make_output();
+
+    expect_commit(DRM_MODE_ATOMIC_TEST_ONLY);
+    expect_commit(DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT);
+    output->test_layers(*primary_fb, {layer(41, overlay_fb, {{10, 20}, {200, 100}}, {{0, 0}, {300, 150}})});
+    output->schedule_page_flip(*primary_fb, {});
+
+    // The TEST_ONLY commit showed nothing, so there's nothing to switch off
+    EXPECT_THAT(committed_value(1, 41, "FB_ID"), Eq(std::nullopt));
+}
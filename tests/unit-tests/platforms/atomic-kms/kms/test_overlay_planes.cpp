@@ -0,0 +1,227 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/atomic-kms/server/kms/overlay_planes.h"
+#include "src/platforms/common/server/kms_framebuffer.h"
+
+#include <drm_fourcc.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mg = mir::graphics;
+namespace mga = mir::graphics::atomic;
+namespace geom = mir::geometry;
+using namespace ::testing;
+
+namespace
+{
+struct StubFBHandle : mg::FBHandle
+{
+    auto size() const -> geom::Size override { return {100, 100}; }
+    operator uint32_t() const override { return 1; }
+};
+
+auto candidate(geom::Rectangle destination, bool has_fb = true, uint32_t format = DRM_FORMAT_XRGB8888)
+    -> mga::OverlayCandidate
+{
+    return {
+        has_fb ? std::make_shared<StubFBHandle>() : nullptr,
+        format,
+        DRM_FORMAT_MOD_LINEAR,
+        destination,
+        geom::RectangleF{{0, 0}, {destination.size.width.as_value(), destination.size.height.as_value()}}};
+}
+
+auto overlay(uint32_t id, bool cursor = false) -> mga::OverlayPlane
+{
+    return {id, cursor, {{DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_LINEAR}, {DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_LINEAR}}};
+}
+
+auto plane_ids(std::vector<mga::OverlayLayer> const& layers) -> std::vector<uint32_t>
+{
+    std::vector<uint32_t> ids;
+    for (auto const& layer : layers)
+    {
+        ids.push_back(layer.plane_id);
+    }
+    return ids;
+}
+
+auto const accept_all = [](std::vector<mga::OverlayLayer> const&) { return true; };
+}
+
+TEST(OverlayPlanes, assigns_topmost_elements_to_topmost_planes)
+{
+    auto const assignment = mga::assign_overlay_planes(
+        {candidate({{0, 0}, {10, 10}}), candidate({{20, 20}, {10, 10}})},
+        {overlay(7), overlay(8)},
+        accept_all);
+
+    EXPECT_THAT(assignment.on_plane, ElementsAre(true, true));
+    EXPECT_THAT(plane_ids(assignment.layers), ElementsAre(7, 8));
+    EXPECT_THAT(assignment.layers[0].destination, Eq(geom::Rectangle{{20, 20}, {10, 10}}));
+}
+
+TEST(OverlayPlanes, composites_elements_without_framebuffers)
+{
+    auto const assignment = mga::assign_overlay_planes(
+        {candidate({{0, 0}, {10, 10}}), candidate({{20, 20}, {10, 10}}, false)},
+        {overlay(7), overlay(8)},
+        accept_all);
+
+    EXPECT_THAT(assignment.on_plane, ElementsAre(true, false));
+    EXPECT_THAT(plane_ids(assignment.layers), ElementsAre(7));
+}
+
+TEST(OverlayPlanes, does_not_lift_elements_beneath_composited_ones)
+{
+    auto const assignment = mga::assign_overlay_planes(
+        {candidate({{0, 0}, {10, 10}}), candidate({{5, 5}, {10, 10}}, false)},
+        {overlay(7), overlay(8)},
+        accept_all);
+
+    EXPECT_THAT(assignment.on_plane, ElementsAre(false, false));
+    EXPECT_THAT(assignment.layers, IsEmpty());
+}
+
+TEST(OverlayPlanes, does_not_use_more_planes_than_there_are)
+{
+    auto const assignment = mga::assign_overlay_planes(
+        {candidate({{0, 0}, {10, 10}}), candidate({{20, 20}, {10, 10}}), candidate({{40, 40}, {10, 10}})},
+        {overlay(7)},
+        accept_all);
+
+    EXPECT_THAT(assignment.on_plane, ElementsAre(false, false, true));
+}
+
+TEST(OverlayPlanes, skips_planes_that_do_not_support_the_format)
+{
+    auto const assignment = mga::assign_overlay_planes(
+        {candidate({{0, 0}, {10, 10}}, true, DRM_FORMAT_NV12)},
+        {overlay(7)},
+        accept_all);
+
+    EXPECT_THAT(assignment.on_plane, ElementsAre(false));
+}
+
+TEST(OverlayPlanes, does_not_scale_on_cursor_planes)
+{
+    auto scaled = candidate({{0, 0}, {64, 64}});
+    scaled.source = geom::RectangleF{{0, 0}, {32, 32}};
+
+    auto const assignment = mga::assign_overlay_planes(
+        {candidate({{100, 100}, {10, 10}}), scaled},
+        {overlay(7, true), overlay(8)},
+        accept_all);
+
+    EXPECT_THAT(assignment.on_plane, ElementsAre(false, true));
+    EXPECT_THAT(plane_ids(assignment.layers), ElementsAre(8));
+}
+
+TEST(OverlayPlanes, composites_elements_the_hardware_rejects)
+{
+    auto const assignment = mga::assign_overlay_planes(
+        {candidate({{0, 0}, {10, 10}}), candidate({{20, 20}, {10, 10}})},
+        {overlay(7), overlay(8)},
+        [](std::vector<mga::OverlayLayer> const& layers) { return layers.size() < 2; });
+
+    EXPECT_THAT(assignment.on_plane, ElementsAre(false, true));
+    EXPECT_THAT(plane_ids(assignment.layers), ElementsAre(7));
+}
+
+TEST(OverlayPlanes, tests_each_assignment_with_those_above_it)
+{
+    std::vector<std::vector<uint32_t>> tested;
+
+    mga::assign_overlay_planes(
+        {candidate({{0, 0}, {10, 10}}), candidate({{20, 20}, {10, 10}})},
+        {overlay(7), overlay(8)},
+        [&](std::vector<mga::OverlayLayer> const& layers)
+        {
+            tested.push_back(plane_ids(layers));
+            return true;
+        });
+
+    EXPECT_THAT(tested, ElementsAre(ElementsAre(7), ElementsAre(7, 8)));
+}
+
+TEST(OverlayPlanes, implicit_modifiers_are_left_for_the_hardware_to_judge)
+{
+    mga::OverlayPlane const plane{7, false, {{DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_LINEAR}}};
+
+    EXPECT_TRUE(plane.supports(DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_INVALID));
+    EXPECT_FALSE(plane.supports(DRM_FORMAT_XRGB8888, I915_FORMAT_MOD_X_TILED));
+    EXPECT_FALSE(plane.supports(DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_LINEAR));
+}
+
+TEST(OverlayPlanes, unscaled_output_shows_elements_where_they_are)
+{
+    EXPECT_THAT(
+        mga::logical_to_crtc({{10, 20}, {100, 50}}, {1920, 1080}, {1920, 1080}),
+        Eq(geom::Rectangle{{10, 20}, {100, 50}}));
+}
+
+TEST(OverlayPlanes, scaled_output_shows_elements_in_mode_pixels)
+{
+    // A 1920x1080 mode at scale 2 shows 960x540 of the scene
+    EXPECT_THAT(
+        mga::logical_to_crtc({{10, 20}, {100, 50}}, {960, 540}, {1920, 1080}),
+        Eq(geom::Rectangle{{20, 40}, {200, 100}}));
+}
+
+TEST(OverlayPlanes, fractionally_scaled_output_keeps_abutting_elements_abutting)
+{
+    // A 1920x1080 mode at scale 1.5 shows 1280x720 of the scene
+    geom::Size const view{1280, 720};
+    geom::Size const mode{1920, 1080};
+
+    auto const left = mga::logical_to_crtc({{0, 0}, {101, 101}}, view, mode);
+    auto const right = mga::logical_to_crtc({{101, 0}, {101, 101}}, view, mode);
+
+    EXPECT_THAT(right.left(), Eq(left.right()));
+    EXPECT_THAT(right.right(), Eq(geom::X{303}));
+}
+
+TEST(OverlayPlanes, element_filling_scaled_output_fills_the_mode)
+{
+    EXPECT_THAT(
+        mga::logical_to_crtc({{0, 0}, {1280, 720}}, {1280, 720}, {1920, 1080}),
+        Eq(geom::Rectangle{{0, 0}, {1920, 1080}}));
+}
+
+TEST(OverlayPlanes, buffer_source_of_unscaled_element_is_its_screen_source)
+{
+    EXPECT_THAT(
+        mga::to_buffer_source({{10, 20}, {100, 50}}, {200, 100}, {200, 100}),
+        Eq(geom::RectangleF{{10, 20}, {100, 50}}));
+}
+
+TEST(OverlayPlanes, buffer_source_is_scaled_to_buffer_pixels)
+{
+    // A scale 2 client's 400x200 buffer shown as a 200x100 element
+    EXPECT_THAT(
+        mga::to_buffer_source({{10, 20}, {100, 50}}, {200, 100}, {400, 200}),
+        Eq(geom::RectangleF{{20, 40}, {200, 100}}));
+}
+
+TEST(OverlayPlanes, buffer_source_keeps_fractional_buffer_pixels)
+{
+    // A scale 1.5 client's 300x150 buffer shown as a 200x100 element
+    EXPECT_THAT(
+        mga::to_buffer_source({{1, 1}, {199, 99}}, {200, 100}, {300, 150}),
+        Eq(geom::RectangleF{{1.5f, 1.5f}, {298.5f, 148.5f}}));
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/atomic-kms/server/kms/render_time_predictor.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mga = mir::graphics::atomic;
+using namespace ::testing;
+using namespace std::chrono_literals;
+
+TEST(RenderTimePredictor, has_no_prediction_without_history)
+{
+    mga::RenderTimePredictor predictor;
+
+    EXPECT_THAT(predictor.prediction(), Eq(std::nullopt));
+}
+
+TEST(RenderTimePredictor, prediction_allows_for_more_than_a_steady_frame_time)
+{
+    mga::RenderTimePredictor predictor;
+
+    predictor.add_sample(4ms);
+
+    ASSERT_TRUE(predictor.prediction());
+    EXPECT_THAT(*predictor.prediction(), Gt(4ms));
+}
+
+TEST(RenderTimePredictor, prediction_converges_on_a_steady_frame_time)
+{
+    mga::RenderTimePredictor predictor;
+
+    predictor.add_sample(12ms);
+    for (auto i = 0; i != 100; ++i)
+    {
+        predictor.add_sample(3ms);
+    }
+
+    ASSERT_TRUE(predictor.prediction());
+    EXPECT_THAT(*predictor.prediction(), AllOf(Ge(3ms), Lt(4ms)));
+}
+
+TEST(RenderTimePredictor, a_slow_frame_raises_the_prediction_beyond_the_average)
+{
+    mga::RenderTimePredictor predictor;
+    for (auto i = 0; i != 100; ++i)
+    {
+        predictor.add_sample(3ms);
+    }
+    auto const steady = *predictor.prediction();
+
+    predictor.add_sample(11ms);
+
+    EXPECT_THAT(*predictor.prediction(), Gt(steady + 1ms));
+}
+
+TEST(RenderTimePredictor, missing_a_deadline_raises_the_prediction)
+{
+    mga::RenderTimePredictor predictor;
+    for (auto i = 0; i != 100; ++i)
+    {
+        predictor.add_sample(3ms);
+    }
+    auto const before = *predictor.prediction();
+
+    predictor.missed_deadline();
+
+    EXPECT_THAT(*predictor.prediction(), Gt(before + 2ms));
+}
@@ -48,7 +48,12 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
         return schedule_page_flip_thunk(&fb);
     }
     MOCK_METHOD(bool, schedule_page_flip_thunk, (graphics::FBHandle const*), ());
-    MOCK_METHOD(void, wait_for_page_flip, (), (override));
+    bool schedule_async_page_flip(graphics::FBHandle const& fb) override
+    {
+        return schedule_async_page_flip_thunk(&fb);
+    }
+    MOCK_METHOD(bool, schedule_async_page_flip_thunk, (graphics::FBHandle const*), ());
+    MOCK_METHOD(std::optional<graphics::FramePresentation>, wait_for_page_flip, (), (override));
 
     MOCK_METHOD(bool, set_cursor_image, (gbm_bo*), (override));
     MOCK_METHOD(void, move_cursor, (geometry::Point), (override));
@@ -221,6 +221,119 @@ TEST_F(MesaDisplaySinkTest, untransformed_with_bypassable_list_can_bypass)
     EXPECT_TRUE(sink.overlay(bypassable_list));
 }
 
+TEST_F(MesaDisplaySinkTest, bypass_buffer_allowing_tearing_is_flipped_to_asynchronously)
+{
+    auto tearing_list = bypassable_list;
+    tearing_list.front().allow_tearing = true;
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, schedule_async_page_flip_thunk(_))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(0);
+
+    ASSERT_TRUE(sink.overlay(tearing_list));
+    sink.post();
+}
+
+TEST_F(MesaDisplaySinkTest, falls_back_to_vsynced_flip_when_async_flip_is_unavailable)
+{
+    auto tearing_list = bypassable_list;
+    tearing_list.front().allow_tearing = true;
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, schedule_async_page_flip_thunk(_))
+        .WillOnce(Return(false));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .WillOnce(Return(true));
+
+    ASSERT_TRUE(sink.overlay(tearing_list));
+    sink.post();
+}
+
+TEST_F(MesaDisplaySinkTest, bypass_buffer_not_allowing_tearing_is_not_flipped_to_asynchronously)
+{
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, schedule_async_page_flip_thunk(_))
+        .Times(0);
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .WillOnce(Return(true));
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+}
+
+TEST_F(MesaDisplaySinkTest, clone_mode_reports_flip_of_slowest_output_for_the_frame_posted)
+{
+    auto const make_output = [](unsigned refresh_rate, int64_t msc)
+        {
+            auto const output = std::make_shared<NiceMock<MockKMSOutput>>();
+            ON_CALL(*output, set_crtc_thunk(_)).WillByDefault(Return(true));
+            ON_CALL(*output, schedule_page_flip_thunk(_)).WillByDefault(Return(true));
+            ON_CALL(*output, max_refresh_rate()).WillByDefault(Return(refresh_rate));
+            FramePresentation flip;
+            flip.frame.msc = msc;
+            flip.hw_clock = true;
+            ON_CALL(*output, wait_for_page_flip()).WillByDefault(Return(flip));
+            return output;
+        };
+    auto const fast_output = make_output(120, 7);
+    auto const slow_output = make_output(60, 42);
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {fast_output, slow_output},
+        display_area,
+        identity);
+
+    // The composited frame's flip on the slowest output is waited for, and reported, as it is posted...
+    EXPECT_CALL(*slow_output, wait_for_page_flip());
+    EXPECT_CALL(*fast_output, wait_for_page_flip()).Times(0);
+
+    sink.set_next_image(std::make_unique<NiceMock<MockKMSFramebuffer>>());
+    sink.post();
+
+    ASSERT_TRUE(sink.last_presentation());
+    EXPECT_THAT(sink.last_presentation()->frame.msc, Eq(42));
+    EXPECT_TRUE(sink.last_presentation()->hw_clock);
+    Mock::VerifyAndClearExpectations(slow_output.get());
+    Mock::VerifyAndClearExpectations(fast_output.get());
+
+    // ...while the other output's flip is only waited for before the next frame, and isn't reported for it
+    EXPECT_CALL(*fast_output, wait_for_page_flip());
+
+    sink.post();
+
+    EXPECT_THAT(sink.last_presentation(), Eq(std::nullopt));
+}
+
 namespace
 {
 template<typename T>
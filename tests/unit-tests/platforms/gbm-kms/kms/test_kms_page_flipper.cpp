@@ -83,6 +83,38 @@ TEST_F(KMSPageFlipperTest, schedule_flip_calls_drm_page_flip)
     page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
 }
 
+TEST_F(KMSPageFlipperTest, schedule_async_flip_fails_without_driver_support)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const fb_id{101};
+    uint32_t const connector_id{345};
+
+    EXPECT_CALL(mock_drm, drmModePageFlip(_, _, _, _, _))
+        .Times(0);
+
+    EXPECT_FALSE(page_flipper.schedule_async_flip(crtc_id, fb_id, connector_id));
+}
+
+TEST_F(KMSPageFlipperTest, schedule_async_flip_calls_drm_page_flip_with_async_flag)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const fb_id{101};
+    uint32_t const connector_id{345};
+
+    ON_CALL(mock_drm, drmGetCap(drm_fd, DRM_CAP_ASYNC_PAGE_FLIP, _))
+        .WillByDefault(DoAll(SetArgPointee<2>(1), Return(0)));
+    mgg::KMSPageFlipper async_page_flipper{drm_fd, mt::fake_shared(report)};
+
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_PAGE_FLIP_ASYNC, _))
+        .WillOnce(Return(0));
+
+    EXPECT_TRUE(async_page_flipper.schedule_async_flip(crtc_id, fb_id, connector_id));
+}
+
 TEST_F(KMSPageFlipperTest, double_schedule_flip_throws)
 {
     using namespace testing;
@@ -45,6 +45,7 @@ class NullPageFlipper : public mgg::PageFlipper
 {
 public:
     bool schedule_flip(uint32_t,uint32_t,uint32_t) override { return true; }
+    bool schedule_async_flip(uint32_t,uint32_t,uint32_t) override { return true; }
     mg::Frame wait_for_flip(uint32_t) override { return {}; }
 };
 
@@ -52,6 +53,7 @@ class MockPageFlipper : public mgg::PageFlipper
 {
 public:
     MOCK_METHOD(bool, schedule_flip, (uint32_t,uint32_t,uint32_t), (override));
+    MOCK_METHOD(bool, schedule_async_flip, (uint32_t,uint32_t,uint32_t), (override));
     MOCK_METHOD(mg::Frame, wait_for_flip, (uint32_t), (override));
 };
 
@@ -235,6 +237,69 @@ TEST_F(RealKMSOutputTest, operations_use_existing_crtc)
     output.wait_for_page_flip();
 }
 
+TEST_F(RealKMSOutputTest, wait_for_page_flip_reports_when_the_flip_was_presented)
+{
+    using namespace testing;
+
+    setup_outputs_connected_crtc();
+
+    uint32_t const fb_id{42};
+    auto const fb = std::make_shared<MockKMSFramebuffer>(fb_id);
+
+    mg::Frame flip;
+    flip.msc = 1234;
+    flip.ust = {CLOCK_MONOTONIC, std::chrono::nanoseconds{5678}};
+
+    EXPECT_CALL(mock_page_flipper, schedule_flip(crtc_ids[0], fb_id, connector_ids[0]))
+        .WillOnce(Return(true));
+    EXPECT_CALL(mock_page_flipper, wait_for_flip(crtc_ids[0]))
+        .WillOnce(Return(flip));
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    EXPECT_TRUE(output.set_crtc(*fb));
+    EXPECT_TRUE(output.schedule_page_flip(*fb));
+
+    auto const presentation = output.wait_for_page_flip();
+    ASSERT_TRUE(presentation);
+    EXPECT_THAT(presentation->frame.msc, Eq(flip.msc));
+    EXPECT_THAT(presentation->frame.ust, Eq(flip.ust));
+    EXPECT_TRUE(presentation->vsync);
+    EXPECT_TRUE(presentation->hw_clock);
+    EXPECT_TRUE(presentation->hw_completion);
+}
+
+TEST_F(RealKMSOutputTest, async_page_flip_is_reported_as_not_vsynced)
+{
+    using namespace testing;
+
+    setup_outputs_connected_crtc();
+
+    uint32_t const fb_id{42};
+    auto const fb = std::make_shared<MockKMSFramebuffer>(fb_id);
+
+    EXPECT_CALL(mock_page_flipper, schedule_async_flip(crtc_ids[0], fb_id, connector_ids[0]))
+        .WillOnce(Return(true));
+    EXPECT_CALL(mock_page_flipper, wait_for_flip(crtc_ids[0]))
+        .WillOnce(Return(mg::Frame{}));
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    EXPECT_TRUE(output.set_crtc(*fb));
+    EXPECT_TRUE(output.schedule_async_page_flip(*fb));
+
+    auto const presentation = output.wait_for_page_flip();
+    ASSERT_TRUE(presentation);
+    EXPECT_FALSE(presentation->vsync);
+    EXPECT_TRUE(presentation->hw_completion);
+}
+
 TEST_F(RealKMSOutputTest, operations_use_possible_crtc)
 {
     using namespace testing;
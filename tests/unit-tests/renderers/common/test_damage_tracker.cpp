@@ -0,0 +1,104 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platform/renderers/common/damage_tracker.h"
+
+#include <mir/test/doubles/fake_renderable.h>
+#include <mir/test/doubles/stub_buffer.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+namespace mg = mir::graphics;
+namespace mr = mir::renderer;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+namespace
+{
+struct DamageTracker : Test
+{
+    auto repaint() -> std::optional<geom::Rectangle>
+    {
+        return tracker.area_to_repaint(renderables, viewport, 1);
+    }
+
+    geom::Rectangle const viewport{{0, 0}, {1000, 1000}};
+    geom::Rectangle const surface_area{{100, 100}, {500, 400}};
+    std::shared_ptr<mtd::StubBuffer> const first_buffer{std::make_shared<mtd::StubBuffer>(mg::BufferID{1})};
+    std::shared_ptr<mtd::StubBuffer> const second_buffer{std::make_shared<mtd::StubBuffer>(mg::BufferID{2})};
+    std::shared_ptr<mtd::FakeRenderable> const surface{std::make_shared<mtd::FakeRenderable>(surface_area)};
+    mg::RenderableList const renderables{surface};
+    mr::DamageTracker tracker;
+};
+}
+
+TEST_F(DamageTracker, repaints_everything_for_first_frame)
+{
+    surface->set_buffer(first_buffer);
+
+    EXPECT_THAT(repaint(), Eq(std::nullopt));
+}
+
+TEST_F(DamageTracker, repaints_nothing_when_nothing_changed)
+{
+    surface->set_buffer(first_buffer);
+    repaint();
+
+    EXPECT_THAT(repaint(), Eq(geom::Rectangle{}));
+}
+
+TEST_F(DamageTracker, repaints_whole_renderable_when_new_buffer_damage_is_unknown)
+{
+    surface->set_buffer(first_buffer);
+    repaint();
+
+    surface->set_buffer(second_buffer);
+
+    EXPECT_THAT(repaint(), Eq(surface_area));
+}
+
+TEST_F(DamageTracker, repaints_only_damaged_part_of_new_buffer)
+{
+    surface->set_buffer(first_buffer);
+    repaint();
+
+    geom::Rectangle const damage{{110, 120}, {20, 10}};
+    surface->set_buffer(second_buffer, first_buffer->id(), geom::Rectangles{damage});
+
+    EXPECT_THAT(repaint(), Eq(damage));
+}
+
+TEST_F(DamageTracker, ignores_damage_relative_to_a_buffer_that_was_not_shown)
+{
+    surface->set_buffer(first_buffer);
+    repaint();
+
+    surface->set_buffer(second_buffer, mg::BufferID{3}, geom::Rectangles{{{110, 120}, {20, 10}}});
+
+    EXPECT_THAT(repaint(), Eq(surface_area));
+}
+
+TEST_F(DamageTracker, clips_buffer_damage_to_the_renderable)
+{
+    surface->set_buffer(first_buffer);
+    repaint();
+
+    surface->set_buffer(second_buffer, first_buffer->id(), geom::Rectangles{{{550, 450}, {100, 100}}});
+
+    EXPECT_THAT(repaint(), Eq(geom::Rectangle{{550, 450}, {50, 50}}));
+}
@@ -593,3 +593,116 @@ TEST_F(GLRenderer, destroys_gl_resources_with_current_context)
                EXPECT_THAT(eglGetCurrentContext(), testing::Eq(dummy_ctx));
             });
 }
+
+TEST_F(GLRenderer, repaints_everything_when_buffer_age_is_unknown)
+{
+    auto output_surface = make_output_surface();
+    ON_CALL(*output_surface, buffer_age()).WillByDefault(Return(0));
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(mock_gl, glScissor(_, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glClear(_));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _)).Times(AtLeast(1));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, does_not_repaint_unchanged_scene_into_preserved_buffer)
+{
+    auto output_surface = make_output_surface();
+    ON_CALL(*output_surface, size()).WillByDefault(Return(mir::geometry::Size{100, 100}));
+    ON_CALL(*output_surface, buffer_age()).WillByDefault(Return(1));
+    auto const raw_surface = output_surface.get();
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport({{0, 0}, {100, 100}});
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(mock_gl, glClear(_)).Times(0);
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _)).Times(0);
+    EXPECT_CALL(*raw_surface, commit());
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, only_repaints_area_of_changed_renderable)
+{
+    auto output_surface = make_output_surface();
+    ON_CALL(*output_surface, size()).WillByDefault(Return(mir::geometry::Size{100, 100}));
+    ON_CALL(*output_surface, buffer_age()).WillByDefault(Return(1));
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport({{0, 0}, {100, 100}});
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(*mock_buffer, id()).WillRepeatedly(Return(mir::graphics::BufferID(790)));
+    EXPECT_CALL(mock_gl, glEnable(GL_SCISSOR_TEST));
+    EXPECT_CALL(mock_gl, glScissor(_, _, testing::Lt(100), testing::Lt(100)));
+    EXPECT_CALL(mock_gl, glClear(_));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _)).Times(AtLeast(1));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, repaints_everything_after_viewport_change)
+{
+    auto output_surface = make_output_surface();
+    ON_CALL(*output_surface, size()).WillByDefault(Return(mir::geometry::Size{100, 100}));
+    ON_CALL(*output_surface, buffer_age()).WillByDefault(Return(1));
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport({{0, 0}, {100, 100}});
+    renderer.render(renderable_list);
+
+    renderer.set_viewport({{0, 0}, {50, 50}});
+
+    EXPECT_CALL(mock_gl, glScissor(_, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glClear(_));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, tells_output_surface_which_area_it_repainted)
+{
+    auto output_surface = make_output_surface();
+    ON_CALL(*output_surface, size()).WillByDefault(Return(mir::geometry::Size{100, 100}));
+    ON_CALL(*output_surface, buffer_age()).WillByDefault(Return(1));
+    auto const raw_surface = output_surface.get();
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport({{0, 0}, {100, 100}});
+    renderer.render(renderable_list);
+
+    std::optional<mir::geometry::Rectangle> damage;
+    ON_CALL(*raw_surface, set_damage(_)).WillByDefault(testing::SaveArg<0>(&damage));
+    EXPECT_CALL(*mock_buffer, id()).WillRepeatedly(Return(mir::graphics::BufferID(790)));
+
+    renderer.render(renderable_list);
+
+    ASSERT_TRUE(damage);
+    EXPECT_THAT(damage->size.width.as_int(), testing::AllOf(testing::Gt(0), testing::Lt(100)));
+    EXPECT_THAT(damage->size.height.as_int(), testing::AllOf(testing::Gt(0), testing::Lt(100)));
+}
+
+TEST_F(GLRenderer, tells_output_surface_everything_changed_when_buffer_age_is_unknown)
+{
+    auto output_surface = make_output_surface();
+    ON_CALL(*output_surface, buffer_age()).WillByDefault(Return(0));
+    EXPECT_CALL(*output_surface, set_damage(testing::Eq(std::nullopt))).Times(AtLeast(1));
+    EXPECT_CALL(*output_surface, set_damage(testing::Ne(std::nullopt))).Times(0);
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, discards_pending_frame_when_suspended)
+{
+    auto output_surface = make_output_surface();
+    EXPECT_CALL(*output_surface, discard_pending_frame());
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.render(renderable_list);
+    renderer.suspend();
+}
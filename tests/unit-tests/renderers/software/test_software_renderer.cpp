@@ -0,0 +1,365 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <mir/renderers/software/renderer.h>
+#include <mir/renderers/software/renderer_factory.h>
+#include <mir/graphics/transformation.h>
+#include <mir/renderer/sw/pixel_source.h>
+
+#include <mir/test/doubles/fake_renderable.h>
+#include <mir/test/doubles/stub_buffer.h>
+#include <mir/test/doubles/stub_display_sink.h>
+#include <mir/test/doubles/null_display_sink.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <drm_fourcc.h>
+
+#include <cstring>
+#include <utility>
+
+using namespace testing;
+namespace mg = mir::graphics;
+namespace mrs = mir::renderer::software;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+namespace
+{
+uint32_t const opaque_black{0xff000000};
+uint32_t const opaque_red{0xffff0000};
+uint32_t const opaque_white{0xffffffff};
+
+auto filled_buffer(geom::Size size, MirPixelFormat format, uint32_t pixel) -> std::shared_ptr<mtd::StubBuffer>
+{
+    auto const buffer = std::make_shared<mtd::StubBuffer>(size, format);
+    auto const mapping = buffer->map_writeable();
+    for (auto y = 0; y != size.height.as_int(); ++y)
+    {
+        auto const row = reinterpret_cast<uint32_t*>(mapping->data() + y * mapping->stride().as_int());
+        std::fill(row, row + size.width.as_int(), pixel);
+    }
+    return buffer;
+}
+
+/// A buffer that counts how often the renderer reads it
+class CountingBuffer : public mtd::StubBuffer
+{
+public:
+    using StubBuffer::StubBuffer;
+
+    auto map_readable() const -> std::unique_ptr<mrs::Mapping<std::byte const>> override
+    {
+        ++reads;
+        return StubBuffer::map_readable();
+    }
+
+    mutable int reads{0};
+};
+
+/// An allocator that recycles a single framebuffer, reporting its age as the KMS allocator does
+class RecyclingAllocator : public mg::CPUAddressableDisplayAllocator
+{
+public:
+    explicit RecyclingAllocator(geom::Size size)
+        : storage{std::make_shared<mtd::StubBuffer>(size, mir_pixel_format_argb_8888)}
+    {
+    }
+
+    auto supported_formats() const -> std::vector<mg::DRMFormat> override
+    {
+        return {mg::DRMFormat{DRM_FORMAT_ARGB8888}};
+    }
+
+    auto alloc_fb(mg::DRMFormat) -> std::unique_ptr<MappableFB> override
+    {
+        return std::make_unique<FB>(storage, std::exchange(age, 1));
+    }
+
+    auto output_size() const -> geom::Size override
+    {
+        return storage->size();
+    }
+
+    /// Put \a pixel straight into the framebuffer, as if left over from an earlier frame
+    void scribble(int x, int y, uint32_t pixel)
+    {
+        auto const mapping = storage->map_writeable();
+        std::memcpy(mapping->data() + y * mapping->stride().as_int() + x * sizeof(pixel), &pixel, sizeof(pixel));
+    }
+
+private:
+    class FB : public MappableFB
+    {
+    public:
+        FB(std::shared_ptr<mtd::StubBuffer> storage, int age)
+            : storage{std::move(storage)},
+              age{age}
+        {
+        }
+
+        auto map_writeable() -> std::unique_ptr<mrs::Mapping<std::byte>> override
+        {
+            return storage->map_writeable();
+        }
+
+        auto format() const -> MirPixelFormat override { return storage->format(); }
+        auto stride() const -> geom::Stride override { return storage->stride(); }
+        auto size() const -> geom::Size override { return storage->size(); }
+        auto buffer_age() const -> int override { return age; }
+
+    private:
+        std::shared_ptr<mtd::StubBuffer> const storage;
+        int const age;
+    };
+
+    std::shared_ptr<mtd::StubBuffer> const storage;
+    int age{0};
+};
+
+auto channel(uint32_t pixel, int shift) -> int
+{
+    return (pixel >> shift) & 0xff;
+}
+
+MATCHER_P(IsPixelNear, expected, "")
+{
+    for (auto shift : {0, 8, 16, 24})
+    {
+        if (std::abs(channel(arg, shift) - channel(expected, shift)) > 1)
+        {
+            *result_listener << "pixel is 0x" << std::hex << arg;
+            return false;
+        }
+    }
+    return true;
+}
+
+struct SoftwareRenderer : Test
+{
+    SoftwareRenderer()
+    {
+        renderer.set_viewport(output_area);
+    }
+
+    auto render(mg::RenderableList const& renderables)
+    {
+        return renderer.render(renderables);
+    }
+
+    static auto pixel_at(mg::Framebuffer& fb, int x, int y) -> uint32_t
+    {
+        auto& mappable = dynamic_cast<mg::CPUAddressableDisplayAllocator::MappableFB&>(fb);
+        auto const mapping = mappable.map_writeable();
+        uint32_t pixel;
+        std::memcpy(&pixel, mapping->data() + y * mapping->stride().as_int() + x * sizeof(pixel), sizeof(pixel));
+        return pixel;
+    }
+
+    geom::Rectangle const output_area{{0, 0}, {8, 8}};
+    mtd::DummyCPUAddressableDisplayAllocator allocator{output_area.size};
+    mrs::Renderer renderer{allocator};
+};
+}
+
+TEST_F(SoftwareRenderer, clears_output_to_opaque_black)
+{
+    auto const fb = render({});
+
+    EXPECT_THAT(pixel_at(*fb, 0, 0), Eq(opaque_black));
+    EXPECT_THAT(pixel_at(*fb, 7, 7), Eq(opaque_black));
+}
+
+TEST_F(SoftwareRenderer, draws_buffer_at_its_screen_position)
+{
+    auto const renderable = std::make_shared<mtd::FakeRenderable>(2, 2, 4, 4);
+    renderable->set_buffer(filled_buffer({4, 4}, mir_pixel_format_xrgb_8888, 0x00ff0000));
+
+    auto const fb = render({renderable});
+
+    EXPECT_THAT(pixel_at(*fb, 2, 2), Eq(opaque_red));
+    EXPECT_THAT(pixel_at(*fb, 5, 5), Eq(opaque_red));
+    EXPECT_THAT(pixel_at(*fb, 1, 1), Eq(opaque_black));
+    EXPECT_THAT(pixel_at(*fb, 6, 6), Eq(opaque_black));
+}
+
+TEST_F(SoftwareRenderer, blends_translucent_buffer_over_what_is_beneath)
+{
+    auto const background = std::make_shared<mtd::FakeRenderable>(output_area);
+    background->set_buffer(filled_buffer(output_area.size, mir_pixel_format_xrgb_8888, opaque_white));
+    auto const translucent = std::make_shared<mtd::FakeRenderable>(output_area, 1.0f, false, std::nullopt);
+    translucent->set_buffer(filled_buffer(output_area.size, mir_pixel_format_argb_8888, 0x80000000));
+
+    auto const fb = render({background, translucent});
+
+    EXPECT_THAT(pixel_at(*fb, 4, 4), IsPixelNear(0xff7f7f7f));
+}
+
+TEST_F(SoftwareRenderer, applies_renderable_alpha)
+{
+    auto const renderable = std::make_shared<mtd::FakeRenderable>(output_area, 0.5f);
+    renderable->set_buffer(filled_buffer(output_area.size, mir_pixel_format_xrgb_8888, opaque_white));
+
+    auto const fb = render({renderable});
+
+    EXPECT_THAT(pixel_at(*fb, 4, 4), IsPixelNear(0xff808080));
+}
+
+TEST_F(SoftwareRenderer, draws_only_within_clip_area)
+{
+    auto const renderable = std::make_shared<mtd::FakeRenderable>(output_area);
+    renderable->set_buffer(filled_buffer(output_area.size, mir_pixel_format_xrgb_8888, opaque_red));
+    renderable->set_clip_area(geom::Rectangle{{0, 0}, {4, 8}});
+
+    auto const fb = render({renderable});
+
+    EXPECT_THAT(pixel_at(*fb, 3, 4), Eq(opaque_red));
+    EXPECT_THAT(pixel_at(*fb, 4, 4), Eq(opaque_black));
+}
+
+TEST_F(SoftwareRenderer, applies_output_transform)
+{
+    renderer.set_output_transform(mg::transformation(mir_orientation_inverted));
+    auto const renderable = std::make_shared<mtd::FakeRenderable>(0, 0, 2, 2);
+    renderable->set_buffer(filled_buffer({2, 2}, mir_pixel_format_xrgb_8888, opaque_red));
+
+    auto const fb = render({renderable});
+
+    EXPECT_THAT(pixel_at(*fb, 0, 0), Eq(opaque_black));
+    EXPECT_THAT(pixel_at(*fb, 6, 6), Eq(opaque_red));
+    EXPECT_THAT(pixel_at(*fb, 7, 7), Eq(opaque_red));
+}
+
+TEST_F(SoftwareRenderer, scales_viewport_to_output_without_fading_edges)
+{
+    renderer.set_viewport({{0, 0}, {4, 4}});
+    auto const renderable = std::make_shared<mtd::FakeRenderable>(0, 0, 2, 2);
+    renderable->set_buffer(filled_buffer({2, 2}, mir_pixel_format_xrgb_8888, opaque_red));
+
+    auto const fb = render({renderable});
+
+    EXPECT_THAT(pixel_at(*fb, 0, 0), Eq(opaque_red));
+    EXPECT_THAT(pixel_at(*fb, 3, 3), Eq(opaque_red));
+    EXPECT_THAT(pixel_at(*fb, 4, 4), Eq(opaque_black));
+}
+
+TEST_F(SoftwareRenderer, does_not_reread_buffers_that_have_not_changed)
+{
+    auto const buffer = std::make_shared<CountingBuffer>(output_area.size, mir_pixel_format_xrgb_8888);
+    auto const renderable = std::make_shared<mtd::FakeRenderable>(output_area);
+    renderable->set_buffer(buffer);
+
+    render({renderable});
+    auto const reads_after_first_frame = buffer->reads;
+    render({renderable});
+
+    EXPECT_THAT(reads_after_first_frame, Eq(1));
+    EXPECT_THAT(buffer->reads, Eq(1));
+}
+
+TEST_F(SoftwareRenderer, keeps_undamaged_content_between_frames)
+{
+    auto const still = std::make_shared<mtd::FakeRenderable>(0, 0, 4, 4);
+    still->set_buffer(filled_buffer({4, 4}, mir_pixel_format_xrgb_8888, opaque_red));
+    auto const changing = std::make_shared<mtd::FakeRenderable>(4, 4, 4, 4);
+    changing->set_buffer(filled_buffer({4, 4}, mir_pixel_format_xrgb_8888, opaque_red));
+
+    render({still, changing});
+    changing->set_buffer(filled_buffer({4, 4}, mir_pixel_format_xrgb_8888, opaque_white));
+    auto const fb = render({still, changing});
+
+    EXPECT_THAT(pixel_at(*fb, 0, 0), Eq(opaque_red));
+    EXPECT_THAT(pixel_at(*fb, 7, 7), Eq(opaque_white));
+}
+
+TEST_F(SoftwareRenderer, repaints_edge_of_content_that_abuts_the_damage)
+{
+    auto const still = std::make_shared<mtd::FakeRenderable>(0, 0, 4, 8);
+    still->set_buffer(filled_buffer({4, 8}, mir_pixel_format_xrgb_8888, opaque_red));
+    auto const changing = std::make_shared<mtd::FakeRenderable>(4, 0, 4, 8);
+    changing->set_buffer(filled_buffer({4, 8}, mir_pixel_format_xrgb_8888, opaque_red));
+
+    render({still, changing});
+    changing->set_buffer(filled_buffer({4, 8}, mir_pixel_format_xrgb_8888, opaque_white));
+    auto const fb = render({still, changing});
+
+    EXPECT_THAT(pixel_at(*fb, 3, 4), Eq(opaque_red));
+    EXPECT_THAT(pixel_at(*fb, 4, 4), Eq(opaque_white));
+}
+
+TEST_F(SoftwareRenderer, inverts_output_with_invert_filter)
+{
+    renderer.set_output_filter(mir_output_filter_invert);
+    auto const renderable = std::make_shared<mtd::FakeRenderable>(0, 0, 4, 4);
+    renderable->set_buffer(filled_buffer({4, 4}, mir_pixel_format_xrgb_8888, opaque_red));
+
+    auto const fb = render({renderable});
+
+    EXPECT_THAT(pixel_at(*fb, 0, 0), Eq(0xff00ffffu));
+    EXPECT_THAT(pixel_at(*fb, 7, 7), Eq(opaque_white));
+}
+
+TEST_F(SoftwareRenderer, copies_only_what_changed_into_recycled_framebuffer)
+{
+    RecyclingAllocator recycling_allocator{output_area.size};
+    mrs::Renderer renderer{recycling_allocator};
+    renderer.set_viewport(output_area);
+    auto const still = std::make_shared<mtd::FakeRenderable>(0, 0, 4, 4);
+    still->set_buffer(filled_buffer({4, 4}, mir_pixel_format_xrgb_8888, opaque_red));
+    auto const changing = std::make_shared<mtd::FakeRenderable>(4, 4, 4, 4);
+    changing->set_buffer(filled_buffer({4, 4}, mir_pixel_format_xrgb_8888, opaque_red));
+
+    renderer.render({still, changing});
+    recycling_allocator.scribble(0, 0, opaque_white);
+    changing->set_buffer(filled_buffer({4, 4}, mir_pixel_format_xrgb_8888, opaque_white));
+    auto const fb = renderer.render({still, changing});
+
+    EXPECT_THAT(pixel_at(*fb, 0, 0), Eq(opaque_white));
+    EXPECT_THAT(pixel_at(*fb, 7, 7), Eq(opaque_white));
+}
+
+TEST_F(SoftwareRenderer, copies_everything_into_recycled_framebuffer_when_filter_changes)
+{
+    RecyclingAllocator recycling_allocator{output_area.size};
+    mrs::Renderer renderer{recycling_allocator};
+    renderer.set_viewport(output_area);
+    auto const renderable = std::make_shared<mtd::FakeRenderable>(4, 4, 4, 4);
+    renderable->set_buffer(filled_buffer({4, 4}, mir_pixel_format_xrgb_8888, opaque_red));
+
+    renderer.render({renderable});
+    renderer.set_output_filter(mir_output_filter_invert);
+    auto const fb = renderer.render({renderable});
+
+    EXPECT_THAT(pixel_at(*fb, 0, 0), Eq(opaque_white));
+    EXPECT_THAT(pixel_at(*fb, 7, 7), Eq(0xff00ffffu));
+}
+
+TEST(SoftwareRendererFactory, creates_software_renderer_for_sink_with_cpu_addressable_buffers)
+{
+    mrs::RendererFactory factory;
+    mtd::StubDisplaySink sink{{{0, 0}, {8, 8}}};
+
+    EXPECT_THAT(factory.create_software_renderer_for(sink), NotNull());
+}
+
+TEST(SoftwareRendererFactory, creates_no_software_renderer_for_sink_without_cpu_addressable_buffers)
+{
+    mrs::RendererFactory factory;
+    mtd::NullDisplaySink sink;
+
+    EXPECT_THAT(factory.create_software_renderer_for(sink), IsNull());
+}
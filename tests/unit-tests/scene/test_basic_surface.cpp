@@ -415,6 +415,24 @@ TEST_F(BasicSurfaceTest, test_surface_is_opaque_by_default)
     EXPECT_FALSE(renderables[0]->shaped());
 }
 
+TEST_F(BasicSurfaceTest, opaque_region_of_renderable_follows_the_surface)
+{
+    using namespace testing;
+
+    surface.set_opaque_region(geom::Rectangles{{{1, 2}, {3, 4}}});
+
+    auto renderables = surface.generate_renderables(compositor_id);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0]->opaque_region(), Eq(geom::Rectangles{{rect.top_left + geom::Displacement{1, 2}, {3, 4}}}));
+
+    geom::Point const moved_to{100, 200};
+    surface.move_to(moved_to);
+
+    renderables = surface.generate_renderables(compositor_id);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0]->opaque_region(), Eq(geom::Rectangles{{moved_to + geom::Displacement{1, 2}, {3, 4}}}));
+}
+
 TEST_F(BasicSurfaceTest, test_surface_visibility)
 {
     using namespace testing;
@@ -1006,7 +1024,7 @@ TEST_F(BasicSurfaceTest, when_frame_is_posted_an_observer_is_notified_of_frame_w
     surface.set_streams({ms::StreamInfo{buffer_stream, {}}});
 
     EXPECT_CALL(*mock_surface_observer, frame_posted(_, mt::RectSizeEq(rect.size)));
-    buffer_stream->frame_posted_callback(rect.size);
+    buffer_stream->frame_posted_callback({{}, rect.size});
 }
 
 TEST_F(BasicSurfaceTest, when_frame_is_posted_an_observer_is_notified_of_frame_at_origin)
@@ -1018,7 +1036,7 @@ TEST_F(BasicSurfaceTest, when_frame_is_posted_an_observer_is_notified_of_frame_a
     surface.set_streams({ms::StreamInfo{buffer_stream, {}}});
 
     EXPECT_CALL(*mock_surface_observer, frame_posted(_, mt::RectTopLeftEq(geom::Point{})));
-    buffer_stream->frame_posted_callback(rect.size);
+    buffer_stream->frame_posted_callback({{}, rect.size});
 }
 
 TEST_F(BasicSurfaceTest, when_stream_info_has_offset_an_observer_is_notified_of_frame_with_correct_offset)
@@ -1027,13 +1045,12 @@ TEST_F(BasicSurfaceTest, when_stream_info_has_offset_an_observer_is_notified_of_
     geom::Displacement const stream_info_offset{7, 10};
 
     auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
-    std::function<void(geom::Size const&)> frame_posted_callback;
 
     surface.register_interest(mock_surface_observer, executor);
     surface.set_streams({ms::StreamInfo{buffer_stream, stream_info_offset}});
 
     EXPECT_CALL(*mock_surface_observer, frame_posted(_, mt::RectTopLeftEq(geom::Point{} + stream_info_offset)));
-    buffer_stream->frame_posted_callback(rect.size);
+    buffer_stream->frame_posted_callback({{}, rect.size});
 }
 
 TEST_F(BasicSurfaceTest, when_surface_has_margins_an_observer_is_notified_of_frame_with_correct_offset)
@@ -1043,14 +1060,13 @@ TEST_F(BasicSurfaceTest, when_surface_has_margins_an_observer_is_notified_of_fra
     geom::DeltaX const margin_left{3}, margin_right{5};
 
     auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
-    std::function<void(geom::Size const&)> frame_posted_callback;
 
     surface.register_interest(mock_surface_observer, executor);
     surface.set_streams({ms::StreamInfo{buffer_stream, {}}});
 
     EXPECT_CALL(*mock_surface_observer, frame_posted(_, mt::RectTopLeftEq(geom::Point{} + margin_top + margin_left)));
     surface.set_window_margins(margin_top, margin_left, margin_bottom, margin_right);
-    buffer_stream->frame_posted_callback({20, 30});
+    buffer_stream->frame_posted_callback({{}, {20, 30}});
 }
 
 TEST_F(BasicSurfaceTest, default_application_id)
@@ -1574,7 +1590,7 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_original_stream_after_surfac
 
     auto local_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
     std::list<ms::StreamInfo> local_stream_list = { { local_stream, {}} };
-    std::function<void(geom::Size const&)> callback = [](auto){};
+    std::function<void(geom::Rectangle const&)> callback = [](auto){};
 
     EXPECT_CALL(*local_stream, set_frame_posted_callback(_))
         .Times(AtLeast(1))
@@ -1590,7 +1606,7 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_original_stream_after_surfac
         display_config_registrar);
 
     surface.reset();
-    callback({10, 10});
+    callback({{0, 0}, {10, 10}});
 }
 
 TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_set_stream_after_surface_destroyed)
@@ -1599,7 +1615,7 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_set_stream_after_surface_des
 
     auto local_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
     std::list<ms::StreamInfo> local_stream_list = { { local_stream, {}} };
-    std::function<void(geom::Size const&)> callback = [](auto){};
+    std::function<void(geom::Rectangle const&)> callback = [](auto){};
 
     EXPECT_CALL(*local_stream, set_frame_posted_callback(_))
         .Times(AtLeast(1))
@@ -1617,7 +1633,7 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_set_stream_after_surface_des
     surface->set_streams(local_stream_list);
 
     surface.reset();
-    callback({10, 10});
+    callback({{0, 0}, {10, 10}});
 }
 
 TEST_F(BasicSurfaceTest, setting_orientation_results_in_renderable_with_same_orientation)
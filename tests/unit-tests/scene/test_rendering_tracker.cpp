@@ -21,8 +21,11 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <sys/sysmacros.h>
+
 namespace mtd = mir::test::doubles;
 namespace mc = mir::compositor;
+namespace mg = mir::graphics;
 
 namespace
 {
@@ -35,6 +38,9 @@ struct RenderingTrackerTest : testing::Test
     mc::CompositorID const compositor_id1{&mock_surface};
     mc::CompositorID const compositor_id2{&compositor_id1};
     mc::CompositorID const compositor_id3{&compositor_id2};
+
+    static uint32_t const xrgb8888{0x34325258};  // DRM_FORMAT_XRGB8888
+    static uint64_t const linear{0};             // DRM_FORMAT_MOD_LINEAR
 };
 
 }
@@ -151,3 +157,91 @@ TEST_F(RenderingTrackerTest, throws_when_passed_inactive_compositor_id)
         tracker.rendered_in(compositor_id2);
     }, std::logic_error);
 }
+
+TEST_F(RenderingTrackerTest, tells_surface_it_is_presented_once_after_rendering)
+{
+    using namespace testing;
+
+    std::set<mc::CompositorID> const compositors{compositor_id1, compositor_id2};
+    tracker.active_compositors(compositors);
+
+    tracker.rendered_in(compositor_id1);
+
+    mg::FramePresentation presentation;
+    presentation.frame.msc = 42;
+
+    EXPECT_CALL(*mock_surface, frame_presented(Field(&mg::FramePresentation::frame, Field(&mg::Frame::msc, Eq(42)))))
+        .Times(1);
+
+    tracker.presented_in(compositor_id2, presentation);
+    tracker.presented_in(compositor_id1, presentation);
+    tracker.presented_in(compositor_id1, presentation);
+}
+
+TEST_F(RenderingTrackerTest, does_not_tell_surface_it_is_presented_by_removed_compositor)
+{
+    using namespace testing;
+
+    std::set<mc::CompositorID> compositors{compositor_id1, compositor_id2};
+    tracker.active_compositors(compositors);
+
+    tracker.rendered_in(compositor_id2);
+    compositors.erase(compositor_id2);
+    tracker.active_compositors(compositors);
+
+    EXPECT_CALL(*mock_surface, frame_presented(_)).Times(0);
+
+    tracker.presented_in(compositor_id2, mg::FramePresentation{});
+}
+
+TEST_F(RenderingTrackerTest, tells_surface_its_scanout_formats_only_when_they_change)
+{
+    using namespace testing;
+
+    std::set<mc::CompositorID> const compositors{compositor_id1, compositor_id2};
+    tracker.active_compositors(compositors);
+
+    mg::ScanoutFormats const formats{makedev(226, 0), {{xrgb8888, linear}}};
+
+    InSequence seq;
+    EXPECT_CALL(*mock_surface, set_scanout_formats(Optional(formats))).Times(1);
+    EXPECT_CALL(*mock_surface, set_scanout_formats(Eq(std::nullopt))).Times(1);
+
+    tracker.scanout_candidate_in(compositor_id1, formats);
+    tracker.scanout_candidate_in(compositor_id1, formats);
+    tracker.scanout_candidate_in(compositor_id2, formats);
+    tracker.scanout_candidate_in(compositor_id2, std::nullopt);
+    tracker.scanout_candidate_in(compositor_id1, std::nullopt);
+    tracker.scanout_candidate_in(compositor_id1, std::nullopt);
+}
+
+TEST_F(RenderingTrackerTest, surface_is_no_longer_a_scanout_candidate_when_occluded)
+{
+    using namespace testing;
+
+    std::set<mc::CompositorID> const compositors{compositor_id1};
+    tracker.active_compositors(compositors);
+
+    mg::ScanoutFormats const formats{makedev(226, 0), {{xrgb8888, linear}}};
+    tracker.scanout_candidate_in(compositor_id1, formats);
+
+    EXPECT_CALL(*mock_surface, set_scanout_formats(Eq(std::nullopt))).Times(1);
+
+    tracker.occluded_in(compositor_id1);
+}
+
+TEST_F(RenderingTrackerTest, surface_is_no_longer_a_scanout_candidate_of_removed_compositor)
+{
+    using namespace testing;
+
+    std::set<mc::CompositorID> compositors{compositor_id1, compositor_id2};
+    tracker.active_compositors(compositors);
+
+    mg::ScanoutFormats const formats{makedev(226, 0), {{xrgb8888, linear}}};
+    tracker.scanout_candidate_in(compositor_id2, formats);
+
+    EXPECT_CALL(*mock_surface, set_scanout_formats(Eq(std::nullopt))).Times(1);
+
+    compositors.erase(compositor_id2);
+    tracker.active_compositors(compositors);
+}
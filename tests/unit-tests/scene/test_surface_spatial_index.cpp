@@ -0,0 +1,183 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/scene/surface_spatial_index.h"
+
+#include <mir/test/doubles/stub_surface.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace ms = mir::scene;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+struct RectangularSurface : mtd::StubSurface
+{
+    explicit RectangularSurface(geom::Rectangle bounds)
+        : bounds{bounds}
+    {
+    }
+
+    geom::Size window_size() const override { return bounds.size; }
+    geom::Rectangle input_bounds() const override { return bounds; }
+    std::vector<geom::Rectangle> get_input_region() const override { return region; }
+
+    bool input_area_contains(geom::Point const& point) const override
+    {
+        if (region.empty())
+        {
+            return bounds.contains(point);
+        }
+
+        for (auto const& rectangle : region)
+        {
+            if (rectangle.contains(point - as_displacement(bounds.top_left)))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    geom::Rectangle bounds;
+    std::vector<geom::Rectangle> region;
+};
+
+struct SurfaceSpatialIndex : Test
+{
+    auto add(geom::Rectangle bounds) -> std::shared_ptr<RectangularSurface>
+    {
+        auto const surface = std::make_shared<RectangularSurface>(bounds);
+        layers[0].push_back(surface);
+        index.set_stacking_order(layers);
+        return surface;
+    }
+
+    auto at(geom::Point point) -> std::shared_ptr<ms::Surface>
+    {
+        return index.topmost_at(point, [point](auto const& surface) { return surface->input_area_contains(point); });
+    }
+
+    std::vector<std::vector<std::shared_ptr<ms::Surface>>> layers{1};
+    ms::SurfaceSpatialIndex index{64};
+};
+}
+
+TEST_F(SurfaceSpatialIndex, finds_nothing_when_empty)
+{
+    EXPECT_THAT(at({10, 10}), IsNull());
+}
+
+TEST_F(SurfaceSpatialIndex, finds_topmost_surface_containing_point)
+{
+    auto const bottom = add({{0, 0}, {300, 300}});
+    auto const middle = add({{100, 0}, {100, 100}});
+    auto const top = add({{0, 0}, {50, 50}});
+
+    EXPECT_THAT(at({10, 10}), Eq(top));
+    EXPECT_THAT(at({150, 50}), Eq(middle));
+    EXPECT_THAT(at({250, 250}), Eq(bottom));
+    EXPECT_THAT(at({350, 350}), IsNull());
+}
+
+TEST_F(SurfaceSpatialIndex, finds_surfaces_at_negative_coordinates)
+{
+    auto const surface = add({{-200, -200}, {100, 100}});
+
+    EXPECT_THAT(at({-150, -150}), Eq(surface));
+    EXPECT_THAT(at({-50, -50}), IsNull());
+}
+
+TEST_F(SurfaceSpatialIndex, follows_restacking)
+{
+    auto const first = add({{0, 0}, {100, 100}});
+    auto const second = add({{0, 0}, {100, 100}});
+
+    layers[0] = {second, first};
+    index.set_stacking_order(layers);
+
+    EXPECT_THAT(at({10, 10}), Eq(first));
+}
+
+TEST_F(SurfaceSpatialIndex, orders_by_layer_before_position_in_layer)
+{
+    auto const above = add({{0, 0}, {100, 100}});
+    auto const below = add({{0, 0}, {100, 100}});
+
+    layers = {{below}, {above}};
+    index.set_stacking_order(layers);
+
+    EXPECT_THAT(at({10, 10}), Eq(above));
+}
+
+TEST_F(SurfaceSpatialIndex, forgets_surfaces_removed_from_the_stack)
+{
+    add({{0, 0}, {100, 100}});
+
+    layers[0].clear();
+    index.set_stacking_order(layers);
+
+    EXPECT_THAT(at({10, 10}), IsNull());
+}
+
+TEST_F(SurfaceSpatialIndex, follows_surface_moved_when_updated)
+{
+    auto const surface = add({{0, 0}, {100, 100}});
+
+    surface->bounds.top_left = {500, 500};
+    index.update(surface.get());
+
+    EXPECT_THAT(at({10, 10}), IsNull());
+    EXPECT_THAT(at({550, 550}), Eq(surface));
+}
+
+TEST_F(SurfaceSpatialIndex, finds_input_region_outside_surface_bounds)
+{
+    auto const surface = add({{200, 200}, {100, 100}});
+
+    surface->region = {{{-150, -150}, {10, 10}}};
+    index.update(surface.get());
+
+    EXPECT_THAT(at({55, 55}), Eq(surface));
+    EXPECT_THAT(at({250, 250}), IsNull());
+}
+
+TEST_F(SurfaceSpatialIndex, finds_surfaces_spanning_many_cells)
+{
+    auto const huge = add({{0, 0}, {100'000, 100'000}});
+    auto const small = add({{0, 0}, {10, 10}});
+
+    EXPECT_THAT(at({5, 5}), Eq(small));
+    EXPECT_THAT(at({50'000, 50'000}), Eq(huge));
+}
+
+TEST_F(SurfaceSpatialIndex, only_offers_surfaces_near_the_point)
+{
+    for (auto i = 0; i != 100; ++i)
+    {
+        add({{i * 100, 0}, {100, 100}});
+    }
+
+    int offered{0};
+    index.topmost_at({5050, 50}, [&](auto const&) { ++offered; return false; });
+
+    EXPECT_THAT(offered, Lt(5));
+}
@@ -584,6 +584,43 @@ TEST_F(SurfaceStack, generates_scene_elements_that_allow_only_one_buffer_acquisi
     elements.front()->renderable()->buffer();
 }
 
+TEST_F(SurfaceStack, tells_streams_of_rendered_surfaces_when_frame_is_presented)
+{
+    using namespace testing;
+
+    mc::CompositorID const compositor_id2{&compositor_id};
+    stack.register_compositor(compositor_id);
+    stack.register_compositor(compositor_id2);
+
+    auto mock_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    auto const surface = std::make_shared<ms::BasicSurface>(
+        std::string("stub"),
+        geom::Rectangle{geom::Point{3, 4},geom::Size{1, 2}},
+        mir_pointer_unconfined,
+        std::list<ms::StreamInfo> { { mock_stream, {}} },
+        std::shared_ptr<mg::CursorImage>(),
+        report,
+        display_config_registrar);
+    stack.add_surface(surface, mi::InputReceptionMode::normal);
+
+    auto const elements = stack.scene_elements_for(compositor_id);
+    ASSERT_THAT(elements.size(), Eq(1u));
+
+    mg::FramePresentation presentation;
+    presentation.vsync = true;
+
+    EXPECT_CALL(*mock_stream, frame_presented(_)).Times(0);
+    stack.frame_presented(compositor_id, presentation);
+    Mock::VerifyAndClearExpectations(mock_stream.get());
+
+    elements.front()->rendered();
+
+    EXPECT_CALL(*mock_stream, frame_presented(Field(&mg::FramePresentation::vsync, IsTrue()))).Times(1);
+    stack.frame_presented(compositor_id2, presentation);
+    stack.frame_presented(compositor_id, presentation);
+    stack.frame_presented(compositor_id, presentation);
+}
+
 namespace
 {
 struct MockConfigureSurface : StubSurface
@@ -868,6 +905,7 @@ TEST_F(SurfaceStack, surface_at_returns_top_surface_under_cursor)
     stub_surface1->resize({900, 900});
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -889,6 +927,7 @@ TEST_F(SurfaceStack, input_surface_at_returns_top_surface_under_cursor)
     stub_surface1->resize({900, 900});
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -912,6 +951,7 @@ TEST_F(SurfaceStack, surface_at_returns_top_visible_surface_under_cursor)
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
     invisible_stub_surface->resize({999, 999});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -935,6 +975,7 @@ TEST_F(SurfaceStack, input_surface_at_returns_top_visible_surface_under_cursor)
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
     invisible_stub_surface->resize({999, 999});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -1222,6 +1263,7 @@ TEST_F(SurfaceStack, when_screen_is_locked_surface_ignores_surface)
     geom::Point const cursor_position{100, 100};
     stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
     stub_surface1->resize({200, 200});
+    executor.execute();
     EXPECT_THAT(stack.surface_at(cursor_position), Eq(stub_surface1));
 
     stack.lock();
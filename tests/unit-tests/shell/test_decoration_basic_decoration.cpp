@@ -347,6 +347,18 @@ TEST_F(DecorationBasicDecoration, redrawn_on_focus_state_change)
     Mock::VerifyAndClearExpectations(&buffer_stream);
 }
 
+TEST_F(DecorationBasicDecoration, hovering_a_button_submits_only_the_button_as_damage)
+{
+    decoration_event(pointer_event(mir_pointer_action_enter, (MirPointerButtons)0, local_point_on_titlebar));
+    Mock::VerifyAndClearExpectations(&buffer_stream);
+    EXPECT_CALL(buffer_stream, submit_buffer(_, _, _, Property(&geom::Rectangles::size, Gt(0u))))
+        .Times(1);
+    EXPECT_CALL(buffer_stream, submit_buffer(_, _, _))
+        .Times(0);
+    decoration_event(pointer_event(mir_pointer_action_motion, (MirPointerButtons)0, local_close_button_location));
+    Mock::VerifyAndClearExpectations(&buffer_stream);
+}
+
 TEST_F(DecorationBasicDecoration, decoration_resized_on_window_resize)
 {
     geom::Size new_size{203, 305};
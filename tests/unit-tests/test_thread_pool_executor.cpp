@@ -18,7 +18,10 @@
 #include <gmock/gmock.h>
 
 #include <boost/throw_exception.hpp>
+#include <atomic>
 #include <chrono>
+#include <mutex>
+#include <set>
 #include <thread>
 #include <future>
 
@@ -215,3 +218,94 @@ TEST(ThreadPoolExecutor, quiesce_waits_until_work_completes)
     mir::ThreadPoolExecutor::quiesce();
     EXPECT_THAT(std::chrono::steady_clock::now(), Gt(expected_end));
 }
+
+TEST(ThreadPoolExecutor, burst_of_work_does_not_need_a_thread_per_item)
+{
+    constexpr int const work_count{1000};
+    auto const done = std::make_shared<mt::Signal>();
+    std::atomic<int> work_index{0};
+    std::mutex mutex;
+    std::set<std::thread::id> threads_used;
+
+    for (auto i = 0; i < work_count; ++i)
+    {
+        mir::thread_pool_executor.spawn(
+            [&]()
+            {
+                {
+                    std::lock_guard lock{mutex};
+                    threads_used.insert(std::this_thread::get_id());
+                }
+                if (++work_index == work_count)
+                {
+                    done->raise();
+                }
+            });
+    }
+
+    ASSERT_TRUE(done->wait_for(60s));
+    mir::ThreadPoolExecutor::quiesce();
+
+    EXPECT_THAT(threads_used.size(), Le(static_cast<size_t>(mir::ThreadPoolExecutor::statistics().workers)));
+}
+
+TEST(ThreadPoolExecutor, work_queued_behind_blocked_workers_is_executed)
+{
+    auto const unblock = std::make_shared<mt::Signal>();
+    auto const workers = mir::ThreadPoolExecutor::statistics().workers;
+
+    for (auto i = 0; i < workers; ++i)
+    {
+        mir::thread_pool_executor.spawn([unblock]() { unblock->wait_for(60s); });
+    }
+    mir::thread_pool_executor.spawn([unblock]() { unblock->raise(); });
+
+    EXPECT_TRUE(unblock->wait_for(60s));
+    mir::ThreadPoolExecutor::quiesce();
+}
+
+TEST(ThreadPoolExecutor, statistics_count_executed_work)
+{
+    auto const before = mir::ThreadPoolExecutor::statistics();
+
+    for (auto i = 0; i < 10; ++i)
+    {
+        mir::thread_pool_executor.spawn([]() {});
+    }
+    mir::ThreadPoolExecutor::quiesce();
+
+    auto const after = mir::ThreadPoolExecutor::statistics();
+    EXPECT_THAT(after.executed - before.executed, Eq(10u));
+    EXPECT_THAT(after.queued, Eq(0u));
+}
+
+TEST(LongRunningExecutor, executes_work_on_a_thread_of_its_own)
+{
+    auto thread_provider = std::make_shared<std::promise<std::thread::id>>();
+    auto thread = thread_provider->get_future();
+
+    mir::long_running_executor.spawn(
+        [thread_provider]()
+        {
+            thread_provider->set_value(std::this_thread::get_id());
+        });
+
+    ASSERT_THAT(thread.wait_for(std::chrono::seconds{60}), Eq(std::future_status::ready));
+    EXPECT_THAT(thread.get(), Ne(std::this_thread::get_id()));
+}
+
+TEST(LongRunningExecutor, quiesce_waits_until_long_running_work_completes)
+{
+    constexpr auto const delay = 500ms;
+
+    auto const expected_end = std::chrono::steady_clock::now() + delay;
+
+    mir::long_running_executor.spawn(
+        [delay]()
+        {
+            std::this_thread::sleep_for(delay);
+        });
+
+    mir::ThreadPoolExecutor::quiesce();
+    EXPECT_THAT(std::chrono::steady_clock::now(), Gt(expected_end));
+}